@@ -0,0 +1,233 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wshorten-64-to-32"
+#endif
+#include <itkImage.h>
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+//! Per-pixel vote counts of an ensemble of label images (segmentations), which can be updated incrementally.
+//!
+//! Adding or removing a member only requires a single pass over that member's labels, so that
+//! consensus results for a changing ensemble (e.g., when exploring different selections of
+//! ensemble members) do not need to re-read all members. Deciding the consensus from the counts
+//! (see vote) only reads the counts, so different thresholds can be tried without touching the
+//! members at all.
+//! Each member has equal weight; the same member can be added multiple times, it then votes
+//! multiple times. vote determines the same labels as iAParametrizableLabelVotingImageFilter with
+//! weight type Equal and no label voters or entropy limit set, with the members as inputs
+//! (including the undecided label, the maximum label of all members + 1).
+//! The counts are stored label by label for each pixel, as 16 bit values (i.e., for at most 65535 members).
+template <typename TLabelImage>
+class iALabelVoteCounts
+{
+public:
+	using LabelImageType = TLabelImage;
+	using LabelImagePointer = typename TLabelImage::Pointer;
+	using LabelPixelType = typename TLabelImage::PixelType;
+	using VoteCountType = std::uint16_t;
+
+	//! create empty counts, with storage for labels 0..labelCount-1; the storage is enlarged if
+	//! members contain larger labels. The image size is determined by the first added member
+	explicit iALabelVoteCounts(int labelCount) :
+		m_labelStride(static_cast<size_t>(std::max(labelCount, 1))),
+		m_memberCount(0)
+	{}
+	//! the number of labels votes are counted for: the maximum label of all current members + 1
+	//! (corresponds to the total label count determined by iAParametrizableLabelVotingImageFilter)
+	int labelCount() const
+	{
+		size_t count = m_labelPixels.size();
+		while (count > 1 && m_labelPixels[count - 1] == 0)
+		{
+			--count;
+		}
+		return static_cast<int>(std::max(count, size_t(1)));
+	}
+	//! the number of members currently contributing to the counts
+	size_t memberCount() const
+	{
+		return m_memberCount;
+	}
+	//! remove all members
+	void clear()
+	{
+		m_counts.clear();
+		m_labelPixels.clear();
+		m_geometry = nullptr;
+		m_memberCount = 0;
+	}
+	//! add the votes of a member; all members need to have the same size.
+	//! Pixels with a negative label don't vote (but count as members, as in the voting filter).
+	void addMember(LabelImageType const* img)
+	{
+		if (!m_geometry)
+		{
+			m_geometry = LabelImageType::New();
+			m_geometry->CopyInformation(img);
+			m_geometry->SetRegions(img->GetBufferedRegion());
+			m_counts.assign(img->GetBufferedRegion().GetNumberOfPixels() * m_labelStride, 0);
+		}
+		assert(m_memberCount < std::numeric_limits<VoteCountType>::max());
+		size_t const requiredStride = static_cast<size_t>(maxLabel(img)) + 1;
+		if (requiredStride > m_labelStride)
+		{
+			enlarge(requiredStride);
+		}
+		update(img, 1);
+		++m_memberCount;
+	}
+	//! remove the votes of a member previously added via addMember; the member needs to contain the same labels as when it was added
+	void removeMember(LabelImageType const* img)
+	{
+		assert(m_memberCount > 0);
+		update(img, -1);
+		--m_memberCount;
+	}
+	//! the consensus label for each pixel (the label with the most votes); pixels are undecided
+	//! (set to labelCount()) if no label has a unique maximum, or if one of the given criteria is
+	//! not fulfilled (criteria with a negative value are not checked):
+	//! @param minAbsPercentage minimum share of members voting for the first best guess (FBG)
+	//! @param minDiffPercentage minimum difference between the shares of members voting for FBG and second best guess (SBG)
+	//! @param minRatio minimum ratio between the votes for FBG and for SBG
+	//! @param undecidedPixels output; the number of undecided pixels
+	LabelImagePointer vote(double minAbsPercentage, double minDiffPercentage, double minRatio, size_t& undecidedPixels) const
+	{
+		undecidedPixels = 0;
+		if (!m_geometry || m_memberCount == 0)
+		{
+			return LabelImagePointer();
+		}
+		auto result = LabelImageType::New();
+		result->CopyInformation(m_geometry);
+		result->SetRegions(m_geometry->GetBufferedRegion());
+		result->Allocate();
+		LabelPixelType* out = result->GetBufferPointer();
+		size_t const labelCount = static_cast<size_t>(this->labelCount());
+		auto const undecidedLabel = static_cast<LabelPixelType>(labelCount);
+		double const memberCount = static_cast<double>(m_memberCount);
+		std::int64_t const pixelCount = static_cast<std::int64_t>(m_counts.size() / m_labelStride);
+		std::int64_t undecided = 0;
+#pragma omp parallel for reduction(+:undecided)
+		for (std::int64_t p = 0; p < pixelCount; ++p)
+		{
+			VoteCountType const* votes = m_counts.data() + p * m_labelStride;
+			size_t fbgLabel = 0;
+			bool unique = true;
+			for (size_t l = 1; l < labelCount; ++l)
+			{
+				if (votes[l] > votes[fbgLabel])
+				{
+					fbgLabel = l;
+					unique = true;
+				}
+				else if (votes[l] == votes[fbgLabel])
+				{
+					unique = false;
+				}
+			}
+			VoteCountType sbgVotes = 0;
+			for (size_t l = 0; l < labelCount; ++l)
+			{
+				if (l != fbgLabel)
+				{
+					sbgVotes = std::max(sbgVotes, votes[l]);
+				}
+			}
+			double fbgPercentage = votes[fbgLabel] / memberCount;
+			double sbgPercentage = sbgVotes / memberCount;
+			bool decided = unique &&
+				!(minAbsPercentage >= 0 && fbgPercentage < minAbsPercentage) &&
+				!(minDiffPercentage >= 0 && (fbgPercentage - sbgPercentage) < minDiffPercentage) &&
+				!(minRatio >= 0 && sbgVotes > 0 && (static_cast<double>(votes[fbgLabel]) / sbgVotes) < minRatio);
+			out[p] = decided ? static_cast<LabelPixelType>(fbgLabel) : undecidedLabel;
+			undecided += decided ? 0 : 1;
+		}
+		undecidedPixels = static_cast<size_t>(undecided);
+		return result;
+	}
+
+private:
+	static bool isVote(LabelPixelType label)
+	{
+		return itk::NumericTraits<LabelPixelType>::IsNonnegative(label);
+	}
+
+	static LabelPixelType maxLabel(LabelImageType const* img)
+	{
+		LabelPixelType const* labels = img->GetBufferPointer();
+		std::int64_t const pixelCount = static_cast<std::int64_t>(img->GetBufferedRegion().GetNumberOfPixels());
+		LabelPixelType result = 0;
+#pragma omp parallel for reduction(max:result)
+		for (std::int64_t p = 0; p < pixelCount; ++p)
+		{
+			result = std::max(result, labels[p]);
+		}
+		return result;
+	}
+
+	//! re-arrange the counts for storing newStride labels per pixel
+	void enlarge(size_t newStride)
+	{
+		std::vector<VoteCountType> counts(m_counts.size() / m_labelStride * newStride, 0);
+		std::int64_t const pixelCount = static_cast<std::int64_t>(m_counts.size() / m_labelStride);
+#pragma omp parallel for
+		for (std::int64_t p = 0; p < pixelCount; ++p)
+		{
+			std::copy_n(m_counts.data() + p * m_labelStride, m_labelStride, counts.data() + p * newStride);
+		}
+		m_counts.swap(counts);
+		m_labelStride = newStride;
+	}
+
+	void update(LabelImageType const* img, int delta)
+	{
+		assert(img->GetBufferedRegion().GetNumberOfPixels() * m_labelStride == m_counts.size());
+		LabelPixelType const* labels = img->GetBufferPointer();
+		std::int64_t const pixelCount = static_cast<std::int64_t>(m_counts.size() / m_labelStride);
+		std::vector<std::int64_t> labelPixels(m_labelStride, 0);
+#pragma omp parallel
+		{
+			std::vector<std::int64_t> threadLabelPixels(m_labelStride, 0);
+#pragma omp for
+			for (std::int64_t p = 0; p < pixelCount; ++p)
+			{
+				auto label = labels[p];
+				if (isVote(label))
+				{
+					assert(static_cast<size_t>(label) < m_labelStride);
+					auto& count = m_counts[p * m_labelStride + label];
+					count = static_cast<VoteCountType>(count + delta);
+					++threadLabelPixels[label];
+				}
+			}
+#pragma omp critical
+			for (size_t l = 0; l < m_labelStride; ++l)
+			{
+				labelPixels[l] += threadLabelPixels[l];
+			}
+		}
+		m_labelPixels.resize(m_labelStride, 0);
+		for (size_t l = 0; l < m_labelStride; ++l)
+		{
+			m_labelPixels[l] += delta * labelPixels[l];
+		}
+	}
+
+	size_t m_labelStride;                    //!< the number of labels for which votes are stored per pixel
+	size_t m_memberCount;
+	std::vector<VoteCountType> m_counts;     //!< vote counts, m_labelStride consecutive values per pixel
+	std::vector<std::int64_t> m_labelPixels; //!< for each label, the number of pixels labeled with it over all members
+	LabelImagePointer m_geometry;            //!< (unallocated) image holding the geometry of the members
+};
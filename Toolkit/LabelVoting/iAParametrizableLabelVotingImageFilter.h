@@ -36,6 +36,11 @@
 #pragma clang diagnostic pop
 #endif
 
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
 enum OutputNumber
 {
 	AbsolutePercentage,
@@ -237,6 +242,7 @@ public:
 		{
 		case AbsolutePercentage: return m_imgAbsMinPerc;
 		case DiffPercentage:     return m_imgMinDiffPerc;
+		case PixelEntropy:       return m_imgPixelEntropy;
 		default:
 		case Ratio:              return m_imgMinRatio;
 		}
@@ -276,8 +282,7 @@ protected:
 	 * global data. */
 	void BeforeThreadedGenerateData() override;
 
-	void ThreadedGenerateData
-		(const OutputImageRegionType & outputRegionForThread, itk::ThreadIdType threadId) override;
+	void DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
 
 	void PrintSelf(std::ostream &, itk::Indent) const override;
 
@@ -306,7 +311,15 @@ private:
 	std::set<std::pair<int, int> > m_inputLabelVotersSet;
 	std::map<std::pair<int, int>, double> m_inputLabelWeightMap;
 	WeightType       m_weightType;
+	//! @{
+	//! lookup tables for the settings above, indexed by label * number of inputs + input index
+	std::vector<char>   m_isLabelVoter;
+	std::vector<double> m_labelWeights;
+	//! @}
+	//! the probability images, indexed by input index * label count + label
+	std::vector<DoubleImg const *> m_probImgList;
 	double           m_undecidedPixels;
+	std::mutex       m_undecidedMutex;
 };
 
 #ifndef ITK_MANUAL_INSTANTIATION
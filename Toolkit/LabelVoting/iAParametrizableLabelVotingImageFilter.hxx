@@ -36,14 +36,17 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wshorten-64-to-32"
 #endif
-#include <itkImageRegionIterator.h>
+#include <itkImageScanlineConstIterator.h>
 #include <itkMath.h>
-#include <itkProgressReporter.h>
 #include <itkStatisticsImageFilter.h>
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
 
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
 template< typename TInputImage, typename TOutputImage >
 iAParametrizableLabelVotingImageFilter< TInputImage, TOutputImage >
 ::iAParametrizableLabelVotingImageFilter():
@@ -78,14 +81,15 @@ iAParametrizableLabelVotingImageFilter< TInputImage, TOutputImage >
 {
 	InputPixelType maxLabel = 0;
 	const size_t numberOfInputFiles = this->GetNumberOfIndexedInputs();
-	typedef itk::ImageRegionConstIterator<TInputImage> IteratorType;
 	for (size_t i = 0; i < numberOfInputFiles; ++i)
 	{
 		const InputImageType *inputImage = this->GetInput(static_cast<unsigned int>(i));
-		IteratorType          it(inputImage, inputImage->GetBufferedRegion());
-		for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+		InputPixelType const* labels = inputImage->GetBufferPointer();
+		const std::int64_t pixelCount = static_cast<std::int64_t>(inputImage->GetBufferedRegion().GetNumberOfPixels());
+#pragma omp parallel for reduction(max:maxLabel)
+		for (std::int64_t p = 0; p < pixelCount; ++p)
 		{
-			maxLabel = std::max(maxLabel, it.Get());
+			maxLabel = std::max(maxLabel, labels[p]);
 		}
 	}
 	return maxLabel;
@@ -157,188 +161,206 @@ iAParametrizableLabelVotingImageFilter< TInputImage, TOutputImage >
 		LOG(lvlWarn, "Weight Type is set to LabelBased, but no input/label to weight map given! Using equal weights.");
 		m_weightType = Equal;
 	}
-}
-
-template< typename TInputImage, typename TOutputImage >
-void iAParametrizableLabelVotingImageFilter<TInputImage, TOutputImage>::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
-	itk::ThreadIdType threadId)
-{
-	itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
 
-	typedef itk::ImageRegionConstIterator< TInputImage > IteratorType;
-	typedef itk::ImageRegionIterator< TOutputImage >     OutIteratorType;
-	typedef itk::ImageRegionIterator<DoubleImg> DoubleOutIteratorType;
-
-	typename TOutputImage::Pointer output = this->GetOutput();
-
-	// Record the number of input files.
+	// convert the per-input and label settings to tables, for a fast lookup while voting:
 	const size_t numberOfInputFiles = this->GetNumberOfIndexedInputs();
-
-	//  create and initialize all input image iterators
-	std::vector<IteratorType> it;
-	std::vector<std::vector<ConstDblIt> > probIt;
-	for (size_t i = 0; i < numberOfInputFiles; ++i)
+	auto inRange = [this, numberOfInputFiles](std::pair<int, int> const& labelInput)
+	{
+		return labelInput.first >= 0 && static_cast<size_t>(labelInput.first) < m_TotalLabelCount &&
+			labelInput.second >= 0 && static_cast<size_t>(labelInput.second) < numberOfInputFiles;
+	};
+	m_isLabelVoter.clear();
+	if (!m_inputLabelVotersSet.empty())
 	{
-		it.push_back(IteratorType(this->GetInput(static_cast<unsigned int>(i)), outputRegionForThread));
-		if (m_MaxPixelEntropy >= 0 || m_weightType == Certainty || m_weightType == FBGSBGDiff)
+		m_isLabelVoter.resize(m_TotalLabelCount * numberOfInputFiles, 0);
+		for (auto const& labelInput : m_inputLabelVotersSet)
+		{
+			if (inRange(labelInput))
+			{
+				m_isLabelVoter[labelInput.first * numberOfInputFiles + labelInput.second] = 1;
+			}
+		}
+	}
+	m_labelWeights.clear();
+	if (m_weightType == LabelBased)
+	{
+		m_labelWeights.resize(m_TotalLabelCount * numberOfInputFiles, 0.0);
+		for (auto const& labelInputWeight : m_inputLabelWeightMap)
+		{
+			if (inRange(labelInputWeight.first))
+			{
+				m_labelWeights[labelInputWeight.first.first * numberOfInputFiles + labelInputWeight.first.second] = labelInputWeight.second;
+			}
+		}
+	}
+	m_probImgList.clear();
+	if (m_MaxPixelEntropy >= 0 || m_weightType == Certainty || m_weightType == FBGSBGDiff)
+	{
+		for (size_t i = 0; i < numberOfInputFiles; ++i)
 		{
-			probIt.push_back(std::vector<ConstDblIt>());
 			for (size_t l = 0; l < m_TotalLabelCount; ++l)
 			{
-				probIt[i].push_back(ConstDblIt(m_probImgs[static_cast<int>(i)][l], outputRegionForThread));
-				probIt[i][l].GoToBegin();
+				m_probImgList.push_back(m_probImgs[i][l].GetPointer());
 			}
 		}
 	}
+	m_undecidedPixels = 0;
+}
 
-	float *votesByLabel = new float[m_TotalLabelCount];
 
-	OutIteratorType out = OutIteratorType(output, outputRegionForThread);
-	DoubleOutIteratorType absOut(m_imgAbsMinPerc, outputRegionForThread);
-	DoubleOutIteratorType diffOut(m_imgMinDiffPerc, outputRegionForThread);
-	DoubleOutIteratorType ratioOut(m_imgMinRatio, outputRegionForThread);
-	DoubleOutIteratorType entropyOut(m_imgPixelEntropy, outputRegionForThread);
-	absOut.GoToBegin();
-	diffOut.GoToBegin();
-	ratioOut.GoToBegin();
-	entropyOut.GoToBegin();
+template< typename TInputImage, typename TOutputImage >
+void iAParametrizableLabelVotingImageFilter<TInputImage, TOutputImage>::DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+	// Voting is done line by line; for each line, the inputs are processed one after the other,
+	// so that each input (and probability image) is read sequentially, instead of reading from
+	// all inputs for each pixel. The votes of the current line are accumulated in votesByLabel.
+	typename TOutputImage::Pointer output = this->GetOutput();
+	const size_t numberOfInputFiles = this->GetNumberOfIndexedInputs();
+	const size_t lineLength = outputRegionForThread.GetSize(0);
+	const bool useProbabilities = !m_probImgList.empty();
+
+	std::vector<float> votesByLabel(lineLength * m_TotalLabelCount);
+	std::vector<int> consideredFiles(lineLength);
+	std::vector<double> avgPixelEntropy(lineLength);
+	std::vector<double> entropy(useProbabilities ? lineLength : 0);
+	std::vector<double> pixelFBG(useProbabilities ? lineLength : 0);
+	std::vector<double> pixelSBG(useProbabilities ? lineLength : 0);
+
 	double limit = -std::log(1.0 / numberOfInputFiles);
 	double normalizeFactor = 1 / limit;
-	for (out.GoToBegin(); !out.IsAtEnd(); ++out)
+	double undecidedPixels = 0;
+	itk::ImageScanlineConstIterator<TOutputImage> lineIt(output, outputRegionForThread);
+	for (lineIt.GoToBegin(); !lineIt.IsAtEnd(); lineIt.NextLine())
 	{
-		// reset number of votes per label for all labels
-		std::fill_n(votesByLabel, m_TotalLabelCount, 0.0f);
+		auto const lineStart = lineIt.GetIndex();
+		std::fill(votesByLabel.begin(), votesByLabel.end(), 0.0f);
+		std::fill(consideredFiles.begin(), consideredFiles.end(), 0);
+		std::fill(avgPixelEntropy.begin(), avgPixelEntropy.end(), 0.0);
 
 		// count number of votes for the labels
-		int consideredFiles = 0;
-		double avgPixelEntropy = 0;
-		for (unsigned int i = 0; i < numberOfInputFiles; ++i)
+		for (size_t i = 0; i < numberOfInputFiles; ++i)
 		{
-			const InputPixelType label = it[i].Get();
-			++(it[i]);
-
-			if (!m_inputLabelVotersSet.empty() &&
-				m_inputLabelVotersSet.count(std::make_pair(label, i)) == 0)
+			const InputImageType* input = this->GetInput(static_cast<unsigned int>(i));
+			InputPixelType const* labels = input->GetBufferPointer() + input->ComputeOffset(lineStart);
+			if (useProbabilities)
 			{
-				continue;
-			}
-			double entropy = 0.0;
-			// calculate entropy of the current pixel for each input file
-			double pixelFBG = 0, pixelSBG = 0;
-			if (m_MaxPixelEntropy >= 0 || m_weightType == Certainty || m_weightType == FBGSBGDiff)
-			{
-				//double probSum = 0.0;
-				for (unsigned int l = 0; l < m_TotalLabelCount; ++l)
+				// calculate entropy and first and second best guess probability of each pixel for the current input
+				std::fill(entropy.begin(), entropy.end(), 0.0);
+				std::fill(pixelFBG.begin(), pixelFBG.end(), 0.0);
+				std::fill(pixelSBG.begin(), pixelSBG.end(), 0.0);
+				for (size_t l = 0; l < m_TotalLabelCount; ++l)
 				{
-					if (probIt[i][l].IsAtEnd())
-					{
-						LOG(lvlInfo, "Prob It at end.");
-					}
-					const double probValue = probIt[i][l].Get();
-					++(probIt[i][l]);
-					//probSum += probValue;
-					if (probValue > 0)
+					DoubleImg const* probImg = m_probImgList[i * m_TotalLabelCount + l];
+					double const* probValues = probImg->GetBufferPointer() + probImg->ComputeOffset(lineStart);
+					for (size_t x = 0; x < lineLength; ++x)
 					{
-						entropy += (probValue * std::log(probValue));
+						const double probValue = probValues[x];
+						if (probValue > 0)
+						{
+							entropy[x] += (probValue * std::log(probValue));
+						}
+						if (probValue > pixelFBG[x])
+						{
+							pixelSBG[x] = pixelFBG[x];
+							pixelFBG[x] = probValue;
+						}
+						else if (probValue > pixelSBG[x])
+						{
+							pixelSBG[x] = probValue;
+						}
 					}
-					if (probValue > pixelFBG)
+				}
+			}
+			for (size_t x = 0; x < lineLength; ++x)
+			{
+				const InputPixelType label = labels[x];
+				const bool labelInRange = itk::NumericTraits<InputPixelType>::IsNonnegative(label) &&
+					static_cast<size_t>(label) < m_TotalLabelCount;
+				if (!m_isLabelVoter.empty() &&
+					(!labelInRange || !m_isLabelVoter[label * numberOfInputFiles + i]))
+				{
+					continue;
+				}
+				double pixelEntropy = 0.0;
+				if (useProbabilities)
+				{
+					pixelEntropy = clamp(0.0, limit, -entropy[x]) * normalizeFactor;
+					avgPixelEntropy[x] += pixelEntropy;
+					if (m_MaxPixelEntropy >= 0 && pixelEntropy > m_MaxPixelEntropy)
 					{
-						pixelSBG = pixelFBG;
-						pixelFBG = probValue;
+						continue;
 					}
-					else if (probValue > pixelSBG)
+				}
+				consideredFiles[x]++;
+				if (labelInRange)
+				{
+					float* votes = votesByLabel.data() + x * m_TotalLabelCount;
+					switch (m_weightType)
 					{
-						pixelSBG = probValue;
+						case Equal: votes[label] += 1.0; break;
+						case LabelBased: votes[label] += m_labelWeights[label * numberOfInputFiles + i]; break;
+						case Certainty: votes[label] += (1.0 - pixelEntropy); break;
+						case FBGSBGDiff: votes[label] += (pixelFBG[x] - pixelSBG[x]); break;
 					}
 				}
-				entropy = -entropy;
-				/*
-				assert(entropy >= -0.000000001 && entropy <= limit + 0.000000001);
-				assert(probSum >= 0.999999999 && probSum <= 1.000000001);
-				*/
-				entropy = clamp(0.0, limit, entropy);
-				entropy = entropy * normalizeFactor;
-				avgPixelEntropy += entropy;
-				if (m_MaxPixelEntropy >= 0 && entropy > m_MaxPixelEntropy)
+			}
+		}
+
+		// determine the label with the most votes for each pixel
+		OutputPixelType* out = output->GetBufferPointer() + output->ComputeOffset(lineStart);
+		double* absOut = m_imgAbsMinPerc->GetBufferPointer() + m_imgAbsMinPerc->ComputeOffset(lineStart);
+		double* diffOut = m_imgMinDiffPerc->GetBufferPointer() + m_imgMinDiffPerc->ComputeOffset(lineStart);
+		double* ratioOut = m_imgMinRatio->GetBufferPointer() + m_imgMinRatio->ComputeOffset(lineStart);
+		double* entropyOut = m_imgPixelEntropy->GetBufferPointer() + m_imgPixelEntropy->ComputeOffset(lineStart);
+		for (size_t x = 0; x < lineLength; ++x)
+		{
+			float const* votes = votesByLabel.data() + x * m_TotalLabelCount;
+			OutputPixelType outLabel = 0;
+			unsigned int firstBestGuessLabel = 0;
+			float firstBestGuessVotes = votes[0];
+			for (size_t l = 1; l < m_TotalLabelCount; ++l)
+			{
+				if (votes[l] > firstBestGuessVotes)
 				{
-					continue;
+					firstBestGuessVotes = votes[l];
+					firstBestGuessLabel = static_cast<unsigned int>(l);
+					outLabel = static_cast<OutputPixelType>(l);
+				}
+				else if (votes[l] == firstBestGuessVotes)
+				{
+					outLabel = m_LabelForUndecidedPixels;
 				}
 			}
-			consideredFiles++;
-			if (itk::NumericTraits<InputPixelType>::IsNonnegative(label))
+			float secondBestGuessVotes = 0;
+			for (size_t l = 0; l < m_TotalLabelCount; ++l)
 			{
-				switch (m_weightType)
+				if (l != firstBestGuessLabel &&
+					votes[l] > secondBestGuessVotes)
 				{
-					case Equal: votesByLabel[label] += 1.0; break;
-					case LabelBased: votesByLabel[label] += m_inputLabelWeightMap[std::make_pair(label, i)]; break;
-					case Certainty: votesByLabel[label] += (1.0 - entropy); break;
-					case FBGSBGDiff: votesByLabel[label] += (pixelFBG - pixelSBG); break;
+					secondBestGuessVotes = votes[l];
 				}
-				
 			}
-		}
-		if (consideredFiles == 0)
-		{
-			m_undecidedPixels += 1;
-			out.Set(m_LabelForUndecidedPixels);
-			continue;
-		}
-
-		avgPixelEntropy = avgPixelEntropy / numberOfInputFiles;
-		// determine the label with the most votes for this pixel
-
-		out.Set(0);
-		unsigned int firstBestGuessLabel = 0;
-		float firstBestGuessVotes = votesByLabel[0];
-		for (size_t l = 1; l < m_TotalLabelCount; ++l)
-		{
-			if (votesByLabel[l] > firstBestGuessVotes)
-			{
-				firstBestGuessVotes = votesByLabel[l];
-				firstBestGuessLabel = static_cast<unsigned int>(l);
-				out.Set(static_cast<OutputPixelType>(l));
-			} else if (votesByLabel[l] == firstBestGuessVotes)
+			double firstBestGuessPercentage = static_cast<double>(firstBestGuessVotes) / numberOfInputFiles;
+			double secondBestGuessPercentage = static_cast<double>(secondBestGuessVotes) / numberOfInputFiles;
+			if ((consideredFiles[x] == 0) ||
+				(m_AbsMinPercentage >= 0 && firstBestGuessPercentage < m_AbsMinPercentage) ||
+				(m_MinDiffPercentage >= 0 && (firstBestGuessPercentage - secondBestGuessPercentage) < m_MinDiffPercentage) ||
+				(m_MinRatio >= 0 && secondBestGuessVotes > 0 && (static_cast<double>(firstBestGuessVotes) / secondBestGuessVotes) < m_MinRatio))
 			{
-				out.Set(m_LabelForUndecidedPixels);
+				outLabel = this->m_LabelForUndecidedPixels;
 			}
-		}
-		float secondBestGuessVotes = 0;
-		for (size_t l = 0; l < m_TotalLabelCount; ++l)
-		{
-			if (l != firstBestGuessLabel &&
-				votesByLabel[l] > secondBestGuessVotes)
+			if (outLabel == this->m_LabelForUndecidedPixels)
 			{
-				secondBestGuessVotes = votesByLabel[l];
+				undecidedPixels += 1;
 			}
+			out[x] = outLabel;
+			absOut[x] = firstBestGuessPercentage;
+			diffOut[x] = firstBestGuessPercentage - secondBestGuessPercentage;
+			// if secondBestGuessVotes = 1 and no other votes, then ratio = numberOfInputFiles-1
+			ratioOut[x] = secondBestGuessVotes > 0 ? (firstBestGuessVotes / secondBestGuessVotes) : numberOfInputFiles;
+			entropyOut[x] = avgPixelEntropy[x] / numberOfInputFiles;
 		}
-		double firstBestGuessPercentage = static_cast<double>(firstBestGuessVotes) / numberOfInputFiles;
-		double secondBestGuessPercentage = static_cast<double>(secondBestGuessVotes) / numberOfInputFiles;
-		if (m_AbsMinPercentage >= 0 && firstBestGuessPercentage < m_AbsMinPercentage)
-		{
-			out.Set(this->m_LabelForUndecidedPixels);
-		}
-		if (m_MinDiffPercentage >= 0 &&	(firstBestGuessPercentage - secondBestGuessPercentage) < m_MinDiffPercentage)
-		{
-			out.Set(this->m_LabelForUndecidedPixels);
-		}
-		if (m_MinRatio >= 0 && secondBestGuessVotes > 0 && (static_cast<double>(firstBestGuessVotes) / secondBestGuessVotes) < m_MinRatio)
-		{
-			out.Set(this->m_LabelForUndecidedPixels);
-		}
-		if (out.Get() == this->m_LabelForUndecidedPixels)
-		{
-			m_undecidedPixels += 1;
-		}
-		absOut.Set(firstBestGuessPercentage);
-		++absOut;
-		diffOut.Set(firstBestGuessPercentage - secondBestGuessPercentage);
-		++diffOut;
-		// if secondBestGuessVotes = 1 and no other votes, then ratio = numberOfInputFiles-1
-		ratioOut.Set(secondBestGuessVotes > 0 ? (firstBestGuessVotes / secondBestGuessVotes) : numberOfInputFiles );
-		++ratioOut;
-		entropyOut.Set(avgPixelEntropy);
-		++entropyOut;
-		progress.CompletedPixel();
 	}
-	delete[] votesByLabel;
+	std::lock_guard<std::mutex> lock(m_undecidedMutex);
+	m_undecidedPixels += undecidedPixels;
 }
@@ -11,6 +11,10 @@
 #pragma clang diagnostic pop
 #endif
 
+#include <map>
+#include <mutex>
+#include <vector>
+
 enum VotingRule
 {
 	SumRule,
@@ -78,8 +82,7 @@ protected:
 	iAProbabilisticVotingImageFilter();
 	virtual ~iAProbabilisticVotingImageFilter() {}
 	void BeforeThreadedGenerateData() override;
-	void ThreadedGenerateData
-		(const OutputImageRegionType & outputRegionForThread, itk::ThreadIdType threadId) override;
+	void DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
 
 	void PrintSelf(std::ostream &, itk::Indent) const override;
 
@@ -94,6 +97,9 @@ private:
 	size_t m_numberOfClassifiers;
 	double m_undecidedUncertaintyThresh;
 	double m_undecidedPixels;
+	std::mutex m_undecidedMutex;
+	//! the probability images, indexed by classifier index * label count + label
+	std::vector<DoubleImg const *> m_probImgList;
 };
 
 #ifndef ITK_MANUAL_INSTANTIATION
@@ -8,9 +8,8 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wshorten-64-to-32"
 #endif
-#include <itkImageRegionIterator.h>
+#include <itkImageScanlineConstIterator.h>
 #include <itkMath.h>
-#include <itkProgressReporter.h>
 #include <itkStatisticsImageFilter.h>
 #ifdef __clang__
 #pragma clang diagnostic pop
@@ -18,6 +17,9 @@
 
 #include <iAMathUtility.h>
 
+#include <algorithm>
+#include <vector>
+
 template< typename TInputImage, typename TOutputImage >
 iAProbabilisticVotingImageFilter<TInputImage, TOutputImage>::iAProbabilisticVotingImageFilter():
 	m_votingRule(MajorityVoteRule),
@@ -55,153 +57,186 @@ void iAProbabilisticVotingImageFilter< TInputImage, TOutputImage >
 	typename TOutputImage::Pointer output = this->GetOutput();
 	output->SetBufferedRegion(output->GetRequestedRegion());
 	output->Allocate();
-	itk::SmartPointer<const TInputImage> in0 = this->GetInput(0);
-}
-
-template< typename TInputImage, typename TOutputImage >
-void iAProbabilisticVotingImageFilter<TInputImage, TOutputImage>::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
-	itk::ThreadIdType threadId)
-{
-	itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
-
-	//typedef itk::ImageRegionConstIterator< TInputImage > IteratorType;
-	typedef itk::ImageRegionIterator< TOutputImage >     OutIteratorType;
-	//typedef itk::ImageRegionIterator<DoubleImg> DoubleOutIteratorType;
-
-	typename TOutputImage::Pointer output = this->GetOutput();
 
-	std::vector<std::vector<ConstDblIt> > probIt;
+	m_probImgList.clear();
 	for (size_t c = 0; c < m_numberOfClassifiers; ++c)
 	{
-		probIt.push_back(std::vector<ConstDblIt>());
 		for (size_t l = 0; l < m_labelCount; ++l)
 		{
-			probIt[c].push_back(ConstDblIt(m_probImgs[c][l], outputRegionForThread));
-			probIt[c][l].GoToBegin();
+			m_probImgList.push_back(m_probImgs[c][l].GetPointer());
 		}
 	}
+	m_undecidedPixels = 0;
+}
 
-	OutIteratorType out = OutIteratorType(output, outputRegionForThread);
-
-	double * combinedPixelProbs = new double[m_labelCount];
+template< typename TInputImage, typename TOutputImage >
+void iAProbabilisticVotingImageFilter<TInputImage, TOutputImage>::DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+	// The region is processed line by line; the probabilities of a line are combined by reading
+	// one probability image after the other, instead of reading from all probability images for
+	// each pixel. combinedProbs holds the combined probabilities of the current line, label by label.
+	typename TOutputImage::Pointer output = this->GetOutput();
+	const size_t lineLength = outputRegionForThread.GetSize(0);
+	std::vector<double> combinedProbs(m_labelCount * lineLength);
+	// for majority vote: label with the highest probability (and that probability) per pixel of the current classifier
+	std::vector<size_t> classifierLabel(m_votingRule == MajorityVoteRule ? lineLength : 0);
+	std::vector<double> classifierMaxProb(m_votingRule == MajorityVoteRule ? lineLength : 0);
+	// for median: the probabilities of all classifiers for one label, classifier by classifier for each pixel
+	std::vector<double> labelProbs(m_votingRule == MedianRule ? m_numberOfClassifiers * lineLength : 0);
+	auto lineProbabilities = [this](size_t c, size_t l, typename OutputImageType::IndexType const & idx) -> double const *
+	{
+		DoubleImg const* img = m_probImgList[c * m_labelCount + l];
+		return img->GetBufferPointer() + img->ComputeOffset(idx);
+	};
+	std::vector<double> combinedPixelProbs(m_labelCount);
 	double normalizeFactor = 1.0 / -std::log(1.0 / m_numberOfClassifiers);
-	for (out.GoToBegin(); !out.IsAtEnd(); ++out)
+	double undecidedPixels = 0;
+	itk::ImageScanlineConstIterator<TOutputImage> lineIt(output, outputRegionForThread);
+	for (lineIt.GoToBegin(); !lineIt.IsAtEnd(); lineIt.NextLine())
 	{
-		double normalizationSum = 0;
-		std::fill(combinedPixelProbs, combinedPixelProbs + m_labelCount, 0);
-		for (size_t l = 0; l < m_labelCount; ++l)
+		auto const lineStart = lineIt.GetIndex();
+		switch (m_votingRule)
 		{
-			switch (m_votingRule)
+		case SumRule:
+			std::fill(combinedProbs.begin(), combinedProbs.end(), 0.0);
+			for (size_t c = 0; c < m_numberOfClassifiers; ++c)
 			{
-			case SumRule:
-				for (size_t c = 0; c < m_numberOfClassifiers; ++c)
+				for (size_t l = 0; l < m_labelCount; ++l)
 				{
-					combinedPixelProbs[l] += probIt[c][l].Get();
+					double const* prob = lineProbabilities(c, l, lineStart);
+					double* combined = combinedProbs.data() + l * lineLength;
+					for (size_t x = 0; x < lineLength; ++x)
+					{
+						combined[x] += prob[x];
+					}
 				}
-				combinedPixelProbs[l] /= m_numberOfClassifiers;
-				break;
-			case MaxRule:
-				for (size_t c = 0; c < m_numberOfClassifiers; ++c)
+			}
+			for (auto & p : combinedProbs)
+			{
+				p /= m_numberOfClassifiers;
+			}
+			break;
+		case MaxRule:
+			std::fill(combinedProbs.begin(), combinedProbs.end(), 0.0);
+			for (size_t c = 0; c < m_numberOfClassifiers; ++c)
+			{
+				for (size_t l = 0; l < m_labelCount; ++l)
 				{
-					combinedPixelProbs[l] = std::max(probIt[c][l].Get(), combinedPixelProbs[l]);
+					double const* prob = lineProbabilities(c, l, lineStart);
+					double* combined = combinedProbs.data() + l * lineLength;
+					for (size_t x = 0; x < lineLength; ++x)
+					{
+						combined[x] = std::max(prob[x], combined[x]);
+					}
 				}
-				break;
-			case MinRule: {
-				double curLabelProb = 1;
-				for (size_t c = 0; c < m_numberOfClassifiers; ++c)
+			}
+			break;
+		case MinRule:
+			std::fill(combinedProbs.begin(), combinedProbs.end(), 1.0);
+			for (size_t c = 0; c < m_numberOfClassifiers; ++c)
+			{
+				for (size_t l = 0; l < m_labelCount; ++l)
 				{
-					curLabelProb = std::min(probIt[c][l].Get(), curLabelProb);
+					double const* prob = lineProbabilities(c, l, lineStart);
+					double* combined = combinedProbs.data() + l * lineLength;
+					for (size_t x = 0; x < lineLength; ++x)
+					{
+						combined[x] = std::min(prob[x], combined[x]);
+					}
 				}
-				combinedPixelProbs[l] = curLabelProb;
-				break;
 			}
-			case MedianRule: {
-				std::vector<double> probs;
+			break;
+		case MedianRule:
+			for (size_t l = 0; l < m_labelCount; ++l)
+			{
 				for (size_t c = 0; c < m_numberOfClassifiers; ++c)
 				{
-					probs.push_back(probIt[c][l].Get());
+					double const* prob = lineProbabilities(c, l, lineStart);
+					for (size_t x = 0; x < lineLength; ++x)
+					{
+						labelProbs[x * m_numberOfClassifiers + c] = prob[x];
+					}
+				}
+				double* combined = combinedProbs.data() + l * lineLength;
+				for (size_t x = 0; x < lineLength; ++x)
+				{
+					auto probs = labelProbs.begin() + x * m_numberOfClassifiers;
+					std::sort(probs, probs + m_numberOfClassifiers);
+					combined[x] = m_numberOfClassifiers % 2 == 0
+						? (probs[(m_numberOfClassifiers / 2) - 1] + probs[m_numberOfClassifiers / 2]) / 2
+						: probs[m_numberOfClassifiers / 2];
 				}
-				std::sort(probs.begin(), probs.end());
-				combinedPixelProbs[l] = probs.size() % 2 == 0
-					? (probs[(probs.size() / 2) - 1] + probs[probs.size() / 2]) / 2
-					: probs[probs.size() / 2];
-				break;
 			}
-			case MajorityVoteRule: {
-				double majorityCount = 0;
-				for (size_t c = 0; c < m_numberOfClassifiers; ++c)
+			break;
+		case MajorityVoteRule:
+			std::fill(combinedProbs.begin(), combinedProbs.end(), 0.0);
+			for (size_t c = 0; c < m_numberOfClassifiers; ++c)
+			{
+				// each classifier votes for the label with its highest probability;
+				// if two highest probabilities are the same, only count it
+				// as a vote towards the lower label index (to not count doubles)
+				std::fill(classifierLabel.begin(), classifierLabel.end(), 0);
+				std::copy_n(lineProbabilities(c, 0, lineStart), lineLength, classifierMaxProb.begin());
+				for (size_t l = 1; l < m_labelCount; ++l)
 				{
-					bool isMajority = true;
-					for (size_t l2 = 0; l2 < m_labelCount; ++l2)
+					double const* prob = lineProbabilities(c, l, lineStart);
+					for (size_t x = 0; x < lineLength; ++x)
 					{
-						if (l == l2)
-						{
-							continue;
-						}
-						if (probIt[c][l2].Get() > probIt[c][l].Get() ||
-							(l2 < l && probIt[c][l2].Get() == probIt[c][l].Get()))
-							// if two highest probabilities are the same, only count it
-							// as a vote towards the lower label index (to not count doubles)
+						if (prob[x] > classifierMaxProb[x])
 						{
-							isMajority = false;
-							break;
+							classifierMaxProb[x] = prob[x];
+							classifierLabel[x] = l;
 						}
 					}
-					if (isMajority)
-					{
-						majorityCount += m_weights[c];
-					}
 				}
-				combinedPixelProbs[l] = majorityCount / m_numberOfClassifiers;
-				break;
+				for (size_t x = 0; x < lineLength; ++x)
+				{
+					combinedProbs[classifierLabel[x] * lineLength + x] += m_weights[c];
+				}
 			}
+			for (auto& p : combinedProbs)
+			{
+				p /= m_numberOfClassifiers;
 			}
-			normalizationSum += combinedPixelProbs[l];
+			break;
 		}
 
-		// determine max probability:
-		/*
-		if (std::abs(normalizationSum - 1.0) > std::numeric_limits<float>::epsilon())
-		{
-			LOG(lvlWarn, "Normalization Sum != 1!");
-		}
-		*/
-		size_t maxProbIdx = 0;
-		double entropy = 0.0;
-		for (size_t l = 0; l < m_labelCount; ++l)
+		OutputPixelType* out = output->GetBufferPointer() + output->ComputeOffset(lineStart);
+		for (size_t x = 0; x < lineLength; ++x)
 		{
-			combinedPixelProbs[l] /= normalizationSum;
-			if (combinedPixelProbs[l] > combinedPixelProbs[maxProbIdx])
+			double normalizationSum = 0;
+			for (size_t l = 0; l < m_labelCount; ++l)
 			{
-				maxProbIdx = l;
+				combinedPixelProbs[l] = combinedProbs[l * lineLength + x];
+				normalizationSum += combinedPixelProbs[l];
 			}
-			if (combinedPixelProbs[l] > 0)
+			// determine max probability:
+			size_t maxProbIdx = 0;
+			double entropy = 0.0;
+			for (size_t l = 0; l < m_labelCount; ++l)
 			{
-				entropy += (combinedPixelProbs[l] * std::log(combinedPixelProbs[l]));
+				combinedPixelProbs[l] /= normalizationSum;
+				if (combinedPixelProbs[l] > combinedPixelProbs[maxProbIdx])
+				{
+					maxProbIdx = l;
+				}
+				if (combinedPixelProbs[l] > 0)
+				{
+					entropy += (combinedPixelProbs[l] * std::log(combinedPixelProbs[l]));
+				}
 			}
-		}
-		entropy = clamp(0.0, 1.0, -entropy*normalizeFactor);
+			entropy = clamp(0.0, 1.0, -entropy*normalizeFactor);
 
-		size_t finalLabel = maxProbIdx;
-		if (entropy >= m_undecidedUncertaintyThresh)
-		{
-			finalLabel = m_labelCount;
-			m_undecidedPixels += 1;
-		}
-
-		// with probabilities, set output (TODO: also output probabilities?)
-		out.Set(static_cast<int>(finalLabel));
-
-		// advance to next pixel:
-		for (size_t c = 0; c < m_numberOfClassifiers; ++c)
-		{
-			for (size_t l = 0; l < m_labelCount; ++l)
+			size_t finalLabel = maxProbIdx;
+			if (entropy >= m_undecidedUncertaintyThresh)
 			{
-				++(probIt[c][l]);
+				finalLabel = m_labelCount;
+				undecidedPixels += 1;
 			}
+			// with probabilities, set output (TODO: also output probabilities?)
+			out[x] = static_cast<OutputPixelType>(finalLabel);
 		}
-		progress.CompletedPixel();
-
 	}
-	delete[] combinedPixelProbs;
+	std::lock_guard<std::mutex> lock(m_undecidedMutex);
+	m_undecidedPixels += undecidedPixels;
 }
@@ -4,6 +4,9 @@
 
 #include <itkImageToImageFilter.h>
 
+#include <map>
+#include <vector>
+
 //! Given a number of input images, compute a final classification based on first and second best guess.
 template< typename TInputImage, typename TOutputImage = TInputImage >
 class iAUndecidedPixelClassifierImageFilter :
@@ -73,8 +76,7 @@ protected:
 	virtual ~iAUndecidedPixelClassifierImageFilter() {}
 	void BeforeThreadedGenerateData() override;
 
-	void ThreadedGenerateData
-		(const OutputImageRegionType & outputRegionForThread, itk::ThreadIdType threadId) override;
+	void DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
 
 	void PrintSelf(std::ostream &, itk::Indent) const override;
 
@@ -83,6 +85,8 @@ protected:
 private:
 	iAUndecidedPixelClassifierImageFilter(const Self &) =delete;
 	void operator=(const Self &) =delete;
+	//! determine the label of an undecided pixel from the first and second best guesses of all inputs at this pixel and in its neighborhood
+	OutputPixelType ClassifyUndecidedPixel(typename TInputImage::IndexType const & idx) const;
 
 	OutputPixelType m_undecidedPixelLabel;
 	bool m_hasUndecidedPixelLabel;
@@ -90,6 +94,9 @@ private:
 	itk::Size<TInputImage::ImageDimension> m_radius;
 	std::map<int, std::vector<DoubleImg::Pointer> > m_probImgs;
 	bool m_uncertaintyTieSolver;
+	//! the probability images, indexed by input index * label count + label
+	std::vector<DoubleImg const *> m_probImgList;
+	std::vector<itk::Offset<TInputImage::ImageDimension>> m_neighborOffsets;
 };
 
 #include "iAUndecidedPixelClassifierImageFilter.hxx"
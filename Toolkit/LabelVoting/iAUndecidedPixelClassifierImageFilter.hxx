@@ -11,10 +11,8 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wshorten-64-to-32"
 #endif
-#include <itkImageRegionIterator.h>
-#include <itkConstNeighborhoodIterator.h>
+#include <itkImageScanlineConstIterator.h>
 #include <itkMath.h>
-#include <itkProgressReporter.h>
 #include <itkStatisticsImageFilter.h>
 #ifdef __clang__
 #pragma clang diagnostic pop
@@ -22,6 +20,10 @@
 
 #include <QString>
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 template< typename TInputImage, typename TOutputImage >
 iAUndecidedPixelClassifierImageFilter< TInputImage, TOutputImage >
 ::iAUndecidedPixelClassifierImageFilter():
@@ -48,13 +50,12 @@ iAUndecidedPixelClassifierImageFilter< TInputImage, TOutputImage >
 ::ComputeMaximumInputValue()
 {
 	InputPixelType maxLabel = 0;
-	itk::ImageRegionConstIterator<TInputImage> it(this->GetInput(0), this->GetInput(0)->GetBufferedRegion());
-	for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+	InputPixelType const* labels = this->GetInput(0)->GetBufferPointer();
+	const std::int64_t pixelCount = static_cast<std::int64_t>(this->GetInput(0)->GetBufferedRegion().GetNumberOfPixels());
+#pragma omp parallel for reduction(max:maxLabel)
+	for (std::int64_t p = 0; p < pixelCount; ++p)
 	{
-		if (it.Get() > maxLabel)
-		{
-			maxLabel = it.Get();
-		}
+		maxLabel = std::max(maxLabel, labels[p]);
 	}
 	return maxLabel;
 }
@@ -73,276 +74,299 @@ iAUndecidedPixelClassifierImageFilter< TInputImage, TOutputImage >
 	typename TOutputImage::Pointer output = this->GetOutput();
 	output->SetBufferedRegion(output->GetRequestedRegion());
 	output->Allocate();
-}
 
-namespace
-{
-	const itk::SizeValueType NoNeighbor = std::numeric_limits<itk::SizeValueType>::max();
+	m_probImgList.clear();
+	if (m_probImgs.size() < 2)
+	{
+		LOG(lvlError, "Expected probability images for at least 2 inputs!");
+		return;
+	}
+	for (size_t i = 0; i < m_probImgs.size(); ++i)
+	{
+		for (size_t l = 0; l < m_labelCount; ++l)
+		{
+			m_probImgList.push_back(m_probImgs[static_cast<int>(i)][l].GetPointer());
+		}
+	}
+	// offsets of all pixels in the neighborhood, in the order of an itk::Neighborhood:
+	itk::SizeValueType neighborCount = 1;
+	for (unsigned int d = 0; d < TInputImage::ImageDimension; ++d)
+	{
+		neighborCount *= 2 * m_radius[d] + 1;
+	}
+	m_neighborOffsets.resize(neighborCount);
+	for (itk::SizeValueType n = 0; n < neighborCount; ++n)
+	{
+		itk::SizeValueType remainder = n;
+		for (unsigned int d = 0; d < TInputImage::ImageDimension; ++d)
+		{
+			m_neighborOffsets[n][d] = static_cast<itk::OffsetValueType>(remainder % (2 * m_radius[d] + 1)) -
+				static_cast<itk::OffsetValueType>(m_radius[d]);
+			remainder /= 2 * m_radius[d] + 1;
+		}
+	}
 }
 
 template< typename TInputImage, typename TOutputImage >
-void iAUndecidedPixelClassifierImageFilter<TInputImage, TOutputImage>::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
-	itk::ThreadIdType threadId)
+void iAUndecidedPixelClassifierImageFilter<TInputImage, TOutputImage>::DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
 {
-	const size_t numberOfClassifiers = m_probImgs.size();
-	if (numberOfClassifiers < 2)
-	{
-		LOG(lvlError, "Expected at least 2 input images!");
-		return;
-	}
-	if (m_probImgs.size() == 0)
+	if (m_probImgList.empty())
 	{
-		LOG(lvlError, "No probability images given!");
 		return;
 	}
-
-	itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
-	
-	typedef itk::ConstNeighborhoodIterator<TInputImage> IntConstNeighborIt;
-	typedef itk::ConstNeighborhoodIterator<DoubleImg>   DblConstNeighborIt;
-
+	// only currently undecided pixels are changed; all others are just copied, line by line:
+	auto input = this->GetInput(0);
 	auto output = this->GetOutput();
-	
-	IntConstNeighborIt it(m_radius, this->GetInput(0), outputRegionForThread);
-	it.GoToBegin();
-	std::vector<std::vector<DblConstNeighborIt> > probIt;
-	for (size_t i = 0; i < numberOfClassifiers; ++i)
+	const size_t lineLength = outputRegionForThread.GetSize(0);
+	itk::ImageScanlineConstIterator<TOutputImage> lineIt(output, outputRegionForThread);
+	for (lineIt.GoToBegin(); !lineIt.IsAtEnd(); lineIt.NextLine())
 	{
-		probIt.push_back(std::vector<DblConstNeighborIt>());
-		for (size_t l = 0; l < m_labelCount; ++l)
+		auto idx = lineIt.GetIndex();
+		InputPixelType const* in = input->GetBufferPointer() + input->ComputeOffset(idx);
+		OutputPixelType* out = output->GetBufferPointer() + output->ComputeOffset(idx);
+		for (size_t x = 0; x < lineLength; ++x)
 		{
-			probIt[i].push_back(DblConstNeighborIt(m_radius, m_probImgs[static_cast<int>(i)][l], outputRegionForThread));
-			probIt[i][l].GoToBegin();
+			if (in[x] == m_undecidedPixelLabel)
+			{
+				idx[0] = lineIt.GetIndex()[0] + static_cast<itk::IndexValueType>(x);
+				out[x] = ClassifyUndecidedPixel(idx);
+			}
+			else
+			{
+				out[x] = in[x];
+			}
 		}
 	}
-	auto out = itk::ImageRegionIterator<TOutputImage>(output, outputRegionForThread);
-	double normalizeFactor = 1.0 / -std::log(1.0 / numberOfClassifiers);
-	for (out.GoToBegin(); !out.IsAtEnd(); ++out)
+}
+
+template< typename TInputImage, typename TOutputImage >
+typename TOutputImage::PixelType iAUndecidedPixelClassifierImageFilter<TInputImage, TOutputImage>::ClassifyUndecidedPixel(
+	typename TInputImage::IndexType const & idx) const
+{
+	// the probability images are accessed directly (instead of via neighborhood iterators),
+	// only for the undecided pixels; all probability images have the same buffered region:
+	const size_t numberOfClassifiers = m_probImgs.size();
+	auto const & probRegion = m_probImgList[0]->GetBufferedRegion();
+	const itk::OffsetValueType centerOffset = m_probImgList[0]->ComputeOffset(idx);
+	auto centerProb = [this, centerOffset](size_t i, size_t l)
 	{
-		if (it.GetCenterPixel() == m_undecidedPixelLabel) // only change currently undecided
-		{
-			std::vector<int> fbgLabelFreq(m_labelCount);
-			std::vector<int> sbgLabelFreq(m_labelCount);
-			std::vector<int> neiLabelFreq(m_labelCount);
-			std::vector<int> fbgLabels(numberOfClassifiers);
-			std::vector<int> neiLabels(numberOfClassifiers);
-			std::vector<double> curUncertainty(numberOfClassifiers);
-			std::vector<double> neiUncertainty(numberOfClassifiers);
+		return m_probImgList[i * m_labelCount + l]->GetBufferPointer()[centerOffset];
+	};
+	std::vector<itk::OffsetValueType> neighborOffsets(m_neighborOffsets.size());
+	std::vector<char> neighborInBounds(m_neighborOffsets.size());
+	for (size_t n = 0; n < m_neighborOffsets.size(); ++n)
+	{
+		auto neighborIdx = idx + m_neighborOffsets[n];
+		neighborInBounds[n] = probRegion.IsInside(neighborIdx);
+		neighborOffsets[n] = neighborInBounds[n] ? m_probImgList[0]->ComputeOffset(neighborIdx) : 0;
+	}
+	double normalizeFactor = 1.0 / -std::log(1.0 / numberOfClassifiers);
+	std::vector<int> fbgLabelFreq(m_labelCount);
+	std::vector<int> sbgLabelFreq(m_labelCount);
+	std::vector<int> neiLabelFreq(m_labelCount);
+	std::vector<int> fbgLabels(numberOfClassifiers);
+	std::vector<int> neiLabels(numberOfClassifiers);
+	std::vector<double> curUncertainty(numberOfClassifiers);
+	std::vector<double> neiUncertainty(numberOfClassifiers);
 
-			// for first/second best set:
-			// for each classifier:
-			//     for each probability:
-			//         if higher than fbg, make new fbg, move fbg to sbg
-			//          else if higher than sbg, make new sbg
-			//     add fbg label to F, add sbg label to S
-			//     (=increase counter for fbg and sbg label in frequency histograms F and S)
+	// for first/second best set:
+	// for each classifier:
+	//     for each probability:
+	//         if higher than fbg, make new fbg, move fbg to sbg
+	//          else if higher than sbg, make new sbg
+	//     add fbg label to F, add sbg label to S
+	//     (=increase counter for fbg and sbg label in frequency histograms F and S)
 
-			for (size_t i = 0; i < numberOfClassifiers; ++i)
+	for (size_t i = 0; i < numberOfClassifiers; ++i)
+	{
+		int fbgLabel = 0, sbgLabel = -1;
+		double entropy = 0.0;
+		for (size_t l = 1; l < m_labelCount; ++l)
+		{
+			double probValue = centerProb(i, l);
+			if (probValue > 0)
 			{
-				int fbgLabel = 0, sbgLabel = -1;
-				double entropy = 0.0;
-				for (size_t l = 1; l < m_labelCount; ++l)
-				{
-					double probValue = probIt[i][l].GetCenterPixel();
-					if (probValue > 0)
-					{
-						entropy += (probValue * std::log(probValue));
-					}
-					if (probValue > probIt[i][fbgLabel].GetCenterPixel())
-					{
-						sbgLabel = fbgLabel;
-						fbgLabel = static_cast<int>(l);
-					}
-					else if (sbgLabel == -1 || probValue > probIt[i][sbgLabel].GetCenterPixel())
-					{
-						sbgLabel = static_cast<int>(l);
-					}
-				}
-				entropy = clamp(0.0, 1.0, -entropy*normalizeFactor);
-				curUncertainty[i] = entropy;
-				fbgLabels[i] = fbgLabel;
-				fbgLabelFreq[fbgLabel]++;
-				sbgLabelFreq[sbgLabel]++;
+				entropy += (probValue * std::log(probValue));
 			}
-
-			// for "best guess of each classifier in neighbourhood":
-			// for each classifier:
-			//     for each neighboring pixel:
-			//         for each probability:
-			//             if highest, make new highest
-			//     add highest label to N
-			std::vector<int> selectedNeighbors;
-			for (size_t i = 0; i < numberOfClassifiers; ++i)
+			if (probValue > centerProb(i, fbgLabel))
 			{
-				double maxProb = 0;
-				int label = -1;
-				itk::SizeValueType selectedNeighbor = NoNeighbor;
-				for (size_t l = 0; l < m_labelCount; ++l)
-				{
-					for (itk::SizeValueType n = 0; n < probIt[i][l].Size(); ++n)
-					{
-						bool isInBounds;
-						double curProb = probIt[i][l].GetPixel(n, isInBounds);
-						if (isInBounds && curProb > maxProb)
-						{
-							maxProb = curProb;
-							label = static_cast<int>(l);
-							selectedNeighbor = n;
-						}
-					}
-				}
-				if (selectedNeighbor == NoNeighbor)
-				{
-					LOG(lvlWarn, "No neighbor found with probability higher than 0!");
-				}
-				double entropy = 0.0;
-				for (size_t l = 0; l < m_labelCount; ++l)
-				{
-					double probValue = probIt[i][l].GetPixel(selectedNeighbor);
-					if (probValue > 0)
-					{
-						entropy += (probValue * std::log(probValue));
-					}
-				}
-				entropy = clamp(0.0, 1.0, -entropy*normalizeFactor);
-				neiLabels[i] = label;
-				neiUncertainty[i] = entropy;
-				++neiLabelFreq[label];
+				sbgLabel = fbgLabel;
+				fbgLabel = static_cast<int>(l);
 			}
-
-			// now we have F, S, N -> build list of candidates (up to 3):
-			//     label(s) appearing first and second most often in F
-			//     label appearing most often in N
-			int fgCand = 0, sgCand = -1;
-			for (size_t l = 1; l < m_labelCount; ++l)
+			else if (sbgLabel == -1 || probValue > centerProb(i, sbgLabel))
 			{
-				// what if another label has the same frequency?
-				if (fbgLabelFreq[l] > fbgLabelFreq[fgCand])
-				{
-					sgCand = fgCand;
-					fgCand = static_cast<int>(l);
-				}
-				else if ((sgCand == -1 && fbgLabelFreq[l] > 0) || (sgCand != -1 && fbgLabelFreq[l] > fbgLabelFreq[sgCand]))
-				{
-					sgCand = static_cast<int>(l);
-				}
-			}
-			std::vector<int> candidateLabels;
-			candidateLabels.push_back(fgCand);
-			if (sgCand != -1)
-			{
-				candidateLabels.push_back(sgCand);
+				sbgLabel = static_cast<int>(l);
 			}
+		}
+		entropy = clamp(0.0, 1.0, -entropy*normalizeFactor);
+		curUncertainty[i] = entropy;
+		fbgLabels[i] = fbgLabel;
+		fbgLabelFreq[fbgLabel]++;
+		sbgLabelFreq[sbgLabel]++;
+	}
 
-			int neCand = 0;
-			for (size_t l = 1; l < m_labelCount; ++l)
+	// for "best guess of each classifier in neighbourhood":
+	// for each classifier:
+	//     for each neighboring pixel:
+	//         for each probability:
+	//             if highest, make new highest
+	//     add highest label to N
+	for (size_t i = 0; i < numberOfClassifiers; ++i)
+	{
+		double maxProb = 0;
+		int label = -1;
+		itk::OffsetValueType selectedNeighbor = 0;
+		for (size_t l = 0; l < m_labelCount; ++l)
+		{
+			double const* probValues = m_probImgList[i * m_labelCount + l]->GetBufferPointer();
+			for (size_t n = 0; n < m_neighborOffsets.size(); ++n)
 			{
-				// what if another label has the same frequency?
-				if (neiLabelFreq[l] > neiLabelFreq[neCand])
+				if (neighborInBounds[n] && probValues[neighborOffsets[n]] > maxProb)
 				{
-					neCand = static_cast<int>(l);
+					maxProb = probValues[neighborOffsets[n]];
+					label = static_cast<int>(l);
+					selectedNeighbor = neighborOffsets[n];
 				}
 			}
-			if (std::find(candidateLabels.begin(), candidateLabels.end(), neCand) == candidateLabels.end())
+		}
+		if (label == -1)
+		{
+			LOG(lvlWarn, "No neighbor found with probability higher than 0!");
+			label = fbgLabels[i];
+			selectedNeighbor = centerOffset;
+		}
+		double entropy = 0.0;
+		for (size_t l = 0; l < m_labelCount; ++l)
+		{
+			double probValue = m_probImgList[i * m_labelCount + l]->GetBufferPointer()[selectedNeighbor];
+			if (probValue > 0)
 			{
-				candidateLabels.push_back(neCand);
+				entropy += (probValue * std::log(probValue));
 			}
+		}
+		entropy = clamp(0.0, 1.0, -entropy*normalizeFactor);
+		neiLabels[i] = label;
+		neiUncertainty[i] = entropy;
+		++neiLabelFreq[label];
+	}
+
+	// now we have F, S, N -> build list of candidates (up to 3):
+	//     label(s) appearing first and second most often in F
+	//     label appearing most often in N
+	int fgCand = 0, sgCand = -1;
+	for (size_t l = 1; l < m_labelCount; ++l)
+	{
+		// what if another label has the same frequency?
+		if (fbgLabelFreq[l] > fbgLabelFreq[fgCand])
+		{
+			sgCand = fgCand;
+			fgCand = static_cast<int>(l);
+		}
+		else if ((sgCand == -1 && fbgLabelFreq[l] > 0) || (sgCand != -1 && fbgLabelFreq[l] > fbgLabelFreq[sgCand]))
+		{
+			sgCand = static_cast<int>(l);
+		}
+	}
+	std::vector<int> candidateLabels;
+	candidateLabels.push_back(fgCand);
+	if (sgCand != -1)
+	{
+		candidateLabels.push_back(sgCand);
+	}
 
-			// out of these candidates, choose the one that:
-			//     appears most often both in FSN and FN
-			//     AND has the lowest average uncertainty		-> ignore at the moment
-			int maxFSNCount = 0; int maxFSNLabel = -1;
-			int maxFNCount = 0;  int maxFNLabel = -1;
-			for (int l : candidateLabels)
+	int neCand = 0;
+	for (size_t l = 1; l < m_labelCount; ++l)
+	{
+		// what if another label has the same frequency?
+		if (neiLabelFreq[l] > neiLabelFreq[neCand])
+		{
+			neCand = static_cast<int>(l);
+		}
+	}
+	if (std::find(candidateLabels.begin(), candidateLabels.end(), neCand) == candidateLabels.end())
+	{
+		candidateLabels.push_back(neCand);
+	}
+
+	// out of these candidates, choose the one that:
+	//     appears most often both in FSN and FN
+	//     AND has the lowest average uncertainty		-> ignore at the moment
+	int maxFSNCount = 0; int maxFSNLabel = -1;
+	int maxFNCount = 0;  int maxFNLabel = -1;
+	for (int l : candidateLabels)
+	{
+		int fsnCount = fbgLabelFreq[l] + sbgLabelFreq[l] + neiLabelFreq[l];
+		int fnCount = fbgLabelFreq[l] + neiLabelFreq[l];
+		/*
+		double uncertaintySum;
+		for (size_t i = 0; i < numberOfInputFiles; ++i)
+		{
+			double entropy = 0.0;
+			for (unsigned int l = 0; l < m_LabelCount; ++l)
 			{
-				int fsnCount = fbgLabelFreq[l] + sbgLabelFreq[l] + neiLabelFreq[l];
-				int fnCount = fbgLabelFreq[l] + neiLabelFreq[l];
-				/*
-				double uncertaintySum;
-				for (size_t i = 0; i < numberOfInputFiles; ++i)
-				{
-					double entropy = 0.0;
-					for (unsigned int l = 0; l < m_LabelCount; ++l)
-					{
 
-					}
-				}
-				*/
-				if (fsnCount > maxFSNCount)
-				{
-					maxFSNCount = fsnCount; maxFSNLabel = l;
-				}
-				if (fnCount > maxFNCount)
-				{
-					maxFNCount = fnCount; maxFNLabel = l;
-				}
 			}
-			if (maxFNLabel != maxFSNLabel && m_uncertaintyTieSolver)
+		}
+		*/
+		if (fsnCount > maxFSNCount)
+		{
+			maxFSNCount = fsnCount; maxFSNLabel = l;
+		}
+		if (fnCount > maxFNCount)
+		{
+			maxFNCount = fnCount; maxFNLabel = l;
+		}
+	}
+	if (maxFNLabel != maxFSNLabel && m_uncertaintyTieSolver)
+	{
+		std::vector<double> candLabelUncertaintySum(candidateLabels.size());
+		std::vector<int> candLabelUncertaintyCnt(candidateLabels.size());
+		std::fill(candLabelUncertaintySum.begin(), candLabelUncertaintySum.end(), 0);
+		std::fill(candLabelUncertaintyCnt.begin(), candLabelUncertaintyCnt.end(), 0);
+		for (size_t i = 0; i < numberOfClassifiers; ++i)
+		{
+			for (size_t c = 0; c < candidateLabels.size(); ++c)
 			{
-				std::vector<double> candLabelUncertaintySum(candidateLabels.size());
-				std::vector<int> candLabelUncertaintyCnt(candidateLabels.size());
-				std::fill(candLabelUncertaintySum.begin(), candLabelUncertaintySum.end(), 0);
-				std::fill(candLabelUncertaintyCnt.begin(), candLabelUncertaintyCnt.end(), 0);
-				for (size_t i = 0; i < numberOfClassifiers; ++i)
+				if (fbgLabels[i] == candidateLabels[c])
 				{
-					for (size_t c = 0; c < candidateLabels.size(); ++c)
-					{
-						if (fbgLabels[i] == candidateLabels[c])
-						{
-							candLabelUncertaintySum[c] += curUncertainty[i];
-							++candLabelUncertaintyCnt[c];
-						}
-						if (neiLabels[i] == candidateLabels[c])
-						{
-							candLabelUncertaintySum[c] += neiUncertainty[i];
-							++candLabelUncertaintyCnt[c];
-						}
-					}
+					candLabelUncertaintySum[c] += curUncertainty[i];
+					++candLabelUncertaintyCnt[c];
 				}
-				double minUncertainty = 1;
-				int finalLabel = -1;
-				for (size_t c = 0; c < candidateLabels.size(); ++c)
+				if (neiLabels[i] == candidateLabels[c])
 				{
-					double uncertainty = candLabelUncertaintySum[c] / candLabelUncertaintyCnt[c];
-					if (uncertainty < minUncertainty)
-					{
-						minUncertainty = uncertainty;
-						finalLabel = candidateLabels[c];
-					}
+					candLabelUncertaintySum[c] += neiUncertainty[i];
+					++candLabelUncertaintyCnt[c];
 				}
-				/*
-				LOG(lvlInfo, QString("Ambiguous result in pixel (%1): candidates=%2, prob.=%3, final label=%4")
-					.arg(QString("%1, %2, %3")
-						.arg(it.GetIndex()[0])
-						.arg(it.GetIndex()[1])
-						.arg(it.GetIndex()[2]))
-					.arg(QString("%1, %2, %3")
-						.arg(candidateLabels[0])
-						.arg(candidateLabels[1])
-						.arg(candidateLabels.size() > 2 ? candidateLabels[2] : -1))
-					.arg(QString("%1, %2, %3")
-						.arg(candLabelUncertaintySum[0] / candLabelUncertaintyCnt[0])
-						.arg(candLabelUncertaintySum[1] / candLabelUncertaintyCnt[1])
-						.arg(candidateLabels.size() > 2 ? candLabelUncertaintySum[2] / candLabelUncertaintyCnt[2] : 0))
-					.arg(finalLabel));
-				*/
-				maxFSNLabel = finalLabel;
 			}
-			out.Set(maxFSNLabel);
 		}
-		else
-		{
-			out.Set(it.GetCenterPixel());
-		}
-		// advance to next pixel in input:
-		++it;
-		for (size_t i = 0; i < numberOfClassifiers; ++i)
+		double minUncertainty = 1;
+		int finalLabel = -1;
+		for (size_t c = 0; c < candidateLabels.size(); ++c)
 		{
-			for (size_t l = 0; l < m_labelCount; ++l)
+			double uncertainty = candLabelUncertaintySum[c] / candLabelUncertaintyCnt[c];
+			if (uncertainty < minUncertainty)
 			{
-				++(probIt[i][l]);
+				minUncertainty = uncertainty;
+				finalLabel = candidateLabels[c];
 			}
 		}
-		progress.CompletedPixel();
+		/*
+		LOG(lvlInfo, QString("Ambiguous result in pixel (%1): candidates=%2, prob.=%3, final label=%4")
+			.arg(QString("%1, %2, %3")
+				.arg(idx[0])
+				.arg(idx[1])
+				.arg(idx[2]))
+			.arg(QString("%1, %2, %3")
+				.arg(candidateLabels[0])
+				.arg(candidateLabels[1])
+				.arg(candidateLabels.size() > 2 ? candidateLabels[2] : -1))
+			.arg(QString("%1, %2, %3")
+				.arg(candLabelUncertaintySum[0] / candLabelUncertaintyCnt[0])
+				.arg(candLabelUncertaintySum[1] / candLabelUncertaintyCnt[1])
+				.arg(candidateLabels.size() > 2 ? candLabelUncertaintySum[2] / candLabelUncertaintyCnt[2] : 0))
+			.arg(finalLabel));
+		*/
+		maxFSNLabel = finalLabel;
 	}
+	return maxFSNLabel;
 }
@@ -17,6 +17,7 @@ message(STATUS "CMake: ${CMAKE_VERSION}")
 # CTest
 #-------------------------
 option(openiA_TESTING_ENABLED "Whether to enable testing. This allows to run CTest/ CDash builds. Default: disabled." OFF)
+option(openiA_BENCHMARK_ENABLED "Whether to build the filter benchmark tool (open_iA_bench), which measures filter performance on synthetic images. Default: disabled." OFF)
 if (openiA_TESTING_ENABLED)
 
 	set(TEST_DATA_DIR "${TEST_DIR}/data")
@@ -247,7 +248,7 @@ set(VTK_COMPONENTS
 	FiltersGeometry             # for vtkDataSetSurfaceFilter used in ExtractSurface - iAExtractSurfaceFilter
 	FiltersHybrid               # for vtkDepthSortPolyData used in 4DCT, DreamCaster, FeatureScout, vtkPolyDataSilhouette used in FeatureScout
 	FiltersModeling             # for vtkRotationalExtrusionFilter, vtkOutlineFilter
-	FiltersStatistics           # for vtkPCAStatistics used in BoneThickness - iABoneThickness
+	FiltersStatistics           # for vtkComputeQuartiles, vtkCorrelativeStatistics used in CompVis
 	GUISupportQt                # for QVTKOpenGLNativeWidget
 	ImagingHybrid               # for vtkSampleFunction used in FeatureScout - iABlobCluster
 	InfovisLayout               # for vtkGraphLayoutStrategy used in CompVis
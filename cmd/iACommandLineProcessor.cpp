@@ -2,6 +2,9 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iACommandLineProcessor.h"
 
+#include "iACommandServer.h"
+#include "iALoadedDataSetCache.h"
+
 #include "iAFilter.h"
 #include "iAFilterRegistry.h"
 #include "iALoggerStdOut.h"
@@ -15,6 +18,7 @@
 #include "iAModuleDispatcher.h"
 #include "iAProgress.h"
 #include "iAStringHelper.h"
+#include "iATrace.h"
 #include "iAValueType.h"
 
 #include <QFileInfo>
@@ -258,7 +262,7 @@ namespace
 			<< "         List available filters, sorted by name (default) or by category\n"
 			<< "     help FilterName\n"
 			<< "         Print help on a specific filter\n"
-			<< "     run FilterName -i Input -o Output -p Parameters [-q] [-c] [-f] [-s n] [-j InParams] [-k OutParams]\n"
+			<< "     run FilterName -i Input -o Output -p Parameters [-q] [-c] [-f] [-s n] [-j InParams] [-k OutParams] [-t TraceFile]\n"
 			<< "         Run the filter given by FilterName with Parameters on given Input, write to Output\n"
 			<< "           -i   the list of input filenames. If a filename contains one or more spaces, it needs\n"
 			<< "                to be quoted, e.g. \"my input file.mhd\"\n"
@@ -297,6 +301,9 @@ namespace
 			<< "                You can check whether a file format requires input parameters through the\n"
 			<< "                'formatinfo' command (see below).\n"
 			<< "                The parameters need to be specified analogously to the -p option, see notes there.\n"
+			<< "           -t TraceFile record the time spent in loading, filtering and saving, and write it to\n"
+			<< "                the given file in Chrome trace event format (e.g. for viewing in https://ui.perfetto.dev);\n"
+			<< "                unless -q is given, a summary per operation is printed as well.\n"
 			<< "         Note: Only image and mesh output is written to the filename(s) specified after -o,\n"
 			<< "           filters returning one or more output values write those values to the command line.\n"
 			<< "     parameters FilterName\n"
@@ -305,10 +312,21 @@ namespace
 			<< "         Output information on which parameters a file format with the given extension\n"
 			<< "         (can be specified with or without leading '.') has for loading/saving.\n"
 			<< "     formats\n"
-			<< "         List available file formats for loading and saving files.\n";
+			<< "         List available file formats for loading and saving files.\n"
+			<< "     server [-n Name] [-c n]\n"
+			<< "         Keep running and execute the commands sent via 'client' (see below). This avoids\n"
+			<< "         loading all modules and, optionally, the input files again for each command.\n"
+			<< "           -n   the name of the local socket to listen on (default: " << DefaultCommandServerName.toStdString() << ")\n"
+			<< "           -c n keep the n most recently loaded input datasets in memory (default: 0).\n"
+			<< "                Datasets are re-loaded if the file was modified in the meantime.\n"
+			<< "     client [-n Name] command [options]\n"
+			<< "         Send the given command (any of the above, e.g. 'run FilterName -i ...') to a running\n"
+			<< "         server. Relative file names are resolved against the current directory of the client.\n"
+			<< "           -n   the name of the local socket the server listens on (default: " << DefaultCommandServerName.toStdString() << ")\n"
+			<< "         Use 'client shutdown' to stop the server.\n";
 	}
 
-	enum iAParseMode { None, Input, Output, Parameter, InvalidParameter, Quiet, Overwrite, InputSeparation, LogLevel, InputParameters, OutputParameters };
+	enum iAParseMode { None, Input, Output, Parameter, InvalidParameter, Quiet, Overwrite, InputSeparation, LogLevel, InputParameters, OutputParameters, TraceFile };
 
 	iAParseMode getMode(QString arg)
 	{
@@ -321,6 +339,7 @@ namespace
 		else if (arg == "-v") return LogLevel;
 		else if (arg == "-k") return OutputParameters;
 		else if (arg == "-j") return InputParameters;
+		else if (arg == "-t") return TraceFile;
 		else return InvalidParameter;
 	}
 
@@ -385,7 +404,40 @@ namespace
 		return true;
 	}
 
-	int runFilter(QStringList const & args)
+	//! records trace spans (see iATrace) while in scope, and writes them to a file on destruction
+	class iATraceRecorder
+	{
+	public:
+		iATraceRecorder(QString const& fileName, bool quiet) : m_fileName(fileName), m_quiet(quiet)
+		{
+			if (!m_fileName.isEmpty())
+			{
+				iATrace::clear();
+				iATrace::setEnabled(true);
+			}
+		}
+		~iATraceRecorder()
+		{
+			if (m_fileName.isEmpty())
+			{
+				return;
+			}
+			iATrace::setEnabled(false);
+			if (!iATrace::writeChromeTrace(m_fileName))
+			{
+				std::cout << QString("ERROR: Could not write trace file '%1'!\n").arg(m_fileName).toStdString();
+			}
+			if (!m_quiet)
+			{
+				std::cout << iATrace::summaryTable().toStdString();
+			}
+		}
+	private:
+		QString m_fileName;
+		bool m_quiet;
+	};
+
+	int runFilter(QStringList const & args, iALoadedDataSetCache* cache)
 	{
 		QString filterName = args[0];
 		auto filter = iAFilterRegistry::filter(filterName);
@@ -402,6 +454,7 @@ namespace
 		QVector<QVariantMap> outParams;
 		bool quiet = false;
 		bool overwrite = false;
+		QString traceFileName;
 		int mode = None;
 		qsizetype curInIdx = 0;
 		qsizetype curOutIdx = 0;
@@ -431,6 +484,10 @@ namespace
 				mode = None;
 				break;
 			}
+			case TraceFile:
+				traceFileName = args[a];
+				mode = None;
+				break;
 			case LogLevel:
 			{
 				bool ok;
@@ -563,6 +620,7 @@ namespace
 			return 1;
 		}
 
+		iATraceRecorder traceRecorder(traceFileName, quiet);
 		try
 		{
 			for (int i = 0; i < inputFiles.size(); ++i)
@@ -579,7 +637,7 @@ namespace
 					return 1;
 				}
 				// TODO: use progress indicator
-				auto dataSet = io->load(inputFiles[i], inParams[i]);
+				auto dataSet = cache ? cache->load(inputFiles[i], inParams[i]) : io->load(inputFiles[i], inParams[i]);
 				if (!dataSet)
 				{
 					std::cout << QString("ERROR: Could not load file %1!\n").arg(inputFiles[i]).toStdString();
@@ -664,36 +722,30 @@ namespace
 	}
 }
 
-int processCommandLine(int argc, char const * const * argv, const char * version)
+int executeCommand(QStringList const& args, const char* version, iALoadedDataSetCache* cache)
 {
-	auto dispatcher = new iAModuleDispatcher(QFileInfo(argv[0]).absolutePath());
-	dispatcher->InitializeModules();
-	if (argc > 1 && QString(argv[1]).toLower() == "list")
+	QString command = args.isEmpty() ? QString() : args[0].toLower();
+	if (args.size() > 0 && command == "list")
 	{
-		printListOfAvailableFilters(argc > 2 ? QString(argv[2]) : QString("name") );
+		printListOfAvailableFilters(args.size() > 1 ? args[1] : QString("name") );
 	}
-	else if (argc > 2 && QString(argv[1]).toLower() == "help")
+	else if (args.size() > 1 && command == "help")
 	{
-		printFilterHelp(argv[2]);
+		printFilterHelp(args[1]);
 	}
-	else if (argc > 2 && QString(argv[1]).toLower() == "run")
+	else if (args.size() > 1 && command == "run")
 	{
-		QStringList args;
-		for (int a = 2; a < argc; ++a)
-		{
-			args << argv[a];
-		}
-		return runFilter(args);
+		return runFilter(args.mid(1), cache);
 	}
-	else if (argc > 2 && QString(argv[1]).toLower() == "parameters")
+	else if (args.size() > 1 && command == "parameters")
 	{
-		printParameterDescriptor(argv[2]);
+		printParameterDescriptor(args[1]);
 	}
-	else if (argc > 2 && QString(argv[1]).toLower() == "formatinfo")
+	else if (args.size() > 1 && command == "formatinfo")
 	{
-		printFormatInfo(argv[2]);
+		printFormatInfo(args[1]);
 	}
-	else if (argc > 1 && QString(argv[1]).toLower() == "formats")
+	else if (args.size() > 0 && command == "formats")
 	{
 		printFormats();
 	}
@@ -703,3 +755,24 @@ int processCommandLine(int argc, char const * const * argv, const char * version
 	}
 	return 0;
 }
+
+int processCommandLine(int argc, char const * const * argv, const char * version)
+{
+	QStringList args;
+	for (int a = 1; a < argc; ++a)
+	{
+		args << argv[a];
+	}
+	// the client only forwards the command to a running server, so it doesn't need to load any modules:
+	if (args.size() > 0 && args[0].toLower() == "client")
+	{
+		return runCommandClient(args.mid(1));
+	}
+	auto dispatcher = new iAModuleDispatcher(QFileInfo(argv[0]).absolutePath());
+	dispatcher->InitializeModules();
+	if (args.size() > 0 && args[0].toLower() == "server")
+	{
+		return runCommandServer(args.mid(1), version);
+	}
+	return executeCommand(args, version, nullptr);
+}
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <QObject>
+#include <QStringList>
 
 //! A progress indicator for the command line, printing to standard out.
 //! Prints end markers and dots marking the current progress, such as:
@@ -22,4 +23,12 @@ private:
 	bool m_quiet;
 };
 
+class iALoadedDataSetCache;
+
+//! Process the command line passed to open_iA_cmd.
 int processCommandLine(int argc, char const * const * argv, const char * version);
+
+//! Execute a single command (list, help, run, ...) given by the arguments
+//! (without the program name); modules need to be loaded already.
+//! @param cache if not nullptr, input datasets are loaded through (and kept in) this cache
+int executeCommand(QStringList const& args, const char* version, iALoadedDataSetCache* cache);
@@ -0,0 +1,245 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iACommandServer.h"
+
+#include "iACommandLineProcessor.h"
+#include "iALoadedDataSetCache.h"
+
+#include "iALog.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+const QString DefaultCommandServerName("open_iA_cmd");
+
+namespace
+{
+	const int ConnectTimeoutMS = 5000;
+	const int ReadTimeoutMS = 30000;
+	const QString ShutdownCommand("shutdown");
+	const QString CacheStatsCommand("cachestats");
+
+	//! Read a complete message consisting of the given values from the socket (blocking).
+	template <typename... T>
+	bool readMessage(QLocalSocket& socket, int timeout, T&... values)
+	{
+		QDataStream in(&socket);
+		in.setVersion(QDataStream::Qt_6_0);
+		while (true)
+		{
+			in.startTransaction();
+			(in >> ... >> values);
+			if (in.commitTransaction())
+			{
+				return true;
+			}
+			if (!socket.waitForReadyRead(timeout))
+			{
+				return false;
+			}
+		}
+	}
+
+	//! Write a message consisting of the given values to the socket (blocking).
+	template <typename... T>
+	bool writeMessage(QLocalSocket& socket, T const&... values)
+	{
+		QDataStream out(&socket);
+		out.setVersion(QDataStream::Qt_6_0);
+		(out << ... << values);
+		while (socket.bytesToWrite() > 0)
+		{
+			if (!socket.waitForBytesWritten(ReadTimeoutMS))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//! Redirects std::cout into a string buffer for the lifetime of this object.
+	class iACoutCapture
+	{
+	public:
+		iACoutCapture() : m_oldBuf(std::cout.rdbuf(m_buffer.rdbuf()))
+		{}
+		~iACoutCapture()
+		{
+			std::cout.rdbuf(m_oldBuf);
+		}
+		QString text() const
+		{
+			return QString::fromStdString(m_buffer.str());
+		}
+	private:
+		std::ostringstream m_buffer;
+		std::streambuf* m_oldBuf;
+	};
+
+	//! Parses the optional "-n name" at the start of the given arguments, removes it from args.
+	QString parseServerName(QStringList& args)
+	{
+		if (args.size() > 1 && args[0] == "-n")
+		{
+			auto name = args[1];
+			args.remove(0, 2);
+			return name;
+		}
+		return DefaultCommandServerName;
+	}
+}
+
+int runCommandServer(QStringList const& args, char const* version)
+{
+	QString serverName = DefaultCommandServerName;
+	size_t cacheSize = 0;
+	for (qsizetype a = 0; a < args.size(); ++a)
+	{
+		if (args[a] == "-n" && a + 1 < args.size())
+		{
+			serverName = args[++a];
+		}
+		else if (args[a] == "-c" && a + 1 < args.size())
+		{
+			bool ok;
+			int size = args[++a].toInt(&ok);
+			if (!ok || size < 0)
+			{
+				std::cout << "ERROR: Invalid value '" << args[a].toStdString()
+					<< "' for cache size, expected an integer number >= 0!\n";
+				return 1;
+			}
+			cacheSize = static_cast<size_t>(size);
+		}
+		else
+		{
+			std::cout << QString("ERROR: Invalid/Unexpected server parameter: '%1', please check your syntax!\n")
+				.arg(args[a]).toStdString();
+			return 1;
+		}
+	}
+	{   // only remove an existing socket if no server answers on it (i.e., it was left behind by a crashed server)
+		QLocalSocket probe;
+		probe.connectToServer(serverName);
+		if (probe.waitForConnected(ConnectTimeoutMS))
+		{
+			probe.disconnectFromServer();
+			std::cout << QString("ERROR: A server is already running on '%1'!\n").arg(serverName).toStdString();
+			return 1;
+		}
+	}
+	QLocalServer::removeServer(serverName);
+	QLocalServer server;
+	server.setSocketOptions(QLocalServer::UserAccessOption);
+	if (!server.listen(serverName))
+	{
+		std::cout << QString("ERROR: Could not listen on '%1': %2\n")
+			.arg(serverName).arg(server.errorString()).toStdString();
+		return 1;
+	}
+	std::cout << QString("Server listening on '%1', caching up to %2 datasets. Stop it via 'open_iA_cmd client%3 %4'.\n")
+		.arg(server.fullServerName()).arg(cacheSize)
+		.arg(serverName == DefaultCommandServerName ? "" : " -n " + serverName)
+		.arg(ShutdownCommand).toStdString() << std::flush;
+	iALoadedDataSetCache cache(cacheSize);
+	auto logLevel = iALog::get()->logLevel();
+	bool running = true;
+	while (running)
+	{
+		if (!server.waitForNewConnection(-1))
+		{
+			std::cout << QString("ERROR: Waiting for connection failed: %1\n").arg(server.errorString()).toStdString();
+			return 1;
+		}
+		std::unique_ptr<QLocalSocket> socket(server.nextPendingConnection());
+		if (!socket)
+		{
+			continue;
+		}
+		QString workDir;
+		QStringList cmdArgs;
+		if (!readMessage(*socket, ReadTimeoutMS, workDir, cmdArgs))
+		{
+			// connections closed without sending a command (e.g., a second server checking whether this one is running) are expected
+			if (socket->state() == QLocalSocket::ConnectedState || socket->bytesAvailable() > 0)
+			{
+				std::cout << "WARNING: Could not read command from client, ignoring connection.\n" << std::flush;
+			}
+			continue;
+		}
+		qint32 result = 0;
+		QString output;
+		if (cmdArgs.size() == 1 && cmdArgs[0].toLower() == ShutdownCommand)
+		{
+			running = false;
+			output = "Server shutting down.\n";
+		}
+		else if (cmdArgs.size() == 1 && cmdArgs[0].toLower() == CacheStatsCommand)
+		{
+			output = QString("Cached datasets: %1; hits: %2; misses: %3\n")
+				.arg(cache.size()).arg(cache.hits()).arg(cache.misses());
+		}
+		else
+		{
+			auto prevDir = QDir::currentPath();
+			QDir::setCurrent(workDir);
+			{
+				iACoutCapture capture;
+				result = executeCommand(cmdArgs, version, &cache);
+				std::cout << std::flush;
+				output = capture.text();
+			}
+			QDir::setCurrent(prevDir);
+			iALog::get()->setLogLevel(logLevel);   // a -v option should only affect the command it was given for
+		}
+		if (!writeMessage(*socket, result, output))
+		{
+			std::cout << "WARNING: Could not send result to client.\n" << std::flush;
+		}
+		socket->disconnectFromServer();
+		if (socket->state() != QLocalSocket::UnconnectedState)
+		{
+			socket->waitForDisconnected(ConnectTimeoutMS);
+		}
+	}
+	return 0;
+}
+
+int runCommandClient(QStringList const& args)
+{
+	QStringList cmdArgs(args);
+	auto serverName = parseServerName(cmdArgs);
+	if (cmdArgs.isEmpty())
+	{
+		std::cout << "ERROR: No command given to send to the server!\n";
+		return 1;
+	}
+	QLocalSocket socket;
+	socket.connectToServer(serverName);
+	if (!socket.waitForConnected(ConnectTimeoutMS))
+	{
+		std::cout << QString("ERROR: Could not connect to server '%1': %2\n")
+			.arg(serverName).arg(socket.errorString()).toStdString();
+		return 1;
+	}
+	if (!writeMessage(socket, QDir::currentPath(), cmdArgs))
+	{
+		std::cout << QString("ERROR: Could not send command to server: %1\n").arg(socket.errorString()).toStdString();
+		return 1;
+	}
+	qint32 result = 1;
+	QString output;
+	if (!readMessage(socket, -1, result, output))   // no timeout - filters might run for a long time
+	{
+		std::cout << QString("ERROR: Could not read result from server: %1\n").arg(socket.errorString()).toStdString();
+		return 1;
+	}
+	std::cout << output.toStdString() << std::flush;
+	return result;
+}
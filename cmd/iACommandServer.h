@@ -0,0 +1,24 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+//! Name of the local socket (Unix domain socket / Windows named pipe) used if none is specified.
+extern const QString DefaultCommandServerName;
+
+//! Runs open_iA_cmd as a server, which executes commands received from clients (see runCommandClient)
+//! until it receives a "shutdown" command. Modules stay loaded between commands, and optionally,
+//! recently loaded input datasets are kept in memory as well.
+//! Commands are executed one after the other, in the order they are received.
+//! @param args the server options (see usage: -n socket name, -c number of cached datasets)
+//! @param version the open_iA version string (for printing usage)
+//! @return 0 if the server was shut down regularly, 1 if it could not be started
+int runCommandServer(QStringList const& args, char const* version);
+
+//! Sends a command to a running open_iA_cmd server, waits for its completion and prints its output.
+//! @param args the command and its options, same as for direct open_iA_cmd invocation;
+//!     optionally preceded by -n and the name of the server socket
+//! @return the result of the command (0 on success), or 1 if the server could not be reached
+int runCommandClient(QStringList const& args);
@@ -0,0 +1,377 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iALoggerStdOut.h"
+#include "iASyntheticImage.h"
+
+#include "iAAttributeDescriptor.h"
+#include "iAAttributes.h"
+#include "iAFilter.h"
+#include "iAFilterRegistry.h"
+#include "iAImageData.h"
+#include "iALog.h"
+#include "iAModuleDispatcher.h"
+#include "iAPerformanceHelper.h"    // for getCurrentRSS / getCurrentPeakRSS
+#include "iASCIFIOCheck.h"
+#include "version.h"
+
+#include <itkMultiThreaderBase.h>
+
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkSMPTools.h>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <numeric>
+#include <thread>
+
+namespace
+{
+	struct iABenchmarkFilter
+	{
+		QString name;
+		QVariantMap parameters;    //!< values overriding the filter's default parameters
+	};
+
+	struct iABenchmarkConfig
+	{
+		std::vector<iABenchmarkFilter> filters;
+		bool allFilters = false;
+		QStringList kinds = QStringList() << "noise";
+		QStringList types = QStringList() << "ushort";
+		std::vector<int> sizes = { 128 };
+		std::vector<int> threads = { 0 };
+		int repetitions = 3;
+		int warmup = 1;
+		int objectCount = 100;
+		unsigned int seed = 42;
+		QString outFileName;
+	};
+
+	const QMap<QString, int>& benchmarkTypes()
+	{
+		static const QMap<QString, int> types{
+			{"uchar", VTK_UNSIGNED_CHAR}, {"char", VTK_CHAR}, {"ushort", VTK_UNSIGNED_SHORT}, {"short", VTK_SHORT},
+			{"uint", VTK_UNSIGNED_INT}, {"int", VTK_INT}, {"float", VTK_FLOAT}, {"double", VTK_DOUBLE} };
+		return types;
+	}
+
+	void printUsage()
+	{
+		std::cout << "open_iA filter benchmark, version " << Open_iA_Version << ".\n"
+			<< "Runs filters repeatedly on synthetic images and reports timing and memory statistics as JSON.\n"
+			<< "Usage:\n"
+			<< "  > open_iA_bench (-f FilterName [-p name=value ...] ... | -a) [options]\n"
+			<< "Options:\n"
+			<< "  -f FilterName  benchmark the given filter (can be given multiple times)\n"
+			<< "  -p name=value  set the parameter of the previously given filter (can be given multiple times);\n"
+			<< "                 parameters not specified are set to their default values\n"
+			<< "  -a             benchmark all filters taking one input image, with default parameters\n"
+			<< "  -d kinds       comma-separated list of synthetic image kinds; available: "
+			                   << syntheticImageKindNames().join(", ").toStdString() << " (default: noise)\n"
+			<< "  -t types       comma-separated list of voxel data types; available: "
+			                   << benchmarkTypes().keys().join(", ").toStdString() << " (default: ushort)\n"
+			<< "  -s sizes       comma-separated list of image sizes; either a single number n for a cubic\n"
+			<< "                 n x n x n image, or XxYxZ (default: 128)\n"
+			<< "  -j threads     comma-separated list of thread counts to run with, 0 means the number\n"
+			<< "                 of available cores (default: 0)\n"
+			<< "  -r n           number of measured repetitions per configuration (default: 3)\n"
+			<< "  -w n           number of unmeasured warm-up runs per configuration (default: 1)\n"
+			<< "  -n n           number of objects in spheres/fibers images (default: 100)\n"
+			<< "  -e seed        seed for the synthetic image generation (default: 42)\n"
+			<< "  -o file        write the JSON result to the given file instead of standard output\n"
+			<< "                 (recommended, since log output of the filters also goes to standard output)\n";
+	}
+
+	bool parseIntList(QString const& str, std::vector<int>& out, int minValue)
+	{
+		out.clear();
+		for (auto s : str.split(",", Qt::SkipEmptyParts))
+		{
+			bool ok;
+			int v = s.trimmed().toInt(&ok);
+			if (!ok || v < minValue)
+			{
+				return false;
+			}
+			out.push_back(v);
+		}
+		return !out.empty();
+	}
+
+	bool parseSize(QString const& str, int dim[3])
+	{
+		auto parts = str.split("x");
+		if (parts.size() != 1 && parts.size() != 3)
+		{
+			return false;
+		}
+		for (int i = 0; i < 3; ++i)
+		{
+			bool ok;
+			dim[i] = parts[parts.size() == 1 ? 0 : i].toInt(&ok);
+			if (!ok || dim[i] < 1)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool parseArgs(int argc, char* argv[], iABenchmarkConfig& cfg, std::vector<std::array<int, 3>>& sizes)
+	{
+		QStringList sizeStrings("128");
+		for (int a = 1; a < argc; ++a)
+		{
+			QString arg(argv[a]);
+			if (arg == "-a")
+			{
+				cfg.allFilters = true;
+				continue;
+			}
+			if (a + 1 >= argc)
+			{
+				std::cout << "ERROR: Missing value for option " << arg.toStdString() << "!\n";
+				return false;
+			}
+			QString value(argv[++a]);
+			bool ok = true;
+			if (arg == "-f")      { cfg.filters.push_back(iABenchmarkFilter{ value, QVariantMap() }); }
+			else if (arg == "-p")
+			{
+				auto eqPos = value.indexOf("=");
+				ok = !cfg.filters.empty() && eqPos > 0;
+				if (ok)
+				{
+					cfg.filters.back().parameters.insert(value.left(eqPos), value.mid(eqPos + 1));
+				}
+			}
+			else if (arg == "-d") { cfg.kinds = value.split(",", Qt::SkipEmptyParts); }
+			else if (arg == "-t") { cfg.types = value.split(",", Qt::SkipEmptyParts); }
+			else if (arg == "-s") { sizeStrings = value.split(",", Qt::SkipEmptyParts); }
+			else if (arg == "-j") { ok = parseIntList(value, cfg.threads, 0); }
+			else if (arg == "-r") { cfg.repetitions = value.toInt(&ok); ok = ok && cfg.repetitions > 0; }
+			else if (arg == "-w") { cfg.warmup = value.toInt(&ok); ok = ok && cfg.warmup >= 0; }
+			else if (arg == "-n") { cfg.objectCount = value.toInt(&ok); ok = ok && cfg.objectCount >= 0; }
+			else if (arg == "-e") { cfg.seed = value.toUInt(&ok); }
+			else if (arg == "-o") { cfg.outFileName = value; }
+			else
+			{
+				std::cout << "ERROR: Unknown option " << arg.toStdString() << "!\n";
+				return false;
+			}
+			if (!ok)
+			{
+				std::cout << "ERROR: Invalid value '" << value.toStdString() << "' for option " << arg.toStdString() << "!\n";
+				return false;
+			}
+		}
+		for (auto s : sizeStrings)
+		{
+			std::array<int, 3> dim;
+			if (!parseSize(s, dim.data()))
+			{
+				std::cout << "ERROR: Invalid image size '" << s.toStdString() << "'!\n";
+				return false;
+			}
+			sizes.push_back(dim);
+		}
+		for (auto k : cfg.kinds)
+		{
+			bool ok;
+			syntheticImageKindFromName(k, ok);
+			if (!ok)
+			{
+				std::cout << "ERROR: Unknown synthetic image kind '" << k.toStdString() << "'!\n";
+				return false;
+			}
+		}
+		for (auto t : cfg.types)
+		{
+			if (!benchmarkTypes().contains(t))
+			{
+				std::cout << "ERROR: Unknown data type '" << t.toStdString() << "'!\n";
+				return false;
+			}
+		}
+		return cfg.allFilters || !cfg.filters.empty();
+	}
+
+	//! Set the number of threads used by ITK, VTK and OpenMP.
+	void setThreadCount(int threads)
+	{
+		itk::MultiThreaderBase::SetGlobalMaximumNumberOfThreads(threads);
+		itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads(threads);
+		vtkMultiThreader::SetGlobalMaximumNumberOfThreads(threads);
+		vtkSMPTools::Initialize(threads);
+		omp_set_num_threads(threads);
+	}
+
+	double median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		auto n = values.size();
+		return (n % 2 == 1) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+	}
+
+	//! Run a single benchmark configuration (filter, image, thread count).
+	QJsonObject runBenchmark(iABenchmarkFilter const& bf, vtkSmartPointer<vtkImageData> img,
+		iABenchmarkConfig const& cfg, int threads)
+	{
+		QJsonObject result;
+		result["filter"] = bf.name;
+		result["threads"] = threads;
+		auto prototype = iAFilterRegistry::filter(bf.name);
+		auto params = joinValues(extractValues(prototype->parameters()), bf.parameters);
+		if (prototype->requiredImages() != 1)
+		{
+			result["error"] = QString("Filter requires %1 input images, only filters with one input are supported")
+				.arg(prototype->requiredImages());
+			return result;
+		}
+		auto input = std::make_shared<iAImageData>(img);
+		std::vector<double> times;
+		size_t peakRSSDelta = 0;
+		for (int r = 0; r < cfg.warmup + cfg.repetitions; ++r)
+		{
+			auto filter = iAFilterRegistry::filter(bf.name);   // fresh instance for each run, as in GUI and command line
+			filter->addInput(input);
+			if (r == 0 && !filter->checkParameters(params))
+			{
+				result["error"] = QString("Invalid parameters");
+				return result;
+			}
+			resetPeakRSS();
+			auto rssBefore = getCurrentRSS();
+			QElapsedTimer timer;
+			timer.start();
+			bool success = filter->run(params);
+			double elapsed = timer.nsecsElapsed() / 1e9;
+			if (!success)
+			{
+				result["error"] = QString("Filter run failed");
+				return result;
+			}
+			if (r >= cfg.warmup)
+			{
+				times.push_back(elapsed);
+				auto peak = getCurrentPeakRSS();
+				peakRSSDelta = std::max(peakRSSDelta, peak > rssBefore ? peak - rssBefore : 0);
+			}
+		}
+		double medianTime = median(times);
+		double voxelCount = static_cast<double>(img->GetNumberOfPoints());
+		QJsonArray timesArr;
+		for (auto t : times)
+		{
+			timesArr.append(t);
+		}
+		result["times"] = timesArr;
+		result["minTime"] = *std::min_element(times.begin(), times.end());
+		result["medianTime"] = medianTime;
+		result["meanTime"] = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+		result["voxelsPerSecond"] = medianTime > 0 ? voxelCount / medianTime : 0.0;
+		result["peakRSS"] = static_cast<qint64>(getCurrentPeakRSS());
+		result["peakRSSIncrease"] = static_cast<qint64>(peakRSSDelta);
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	iALog::setLogger(iALoggerStdOut::get());
+	iABenchmarkConfig cfg;
+	std::vector<std::array<int, 3>> sizes;
+	if (!parseArgs(argc, argv, cfg, sizes))
+	{
+		printUsage();
+		return 1;
+	}
+	QFileInfo fi(argv[0]);
+	CheckSCIFIO(fi.absolutePath());
+	auto dispatcher = new iAModuleDispatcher(fi.absolutePath());
+	dispatcher->InitializeModules();
+	if (cfg.allFilters)
+	{
+		for (auto factory : iAFilterRegistry::filterFactories())
+		{
+			auto filter = factory();
+			if (filter->requiredImages() == 1)
+			{
+				cfg.filters.push_back(iABenchmarkFilter{ filter->name(), QVariantMap() });
+			}
+		}
+	}
+	for (auto const& bf : cfg.filters)
+	{
+		if (!iAFilterRegistry::filter(bf.name))
+		{
+			std::cout << "ERROR: Filter '" << bf.name.toStdString() << "' does not exist!\n";
+			return 1;
+		}
+	}
+	int const hwThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	QJsonArray results;
+	for (auto kindName : cfg.kinds)
+	{
+		bool ok;
+		auto kind = syntheticImageKindFromName(kindName, ok);
+		for (auto typeName : cfg.types)
+		{
+			for (auto const& dim : sizes)
+			{
+				auto img = createSyntheticImage(kind, benchmarkTypes()[typeName], dim.data(), cfg.seed, cfg.objectCount);
+				for (auto threads : cfg.threads)
+				{
+					int numThreads = (threads == 0) ? hwThreads : threads;
+					setThreadCount(numThreads);
+					for (auto const& bf : cfg.filters)
+					{
+						std::cerr << QString("Running %1 on %2 %3 image of size %4x%5x%6 with %7 threads...\n")
+							.arg(bf.name).arg(kindName).arg(typeName).arg(dim[0]).arg(dim[1]).arg(dim[2])
+							.arg(numThreads).toStdString();
+						auto result = runBenchmark(bf, img, cfg, numThreads);
+						result["dataset"] = kindName;
+						result["type"] = typeName;
+						result["size"] = QJsonArray{ dim[0], dim[1], dim[2] };
+						results.append(result);
+					}
+				}
+			}
+		}
+	}
+	QJsonObject root;
+	root["version"] = Open_iA_Version;
+	root["hardwareThreads"] = hwThreads;
+	root["repetitions"] = cfg.repetitions;
+	root["warmup"] = cfg.warmup;
+	root["seed"] = static_cast<qint64>(cfg.seed);
+	root["results"] = results;
+	auto json = QJsonDocument(root).toJson();
+	if (cfg.outFileName.isEmpty())
+	{
+		std::cout << json.toStdString();
+	}
+	else
+	{
+		QFile f(cfg.outFileName);
+		if (!f.open(QIODevice::WriteOnly))
+		{
+			std::cout << "ERROR: Could not open output file '" << cfg.outFileName.toStdString() << "' for writing!\n";
+			return 1;
+		}
+		f.write(json);
+	}
+	return 0;
+}
@@ -0,0 +1,88 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iALoadedDataSetCache.h"
+
+#include "iADataSet.h"
+
+// io
+#include "iAFileTypeRegistry.h"
+
+#include <QFileInfo>
+
+namespace
+{
+	QString cacheKey(QString const& absFileName, QVariantMap const& paramValues)
+	{
+		QString key = absFileName;
+		for (auto it = paramValues.cbegin(); it != paramValues.cend(); ++it)    // QVariantMap is sorted by key
+		{
+			key += QString("|%1=%2").arg(it.key()).arg(it.value().toString());
+		}
+		return key;
+	}
+}
+
+iALoadedDataSetCache::iALoadedDataSetCache(size_t maxEntries) :
+	m_maxEntries(maxEntries),
+	m_hits(0),
+	m_misses(0)
+{}
+
+std::shared_ptr<iADataSet> iALoadedDataSetCache::load(QString const& fileName, QVariantMap const& paramValues)
+{
+	QFileInfo fi(fileName);
+	auto key = cacheKey(fi.absoluteFilePath(), paramValues);
+	auto lastModified = fi.lastModified();
+	for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		if (it->key != key)
+		{
+			continue;
+		}
+		if (it->lastModified != lastModified)
+		{   // file changed on disk since we loaded it
+			m_entries.erase(it);
+			break;
+		}
+		m_entries.splice(m_entries.begin(), m_entries, it);
+		++m_hits;
+		return m_entries.front().dataSet;
+	}
+	++m_misses;
+	auto io = iAFileTypeRegistry::createIO(fileName, iAFileIO::Load);
+	if (!io)
+	{
+		return nullptr;
+	}
+	auto dataSet = io->load(fileName, paramValues);
+	if (!dataSet || m_maxEntries == 0)
+	{
+		return dataSet;
+	}
+	m_entries.push_front(Entry{key, lastModified, dataSet});
+	while (m_entries.size() > m_maxEntries)
+	{
+		m_entries.pop_back();
+	}
+	return dataSet;
+}
+
+size_t iALoadedDataSetCache::hits() const
+{
+	return m_hits;
+}
+
+size_t iALoadedDataSetCache::misses() const
+{
+	return m_misses;
+}
+
+size_t iALoadedDataSetCache::size() const
+{
+	return m_entries.size();
+}
+
+void iALoadedDataSetCache::clear()
+{
+	m_entries.clear();
+}
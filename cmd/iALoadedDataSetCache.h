@@ -0,0 +1,50 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <QDateTime>
+#include <QString>
+#include <QVariantMap>
+
+#include <list>
+#include <memory>
+
+class iADataSet;
+
+//! Keeps the most recently loaded datasets in memory, so that subsequent filter
+//! runs in server mode (see iACommandServer.h) can re-use them without loading
+//! the same file again.
+//! Entries are identified by absolute file name and load parameters; an entry is
+//! discarded if the file was modified on disk since it was loaded. If more than the
+//! configured maximum number of entries are held, the least recently used is dropped.
+//! Note: filters are expected to not modify their input datasets; a filter that does
+//! so would see the modified dataset on the next run using the same input file.
+class iALoadedDataSetCache
+{
+public:
+	//! create a cache holding at most the given number of datasets
+	explicit iALoadedDataSetCache(size_t maxEntries);
+	//! retrieve the dataset stored in the given file, loaded with the given parameters;
+	//! if it is not in the cache yet, it is loaded and added to the cache.
+	//! @return the loaded dataset, or nullptr if no reader was found or loading failed
+	std::shared_ptr<iADataSet> load(QString const& fileName, QVariantMap const& paramValues);
+	//! number of load calls that could be served from the cache
+	size_t hits() const;
+	//! number of load calls that required loading the file
+	size_t misses() const;
+	//! number of datasets currently held
+	size_t size() const;
+	//! drop all cached datasets
+	void clear();
+
+private:
+	struct Entry
+	{
+		QString key;
+		QDateTime lastModified;
+		std::shared_ptr<iADataSet> dataSet;
+	};
+	std::list<Entry> m_entries;    //!< cached datasets, most recently used first
+	size_t m_maxEntries;
+	size_t m_hits, m_misses;
+};
@@ -0,0 +1,169 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASyntheticImage.h"
+
+#include "iAToolsVTK.h"
+#include "iATypedCallHelper.h"
+#include "iAVec3.h"
+
+#include <vtkImageData.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <type_traits>
+
+namespace
+{
+	struct iASphere
+	{
+		iAVec3d center;
+		double radius;
+	};
+
+	struct iAFiberSegment
+	{
+		iAVec3d start, dir;   // dir is normalized
+		double length, radius;
+	};
+
+	//! squared distance of point p to the line segment defined by the given fiber
+	double fiberDistSq(iAFiberSegment const& f, iAVec3d const& p)
+	{
+		auto d = p - f.start;
+		double t = std::clamp(dotProduct(d, f.dir), 0.0, f.length);
+		auto closest = f.start + f.dir * t;
+		auto diff = p - closest;
+		return dotProduct(diff, diff);
+	}
+
+	template <typename T>
+	void valueRange(double& minVal, double& maxVal)
+	{
+		if (std::is_floating_point_v<T>)
+		{
+			minVal = 0.0;
+			maxVal = 1.0;
+		}
+		else
+		{
+			minVal = static_cast<double>(std::numeric_limits<T>::lowest());
+			maxVal = static_cast<double>(std::numeric_limits<T>::max());
+		}
+	}
+
+	template <typename T>
+	void fillSynthetic(vtkImageData* img, iASyntheticImageKind kind, int const dim[3], unsigned int seed, int objectCount)
+	{
+		double minVal, maxVal;
+		valueRange<T>(minVal, maxVal);
+		double range = maxVal - minVal;
+		// object parameters are drawn up front so that the image content does not depend on the number of threads:
+		std::mt19937 objRng(seed);
+		double maxDim = std::max({ dim[0], dim[1], dim[2] });
+		std::uniform_real_distribution<double> posX(0, dim[0]), posY(0, dim[1]), posZ(0, dim[2]);
+		std::uniform_real_distribution<double> sphereRadius(maxDim / 50.0, maxDim / 10.0);
+		std::uniform_real_distribution<double> fiberRadius(std::max(1.0, maxDim / 200.0), std::max(1.5, maxDim / 100.0));
+		std::uniform_real_distribution<double> fiberLength(maxDim / 10.0, maxDim / 3.0);
+		std::normal_distribution<double> dirComp(0.0, 1.0);
+		std::vector<iASphere> spheres;
+		std::vector<iAFiberSegment> fibers;
+		for (int o = 0; kind != iASyntheticImageKind::Noise && o < objectCount; ++o)
+		{
+			iAVec3d pos(posX(objRng), posY(objRng), posZ(objRng));
+			if (kind == iASyntheticImageKind::Spheres)
+			{
+				spheres.push_back(iASphere{ pos, sphereRadius(objRng) });
+			}
+			else
+			{
+				iAVec3d dir(dirComp(objRng), dirComp(objRng), dirComp(objRng));
+				if (dir.length() == 0)
+				{
+					dir = iAVec3d(1, 0, 0);
+				}
+				fibers.push_back(iAFiberSegment{ pos, dir.normalized(), fiberLength(objRng), fiberRadius(objRng) });
+			}
+		}
+		auto data = static_cast<T*>(img->GetScalarPointer());
+		const double background = minVal + range / 4;
+		const double foreground = minVal + range * 3 / 4;
+		const double noiseAmplitude = (kind == iASyntheticImageKind::Noise) ? range : range / 8;
+#pragma omp parallel for
+		for (int z = 0; z < dim[2]; ++z)
+		{
+			// one generator per slice, seeded from the slice index, for reproducibility independent of thread count:
+			std::mt19937 rng(seed + 1 + static_cast<unsigned int>(z));
+			std::uniform_real_distribution<double> noise(-0.5, 0.5);
+			// only consider objects that intersect the current slice:
+			std::vector<iASphere const*> sliceSpheres;
+			for (auto const& s : spheres)
+			{
+				if (std::abs(s.center.z() - z) <= s.radius)
+				{
+					sliceSpheres.push_back(&s);
+				}
+			}
+			std::vector<iAFiberSegment const*> sliceFibers;
+			for (auto const& f : fibers)
+			{
+				double z0 = f.start.z(), z1 = f.start.z() + f.dir.z() * f.length;
+				if (z >= std::min(z0, z1) - f.radius && z <= std::max(z0, z1) + f.radius)
+				{
+					sliceFibers.push_back(&f);
+				}
+			}
+			size_t sliceOffset = static_cast<size_t>(z) * dim[0] * dim[1];
+			for (int y = 0; y < dim[1]; ++y)
+			{
+				for (int x = 0; x < dim[0]; ++x)
+				{
+					double value;
+					if (kind == iASyntheticImageKind::Noise)
+					{
+						value = minVal + range / 2;
+					}
+					else
+					{
+						iAVec3d p(x, y, z);
+						bool inside = std::any_of(sliceSpheres.begin(), sliceSpheres.end(), [&p](iASphere const* s)
+							{
+								auto d = p - s->center;
+								return dotProduct(d, d) <= s->radius * s->radius;
+							}) ||
+							std::any_of(sliceFibers.begin(), sliceFibers.end(), [&p](iAFiberSegment const* f)
+							{
+								return fiberDistSq(*f, p) <= f->radius * f->radius;
+							});
+						value = inside ? foreground : background;
+					}
+					value = std::clamp(value + noise(rng) * noiseAmplitude, minVal, maxVal);
+					data[sliceOffset + static_cast<size_t>(y) * dim[0] + x] = static_cast<T>(value);
+				}
+			}
+		}
+	}
+}
+
+QStringList syntheticImageKindNames()
+{
+	return QStringList() << "noise" << "spheres" << "fibers";
+}
+
+iASyntheticImageKind syntheticImageKindFromName(QString const& name, bool& ok)
+{
+	auto idx = syntheticImageKindNames().indexOf(name.toLower());
+	ok = idx != -1;
+	return ok ? static_cast<iASyntheticImageKind>(idx) : iASyntheticImageKind::Noise;
+}
+
+vtkSmartPointer<vtkImageData> createSyntheticImage(iASyntheticImageKind kind, int vtkType, int const dim[3],
+	unsigned int seed, int objectCount)
+{
+	double const spacing[3] = { 1.0, 1.0, 1.0 };
+	auto img = allocateImage(vtkType, dim, spacing);
+	VTK_TYPED_CALL(fillSynthetic, vtkType, img, kind, dim, seed, objectCount);
+	img->Modified();
+	return img;
+}
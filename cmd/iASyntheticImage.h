@@ -0,0 +1,38 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <vtkSmartPointer.h>
+
+#include <QStringList>
+
+class vtkImageData;
+
+//! Kinds of synthetic images that can be created via createSyntheticImage.
+enum class iASyntheticImageKind
+{
+	Noise,     //!< uniformly distributed random values
+	Spheres,   //!< randomly placed spheres of random radius on a (noisy) background
+	Fibers     //!< randomly placed and oriented cylinders ("fiber phantom") on a (noisy) background
+};
+
+//! Names of the available synthetic image kinds, in the order of iASyntheticImageKind.
+QStringList syntheticImageKindNames();
+
+//! Map the given name (case-insensitive) to an image kind.
+//! @param name the name of the kind, one of those returned by syntheticImageKindNames
+//! @param ok set to true if name is a valid kind name, to false otherwise
+iASyntheticImageKind syntheticImageKindFromName(QString const& name, bool& ok);
+
+//! Create a synthetic image for testing / benchmarking purposes.
+//! The created image is deterministic for a given combination of parameters.
+//! Object voxels are set to 3/4 and background to 1/4 of the value range (the data type
+//! range for integer types, [0..1] for floating point types), and noise of 1/8 of the range
+//! is added; for the Noise kind, the values are spread uniformly over the value range.
+//! @param kind the kind of image content to create
+//! @param vtkType the VTK type identifier (VTK_UNSIGNED_SHORT, VTK_FLOAT, ...) of the voxel data type
+//! @param dim the size of the image in the 3 dimensions
+//! @param seed the seed for the random number generator
+//! @param objectCount the number of objects (spheres or fibers), ignored for Noise
+vtkSmartPointer<vtkImageData> createSyntheticImage(iASyntheticImageKind kind, int vtkType, int const dim[3],
+	unsigned int seed = 42, int objectCount = 100);
@@ -0,0 +1,162 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>    // for size_t
+#include <vector>
+
+//! A set of indices in a fixed range [0, size), stored as one bit per index.
+//!
+//! Intended for selections of rows (objects, points) in large tables: membership tests and
+//! modifications take constant time, and set operations (e.g. for adding to or removing from a
+//! selection) process 64 indices at once. Conversion to and from a sorted list of indices, as
+//! used by most consumers of selections, takes time linear in the number of words plus the number
+//! of contained indices.
+class iABitSet
+{
+public:
+	using WordType = quint64;
+	static constexpr size_t WordBits = 64;
+
+	//! create an empty set for indices in [0, size)
+	explicit iABitSet(size_t size = 0) :
+		m_size(size),
+		m_words((size + WordBits - 1) / WordBits, 0)
+	{}
+	//! create a set containing the given indices (in any order; indices >= size are ignored)
+	static iABitSet fromIndices(std::vector<size_t> const& indices, size_t size)
+	{
+		iABitSet result(size);
+		for (size_t idx : indices)
+		{
+			if (idx < size)
+			{
+				result.set(idx);
+			}
+		}
+		return result;
+	}
+	//! the size of the index range covered by this set
+	size_t size() const
+	{
+		return m_size;
+	}
+	//! whether the given index is contained in the set
+	bool test(size_t idx) const
+	{
+		return (m_words[idx / WordBits] >> (idx % WordBits)) & 1;
+	}
+	//! add the given index to the set
+	void set(size_t idx)
+	{
+		m_words[idx / WordBits] |= bit(idx);
+	}
+	//! add the given index to the set; safe to call concurrently from multiple threads (for any index)
+	void setAtomic(size_t idx)
+	{
+		std::atomic_ref<WordType>(m_words[idx / WordBits]).fetch_or(bit(idx), std::memory_order_relaxed);
+	}
+	//! remove the given index from the set
+	void reset(size_t idx)
+	{
+		m_words[idx / WordBits] &= ~bit(idx);
+	}
+	//! remove all indices from the set
+	void clear()
+	{
+		std::fill(m_words.begin(), m_words.end(), 0);
+	}
+	//! the number of indices contained in the set
+	size_t count() const
+	{
+		size_t result = 0;
+		for (auto w : m_words)
+		{
+			result += std::popcount(w);
+		}
+		return result;
+	}
+	//! the number of indices contained in both this and the other set (without creating the intersection);
+	//! both sets need to have the same size
+	size_t intersectionCount(iABitSet const& other) const
+	{
+		assert(m_size == other.m_size);
+		size_t result = 0;
+		for (size_t w = 0; w < m_words.size(); ++w)
+		{
+			result += std::popcount(m_words[w] & other.m_words[w]);
+		}
+		return result;
+	}
+	//! whether the set contains any index
+	bool any() const
+	{
+		return std::any_of(m_words.begin(), m_words.end(), [](WordType w) { return w != 0; });
+	}
+	//! the indices contained in this set, in ascending order
+	std::vector<size_t> toIndices() const
+	{
+		std::vector<size_t> result;
+		result.reserve(count());
+		for (size_t w = 0; w < m_words.size(); ++w)
+		{
+			for (WordType word = m_words[w]; word != 0; word &= word - 1)
+			{
+				result.push_back(w * WordBits + std::countr_zero(word));
+			}
+		}
+		return result;
+	}
+	//! @{ set operations; both sets need to have the same size
+	iABitSet& operator|=(iABitSet const& other)
+	{
+		return combine(other, [](WordType a, WordType b) { return a | b; });
+	}
+	iABitSet& operator&=(iABitSet const& other)
+	{
+		return combine(other, [](WordType a, WordType b) { return a & b; });
+	}
+	iABitSet& operator^=(iABitSet const& other)
+	{
+		return combine(other, [](WordType a, WordType b) { return a ^ b; });
+	}
+	//! remove all indices contained in other from this set
+	iABitSet& subtract(iABitSet const& other)
+	{
+		return combine(other, [](WordType a, WordType b) { return a & ~b; });
+	}
+	//! @}
+	bool operator==(iABitSet const& other) const
+	{
+		return m_size == other.m_size && m_words == other.m_words;
+	}
+	bool operator!=(iABitSet const& other) const
+	{
+		return !(*this == other);
+	}
+
+private:
+	static WordType bit(size_t idx)
+	{
+		return static_cast<WordType>(1) << (idx % WordBits);
+	}
+	template <typename Op>
+	iABitSet& combine(iABitSet const& other, Op op)
+	{
+		assert(m_size == other.m_size);
+		for (size_t w = 0; w < m_words.size(); ++w)
+		{
+			m_words[w] = op(m_words[w], other.m_words[w]);
+		}
+		return *this;
+	}
+
+	size_t m_size;
+	std::vector<WordType> m_words;
+};
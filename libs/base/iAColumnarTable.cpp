@@ -0,0 +1,146 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iAColumnarTable.h"
+
+#include <vtkDoubleArray.h>
+#include <vtkTable.h>
+
+#include <QMutex>
+
+#include <limits>
+#include <map>
+
+namespace
+{
+	//! Owners of memory referenced by vtk arrays created in iAColumnarTable::vtkView, by data pointer.
+	//! Intentionally never deleted, as arrays might still be released during static destruction.
+	struct iAViewOwners
+	{
+		QMutex mutex;
+		std::multimap<void*, std::shared_ptr<iAColumnarTable>> owners;
+	};
+	iAViewOwners& viewOwners()
+	{
+		static auto* owners = new iAViewOwners();
+		return *owners;
+	}
+
+	//! called by vtk instead of freeing the memory of an array referencing a table column
+	void releaseViewOwner(void* ptr)
+	{
+		auto& v = viewOwners();
+		QMutexLocker locker(&v.mutex);
+		auto it = v.owners.find(ptr);
+		if (it != v.owners.end())
+		{
+			v.owners.erase(it);
+		}
+	}
+}
+
+const size_t iAColumnarTable::NoColumn = std::numeric_limits<size_t>::max();
+
+iAColumnarTable::iAColumnarTable()
+{}
+
+iAColumnarTable::iAColumnarTable(std::vector<QString> const& columnNames, size_t rowCount) :
+	m_columnNames(columnNames),
+	m_columns(columnNames.size(), ColumnType(rowCount, 0))
+{}
+
+size_t iAColumnarTable::columnCount() const
+{
+	return m_columns.size();
+}
+
+size_t iAColumnarTable::rowCount() const
+{
+	return m_columns.empty() ? 0 : m_columns[0].size();
+}
+
+QString const& iAColumnarTable::columnName(size_t colIdx) const
+{
+	return m_columnNames[colIdx];
+}
+
+size_t iAColumnarTable::columnIndex(QString const& name) const
+{
+	for (size_t c = 0; c < m_columnNames.size(); ++c)
+	{
+		if (m_columnNames[c] == name)
+		{
+			return c;
+		}
+	}
+	return NoColumn;
+}
+
+iAColumnarTable::ColumnType& iAColumnarTable::column(size_t colIdx)
+{
+	return m_columns[colIdx];
+}
+
+iAColumnarTable::ColumnType const& iAColumnarTable::column(size_t colIdx) const
+{
+	return m_columns[colIdx];
+}
+
+std::vector<iAColumnarTable::ColumnType>& iAColumnarTable::columns()
+{
+	return m_columns;
+}
+
+std::vector<iAColumnarTable::ColumnType> const& iAColumnarTable::columns() const
+{
+	return m_columns;
+}
+
+std::vector<QString>& iAColumnarTable::columnNames()
+{
+	return m_columnNames;
+}
+
+std::vector<QString> const& iAColumnarTable::columnNames() const
+{
+	return m_columnNames;
+}
+
+size_t iAColumnarTable::addColumn(QString const& name)
+{
+	m_columnNames.push_back(name);
+	m_columns.push_back(ColumnType(rowCount(), 0));
+	return m_columns.size() - 1;
+}
+
+size_t iAColumnarTable::memorySize() const
+{
+	size_t result = 0;
+	for (auto const& col : m_columns)
+	{
+		result += col.capacity() * sizeof(ValueType);
+	}
+	return result;
+}
+
+vtkSmartPointer<vtkTable> iAColumnarTable::vtkView()
+{
+	auto result = vtkSmartPointer<vtkTable>::New();
+	for (size_t c = 0; c < m_columns.size(); ++c)
+	{
+		auto arr = vtkSmartPointer<vtkDoubleArray>::New();
+		arr->SetName(m_columnNames[c].toStdString().c_str());
+		if (!m_columns[c].empty())
+		{
+			{
+				auto& v = viewOwners();
+				QMutexLocker locker(&v.mutex);
+				v.owners.insert(std::make_pair(m_columns[c].data(), shared_from_this()));
+			}
+			// save=0 + user-defined free function: vtk calls releaseViewOwner instead of freeing the memory
+			arr->SetArray(m_columns[c].data(), static_cast<vtkIdType>(m_columns[c].size()), 0, VTK_DATA_ARRAY_USER_DEFINED);
+			arr->SetArrayFreeFunction(releaseViewOwner);
+		}
+		result->AddColumn(arr);
+	}
+	return result;
+}
@@ -0,0 +1,70 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iabase_export.h"
+
+#include <vtkSmartPointer.h>
+
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+class vtkTable;
+
+//! Table of numeric values, stored column by column (one contiguous array of doubles per column).
+//!
+//! Intended as single storage for object characteristics (e.g. loaded from a .csv file), which
+//! is shared by all views on the data instead of each of them holding their own copy:
+//! iASPLOMData can directly operate on the columns of a table, and vtkView() provides a
+//! vtkTable whose columns reference the memory of this table.
+//! Must be created via std::make_shared (required for keeping the table alive while vtkTable views exist).
+class iAbase_API iAColumnarTable : public std::enable_shared_from_this<iAColumnarTable>
+{
+public:
+	using ValueType = double;
+	using ColumnType = std::vector<ValueType>;
+	//! create an empty table (no columns, no rows)
+	iAColumnarTable();
+	//! create a table with the given columns and number of rows; all values are initialized to 0
+	iAColumnarTable(std::vector<QString> const& columnNames, size_t rowCount);
+
+	//! number of columns
+	size_t columnCount() const;
+	//! number of rows (0 if the table has no columns)
+	size_t rowCount() const;
+	//! name of the column with the given index
+	QString const& columnName(size_t colIdx) const;
+	//! index of the column with the given name (NoColumn if there is none)
+	size_t columnIndex(QString const& name) const;
+	//! @{ values of the column with the given index
+	ColumnType& column(size_t colIdx);
+	ColumnType const& column(size_t colIdx) const;
+	//! @}
+	//! @{ access to all columns and column names, for modifying the table structure
+	std::vector<ColumnType>& columns();
+	std::vector<ColumnType> const& columns() const;
+	std::vector<QString>& columnNames();
+	std::vector<QString> const& columnNames() const;
+	//! @}
+	//! append a column with the given name (with all values initialized to 0)
+	//! @return the index of the new column
+	size_t addColumn(QString const& name);
+	//! @return the (approximate) number of bytes used for storing the values
+	size_t memorySize() const;
+
+	//! A vtkTable with one vtkDoubleArray per column, directly referencing the memory of this table
+	//! (i.e. without copying the values; changes in one are visible in the other).
+	//! The view keeps this table alive as long as any of its arrays exist. It reflects the structure of
+	//! the table at the time of the call, so the table must not be re-structured (columns added or
+	//! resized) as long as the view is in use; modifying values is fine.
+	vtkSmartPointer<vtkTable> vtkView();
+
+	//! returned by columnIndex if no column with the given name exists
+	static const size_t NoColumn;
+
+private:
+	std::vector<QString> m_columnNames;
+	std::vector<ColumnType> m_columns;
+};
@@ -0,0 +1,423 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iACompressedLabelImage.h"
+
+#include "iAToolsITK.h"
+#include "iATypedCallHelper.h"
+
+#include <QString>
+
+#include <map>
+#include <unordered_map>
+
+iACompressedLabelImage::iACompressedLabelImage() :
+	m_dim{0, 0, 0},
+	m_sliceRunStart(1, 0)
+{}
+
+namespace
+{
+	template <typename T>
+	void createFromITK(iAITKIO::ImagePointer img, iACompressedLabelImage& result)
+	{
+		if constexpr (std::is_integral_v<T>)
+		{
+			using ImageType = itk::Image<T, iAITKIO::Dim>;
+			auto typedImg = dynamic_cast<ImageType*>(img.GetPointer());
+			auto size = typedImg->GetLargestPossibleRegion().GetSize();
+			int dim[3] = {static_cast<int>(size[0]), static_cast<int>(size[1]), static_cast<int>(size[2])};
+			result = iACompressedLabelImage::create(typedImg->GetBufferPointer(), dim);
+		}
+		else
+		{
+			Q_UNUSED(img);
+			Q_UNUSED(result);
+			throw std::runtime_error("Compressed label image: Only integer image types are supported!");
+		}
+	}
+}
+
+iACompressedLabelImage iACompressedLabelImage::create(iAITKIO::ImagePointer img)
+{
+	if (img->GetNumberOfComponentsPerPixel() != 1)
+	{
+		throw std::runtime_error("Compressed label image: Only single-component images are supported!");
+	}
+	iACompressedLabelImage result;
+	ITK_TYPED_CALL(createFromITK, itkScalarType(img), img, result);
+	return result;
+}
+
+void iACompressedLabelImage::setRuns(std::vector<std::vector<std::pair<LabelType, RunLengthType>>> const& sliceRuns)
+{
+	m_sliceRunStart.resize(sliceRuns.size() + 1);
+	m_sliceRunStart[0] = 0;
+	for (size_t z = 0; z < sliceRuns.size(); ++z)
+	{
+		m_sliceRunStart[z + 1] = m_sliceRunStart[z] + sliceRuns[z].size();
+	}
+	// collect the labels of all slices, then sort and deduplicate them once:
+	m_labels.clear();
+	for (auto const& runs : sliceRuns)
+	{
+		for (auto const& run : runs)
+		{   // skip labels repeating the previous one (e.g. runs continuing on the next line), to collect fewer duplicates:
+			if (m_labels.empty() || m_labels.back() != run.first)
+			{
+				m_labels.push_back(run.first);
+			}
+		}
+	}
+	std::sort(m_labels.begin(), m_labels.end());
+	m_labels.erase(std::unique(m_labels.begin(), m_labels.end()), m_labels.end());
+	if (m_labels.size() > static_cast<size_t>(std::numeric_limits<LabelIdxType>::max()) + 1)
+	{
+		throw std::runtime_error(QString("Compressed label image: Too many distinct labels (%1, at most %2 are supported)!")
+			.arg(m_labels.size()).arg(static_cast<size_t>(std::numeric_limits<LabelIdxType>::max()) + 1).toStdString());
+	}
+	m_runLabel.resize(m_sliceRunStart.back());
+	m_runLength.resize(m_sliceRunStart.back());
+	qint64 sliceCount = static_cast<qint64>(sliceRuns.size());
+#pragma omp parallel for schedule(dynamic, 1)
+	for (qint64 z = 0; z < sliceCount; ++z)
+	{
+		size_t r = m_sliceRunStart[z];
+		for (auto const& run : sliceRuns[z])
+		{
+			m_runLabel[r] = static_cast<LabelIdxType>(
+				std::lower_bound(m_labels.begin(), m_labels.end(), run.first) - m_labels.begin());
+			m_runLength[r] = run.second;
+			++r;
+		}
+	}
+}
+
+int const* iACompressedLabelImage::dim() const
+{
+	return m_dim;
+}
+
+qint64 iACompressedLabelImage::voxelCount() const
+{
+	return static_cast<qint64>(m_dim[0]) * m_dim[1] * m_dim[2];
+}
+
+std::vector<iACompressedLabelImage::LabelType> const& iACompressedLabelImage::labels() const
+{
+	return m_labels;
+}
+
+size_t iACompressedLabelImage::runCount() const
+{
+	return m_runLength.size();
+}
+
+size_t iACompressedLabelImage::memorySize() const
+{
+	return sizeof(*this) +
+		m_labels.size() * sizeof(LabelType) +
+		m_runLabel.size() * sizeof(LabelIdxType) +
+		m_runLength.size() * sizeof(RunLengthType) +
+		m_sliceRunStart.size() * sizeof(size_t);
+}
+
+
+namespace
+{
+	//! above this number of label combinations, confusion counts are collected in a hash map instead of a dense matrix
+	const size_t MaxDenseConfusionSize = 1 << 16;
+
+	//! walk through the runs of both images in the given slice; calls count(sourceLabelIdx, targetLabelIdx, voxelCount)
+	//! for each stretch of voxels where both images have the same label
+	template <typename CountFunc>
+	void visitOverlappingRuns(std::vector<iACompressedLabelImage::LabelIdxType> const& srcLabel,
+		std::vector<iACompressedLabelImage::RunLengthType> const& srcLength, size_t srcRun, size_t srcEnd,
+		std::vector<iACompressedLabelImage::LabelIdxType> const& tgtLabel,
+		std::vector<iACompressedLabelImage::RunLengthType> const& tgtLength, size_t tgtRun, size_t tgtEnd,
+		CountFunc count)
+	{
+		if (srcRun == srcEnd || tgtRun == tgtEnd)
+		{
+			return;
+		}
+		auto srcRemaining = srcLength[srcRun];
+		auto tgtRemaining = tgtLength[tgtRun];
+		while (true)
+		{
+			auto common = std::min(srcRemaining, tgtRemaining);
+			count(srcLabel[srcRun], tgtLabel[tgtRun], common);
+			srcRemaining -= common;
+			tgtRemaining -= common;
+			if (srcRemaining == 0)
+			{
+				if (++srcRun == srcEnd)
+				{
+					break;
+				}
+				srcRemaining = srcLength[srcRun];
+			}
+			if (tgtRemaining == 0)
+			{
+				if (++tgtRun == tgtEnd)
+				{
+					break;
+				}
+				tgtRemaining = tgtLength[tgtRun];
+			}
+		}
+	}
+}
+
+iALabelOverlapMeasures::iALabelOverlapMeasures(iACompressedLabelImage const& source, iACompressedLabelImage const& target,
+	LabelType const* ignoredTargetLabel)
+{
+	if (!std::equal(source.m_dim, source.m_dim + 3, target.m_dim))
+	{
+		throw std::runtime_error("Label overlap: images need to have the same size!");
+	}
+	size_t const srcLabelCount = source.m_labels.size();
+	size_t const tgtLabelCount = target.m_labels.size();
+	qint64 const sliceCount = source.m_dim[2];
+	// counts per (source label index, target label index):
+	std::map<std::pair<size_t, size_t>, quint64> confusion;
+	if (srcLabelCount * tgtLabelCount <= MaxDenseConfusionSize)
+	{
+		std::vector<quint64> dense(srcLabelCount * tgtLabelCount, 0);
+#pragma omp parallel
+		{
+			std::vector<quint64> local(dense.size(), 0);
+#pragma omp for schedule(dynamic, 1)
+			for (qint64 z = 0; z < sliceCount; ++z)
+			{
+				visitOverlappingRuns(source.m_runLabel, source.m_runLength, source.m_sliceRunStart[z], source.m_sliceRunStart[z + 1],
+					target.m_runLabel, target.m_runLength, target.m_sliceRunStart[z], target.m_sliceRunStart[z + 1],
+					[&local, tgtLabelCount](size_t s, size_t t, quint64 c) { local[s * tgtLabelCount + t] += c; });
+			}
+#pragma omp critical
+			for (size_t i = 0; i < dense.size(); ++i)
+			{
+				dense[i] += local[i];
+			}
+		}
+		for (size_t s = 0; s < srcLabelCount; ++s)
+		{
+			for (size_t t = 0; t < tgtLabelCount; ++t)
+			{
+				if (dense[s * tgtLabelCount + t] > 0)
+				{
+					confusion[std::make_pair(s, t)] = dense[s * tgtLabelCount + t];
+				}
+			}
+		}
+	}
+	else
+	{
+#pragma omp parallel
+		{
+			std::unordered_map<quint64, quint64> local;
+#pragma omp for schedule(dynamic, 1)
+			for (qint64 z = 0; z < sliceCount; ++z)
+			{
+				visitOverlappingRuns(source.m_runLabel, source.m_runLength, source.m_sliceRunStart[z], source.m_sliceRunStart[z + 1],
+					target.m_runLabel, target.m_runLength, target.m_sliceRunStart[z], target.m_sliceRunStart[z + 1],
+					[&local, tgtLabelCount](size_t s, size_t t, quint64 c) { local[s * tgtLabelCount + t] += c; });
+			}
+#pragma omp critical
+			for (auto const& e : local)
+			{
+				confusion[std::make_pair(e.first / tgtLabelCount, e.first % tgtLabelCount)] += e.second;
+			}
+		}
+	}
+
+	// collect counts per label value:
+	std::map<LabelType, iALabelCounts> counts;
+	for (auto const& e : confusion)
+	{
+		LabelType srcLabel = source.m_labels[e.first.first];
+		LabelType tgtLabel = target.m_labels[e.first.second];
+		if (ignoredTargetLabel && tgtLabel == *ignoredTargetLabel)
+		{
+			continue;
+		}
+		m_confusion.push_back(iAConfusionEntry{srcLabel, tgtLabel, e.second});
+		counts[srcLabel].source += e.second;
+		counts[tgtLabel].target += e.second;
+		if (srcLabel == tgtLabel)
+		{
+			counts[srcLabel].intersection += e.second;
+		}
+	}
+	for (auto const& c : counts)
+	{
+		m_labels.push_back(c.first);
+		m_counts.push_back(c.second);
+	}
+}
+
+std::vector<iALabelOverlapMeasures::LabelType> const& iALabelOverlapMeasures::labels() const
+{
+	return m_labels;
+}
+
+std::vector<iALabelOverlapMeasures::iAConfusionEntry> const& iALabelOverlapMeasures::confusion() const
+{
+	return m_confusion;
+}
+
+iALabelOverlapMeasures::iALabelCounts const* iALabelOverlapMeasures::counts(LabelType label) const
+{
+	auto it = std::lower_bound(m_labels.begin(), m_labels.end(), label);
+	return (it != m_labels.end() && *it == label) ? &m_counts[it - m_labels.begin()] : nullptr;
+}
+
+quint64 iALabelOverlapMeasures::sourceCount(LabelType label) const
+{
+	auto c = counts(label);
+	return c ? c->source : 0;
+}
+
+quint64 iALabelOverlapMeasures::targetCount(LabelType label) const
+{
+	auto c = counts(label);
+	return c ? c->target : 0;
+}
+
+quint64 iALabelOverlapMeasures::intersection(LabelType label) const
+{
+	auto c = counts(label);
+	return c ? c->intersection : 0;
+}
+
+quint64 iALabelOverlapMeasures::unionCount(LabelType label) const
+{
+	auto c = counts(label);
+	return c ? c->source + c->target - c->intersection : 0;
+}
+
+namespace
+{
+	//! ratio as computed in itk::LabelOverlapMeasuresImageFilter: maximum double value if denominator is zero
+	double overlapRatio(double numerator, double denominator)
+	{
+		return (denominator == 0.0) ? std::numeric_limits<double>::max() : numerator / denominator;
+	}
+}
+
+double iALabelOverlapMeasures::totalOverlap() const
+{
+	double numerator = 0.0, denominator = 0.0;
+	for (size_t i = 0; i < m_labels.size(); ++i)
+	{
+		if (m_labels[i] == 0)
+		{   // do not include the background
+			continue;
+		}
+		numerator += m_counts[i].intersection;
+		denominator += m_counts[i].target;
+	}
+	return overlapRatio(numerator, denominator);
+}
+
+double iALabelOverlapMeasures::unionOverlap() const
+{
+	double numerator = 0.0, denominator = 0.0;
+	for (size_t i = 0; i < m_labels.size(); ++i)
+	{
+		if (m_labels[i] == 0)
+		{
+			continue;
+		}
+		numerator += m_counts[i].intersection;
+		denominator += m_counts[i].source + m_counts[i].target - m_counts[i].intersection;
+	}
+	return overlapRatio(numerator, denominator);
+}
+
+double iALabelOverlapMeasures::meanOverlap() const
+{
+	double uo = unionOverlap();
+	return 2.0 * uo / (1.0 + uo);
+}
+
+double iALabelOverlapMeasures::volumeSimilarity() const
+{
+	double numerator = 0.0, denominator = 0.0;
+	for (size_t i = 0; i < m_labels.size(); ++i)
+	{
+		if (m_labels[i] == 0)
+		{
+			continue;
+		}
+		numerator += static_cast<double>(m_counts[i].source) - static_cast<double>(m_counts[i].target);
+		denominator += static_cast<double>(m_counts[i].source) + static_cast<double>(m_counts[i].target);
+	}
+	return (denominator == 0.0) ? std::numeric_limits<double>::max() : 2.0 * numerator / denominator;
+}
+
+double iALabelOverlapMeasures::falseNegativeError() const
+{
+	double numerator = 0.0, denominator = 0.0;
+	for (size_t i = 0; i < m_labels.size(); ++i)
+	{
+		if (m_labels[i] == 0)
+		{
+			continue;
+		}
+		numerator += m_counts[i].target - m_counts[i].intersection;
+		denominator += m_counts[i].target;
+	}
+	return overlapRatio(numerator, denominator);
+}
+
+double iALabelOverlapMeasures::falsePositiveError() const
+{
+	double numerator = 0.0, denominator = 0.0;
+	for (size_t i = 0; i < m_labels.size(); ++i)
+	{
+		if (m_labels[i] == 0)
+		{
+			continue;
+		}
+		numerator += m_counts[i].source - m_counts[i].intersection;
+		denominator += m_counts[i].source;
+	}
+	return overlapRatio(numerator, denominator);
+}
+
+double iALabelOverlapMeasures::targetOverlap(LabelType label) const
+{
+	auto c = counts(label);
+	return c ? overlapRatio(c->intersection, c->target) : 0.0;
+}
+
+double iALabelOverlapMeasures::unionOverlap(LabelType label) const
+{
+	auto c = counts(label);
+	return c ? overlapRatio(c->intersection, c->source + c->target - c->intersection) : 0.0;
+}
+
+double iALabelOverlapMeasures::meanOverlap(LabelType label) const
+{
+	double uo = unionOverlap(label);
+	return 2.0 * uo / (1.0 + uo);
+}
+
+double iALabelOverlapMeasures::volumeSimilarity(LabelType label) const
+{
+	auto c = counts(label);
+	return c ? 2.0 * (static_cast<double>(c->source) - static_cast<double>(c->target)) /
+		(static_cast<double>(c->source) + static_cast<double>(c->target)) : 0.0;
+}
+
+double iALabelOverlapMeasures::falseNegativeError(LabelType label) const
+{
+	auto c = counts(label);
+	return c ? overlapRatio(c->target - c->intersection, c->target) : 0.0;
+}
+
+double iALabelOverlapMeasures::falsePositiveError(LabelType label) const
+{
+	auto c = counts(label);
+	return c ? overlapRatio(c->source - c->intersection, c->source) : 0.0;
+}
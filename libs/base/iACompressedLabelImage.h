@@ -0,0 +1,173 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iabase_export.h"
+
+#include "iAitkBaseImageTypes.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+//! Compact, run-length encoded representation of a 3D label image.
+//!
+//! Stores consecutive voxels of the same label (in x-y-z memory order) as one run; since runs
+//! are split at slice boundaries, slices can be processed independently (in parallel).
+//! Each run requires 8 bytes (index into the table of distinct labels, length), so segmentation
+//! results, which typically consist of few, large regions, shrink by far more than an order of
+//! magnitude compared to an int image. Overlap measures between two such images can be computed
+//! directly on the runs, see iALabelOverlapMeasures.
+class iAbase_API iACompressedLabelImage
+{
+public:
+	//! type of the label values
+	using LabelType = qint64;
+	//! type for indices into the table of distinct labels
+	using LabelIdxType = std::uint32_t;
+	//! type for the length of runs (each run lies within a single slice)
+	using RunLengthType = std::uint32_t;
+
+	//! create an empty image
+	iACompressedLabelImage();
+	//! create from a raw (x-y-z ordered) buffer of integer labels
+	template <typename T>
+	static iACompressedLabelImage create(T const* data, int const dim[3]);
+	//! create from an ITK image; the image needs to have an integer pixel type
+	static iACompressedLabelImage create(iAITKIO::ImagePointer img);
+
+	//! the size of the image in the 3 dimensions
+	int const* dim() const;
+	//! the number of voxels in the image
+	qint64 voxelCount() const;
+	//! the distinct labels in the image, in ascending order
+	std::vector<LabelType> const& labels() const;
+	//! the number of runs used to store the image
+	size_t runCount() const;
+	//! the (approximate) number of bytes used for storing the image
+	size_t memorySize() const;
+	//! decompress into a raw (x-y-z ordered) buffer, which needs to hold voxelCount() elements
+	template <typename T>
+	void decompress(T* data) const;
+
+private:
+	friend class iALabelOverlapMeasures;
+	//! set up the image from runs holding the original label values (per slice)
+	void setRuns(std::vector<std::vector<std::pair<LabelType, RunLengthType>>> const& sliceRuns);
+
+	int m_dim[3];
+	std::vector<LabelType> m_labels;           //!< distinct label values, ascending
+	std::vector<LabelIdxType> m_runLabel;      //!< for each run, the index of its label in m_labels
+	std::vector<RunLengthType> m_runLength;    //!< for each run, the number of voxels in it
+	std::vector<size_t> m_sliceRunStart;       //!< for each slice, the index of its first run (plus the total run count at the end)
+};
+
+//! Overlap measures between two label images, computed from their confusion counts.
+//! The measures (and their handling of edge cases) are the same as in
+//! itk::LabelOverlapMeasuresImageFilter; the background label (0) is not included in the
+//! measures summarizing all labels.
+class iAbase_API iALabelOverlapMeasures
+{
+public:
+	using LabelType = iACompressedLabelImage::LabelType;
+	//! number of voxels with a given combination of source and target label
+	struct iAConfusionEntry
+	{
+		LabelType source, target;
+		quint64 count;
+	};
+	//! compute the confusion counts between source and target image (which need to have the same size).
+	//! @param source the source (e.g. reference) image
+	//! @param target the target (e.g. segmentation) image
+	//! @param ignoredTargetLabel if given, voxels with this label in the target image are not considered
+	iALabelOverlapMeasures(iACompressedLabelImage const& source, iACompressedLabelImage const& target,
+		LabelType const* ignoredTargetLabel = nullptr);
+
+	//! all labels occurring in the source or target image, in ascending order
+	std::vector<LabelType> const& labels() const;
+	//! all non-zero confusion counts, ordered by source, then target label
+	std::vector<iAConfusionEntry> const& confusion() const;
+	//! number of voxels with the given label in the source image
+	quint64 sourceCount(LabelType label) const;
+	//! number of voxels with the given label in the target image
+	quint64 targetCount(LabelType label) const;
+	//! number of voxels with the given label in both images
+	quint64 intersection(LabelType label) const;
+	//! number of voxels with the given label in any of the two images
+	quint64 unionCount(LabelType label) const;
+
+	//! @{ measures over all (non-background) labels
+	double totalOverlap() const;
+	double unionOverlap() const;     //!< Jaccard index
+	double meanOverlap() const;      //!< Dice coefficient
+	double volumeSimilarity() const;
+	double falseNegativeError() const;
+	double falsePositiveError() const;
+	//! @}
+	//! @{ measures for a single label
+	double targetOverlap(LabelType label) const;
+	double unionOverlap(LabelType label) const;
+	double meanOverlap(LabelType label) const;    //!< Dice coefficient of the given label
+	double volumeSimilarity(LabelType label) const;
+	double falseNegativeError(LabelType label) const;
+	double falsePositiveError(LabelType label) const;
+	//! @}
+
+private:
+	struct iALabelCounts
+	{
+		quint64 source = 0, target = 0, intersection = 0;
+	};
+	iALabelCounts const* counts(LabelType label) const;
+	std::vector<LabelType> m_labels;
+	std::vector<iALabelCounts> m_counts;    //!< counts for each label in m_labels
+	std::vector<iAConfusionEntry> m_confusion;
+};
+
+template <typename T>
+iACompressedLabelImage iACompressedLabelImage::create(T const* data, int const dim[3])
+{
+	static_assert(std::is_integral_v<T>, "iACompressedLabelImage: label images need to have an integer type!");
+	qint64 const sliceSize = static_cast<qint64>(dim[0]) * dim[1];
+	std::vector<std::vector<std::pair<LabelType, RunLengthType>>> sliceRuns(dim[2]);
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int z = 0; z < dim[2]; ++z)
+	{
+		T const* slice = data + z * sliceSize;
+		auto& runs = sliceRuns[z];
+		qint64 runStart = 0;
+		for (qint64 i = 1; i <= sliceSize; ++i)
+		{
+			if (i == sliceSize || slice[i] != slice[runStart] ||
+				i - runStart == std::numeric_limits<RunLengthType>::max())
+			{
+				runs.push_back(std::make_pair(static_cast<LabelType>(slice[runStart]), static_cast<RunLengthType>(i - runStart)));
+				runStart = i;
+			}
+		}
+	}
+	iACompressedLabelImage result;
+	std::copy(dim, dim + 3, result.m_dim);
+	result.setRuns(sliceRuns);
+	return result;
+}
+
+template <typename T>
+void iACompressedLabelImage::decompress(T* data) const
+{
+	qint64 const sliceSize = static_cast<qint64>(m_dim[0]) * m_dim[1];
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int z = 0; z < m_dim[2]; ++z)
+	{
+		T* out = data + z * sliceSize;
+		for (size_t r = m_sliceRunStart[z]; r < m_sliceRunStart[z + 1]; ++r)
+		{
+			out = std::fill_n(out, m_runLength[r], static_cast<T>(m_labels[m_runLabel[r]]));
+		}
+	}
+}
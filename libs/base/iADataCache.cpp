@@ -0,0 +1,158 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iADataCache.h"
+
+#include "iALog.h"
+
+iADataCache& iADataCache::get()
+{
+	static iADataCache instance;
+	return instance;
+}
+
+iADataCache::iADataCache() :
+	m_memoryBudget(DefaultMemoryBudget),
+	m_bytesResident(0),
+	m_hits(0),
+	m_misses(0),
+	m_evictions(0)
+{}
+
+QString iADataCache::cacheKey(char const* typeName, QString const& absFileName, QVariantMap const& params)
+{
+	QString key = QString("%1|%2").arg(typeName).arg(absFileName);
+	for (auto it = params.cbegin(); it != params.cend(); ++it)    // QVariantMap is sorted by key
+	{
+		key += QString("|%1=%2").arg(it.key()).arg(it.value().toString());
+	}
+	return key;
+}
+
+std::shared_ptr<iADataCache::iAAbstractValue> iADataCache::find(QString const& key, QDateTime const& lastModified)
+{
+	for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		if (it->key != key)
+		{
+			continue;
+		}
+		if (it->lastModified != lastModified)
+		{   // file changed on disk since we loaded it
+			m_bytesResident -= it->bytes;
+			m_entries.erase(it);
+			break;
+		}
+		m_entries.splice(m_entries.begin(), m_entries, it);
+		++m_hits;
+		return m_entries.front().value;
+	}
+	++m_misses;
+	return nullptr;
+}
+
+std::shared_ptr<iADataCache::iAAbstractValue> iADataCache::insert(Entry&& entry)
+{
+	QMutexLocker locker(&m_mutex);
+	for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		if (it->key != entry.key)
+		{
+			continue;
+		}
+		if (it->lastModified == entry.lastModified)
+		{   // loaded concurrently by another thread in the meantime; use the already cached object
+			m_entries.splice(m_entries.begin(), m_entries, it);
+			return m_entries.front().value;
+		}
+		// an outdated version of the same data; replace it:
+		m_bytesResident -= it->bytes;
+		m_entries.erase(it);
+		break;
+	}
+	m_bytesResident += entry.bytes;
+	m_entries.push_front(std::move(entry));
+	auto value = m_entries.front().value;
+	evict();
+	return value;
+}
+
+void iADataCache::evict()
+{
+	auto it = m_entries.end();
+	while (m_bytesResident > m_memoryBudget && it != m_entries.begin())
+	{
+		--it;
+		if (it->value->inUse())
+		{
+			continue;
+		}
+		LOG(lvlDebug, QString("Data cache: evicting %1 (%2 bytes).").arg(it->absFileName).arg(it->bytes));
+		m_bytesResident -= it->bytes;
+		++m_evictions;
+		it = m_entries.erase(it);
+	}
+}
+
+void iADataCache::setMemoryBudget(size_t bytes)
+{
+	QMutexLocker locker(&m_mutex);
+	m_memoryBudget = bytes;
+	evict();
+}
+
+size_t iADataCache::memoryBudget() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_memoryBudget;
+}
+
+void iADataCache::trim()
+{
+	QMutexLocker locker(&m_mutex);
+	evict();
+}
+
+void iADataCache::remove(QString const& fileName)
+{
+	QString absFileName = QFileInfo(fileName).absoluteFilePath();
+	QMutexLocker locker(&m_mutex);
+	for (auto it = m_entries.begin(); it != m_entries.end();)
+	{
+		if (it->absFileName == absFileName)
+		{
+			m_bytesResident -= it->bytes;
+			it = m_entries.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void iADataCache::clear()
+{
+	QMutexLocker locker(&m_mutex);
+	m_entries.clear();
+	m_bytesResident = 0;
+}
+
+iADataCache::Stats iADataCache::stats() const
+{
+	QMutexLocker locker(&m_mutex);
+	Stats s;
+	s.hits = m_hits;
+	s.misses = m_misses;
+	s.evictions = m_evictions;
+	s.entries = m_entries.size();
+	s.bytesResident = m_bytesResident;
+	for (auto const& e : m_entries)
+	{
+		if (e.value->inUse())
+		{
+			s.bytesPinned += e.bytes;
+		}
+	}
+	s.memoryBudget = m_memoryBudget;
+	return s;
+}
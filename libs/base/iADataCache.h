@@ -0,0 +1,161 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iabase_export.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <typeinfo>
+
+//! Process-wide, memory-budgeted cache for data loaded from files.
+//!
+//! Entries are identified by absolute file name, load parameters and the type of the cached
+//! object; an entry is considered outdated (and reloaded) if the file was modified since it was loaded.
+//! Any kind of (smart) pointer can be cached: std::shared_ptr, vtkSmartPointer and itk::SmartPointer.
+//!
+//! When the size of all cached objects exceeds the memory budget, the least recently used
+//! entries are evicted. Entries which are currently in use, i.e., which are referenced from
+//! somewhere outside of the cache, are "pinned": they are never evicted, since that would not
+//! free their memory, and a subsequent request would load a second copy. So to pin an entry,
+//! simply keep the pointer returned by load.
+//! Evicting an entry only drops the cache's reference, so it is always safe to do.
+//!
+//! All methods are thread-safe; loading itself happens outside of the internal lock, so
+//! multiple threads can load different files concurrently.
+class iAbase_API iADataCache
+{
+public:
+	//! statistics about cache usage
+	struct Stats
+	{
+		size_t hits = 0;           //!< number of requests served from the cache
+		size_t misses = 0;         //!< number of requests that required loading
+		size_t evictions = 0;      //!< number of entries dropped because the memory budget was exceeded
+		size_t entries = 0;        //!< number of entries currently held
+		size_t bytesResident = 0;  //!< summed up size of all cached objects
+		size_t bytesPinned = 0;    //!< summed up size of the cached objects currently in use
+		size_t memoryBudget = 0;   //!< the current memory budget
+		//! ratio of requests served from the cache (0..1)
+		double hitRate() const { return (hits + misses) > 0 ? static_cast<double>(hits) / (hits + misses) : 0; }
+	};
+
+	//! the process-wide cache instance
+	static iADataCache& get();
+
+	//! Retrieve the object loaded from the given file with the given parameters. If it is not
+	//! in the cache yet (or outdated), it is loaded via loadFunc and added to the cache.
+	//! @param fileName the file the object is loaded from
+	//! @param params any parameters influencing loading (part of the cache key)
+	//! @param loadFunc loads the object; returning a null pointer signals failure (nothing is cached then)
+	//! @param sizeFunc determines the (approximate) size of the loaded object in bytes
+	//! @return the cached or newly loaded object (or a null pointer if loading failed)
+	template <typename PtrT>
+	PtrT load(QString const& fileName, QVariantMap const& params,
+		std::function<PtrT()> loadFunc, std::function<size_t(PtrT const&)> sizeFunc);
+
+	//! Set the maximum summed up size of the cached objects (in bytes).
+	//! If the cache currently holds more, unused entries are evicted immediately.
+	void setMemoryBudget(size_t bytes);
+	//! the maximum summed up size of the cached objects
+	size_t memoryBudget() const;
+	//! Evict unused entries until the cache fits the memory budget again (e.g. after pinned entries were released).
+	void trim();
+	//! Remove the entries for the given file (for all load parameters), e.g. when it was overwritten.
+	void remove(QString const& fileName);
+	//! Drop all entries (pinned objects stay valid, as they are still referenced by their users).
+	void clear();
+	//! current statistics on the cache
+	Stats stats() const;
+
+	//! default memory budget: 4 GiB (the GUI applies the budget configured in the preferences on startup)
+	static constexpr size_t DefaultMemoryBudget = static_cast<size_t>(4) * 1024 * 1024 * 1024;
+
+private:
+	//! type-erased cached object
+	class iAAbstractValue
+	{
+	public:
+		virtual ~iAAbstractValue() = default;
+		//! whether the object is currently referenced outside of the cache
+		virtual bool inUse() const = 0;
+	};
+	template <typename PtrT>
+	class iAValue : public iAAbstractValue
+	{
+	public:
+		explicit iAValue(PtrT p) : ptr(p) {}
+		bool inUse() const override
+		{
+			if constexpr (requires { ptr.use_count(); })
+			{   // std::shared_ptr
+				return ptr.use_count() > 1;
+			}
+			else
+			{   // VTK and ITK objects are intrusively reference counted
+				return ptr->GetReferenceCount() > 1;
+			}
+		}
+		PtrT ptr;
+	};
+	struct Entry
+	{
+		QString key;
+		QString absFileName;
+		QDateTime lastModified;
+		size_t bytes;
+		std::shared_ptr<iAAbstractValue> value;
+	};
+
+	iADataCache();
+	iADataCache(iADataCache const&) = delete;
+	void operator=(iADataCache const&) = delete;
+
+	//! look up the entry; a found entry is moved to the front of the LRU list. Call with m_mutex locked!
+	std::shared_ptr<iAAbstractValue> find(QString const& key, QDateTime const& lastModified);
+	//! add an entry; if an entry with the same key and modification time is already present (loaded
+	//! concurrently), the existing value is returned instead; an entry for an older version is replaced
+	std::shared_ptr<iAAbstractValue> insert(Entry&& entry);
+	//! evict unused entries until the budget is met. Call with m_mutex locked!
+	void evict();
+	static QString cacheKey(char const* typeName, QString const& absFileName, QVariantMap const& params);
+
+	mutable QMutex m_mutex;
+	std::list<Entry> m_entries;    //!< cached objects, most recently used first
+	size_t m_memoryBudget;
+	size_t m_bytesResident;
+	size_t m_hits, m_misses, m_evictions;
+};
+
+template <typename PtrT>
+PtrT iADataCache::load(QString const& fileName, QVariantMap const& params,
+	std::function<PtrT()> loadFunc, std::function<size_t(PtrT const&)> sizeFunc)
+{
+	Entry entry;
+	QFileInfo fi(fileName);
+	entry.absFileName = fi.absoluteFilePath();
+	entry.lastModified = fi.lastModified();
+	entry.key = cacheKey(typeid(PtrT).name(), entry.absFileName, params);
+	{
+		QMutexLocker locker(&m_mutex);
+		if (auto value = find(entry.key, entry.lastModified))
+		{
+			return std::static_pointer_cast<iAValue<PtrT>>(value)->ptr;
+		}
+	}
+	PtrT result = loadFunc();
+	if (!result)
+	{
+		return result;
+	}
+	entry.bytes = sizeFunc(result);
+	entry.value = std::make_shared<iAValue<PtrT>>(result);
+	return std::static_pointer_cast<iAValue<PtrT>>(insert(std::move(entry)))->ptr;
+}
@@ -7,6 +7,7 @@
 #include "iALog.h"
 #include "iAProgress.h"
 #include "iAStringHelper.h"
+#include "iATrace.h"
 
 #include <vtkImageData.h>
 
@@ -201,6 +202,7 @@ bool iAFilter::run(QVariantMap const & parameters)
 	}
 	clearOutput();
 	m_outputValues.clear();
+	iATraceSpan span("filter", m_name);
 	performWork(parameters);
 	return true;
 }
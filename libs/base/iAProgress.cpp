@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iAProgress.h"
 
+#include "iATrace.h"
+
 #include <vtkAlgorithm.h>
 #include <vtkCommand.h>
 
@@ -73,6 +75,15 @@ void iAProgress::observe(vtkAlgorithm* caller) const
 	caller->AddObserver(vtkCommand::ProgressEvent, m_vtkCommand);
 }
 
+iAProgress::iAProgress() :
+	m_stageStart(0)
+{}
+
+iAProgress::~iAProgress()
+{
+	traceStage(QString());
+}
+
 void iAProgress::emitProgress(double p) const
 {
 	emit progress(p);
@@ -80,5 +91,22 @@ void iAProgress::emitProgress(double p) const
 
 void iAProgress::setStatus(QString const & status) const
 {
+	traceStage(status);
 	emit statusChanged(status);
 }
+
+void iAProgress::traceStage(QString const& stage) const
+{
+	QMutexLocker locker(&m_stageMutex);
+	if (m_stage.isEmpty() && !iATrace::enabled())
+	{
+		return;
+	}
+	auto now = iATrace::now();
+	if (!m_stage.isEmpty())
+	{
+		iATrace::addEvent(m_stage, "progress", m_stageStart, now);
+	}
+	m_stage = iATrace::enabled() ? stage : QString();
+	m_stageStart = now;
+}
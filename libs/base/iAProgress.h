@@ -7,6 +7,7 @@
 #include <itkCommand.h>
 #include <vtkSmartPointer.h>
 
+#include <QMutex>
 #include <QObject>
 
 class iAProgress;
@@ -34,10 +35,13 @@ class vtkAlgorithm;
 //! Connects computation with progress listeners through signals.
 //! Can be used to track progress of vtk and itk filters,
 //! and provides an interface for manual progress tracking.
+//! If tracing is enabled (see iATrace), the time between status changes is recorded as stages.
 class iAbase_API iAProgress : public QObject
 {
 	Q_OBJECT
 public:
+	iAProgress();
+	~iAProgress();
 	//! observe an ITK algorithm (and pass on its progress report)
 	//! @param caller the ITK algorithm to observe
 	void observe( itk::Object *caller ) const;
@@ -64,6 +68,11 @@ signals:
 	void statusChanged(QString const & status) const;
 
 private:
+	//! end the currently traced stage (if any) and start tracing the given one
+	void traceStage(QString const& stage) const;
 	mutable itk::SmartPointer<iAitkCommand> m_itkCommand;
 	mutable vtkSmartPointer<iAvtkCommand> m_vtkCommand;
+	mutable QMutex m_stageMutex;
+	mutable QString m_stage;       //!< name of the currently traced stage (empty if none)
+	mutable qint64 m_stageStart;   //!< start time of the currently traced stage
 };
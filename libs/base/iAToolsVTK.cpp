@@ -6,8 +6,8 @@
 #include "iALog.h"
 #include "iAMathUtility.h"      // for mapValue
 #include "iAProgress.h"
-#include "iATypedCallHelper.h"
 #include "iAValueTypeVectorHelpers.h"        // for variantVectorFrom
+#include "iAVoxelKernels.h"
 #include "iAVtkDraw.h"
 
 #include <vtkBMPWriter.h>
@@ -28,8 +28,6 @@
 #include <QRegularExpression>
 #include <QStringList>
 
-//#include <omp.h>    // for  omp_get_thread_num
-
 // declared in iAVtkDraw.h
 vtkStandardNewMacro(iAvtkImageData);
 
@@ -71,117 +69,26 @@ vtkSmartPointer<vtkImageData> allocateImage(vtkSmartPointer<vtkImageData> img)
 	return allocateImage(img->GetScalarType(), img->GetDimensions(), img->GetSpacing());
 }
 
-namespace
-{
-	template <typename T>
-	void processImg_tmpl(void* voidPtr, std::function<double(double)> func, qint64 count, iAProgress* p)
-	{
-		T* ptr = static_cast<T*>(voidPtr);
-		qint64 step = count / 100;
-		qint64 lastEmit = 0;
-//#pragma omp parallel for		// no (significant) speedup
-		for (qint64 i = 0; i < count; ++i)
-		{
-			ptr[i] = func(ptr[i]);
-			if (p && i > (lastEmit + step)) // && omp_get_thread_num() == 0)	// in case OpenMP used, see https://stackoverflow.com/questions/28050669/can-i-report-progress-for-openmp-tasks
-			{
-				p->emitProgress(100 * i / count);
-				lastEmit = i;
-			}
-		}
-		if (p)
-		{
-			p->emitProgress(100);
-		}
-	}
-
-	void processImg(vtkSmartPointer<vtkImageData> img, std::function<double(double)> func, iAProgress* p)
-	{
-		int const* dim = img->GetDimensions();
-		int components = img->GetNumberOfScalarComponents();
-		qint64 count = static_cast<qint64>(dim[0]) * static_cast<qint64>(dim[1]) * dim[2] * components;
-		void* voidPtr = img->GetScalarPointer();
-		VTK_TYPED_CALL(processImg_tmpl, img->GetScalarType(), voidPtr, func, count, p);
-	}
-
-	template <typename T, typename U>
-	void processTwoImg_tmpl2(
-		T* dstPtr, void* srcVoidPtr, std::function<double(double, double)> func, qint64 count, iAProgress* p)
-	{
-		U* srcPtr = static_cast<U*>(srcVoidPtr);
-		qint64 step = count / 10;
-		qint64 lastEmit = 0;
-//#pragma omp parallel for		// no (significant) speedup
-		for (qint64 i = 0; i < count; ++i)
-		{
-			dstPtr[i] = static_cast<T>(func(static_cast<double>(dstPtr[i]), static_cast<double>(srcPtr[i])));
-			if (p && i > (lastEmit + step)) // && omp_get_thread_num() == 0)	// in case OpenMP used, see https://stackoverflow.com/questions/28050669/can-i-report-progress-for-openmp-tasks
-			{
-				p->emitProgress(100 * i / count);
-				lastEmit = i;
-			}
-		}
-		if (p)
-		{
-			p->emitProgress(100);
-		}
-	}
-
-	template <typename T>
-	void processTwoImg_tmpl1(void* dstVoidPtr, vtkSmartPointer<vtkImageData> const src, std::function<double(double, double)> func, qint64 count, iAProgress* p)
-	{
-		T* dstPtr = static_cast<T*>(dstVoidPtr);
-		void* srcVoidPtr = src->GetScalarPointer();
-		switch (src->GetScalarType())
-		{
-			case VTK_UNSIGNED_CHAR:      processTwoImg_tmpl2<T, unsigned char>     (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_CHAR:
-			case VTK_SIGNED_CHAR:        processTwoImg_tmpl2<T, char>              (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_SHORT:              processTwoImg_tmpl2<T, short>             (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_UNSIGNED_SHORT:     processTwoImg_tmpl2<T, unsigned short>    (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_INT:                processTwoImg_tmpl2<T, int>               (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_UNSIGNED_INT:       processTwoImg_tmpl2<T, unsigned int>      (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_LONG:               processTwoImg_tmpl2<T, long>              (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_UNSIGNED_LONG:      processTwoImg_tmpl2<T, unsigned long>     (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_LONG_LONG:          processTwoImg_tmpl2<T, long long>         (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_UNSIGNED_LONG_LONG: processTwoImg_tmpl2<T, unsigned long long>(dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_FLOAT:              processTwoImg_tmpl2<T, float>             (dstPtr, srcVoidPtr, func, count, p); break;
-			case VTK_DOUBLE:             processTwoImg_tmpl2<T, double>            (dstPtr, srcVoidPtr, func, count, p); break;
-			default:
-			throw std::runtime_error("Invalid datatype in processTwoImg_tmpl1!");
-		}
-	}
-
-	void processTwoImg(vtkSmartPointer<vtkImageData> img1, vtkSmartPointer<vtkImageData> const img2,
-		std::function<double(double, double)> func, iAProgress* p)
-	{
-		// check for same dimensions/spacing/origin:
-		for (int i = 0; i < 3; ++i)
-		{
-			assert(img1->GetDimensions()[i] == img2->GetDimensions()[i]);
-			assert(img1->GetSpacing()[i]    == img2->GetSpacing()[i]);
-			assert(img1->GetOrigin()[i]     == img2->GetOrigin()[i]);
-		}
-		int const* dim = img1->GetDimensions();
-		qint64 count = static_cast<qint64>(dim[0]) * static_cast<qint64>(dim[1]) * dim[2];
-		void* dstPtr = img1->GetScalarPointer();
-		VTK_TYPED_CALL(processTwoImg_tmpl1, img1->GetScalarType(), dstPtr, img2, func, count, p);
-	}
-}
-
 void fillImage(vtkSmartPointer<vtkImageData> img, double const value, iAProgress* p)
 {
-	processImg(img, [value](double) -> double { return value; }, p);
+	transformImage(img, [value](auto v) { return static_cast<decltype(v)>(value); }, p);
 }
 
-iAbase_API void multiplyImage(vtkSmartPointer<vtkImageData> img, double value, iAProgress* p)
+void multiplyImage(vtkSmartPointer<vtkImageData> img, double value, iAProgress* p)
 {
-	processImg(img, [value](double x) -> double { return x * value; }, p);
+	transformImage(img, [value](auto v) { return v * value; }, p);
 }
 
 void addImages(vtkSmartPointer<vtkImageData> imgDst, vtkSmartPointer<vtkImageData> const imgToAdd, iAProgress* p)
 {
-	processTwoImg(imgDst, imgToAdd, [](double x, double y) -> double { return x + y; }, p);
+	// check for same dimensions/spacing/origin:
+	for (int i = 0; i < 3; ++i)
+	{
+		assert(imgDst->GetDimensions()[i] == imgToAdd->GetDimensions()[i]);
+		assert(imgDst->GetSpacing()[i]    == imgToAdd->GetSpacing()[i]);
+		assert(imgDst->GetOrigin()[i]     == imgToAdd->GetOrigin()[i]);
+	}
+	transformImage(imgDst, imgToAdd, [](auto x, auto y) { return static_cast<double>(x) + static_cast<double>(y); }, p);
 }
 
 void writeSingleSliceImage(QString const & filename, vtkImageData* img, int compressionLevel)
@@ -0,0 +1,236 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iATrace.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace
+{
+	struct iATraceData
+	{
+		QMutex mutex;
+		std::vector<iATrace::iAEvent> events;
+		size_t dropped = 0;
+	};
+	iATraceData& traceData()
+	{
+		static iATraceData data;
+		return data;
+	}
+
+	std::chrono::steady_clock::time_point const TraceEpoch = std::chrono::steady_clock::now();
+
+	std::atomic<quint32> NextThreadNumber(1);
+	quint32 currentThreadNumber()
+	{
+		thread_local quint32 threadNumber = NextThreadNumber.fetch_add(1, std::memory_order_relaxed);
+		return threadNumber;
+	}
+
+	thread_local int CurrentDepth = 0;
+}
+
+std::atomic<bool> iATrace::s_enabled(false);
+
+void iATrace::setEnabled(bool enabled)
+{
+	s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void iATrace::clear()
+{
+	auto& d = traceData();
+	QMutexLocker locker(&d.mutex);
+	d.events.clear();
+	d.dropped = 0;
+}
+
+std::vector<iATrace::iAEvent> iATrace::events()
+{
+	auto& d = traceData();
+	QMutexLocker locker(&d.mutex);
+	return d.events;
+}
+
+size_t iATrace::droppedEventCount()
+{
+	auto& d = traceData();
+	QMutexLocker locker(&d.mutex);
+	return d.dropped;
+}
+
+qint64 iATrace::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - TraceEpoch).count();
+}
+
+void iATrace::addEvent(QString const& name, QString const& category, qint64 start, qint64 end, int depth)
+{
+	iAEvent ev{ name, category, currentThreadNumber(), start, end - start, depth };
+	auto& d = traceData();
+	QMutexLocker locker(&d.mutex);
+	if (d.events.size() >= MaxEventCount)
+	{
+		++d.dropped;
+		return;
+	}
+	d.events.push_back(std::move(ev));
+}
+
+std::vector<iATrace::iASummaryEntry> iATrace::summary()
+{
+	auto evs = events();
+	// determine self time: subtract the duration of each nested span from its direct parent.
+	// spans on the same thread are either disjoint or fully nested, so process them ordered by start
+	// (parents before their children) while keeping the chain of currently open spans on a stack:
+	std::vector<size_t> order;
+	for (size_t i = 0; i < evs.size(); ++i)
+	{
+		if (evs[i].depth != NoDepth)
+		{
+			order.push_back(i);
+		}
+	}
+	std::sort(order.begin(), order.end(), [&evs](size_t a, size_t b)
+		{
+			auto const& ea = evs[a];
+			auto const& eb = evs[b];
+			if (ea.thread != eb.thread)
+			{
+				return ea.thread < eb.thread;
+			}
+			if (ea.start != eb.start)
+			{
+				return ea.start < eb.start;
+			}
+			return ea.depth < eb.depth;
+		});
+	std::vector<qint64> self(evs.size());
+	for (size_t i = 0; i < evs.size(); ++i)
+	{
+		self[i] = evs[i].duration;
+	}
+	std::vector<size_t> open;
+	for (size_t i : order)
+	{
+		auto const& ev = evs[i];
+		while (!open.empty() && (evs[open.back()].thread != ev.thread ||
+			evs[open.back()].start + evs[open.back()].duration < ev.start + ev.duration))
+		{
+			open.pop_back();
+		}
+		if (!open.empty())
+		{
+			self[open.back()] -= ev.duration;
+		}
+		open.push_back(i);
+	}
+
+	std::map<std::pair<QString, QString>, iASummaryEntry> entries;
+	for (size_t i = 0; i < evs.size(); ++i)
+	{
+		auto const& ev = evs[i];
+		double durationMS = ev.duration / 1000.0;
+		auto it = entries.find(std::make_pair(ev.category, ev.name));
+		if (it == entries.end())
+		{
+			entries.insert(std::make_pair(std::make_pair(ev.category, ev.name),
+				iASummaryEntry{ ev.name, ev.category, 1, durationMS, self[i] / 1000.0, durationMS, durationMS }));
+		}
+		else
+		{
+			auto& e = it->second;
+			++e.count;
+			e.total += durationMS;
+			e.self += self[i] / 1000.0;
+			e.min = std::min(e.min, durationMS);
+			e.max = std::max(e.max, durationMS);
+		}
+	}
+	std::vector<iASummaryEntry> result;
+	for (auto const& e : entries)
+	{
+		result.push_back(e.second);
+	}
+	std::sort(result.begin(), result.end(), [](iASummaryEntry const& a, iASummaryEntry const& b) { return a.total > b.total; });
+	return result;
+}
+
+QString iATrace::summaryTable()
+{
+	auto entries = summary();
+	int nameWidth = 9;
+	for (auto const& e : entries)
+	{
+		nameWidth = std::max(nameWidth, static_cast<int>(e.category.size() + e.name.size() + 2));
+	}
+	nameWidth = std::min(nameWidth, 80);
+	QString result = QString("%1 %2 %3 %4 %5 %6 %7\n")
+		.arg(QString("Operation"), -nameWidth)
+		.arg(QString("Count"), 8).arg(QString("Total [ms]"), 12).arg(QString("Self [ms]"), 12)
+		.arg(QString("Mean [ms]"), 12).arg(QString("Min [ms]"), 12).arg(QString("Max [ms]"), 12);
+	for (auto const& e : entries)
+	{
+		result += QString("%1 %2 %3 %4 %5 %6 %7\n")
+			.arg(QString("%1: %2").arg(e.category).arg(e.name).left(nameWidth), -nameWidth)
+			.arg(static_cast<qulonglong>(e.count), 8)
+			.arg(e.total, 12, 'f', 2)
+			.arg(e.self, 12, 'f', 2)
+			.arg(e.total / e.count, 12, 'f', 2)
+			.arg(e.min, 12, 'f', 2)
+			.arg(e.max, 12, 'f', 2);
+	}
+	auto dropped = droppedEventCount();
+	if (dropped > 0)
+	{
+		result += QString("(%1 spans not recorded since the maximum number of spans was reached)\n").arg(dropped);
+	}
+	return result;
+}
+
+bool iATrace::writeChromeTrace(QString const& fileName)
+{
+	QJsonArray traceEvents;
+	for (auto const& ev : events())
+	{
+		QJsonObject obj;
+		obj["name"] = ev.name;
+		obj["cat"] = ev.category;
+		obj["ph"] = "X";    // "complete" event, i.e. start and duration in one event
+		obj["ts"] = ev.start;
+		obj["dur"] = ev.duration;
+		obj["pid"] = 1;
+		obj["tid"] = static_cast<qint64>(ev.thread);
+		traceEvents.append(obj);
+	}
+	QJsonObject root;
+	root["traceEvents"] = traceEvents;
+	root["displayTimeUnit"] = "ms";
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		return false;
+	}
+	auto json = QJsonDocument(root).toJson(QJsonDocument::Compact);
+	return file.write(json) == json.size();
+}
+
+void iATraceSpan::begin()
+{
+	m_depth = CurrentDepth++;
+	m_start = iATrace::now();
+}
+
+void iATraceSpan::end()
+{
+	--CurrentDepth;
+	iATrace::addEvent(m_nameLiteral ? QString(m_nameLiteral) : m_name, m_category, m_start, iATrace::now(), m_depth);
+}
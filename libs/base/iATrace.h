@@ -0,0 +1,122 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iabase_export.h"
+
+#include <QString>
+
+#include <atomic>
+#include <vector>
+
+//! Process-wide recording of the time spent in operations (e.g. filters, file I/O, rendering).
+//!
+//! Operations are recorded as spans (see iATraceSpan) with name, category, thread, start time and
+//! duration; spans on the same thread can be nested. Recording is disabled by default; when
+//! disabled, a span costs only the check of an atomic flag. The recorded spans can be exported
+//! in Chrome's trace event format (viewable e.g. in chrome://tracing or https://ui.perfetto.dev),
+//! or summarized per operation.
+//! All methods are thread-safe.
+class iAbase_API iATrace
+{
+public:
+	//! A recorded span; times are in microseconds since the process-wide trace epoch
+	struct iAEvent
+	{
+		QString name;
+		QString category;
+		quint32 thread;     //!< sequential number of the thread (1 = first thread that recorded a span)
+		qint64 start;
+		qint64 duration;
+		int depth;          //!< nesting depth on its thread (0 = top-level), or NoDepth if not nested (e.g. progress stages)
+	};
+	//! Summary of all spans with the same name and category; times are in milliseconds
+	struct iASummaryEntry
+	{
+		QString name;
+		QString category;
+		size_t count;
+		double total;       //!< summed up duration of all spans
+		double self;        //!< summed up duration of all spans, without the time spent in nested spans
+		double min, max;
+	};
+	//! depth value of spans not participating in nesting
+	static constexpr int NoDepth = -1;
+	//! maximum number of recorded spans; further spans are dropped (see droppedEventCount)
+	static constexpr size_t MaxEventCount = 1000000;
+
+	//! enable or disable recording (already recorded spans are kept)
+	static void setEnabled(bool enabled);
+	//! whether spans are currently recorded
+	static bool enabled()
+	{
+		return s_enabled.load(std::memory_order_relaxed);
+	}
+	//! remove all recorded spans
+	static void clear();
+	//! all recorded spans (in order of their end)
+	static std::vector<iAEvent> events();
+	//! number of spans dropped because MaxEventCount was reached
+	static size_t droppedEventCount();
+	//! summary per operation (name and category), sorted by descending total time
+	static std::vector<iASummaryEntry> summary();
+	//! the summary as human-readable, fixed-width text table
+	static QString summaryTable();
+	//! write the recorded spans as Chrome trace event JSON file
+	//! @return true if the file was written successfully, false otherwise
+	static bool writeChromeTrace(QString const& fileName);
+
+	//! the current time, in microseconds since the trace epoch
+	static qint64 now();
+	//! record a span which was measured separately (e.g. not on a single thread)
+	static void addEvent(QString const& name, QString const& category, qint64 start, qint64 end, int depth = NoDepth);
+
+private:
+	static std::atomic<bool> s_enabled;
+};
+
+//! Records the time from its construction to its destruction as span in iATrace (if enabled at construction).
+//! Usage: iATraceSpan span("io", "Loading file");
+class iAbase_API iATraceSpan
+{
+public:
+	//! start a span with the given category and name; pass string literals where possible
+	//! (they are only converted to QString if the span is actually recorded)
+	iATraceSpan(char const* category, char const* name) :
+		m_active(iATrace::enabled()), m_category(category), m_nameLiteral(name)
+	{
+		if (m_active)
+		{
+			begin();
+		}
+	}
+	//! start a span with the given category and name
+	iATraceSpan(char const* category, QString const& name) :
+		m_active(iATrace::enabled()), m_category(category), m_nameLiteral(nullptr)
+	{
+		if (m_active)
+		{
+			m_name = name;
+			begin();
+		}
+	}
+	//! ends the span
+	~iATraceSpan()
+	{
+		if (m_active)
+		{
+			end();
+		}
+	}
+	iATraceSpan(iATraceSpan const&) = delete;
+	iATraceSpan& operator=(iATraceSpan const&) = delete;
+private:
+	void begin();
+	void end();
+	bool m_active;
+	char const* m_category;
+	char const* m_nameLiteral;
+	QString m_name;
+	qint64 m_start;
+	int m_depth;
+};
@@ -0,0 +1,169 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iAProgress.h"
+
+#include <vtkImageData.h>
+#include <vtkType.h>
+
+#include <QString>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <stdexcept>
+
+//  ----- Voxel kernels: parallel per-voxel operations on raw image buffers and VTK images -----
+//
+// The operations are passed as functors (typically lambdas), which the compiler can inline into the
+// inner loops; in contrast to passing them as std::function, this also allows the inner loops to be
+// vectorized. The voxel range is split into chunks which are processed in parallel; progress is
+// reported per processed chunk. The functors are called concurrently from multiple threads, so they
+// must not modify shared state; they also must not throw exceptions.
+//
+// Example - clamp all values of an image to the range [0, 1]:
+//     transformImage(img, [](auto v) { return std::clamp(v, decltype(v)(0), decltype(v)(1)); });
+
+//! Number of voxels processed as one unit of work by the voxel kernels.
+//! Chosen such that the data of a chunk fits into the (L2) cache for all common voxel types.
+constexpr qint64 VoxelKernelChunkSize = 1 << 15;
+
+//! Process the range [0, count) in parallel, in chunks of the given size.
+//! @param count the number of elements to process
+//! @param chunkFunc called as chunkFunc(begin, end) for each chunk [begin, end) of elements
+//! @param p if given, used to report progress (after each finished chunk)
+//! @param chunkSize the (maximum) number of elements in each chunk
+template <typename ChunkFunc>
+void processChunksParallel(qint64 count, ChunkFunc chunkFunc, iAProgress* p = nullptr, qint64 chunkSize = VoxelKernelChunkSize)
+{
+	assert(chunkSize > 0);
+	qint64 const chunkCount = (count + chunkSize - 1) / chunkSize;
+	std::atomic<qint64> finishedChunks(0);
+	std::atomic<int> lastPercent(0);
+#pragma omp parallel for schedule(dynamic)
+	for (qint64 c = 0; c < chunkCount; ++c)
+	{
+		qint64 const begin = c * chunkSize;
+		chunkFunc(begin, std::min(begin + chunkSize, count));
+		if (p)
+		{   // only emit if percentage has changed, to avoid flooding listeners with signals:
+			int percent = static_cast<int>(100 * (++finishedChunks) / chunkCount);
+			int last = lastPercent.load();
+			while (percent > last && !lastPercent.compare_exchange_weak(last, percent))
+			{}
+			if (percent > last)
+			{
+				p->emitProgress(percent);
+			}
+		}
+	}
+	if (p && lastPercent.load() < 100)
+	{
+		p->emitProgress(100);
+	}
+}
+
+//! Replace each value in a buffer by the result of a unary operation on it: data[i] = op(data[i]).
+template <typename T, typename Op>
+void transformVoxels(T* data, qint64 count, Op op, iAProgress* p = nullptr)
+{
+	processChunksParallel(count, [data, op](qint64 begin, qint64 end)
+		{
+			for (qint64 i = begin; i < end; ++i)
+			{
+				data[i] = static_cast<T>(op(data[i]));
+			}
+		}, p);
+}
+
+//! Compute the values of a buffer from the corresponding values of an arbitrary number of
+//! source buffers: dst[i] = op(src1[i], src2[i], ...). dst may also be one of the sources.
+template <typename TDst, typename Op, typename... TSrc>
+void combineVoxels(TDst* dst, qint64 count, Op op, iAProgress* p, TSrc const*... src)
+{
+	processChunksParallel(count, [dst, op, src...](qint64 begin, qint64 end)
+		{
+			for (qint64 i = begin; i < end; ++i)
+			{
+				dst[i] = static_cast<TDst>(op(src[i]...));
+			}
+		}, p);
+}
+
+//! Combine each value in a buffer with the corresponding value from a second buffer: dst[i] = op(dst[i], src[i]).
+template <typename TDst, typename TSrc, typename Op>
+void transformVoxels(TDst* dst, TSrc const* src, qint64 count, Op op, iAProgress* p = nullptr)
+{
+	combineVoxels(dst, count, op, p, static_cast<TDst const*>(dst), src);
+}
+
+//! Call func with a pointer to the scalar data of the given image, cast to the image's actual scalar type.
+//! @param img the image whose scalar data pointer should be passed to func
+//! @param func a generic functor (e.g. [](auto* ptr) {...}), which gets instantiated for each VTK scalar type
+template <typename Func>
+void callWithTypedScalars(vtkImageData* img, Func func)
+{
+	void* ptr = img->GetScalarPointer();
+	switch (img->GetScalarType())
+	{
+	case VTK_UNSIGNED_CHAR:      func(static_cast<unsigned char*>(ptr));      break;
+	case VTK_SIGNED_CHAR:        func(static_cast<signed char*>(ptr));        break;
+	case VTK_CHAR:               func(static_cast<char*>(ptr));               break;
+	case VTK_SHORT:              func(static_cast<short*>(ptr));              break;
+	case VTK_UNSIGNED_SHORT:     func(static_cast<unsigned short*>(ptr));     break;
+	case VTK_INT:                func(static_cast<int*>(ptr));                break;
+	case VTK_UNSIGNED_INT:       func(static_cast<unsigned int*>(ptr));       break;
+	case VTK_LONG:               func(static_cast<long*>(ptr));               break;
+	case VTK_UNSIGNED_LONG:      func(static_cast<unsigned long*>(ptr));      break;
+	case VTK_LONG_LONG:          func(static_cast<long long*>(ptr));          break;
+	case VTK_UNSIGNED_LONG_LONG: func(static_cast<unsigned long long*>(ptr)); break;
+	case VTK_FLOAT:              func(static_cast<float*>(ptr));              break;
+	case VTK_DOUBLE:             func(static_cast<double*>(ptr));             break;
+	default:
+		throw std::runtime_error(QString("Unsupported VTK scalar type %1 in voxel kernel!")
+			.arg(img->GetScalarType()).toStdString());
+	}
+}
+
+//! The number of values (voxels times components) stored in the given image.
+inline qint64 valueCount(vtkImageData* img)
+{
+	int const* dim = img->GetDimensions();
+	return static_cast<qint64>(dim[0]) * dim[1] * dim[2] * img->GetNumberOfScalarComponents();
+}
+
+//! Replace each value of an image by the result of a unary operation on it.
+//! @param img the image to modify
+//! @param op a generic functor, called with the value in the image's scalar type
+//! @param p if given, used to report progress
+template <typename Op>
+void transformImage(vtkImageData* img, Op op, iAProgress* p = nullptr)
+{
+	callWithTypedScalars(img, [img, &op, p](auto* data)
+		{
+			transformVoxels(data, valueCount(img), op, p);
+		});
+}
+
+//! Combine each value of an image with the corresponding value of a second image
+//! of same dimensions and number of components (but potentially different scalar type).
+//! @param dst the image to modify
+//! @param src the image providing the second operand (not modified)
+//! @param op a generic functor, called as op(dstValue, srcValue) in the images' respective scalar types
+//! @param p if given, used to report progress
+template <typename Op>
+void transformImage(vtkImageData* dst, vtkImageData* src, Op op, iAProgress* p = nullptr)
+{
+	if (valueCount(dst) != valueCount(src))
+	{
+		throw std::runtime_error("Images combined in voxel kernel have different number of values!");
+	}
+	callWithTypedScalars(dst, [dst, src, &op, p](auto* dstData)
+		{
+			callWithTypedScalars(src, [dst, dstData, &op, p](auto* srcData)
+				{
+					transformVoxels(dstData, srcData, valueCount(dst), op, p);
+				});
+		});
+}
@@ -6,6 +6,7 @@
 #include "iAMathUtility.h"
 #include "iAVtkDataTypeMapper.h"
 #include "iAToolsVTK.h"
+#include "iATrace.h"
 #include "iATypedCallHelper.h"
 
 //#define MODE_OWN 0        // use self-written code
@@ -59,11 +60,13 @@ void iAHistogramData::setBin(size_t binIdx, DataType value)
 {
 	m_histoData[binIdx] = value;
 	adaptBounds(m_yBounds, value);
+	invalidateLOD();
 }
 
 void iAHistogramData::clear()
 {
 	std::fill(m_histoData, m_histoData + m_numBin, 0);
+	invalidateLOD();
 }
 
 void iAHistogramData::setSpacing(DataType spacing)
@@ -272,6 +275,7 @@ std::shared_ptr<iAHistogramData> iAHistogramData::create(QString const& name,
 	auto numBins = finalNumBin(img, desiredNumBin);
 	auto histRange = histoRange(scalarRange, numBins, valueType);
 	auto result = iAHistogramData::create(name, valueType, scalarRange[0], scalarRange[0] + histRange, numBins);
+	iATraceSpan span("compute", "Image histogram");
 
 	//QElapsedTimer timer;
 	//timer.start();
@@ -4,6 +4,31 @@
 
 #include <QString>
 
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	using iAMinMax = std::pair<iAPlotData::DataType, iAPlotData::DataType>;
+
+	iAMinMax emptyRange()
+	{
+		return iAMinMax(std::numeric_limits<iAPlotData::DataType>::infinity(), -std::numeric_limits<iAPlotData::DataType>::infinity());
+	}
+
+	//! extend range by the given minimum and maximum; comparisons are written such that NaN values are ignored
+	void adaptRange(iAMinMax& range, iAPlotData::DataType minVal, iAPlotData::DataType maxVal)
+	{
+		if (minVal < range.first)
+		{
+			range.first = minVal;
+		}
+		if (maxVal > range.second)
+		{
+			range.second = maxVal;
+		}
+	}
+}
 
 iAPlotData::iAPlotData(QString const & name, iAValueType type): m_name(name), m_valueType(type)
 {}
@@ -21,6 +46,98 @@ iAValueType iAPlotData::valueType() const
 	return m_valueType;
 }
 
+std::pair<iAPlotData::DataType, iAPlotData::DataType> iAPlotData::yRange(size_t firstIdx, size_t lastIdx) const
+{
+	auto result = emptyRange();
+	size_t lo = firstIdx, hi = lastIdx + 1;
+	std::shared_ptr<LODLevels const> levels;
+	if (valueCount() >= LODMinValueCount && hi - lo >= 2 * LODFactor)
+	{
+		QMutexLocker locker(&m_lodMutex);
+		if (!m_lod)
+		{
+			m_lod = buildLOD();
+		}
+		levels = m_lod;
+	}
+	// at each level, consider the elements not covered by a whole element of the next higher level
+	// individually, then continue with the remaining (aligned) range on the next higher level:
+	while (lo < hi && (!levels || lo % LODFactor != 0))
+	{
+		auto v = yValue(lo++);
+		adaptRange(result, v, v);
+	}
+	while (lo < hi && hi % LODFactor != 0)
+	{
+		auto v = yValue(--hi);
+		adaptRange(result, v, v);
+	}
+	lo /= LODFactor;
+	hi /= LODFactor;
+	for (size_t l = 0; levels && l < levels->size() && lo < hi; ++l)
+	{
+		auto const& level = (*levels)[l];
+		bool const topLevel = (l == levels->size() - 1);
+		while (lo < hi && (topLevel || lo % LODFactor != 0))
+		{
+			adaptRange(result, level[lo].first, level[lo].second);
+			++lo;
+		}
+		while (lo < hi && hi % LODFactor != 0)
+		{
+			--hi;
+			adaptRange(result, level[hi].first, level[hi].second);
+		}
+		lo /= LODFactor;
+		hi /= LODFactor;
+	}
+	return result;
+}
+
+void iAPlotData::invalidateLOD()
+{
+	QMutexLocker locker(&m_lodMutex);
+	m_lod.reset();
+}
+
+std::shared_ptr<iAPlotData::LODLevels const> iAPlotData::buildLOD() const
+{
+	auto levels = std::make_shared<LODLevels>();
+	qint64 const factor = LODFactor;
+	qint64 const count = static_cast<qint64>(valueCount());
+	levels->emplace_back((count + factor - 1) / factor);
+	auto& lowest = levels->back();
+#pragma omp parallel for
+	for (qint64 b = 0; b < static_cast<qint64>(lowest.size()); ++b)
+	{
+		auto range = emptyRange();
+		for (qint64 i = b * factor; i < std::min((b + 1) * factor, count); ++i)
+		{
+			auto v = yValue(i);
+			adaptRange(range, v, v);
+		}
+		lowest[b] = range;
+	}
+	while (levels->back().size() > LODFactor)
+	{
+		qint64 const belowCount = static_cast<qint64>(levels->back().size());
+		levels->emplace_back((belowCount + factor - 1) / factor);
+		auto const& below = (*levels)[levels->size() - 2];
+		auto& level = levels->back();
+#pragma omp parallel for
+		for (qint64 b = 0; b < static_cast<qint64>(level.size()); ++b)
+		{
+			auto range = emptyRange();
+			for (qint64 i = b * factor; i < std::min((b + 1) * factor, belowCount); ++i)
+			{
+				adaptRange(range, below[i].first, below[i].second);
+			}
+			level[b] = range;
+		}
+	}
+	return levels;
+}
+
 void adaptBounds(iAPlotData::DataType bounds[2], iAPlotData::DataType value)
 {
 	if (value < bounds[0])
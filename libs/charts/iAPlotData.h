@@ -6,11 +6,22 @@
 
 #include "iacharts_export.h"
 
+#include <QMutex>
 #include <QString>
 
 #include <cstddef> // for size_t
+#include <memory>
+#include <utility> // for pair
+#include <vector>
 
 //! Abstract base class providing data used for drawing a plot in a chart.
+//!
+//! For drawing data series with many more values than there are pixels, plots need the minimum
+//! and maximum y value of ranges of consecutive values, see yRange. For large data series, these
+//! are retrieved from a min/max level-of-detail (LOD) pyramid: each level stores minimum and
+//! maximum of blocks of LODFactor elements of the level below (the lowest level summarizes the
+//! y values themselves). The pyramid is built on first use; derived classes need to call
+//! invalidateLOD whenever their y values change.
 class iAcharts_API iAPlotData
 {
 public:
@@ -49,7 +60,31 @@ public:
 	//! @return a description of the datapoint that the user currrently is over/closest to.
 	virtual QString toolTipText(DataType dataX) const =0;
 
+	//! Minimum and maximum y value in the index range [firstIdx, lastIdx].
+	//! Takes time logarithmic in the size of the range (apart from building the LOD pyramid on first use).
+	//! Thread-safe, as long as yValue is.
+	//! @return pair of minimum and maximum; minimum is larger than maximum if the range contains only NaN values.
+	std::pair<DataType, DataType> yRange(size_t firstIdx, size_t lastIdx) const;
+
+	//! number of elements of a level in the LOD pyramid summarized by one element in the next higher level
+	static constexpr size_t LODFactor = 8;
+	//! minimum number of values for which an LOD pyramid is built (for less, yRange simply checks all values)
+	static constexpr size_t LODMinValueCount = 4096;
+
+protected:
+	//! Discard the LOD pyramid (it is rebuilt on next use); needs to be called whenever y values change.
+	void invalidateLOD();
+
 private:
+	using LODLevels = std::vector<std::vector<std::pair<DataType, DataType>>>;
+	//! build the LOD pyramid from the current y values
+	std::shared_ptr<LODLevels const> buildLOD() const;
+
+	//! The LOD pyramid, lowest level first (null if not built yet).
+	mutable std::shared_ptr<LODLevels const> m_lod;
+	//! Guards access to m_lod.
+	mutable QMutex m_lodMutex;
+
 	//! The name of the data series that this object holds.
 	QString m_name;
 	//! The type of the values that were used as input to compute the histogram.
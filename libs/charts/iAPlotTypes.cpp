@@ -11,6 +11,9 @@
 #include <QPainterPath>
 #include <QPolygon>
 
+#include <algorithm>
+#include <cstdlib> // for std::abs
+
 // iAPlot
 
 iAPlot::iAPlot(std::shared_ptr<iAPlotData> data, QColor const & color):
@@ -79,17 +82,105 @@ void iASelectedBinPlot::setSelectedBin(size_t idx)
 
 
 
+// Level of detail:
+// When there are considerably more data points than pixel columns, the plots below only draw what
+// is actually visible: all data points drawn in the same pixel column are merged, such that the
+// output stays identical to drawing each data point separately. Data points are grouped by
+// (truncated) pixel column; since x values are ascending, each column holds a contiguous index range.
 namespace
 {
+	//! pixel column in which the data point with the given index is drawn
+	int pixelColumn(iAPlotData const& data, size_t idx, iAMapper const& xMapper)
+	{
+		return static_cast<int>(xMapper.srcToDst(data.xValue(idx)));
+	}
+
+	//! whether the data points in the given range are considerably more than the pixel columns they are drawn in
+	bool useLOD(iAPlotData const& data, size_t startIdx, size_t endIdx, iAMapper const& xMapper)
+	{
+		size_t columns = std::abs(pixelColumn(data, endIdx, xMapper) - pixelColumn(data, startIdx, xMapper)) + 1;
+		return endIdx - startIdx + 1 > 2 * columns;
+	}
+
+	//! the index of the last data point in [idx, endIdx] that is drawn in the same pixel column as idx
+	size_t lastIdxInColumn(iAPlotData const& data, size_t idx, size_t endIdx, iAMapper const& xMapper)
+	{
+		int column = pixelColumn(data, idx, xMapper);
+		// exponential search for an index in another column, then binary search in between;
+		// lo is always in the column, hi never (endIdx + 1 stands for "past the end"):
+		size_t lo = idx, hi = idx + 1, step = 1;
+		while (hi <= endIdx && pixelColumn(data, hi, xMapper) == column)
+		{
+			lo = hi;
+			step *= 2;
+			hi = idx + step;
+		}
+		hi = std::min(hi, endIdx + 1);
+		while (hi - lo > 1)
+		{
+			size_t mid = lo + (hi - lo) / 2;
+			if (pixelColumn(data, mid, xMapper) == column)
+			{
+				lo = mid;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+		return lo;
+	}
+
+	//! call func(column, firstIdx, lastIdx) for each pixel column containing data points from [startIdx, endIdx]
+	template <typename Func>
+	void forEachPixelColumn(iAPlotData const& data, size_t startIdx, size_t endIdx, iAMapper const& xMapper, Func func)
+	{
+		for (size_t idx = startIdx; idx <= endIdx; )
+		{
+			size_t lastIdx = lastIdxInColumn(data, idx, endIdx, xMapper);
+			func(pixelColumn(data, idx, xMapper), idx, lastIdx);
+			idx = lastIdx + 1;
+		}
+	}
+
+	void addPoint(QPolygon& poly, QPoint const& pt)
+	{
+		if (poly.isEmpty() || poly.back() != pt)
+		{
+			poly.push_back(pt);
+		}
+	}
+
+	//! @param extremes whether the polygon will be stroked; a filled polygon has no area within a single pixel
+	//!        column, so there, only the first and the last data point of each column are required. For stroking,
+	//!        the vertical line between minimum and maximum in the column is required as well
 	void buildLinePolygon(QPolygon& poly, std::shared_ptr<iAPlotData> data, size_t startIdx, size_t endIdx,
-		iAMapper const& xMapper, iAMapper const& yMapper)
+		iAMapper const& xMapper, iAMapper const& yMapper, bool extremes)
 	{
-		for (size_t idx = startIdx; idx <= endIdx; ++idx)
+		if (!useLOD(*data, startIdx, endIdx, xMapper))
 		{
-			int curX = xMapper.srcToDst(data->xValue(idx));
-			int curY = yMapper.srcToDst(data->yValue(idx));
-			poly.push_back(QPoint(curX, curY));
+			for (size_t idx = startIdx; idx <= endIdx; ++idx)
+			{
+				int curX = xMapper.srcToDst(data->xValue(idx));
+				int curY = yMapper.srcToDst(data->yValue(idx));
+				poly.push_back(QPoint(curX, curY));
+			}
+			return;
 		}
+		forEachPixelColumn(*data, startIdx, endIdx, xMapper, [&](int x, size_t firstIdx, size_t lastIdx)
+		{
+			addPoint(poly, QPoint(x, static_cast<int>(yMapper.srcToDst(data->yValue(firstIdx)))));
+			if (extremes && lastIdx > firstIdx + 1)
+			{
+				auto range = data->yRange(firstIdx + 1, lastIdx - 1);
+				if (range.first <= range.second)
+				{
+					addPoint(poly, QPoint(x, static_cast<int>(yMapper.srcToDst(range.first))));
+					addPoint(poly, QPoint(x, static_cast<int>(yMapper.srcToDst(range.second))));
+				}
+			}
+			addPoint(poly, QPoint(x, static_cast<int>(yMapper.srcToDst(data->yValue(lastIdx)))));
+		});
 	}
 }
 
@@ -113,7 +204,7 @@ void iALinePlot::draw(QPainter& painter, size_t startIdx, size_t endIdx, iAMappe
 		return;
 	}
 	QPolygon poly;
-	buildLinePolygon(poly, m_data, startIdx, endIdx, xMapper, yMapper);
+	buildLinePolygon(poly, m_data, startIdx, endIdx, xMapper, yMapper, true);
 	QPen pen(painter.pen());
 	pen.setWidth(m_lineWidth);
 	pen.setColor(color());
@@ -142,7 +233,7 @@ void iAFilledLinePlot::draw(QPainter& painter, size_t startIdx, size_t endIdx, i
 	int pt1x = xMapper.srcToDst(m_data->xValue(startIdx - (startIdx > 0 ? 1 : 0)));
 	int pt2x = xMapper.srcToDst(m_data->xValue(endIdx + (endIdx >= m_data->valueCount() ? 1 : 0)));
 	poly.push_back(QPoint(pt1x, 0));
-	buildLinePolygon(poly, m_data, startIdx, endIdx, xMapper, yMapper);
+	buildLinePolygon(poly, m_data, startIdx, endIdx, xMapper, yMapper, false);
 	poly.push_back(QPoint(pt2x, 0));
 	QPainterPath tmpPath;
 	tmpPath.addPolygon(poly);
@@ -190,13 +281,25 @@ void iAStepFunctionPlot::draw(QPainter& painter, size_t startIdx, size_t endIdx,
 	QPainterPath tmpPath;
 	QPolygon poly;
 	poly.push_back(QPoint(xMapper.srcToDst(m_data->xValue(startIdx)), 0));
-	for (size_t idx = startIdx; idx <= endIdx; ++idx)
+	if (useLOD(*m_data, startIdx, endIdx, xMapper))
+	{	// in a column with multiple data points, all steps but the last have zero width:
+		forEachPixelColumn(*m_data, startIdx, endIdx, xMapper, [&](int x, size_t /*firstIdx*/, size_t lastIdx)
+		{
+			int curY = yMapper.srcToDst(m_data->yValue(lastIdx));
+			poly.push_back(QPoint(x, curY));
+			poly.push_back(QPoint(xMapper.srcToDst(m_data->xValue(lastIdx + 1)), curY));
+		});
+	}
+	else
 	{
-		int curX1 = xMapper.srcToDst(m_data->xValue(idx));
-		int curX2 = xMapper.srcToDst(m_data->xValue(idx + 1));
-		int curY = yMapper.srcToDst(m_data->yValue(idx));
-		poly.push_back(QPoint(curX1, curY));
-		poly.push_back(QPoint(curX2, curY));
+		for (size_t idx = startIdx; idx <= endIdx; ++idx)
+		{
+			int curX1 = xMapper.srcToDst(m_data->xValue(idx));
+			int curX2 = xMapper.srcToDst(m_data->xValue(idx + 1));
+			int curY = yMapper.srcToDst(m_data->yValue(idx));
+			poly.push_back(QPoint(curX1, curY));
+			poly.push_back(QPoint(curX2, curY));
+		}
 	}
 	poly.push_back(QPoint(xMapper.srcToDst(m_data->xValue(endIdx + 1)), 0));
 	tmpPath.addPolygon(poly);
@@ -218,6 +321,36 @@ iABarGraphPlot::iABarGraphPlot(std::shared_ptr<iAPlotData> data, QColor const& c
 void iABarGraphPlot::draw(QPainter& painter, size_t startIdx, size_t endIdx, iAMapper const & xMapper, iAMapper const & yMapper) const
 {
 	QColor fillColor = color();
+	// with a lookup table or a translucent color, the result depends on each single bar drawn:
+	if (!m_lut && fillColor.alpha() == 255 && useLOD(*m_data, startIdx, endIdx, xMapper))
+	{
+		forEachPixelColumn(*m_data, startIdx, endIdx, xMapper, [&](int x, size_t firstIdx, size_t lastIdx)
+		{
+			// all bars but the last in a column have a width of -m_margin; the union of them is covered by
+			// the bars with the largest positive and negative height:
+			if (m_margin > 0 && lastIdx > firstIdx)
+			{
+				auto range = m_data->yRange(firstIdx, lastIdx - 1);
+				if (range.first <= range.second)
+				{
+					int h1 = yMapper.srcToDst(range.first);
+					int h2 = yMapper.srcToDst(range.second);
+					if (std::max(h1, h2) > 0)
+					{
+						painter.fillRect(QRect(x, 1, -m_margin, std::max(h1, h2)), fillColor);
+					}
+					if (std::min(h1, h2) < 0)
+					{
+						painter.fillRect(QRect(x, 1, -m_margin, std::min(h1, h2)), fillColor);
+					}
+				}
+			}
+			int barWidth = xMapper.srcToDst(m_data->xValue(lastIdx + 1)) - x - m_margin;
+			int h = yMapper.srcToDst(m_data->yValue(lastIdx));
+			painter.fillRect(QRect(x, 1, barWidth, h), fillColor);
+		});
+		return;
+	}
 	for (size_t idx = startIdx; idx <= endIdx; ++idx)
 	{
 		int x = xMapper.srcToDst(m_data->xValue(idx));
@@ -102,7 +102,8 @@ iAQSplom::Settings::Settings() :
 	colorThemeName("Diverging blue-gray-red"),
 	colorThemeQualName("Brewer Set3 (max. 12)"),
 	pointColor(QColor(128, 128, 128)),
-	enableColorSettings(false)
+	enableColorSettings(false),
+	densityThreshold(100000)
 {
 }
 
@@ -164,6 +165,26 @@ void iAQSplom::setSelectionColor(QColor color)
 	}
 }
 
+void iAQSplom::setDensityThreshold(size_t threshold)
+{
+	settings.densityThreshold = threshold;
+	for (auto& row : m_matrix)
+	{
+		for (auto s : row)
+		{
+			if (s)
+			{
+				s->settings.densityThreshold = threshold;
+			}
+		}
+	}
+	if (m_maximizedPlot)
+	{
+		m_maximizedPlot->settings.densityThreshold = threshold;
+	}
+	update();
+}
+
 void iAQSplom::setSelectionMode(int mode)
 {
 	if (m_maximizedPlot)
@@ -417,6 +438,7 @@ void iAQSplom::createScatterPlot(size_t y, size_t x, bool initial)
 	s->setPointRadius(settings.pointRadius);
 	s->settings.showPCC = settings.showPCC;
 	s->settings.showSCC = settings.showSCC;
+	s->settings.densityThreshold = settings.densityThreshold;
 	if (!initial)
 	{
 		s->setLookupTable(m_lut, m_colorLookupParam);
@@ -897,6 +919,7 @@ void iAQSplom::maximizeSelectedPlot(iAScatterPlot *selectedPlot)
 	m_maximizedPlot->settings.selectionEnabled = settings.selectionEnabled;
 	m_maximizedPlot->settings.showPCC = settings.showPCC;
 	m_maximizedPlot->settings.showSCC = settings.showSCC;
+	m_maximizedPlot->settings.densityThreshold = settings.densityThreshold;
 	updateMaxPlotRect();
 	if (selectedPlot->getRect().height() > 0)
 	{
@@ -119,6 +119,7 @@ public:
 	void setPointOpacity( double opacity );                          //!< set the opaci	ty for all data points
 	std::shared_ptr<iAScatterPlotViewData> viewData();
 	void setSelectionColor(QColor color);                            //!< set the color for selected points
+	void setDensityThreshold(size_t threshold);                      //!< set the number of visible points above which scatter plots show a density image instead of single points
 	void enableSelection(bool enable);                               //!< set whether selections are allowed or not
 	void getActivePlotIndices( int * inds_out );                     //!< Get X and Y parameter indices of currently active scatter plot.
 	int visibleParametersCount() const;                              //!< Get the number of parameters currently displayed
@@ -262,6 +263,7 @@ public:
 
 		QColor pointColor;                       //!< Color for each point if color scheme is uniform
 		bool enableColorSettings;                //!< Whether color coding settings are accessible
+		size_t densityThreshold;                 //!< Number of visible points above which a scatter plot shows a density image instead of single points
 	};
 	Settings settings;
 protected:
@@ -2,79 +2,86 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iASPLOMData.h"
 
+#include "iAColumnarTable.h"
+
 const size_t iASPLOMData::NoDataIdx = std::numeric_limits<size_t>::max();
 
-iASPLOMData::iASPLOMData()
+iASPLOMData::iASPLOMData():
+	m_table(std::make_shared<iAColumnarTable>())
+{
+}
+
+iASPLOMData::iASPLOMData(std::shared_ptr<iAColumnarTable> table):
+	m_table(table)
 {
 }
 
+std::shared_ptr<iAColumnarTable> iASPLOMData::table() const
+{
+	return m_table;
+}
+
 void iASPLOMData::setParameterNames(std::vector<QString> const & names, size_t rowReserve)
 {
-	m_paramNames = names;
-	m_dataPoints.clear();
-	for (size_t i = 0; i < m_paramNames.size(); ++i)
+	m_table->columnNames() = names;
+	auto& columns = m_table->columns();
+	columns.clear();
+	for (size_t i = 0; i < names.size(); ++i)
 	{
 		std::vector<double> column;
 		if (rowReserve > 0)
 		{
 			column.reserve(rowReserve);
 		}
-		m_dataPoints.push_back(column);
+		columns.push_back(column);
 	}
 }
 
 void iASPLOMData::addParameter(QString& name)
 {
-	m_paramNames.push_back(name);
+	m_table->addColumn(name);
 	m_ranges.push_back(std::vector<double>(2, 0));
-	m_dataPoints.push_back(std::vector<double>(numPoints()));
 }
 
 std::vector<std::vector<double>> & iASPLOMData::data()
 {
-	return m_dataPoints;
+	return m_table->columns();
 }
 
 std::vector<QString> & iASPLOMData::paramNames()
 {
-	return m_paramNames;
+	return m_table->columnNames();
 }
 
 const std::vector<std::vector<double>> & iASPLOMData::data() const
 {
-	return m_dataPoints;
+	return m_table->columns();
 }
 
 const std::vector<double> & iASPLOMData::paramData(size_t paramIndex) const
 {
-	return m_dataPoints[paramIndex];
+	return m_table->column(paramIndex);
 }
 
 QString iASPLOMData::parameterName(size_t paramIndex) const
 {
-	return m_paramNames[paramIndex];
+	return m_table->columnName(paramIndex);
 }
 
 size_t iASPLOMData::paramIndex(QString const & paramName) const
 {
-	for (unsigned long i = 0; i < numParams(); ++i)
-	{
-		if (m_paramNames[i] == paramName)
-		{
-			return i;
-		}
-	}
-	return NoDataIdx;
+	size_t idx = m_table->columnIndex(paramName);
+	return (idx == iAColumnarTable::NoColumn) ? NoDataIdx : idx;
 }
 
 size_t iASPLOMData::numParams() const
 {
-	return m_paramNames.size();
+	return m_table->columnCount();
 }
 
 size_t iASPLOMData::numPoints() const
 {
-	return m_dataPoints.size() < 1 ? 0 : m_dataPoints[0].size();
+	return m_table->rowCount();
 }
 
 double const* iASPLOMData::paramRange(size_t paramIndex) const
@@ -84,12 +91,12 @@ double const* iASPLOMData::paramRange(size_t paramIndex) const
 
 void iASPLOMData::updateRanges()
 {
-	m_ranges.resize(m_dataPoints.size());
-	for (size_t param = 0; param < m_dataPoints.size(); ++param)
+	m_ranges.resize(numParams());
+	for (size_t param = 0; param < numParams(); ++param)
 	{
 		updateRangeInternal(param);
 	}
-	for (size_t param = 0; param < m_dataPoints.size(); ++param)
+	for (size_t param = 0; param < numParams(); ++param)
 	{
 		emit dataChanged(param);
 	}
@@ -115,16 +122,17 @@ void iASPLOMData::updateRange(size_t paramIndex)
 
 void iASPLOMData::updateRangeInternal(size_t paramIndex)
 {
-	if (paramIndex >= m_dataPoints.size())
+	if (paramIndex >= numParams())
 	{
 		return;
 	}
+	auto const& values = m_table->column(paramIndex);
 	m_ranges[paramIndex].resize(2);
 	m_ranges[paramIndex][0] = std::numeric_limits<double>::max();
 	m_ranges[paramIndex][1] = std::numeric_limits<double>::lowest();
-	for (size_t row = 0; row < m_dataPoints[paramIndex].size(); ++row)
+	for (size_t row = 0; row < values.size(); ++row)
 	{
-		double value = m_dataPoints[paramIndex][row];
+		double value = values[row];
 		if (value < m_ranges[paramIndex][0])
 		{
 			m_ranges[paramIndex][0] = value;
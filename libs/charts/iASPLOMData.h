@@ -7,18 +7,26 @@
 #include <QObject>
 
 #include <cstddef>    // for size_t
+#include <memory>
 #include <vector>
 
+class iAColumnarTable;
+
 class QString;
 
 //! Stores data shown in a scatter plot matrix (SPLOM).
 //! Data is represented as table with data values for one object per row, along with the names of the columns/parameters.
+//! The values are stored in an iAColumnarTable, which can be shared with other views on the same data.
 class iAcharts_API iASPLOMData : public QObject
 {
 	Q_OBJECT
 public:
 	static const size_t NoDataIdx;
 	iASPLOMData();
+	//! Create SPLOM data directly operating on the given table (without copying its values).
+	//! Note that modifications of the data (e.g. via data() or setParameterNames) are applied to the shared table.
+	explicit iASPLOMData(std::shared_ptr<iAColumnarTable> table);
+	std::shared_ptr<iAColumnarTable> table() const;   //!< Get the table holding the values
 	void setParameterNames(std::vector<QString> const& paramNmes, size_t rowReserve = 0);  //! Set the parameter names (clears all columns) with an optional row "size" (i.e. how many rows are planned to be there, i.e. used in vector::reserve)
 	std::vector<std::vector<double>> & data();        //!< Get the table values
 	std::vector<QString> & paramNames();              //!< Get the names of the columns/parameters
@@ -36,8 +44,7 @@ public:
 signals:
 	void dataChanged(size_t paramIndex);              //!< emitted when the range of a parameter has changed
 protected:
-	std::vector<QString> m_paramNames;                //!< list of parameter names
-	std::vector<std::vector<double>> m_dataPoints;    //!< lists containing data points
+	std::shared_ptr<iAColumnarTable> m_table;         //!< parameter names and lists containing data points
 	std::vector<std::vector<double> > m_ranges;       //!< ranges of all parameters
 private:
 	void updateRangeInternal(size_t paramIndex);      //!< Update internal range data for parameter paramIndex
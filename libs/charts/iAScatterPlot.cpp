@@ -2,10 +2,12 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iAScatterPlot.h"
 
+#include "iABitSet.h"
 #include "iAColorTheme.h"
 #include "iALog.h"
 #include "iALookupTable.h"
 #include "iAMathUtility.h"
+#include "iAScatterPlotDensity.h"
 #include "iAScatterPlotViewData.h"
 #include "iASPLOMData.h"
 
@@ -18,6 +20,9 @@
 #include <QPolygon>
 #include <QWheelEvent>
 
+#include <functional>
+#include <utility>    // for std::as_const
+
 
 iAScatterPlot::Settings::Settings() :
 	pickedPointMagnification( 2.0 ),
@@ -45,7 +50,9 @@ iAScatterPlot::Settings::Settings() :
 	selectionEnabled(false),
 	showPCC(false),
 	showSCC(false),
-	drawGridLines(true)
+	drawGridLines(true),
+	densityThreshold(100000),
+	densityGridSize(256)
 {}
 
 iAScatterPlot::iAScatterPlot(iAScatterPlotViewData* viewData, iAChartParentWidget* parent,
@@ -71,6 +78,11 @@ iAScatterPlot::iAScatterPlot(iAScatterPlotViewData* viewData, iAChartParentWidge
 	m_isPreviewPlot( false ),
 	m_curVisiblePts ( 0 ),
 	m_dragging(false),
+	m_density(std::make_unique<iAScatterPlotDensity>()),
+	m_densityCellsOutdated(true),
+	m_densityCountsOutdated(true),
+	m_densitySelectionVersion(0),
+	m_drawDensity(false),
 	m_pcc(0),
 	m_scc(0),
 	m_pccValid(false),
@@ -133,6 +145,7 @@ void iAScatterPlot::updatePoints()
 #ifdef SP_OLDOPENGL
 	m_pointsOutdated = true;
 #endif
+	m_densityCountsOutdated = true;
 }
 
 void iAScatterPlot::setLookupTable( std::shared_ptr<iALookupTable> &lut, size_t colInd )
@@ -272,7 +285,10 @@ void iAScatterPlot::paintOnParent( QPainter & painter )
 	{
 		return;
 	}
-	if (m_pointsOutdated)
+#endif
+	m_drawDensity = updateDensity();
+#ifdef SP_OLDOPENGL
+	if (m_pointsOutdated && !m_drawDensity)
 	{
 		fillVBO();
 	}
@@ -584,6 +600,7 @@ void iAScatterPlot::dataChanged(size_t paramIndex)
 
 void iAScatterPlot::applyMarginToRanges()
 {
+	m_densityCellsOutdated = true;
 	m_prX[0] = m_splomData->paramRange(m_paramIndices[0])[0];
 	m_prX[1] = m_splomData->paramRange(m_paramIndices[0])[1];
 	if (m_prX[0] == m_prX[1])
@@ -740,14 +757,97 @@ QPointF iAScatterPlot::getPositionFromPointIndex( size_t idx ) const
 	return QPointF( x, y );
 }
 
+namespace
+{
+	enum class iARectPolygonRelation { Outside, Inside, Partial };
+
+	//! whether the line segment from a to b intersects the given rectangle
+	bool segmentIntersectsRect(QPointF const& a, QPointF const& b, QRectF const& rect)
+	{
+		if (std::max(a.x(), b.x()) < rect.left() || std::min(a.x(), b.x()) > rect.right() ||
+			std::max(a.y(), b.y()) < rect.top() || std::min(a.y(), b.y()) > rect.bottom())
+		{
+			return false;
+		}
+		// bounding boxes overlap; the segment intersects if the rectangle's corners are not all on the same side of its line:
+		auto side = [&a, &b](QPointF const& p) { return (b.x() - a.x()) * (p.y() - a.y()) - (b.y() - a.y()) * (p.x() - a.x()); };
+		double s[4] = { side(rect.topLeft()), side(rect.topRight()), side(rect.bottomLeft()), side(rect.bottomRight()) };
+		return !((s[0] > 0 && s[1] > 0 && s[2] > 0 && s[3] > 0) || (s[0] < 0 && s[1] < 0 && s[2] < 0 && s[3] < 0));
+	}
+
+	//! whether the given rectangle is completely inside, completely outside, or partially inside the given polygon
+	iARectPolygonRelation rectPolygonRelation(QRectF const& rect, QPolygonF const& poly)
+	{
+		for (qsizetype i = 0; i < poly.size(); ++i)
+		{
+			if (segmentIntersectsRect(poly[i], poly[(i + 1) % poly.size()], rect))
+			{
+				return iARectPolygonRelation::Partial;
+			}
+		}
+		// no polygon edge crosses the rectangle, so it is either fully inside or fully outside:
+		return poly.containsPoint(rect.center(), Qt::OddEvenFill) ? iARectPolygonRelation::Inside : iARectPolygonRelation::Outside;
+	}
+}
+
+iABitSet iAScatterPlot::pointsInPolygon(QPolygonF const& pPoly) const
+{
+	iABitSet result(m_splomData->numPoints());
+	auto const& xData = m_splomData->paramData(m_paramIndices[0]);
+	auto const& yData = m_splomData->paramData(m_paramIndices[1]);
+	int rangeBinX[2] = { p2binx(pPoly.boundingRect().left()), p2binx(pPoly.boundingRect().right()) };
+	int rangeBinY[2] = { p2biny(pPoly.boundingRect().top()), p2biny(pPoly.boundingRect().bottom()) };
+	std::vector<int> bins;
+	for (int binx = rangeBinX[0]; binx <= rangeBinX[1]; ++binx)
+	{
+		for (int biny = rangeBinY[0]; biny <= rangeBinY[1]; ++biny)
+		{
+			bins.push_back(getBinIndex(binx, biny));
+		}
+	}
+	double const binSize[2] = {
+		(m_prX[1] - m_prX[0]) / (m_gridDims[0] - 1),
+		(m_prY[1] - m_prY[0]) / (m_gridDims[1] - 1)
+	};
+#pragma omp parallel for schedule(dynamic, 16)
+	for (qint64 b = 0; b < static_cast<qint64>(bins.size()); ++b)
+	{
+		int binx = bins[b] % m_gridDims[0], biny = bins[b] / m_gridDims[0];
+		// bins are tested as a whole, so that only points in bins intersected by the polygon border need to be tested
+		// individually; border bins also contain the points outside of the parameter range, so they are always tested:
+		auto relation = iARectPolygonRelation::Partial;
+		if (binx > 0 && binx < m_gridDims[0] - 1 && biny > 0 && biny < m_gridDims[1] - 1)
+		{
+			QRectF binRect(m_prX[0] + binx * binSize[0], m_prY[0] + biny * binSize[1], binSize[0], binSize[1]);
+			// enlarge slightly, to be on the safe side regarding points on the border of the bin:
+			binRect.adjust(-binSize[0] * 1e-6, -binSize[1] * 1e-6, binSize[0] * 1e-6, binSize[1] * 1e-6);
+			relation = rectPolygonRelation(binRect, pPoly);
+		}
+		if (relation == iARectPolygonRelation::Outside)
+		{
+			continue;
+		}
+		for (auto i : m_pointsGrid[bins[b]])
+		{
+			if (m_viewData->matchesFilter(m_splomData, i) && (relation == iARectPolygonRelation::Inside ||
+				pPoly.containsPoint(QPointF(xData[i], yData[i]), Qt::OddEvenFill)))
+			{
+				result.setAtomic(i);
+			}
+		}
+	}
+	return result;
+}
+
 void iAScatterPlot::updateSelectedPoints(bool append, bool remove)
 {
-	bool wasModified = false;
 	auto& selInds = m_viewData->selection();
-	if (!append && !remove)
+	size_t numPoints = m_splomData->numPoints();
+	auto const prevSel = iABitSet::fromIndices(selInds, numPoints);
+	iABitSet newSel(numPoints);
+	if (append || remove)
 	{
-		wasModified = selInds.size() > 0;
-		selInds.clear();
+		newSel = prevSel;
 	}
 	if (m_selPoly.size() > 0)
 	{
@@ -757,43 +857,27 @@ void iAScatterPlot::updateSelectedPoints(bool append, bool remove)
 			QPointF p(x2p(m_selPoly.point(i).x()), y2p(m_selPoly.point(i).y()));
 			pPoly.append(p);
 		}
-		int rangeBinX[2] = { p2binx(pPoly.boundingRect().left()), p2binx(pPoly.boundingRect().right()) };
-		int rangeBinY[2] = { p2biny(pPoly.boundingRect().top()), p2biny(pPoly.boundingRect().bottom()) };
-		for (int binx = rangeBinX[0]; binx <= rangeBinX[1]; ++binx)
+		auto inPolygon = pointsInPolygon(pPoly);
+		if (append && remove)
+		{   // XOR: of the points in the polygon, those already selected will be de-selected, the others added
+			newSel ^= inPolygon;
+		}
+		else if (remove)
 		{
-			for (int biny = rangeBinY[0]; biny <= rangeBinY[1]; ++biny)
-			{
-				auto const & pts = m_pointsGrid[getBinIndex(binx, biny)];
-				for(auto i: pts)
-				{
-					if (!m_viewData->matchesFilter(m_splomData, i))
-					{
-						continue;
-					}
-					QPointF pt(m_splomData->paramData(m_paramIndices[0])[i], m_splomData->paramData(m_paramIndices[1])[i]);
-					if (pPoly.containsPoint(pt, Qt::OddEvenFill))
-					{
-						auto pos = std::find(selInds.begin(), selInds.end(), i);
-						if (pos != selInds.end() && remove)
-						{
-							selInds.erase(pos);
-							wasModified = true;
-						}
-						else if (pos == selInds.end() && (!remove || append)) // achieves XOR-like behavior if both remove and append are true
-						{
-							selInds.push_back(i);
-							wasModified = true;
-						}
-					}
-				}
-			}
+			newSel.subtract(inPolygon);
+		}
+		else
+		{
+			newSel |= inPolygon;
 		}
 	}
+	bool wasModified = newSel != prevSel || selInds.size() != prevSel.count();
 	bool needToClearPolygon = m_selPoly.size() > 0;
 	m_selPoly.clear();
 	if (wasModified)
 	{
-		std::sort(selInds.begin(), selInds.end());
+		selInds = newSel.toIndices();    // already sorted
+		m_viewData->markSelectionModified();
 		emit selectionModified();
 	}
 	else if (needToClearPolygon)
@@ -895,6 +979,11 @@ void iAScatterPlot::drawPoints( QPainter &painter )
 		}
 	}
 
+	if (m_drawDensity)
+	{
+		drawDensity(painter);
+	}
+
 #ifdef SP_OLDOPENGL
 	double ptSize = 2 * ptRad;
 	// all points
@@ -939,38 +1028,47 @@ void iAScatterPlot::drawPoints( QPainter &painter )
 	}
 	*/
 
-	// Draw points:
-	if (!m_pointsBuffer->bind())//TODO: proper handling (exceptions?)
+	// Draw points (unless drawn as density image):
+	if (!m_drawDensity)
 	{
-		LOG(lvlWarn, "Failed to bind points buffer!");
-		return;
+		if (!m_pointsBuffer->bind())//TODO: proper handling (exceptions?)
+		{
+			LOG(lvlWarn, "Failed to bind points buffer!");
+			return;
+		}
+		glEnable( GL_POINT_SMOOTH );
+		glEnable( GL_BLEND );
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+		glPointSize( ptSize );
+		glEnableClientState( GL_VERTEX_ARRAY );
+		glVertexPointer( 3, GL_FLOAT, 7 * sizeof( GLfloat ), (const void *) ( 0 ) );
+		glEnableClientState( GL_COLOR_ARRAY );
+		glColorPointer( 4, GL_FLOAT, 7 * sizeof( GLfloat ), (const void *) ( 3 * sizeof( GLfloat ) ) );
+		assert(m_curVisiblePts < std::numeric_limits<GLsizei>::max());
+		glDrawArrays( GL_POINTS, 0, static_cast<GLsizei>(m_curVisiblePts) );//glDrawElements( GL_POINTS, m_pointsBuffer->size(), GL_UNSIGNED_INT, 0 );
+		glDisableClientState( GL_COLOR_ARRAY );
+
+		// Draw selection:
+		glColor3f( settings.selectionColor.red() / 255.0, settings.selectionColor.green() / 255.0, settings.selectionColor.blue() / 255.0 );
+		auto const& selInds = m_viewData->filteredSelection(m_splomData);
+		std::vector<uint> uintSelInds;
+		for (size_t idx : selInds)
+		{
+			// copy doesn't work as it would require explicit conversion from size_t to uint
+			uintSelInds.push_back(static_cast<uint>(idx));
+		}
+		// TODO: This still limits the data to be drawn to the maximum of unsigned int (i.e. 2^32!)
+		//       but unfortunately, there is no GL_UNSIGNED_LONG_LONG (yet)
+		glDrawElements(GL_POINTS, static_cast<GLsizei>(selInds.size()), GL_UNSIGNED_INT, uintSelInds.data());
+		glDisableClientState( GL_VERTEX_ARRAY );
+		m_pointsBuffer->release();
+	}
+	else
+	{
+		glEnable( GL_POINT_SMOOTH );
+		glEnable( GL_BLEND );
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
 	}
-	glEnable( GL_POINT_SMOOTH );
-	glEnable( GL_BLEND );
-	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-	glPointSize( ptSize );
-	glEnableClientState( GL_VERTEX_ARRAY );
-	glVertexPointer( 3, GL_FLOAT, 7 * sizeof( GLfloat ), (const void *) ( 0 ) );
-	glEnableClientState( GL_COLOR_ARRAY );
-	glColorPointer( 4, GL_FLOAT, 7 * sizeof( GLfloat ), (const void *) ( 3 * sizeof( GLfloat ) ) );
-	assert(m_curVisiblePts < std::numeric_limits<GLsizei>::max());
-	glDrawArrays( GL_POINTS, 0, static_cast<GLsizei>(m_curVisiblePts) );//glDrawElements( GL_POINTS, m_pointsBuffer->size(), GL_UNSIGNED_INT, 0 );
-	glDisableClientState( GL_COLOR_ARRAY );
-
-	// Draw selection:
-	glColor3f( settings.selectionColor.red() / 255.0, settings.selectionColor.green() / 255.0, settings.selectionColor.blue() / 255.0 );
-	auto const& selInds = m_viewData->filteredSelection(m_splomData);
-	std::vector<uint> uintSelInds;
-	for (size_t idx : selInds)
-	{
-		// copy doesn't work as it would require explicit conversion from size_t to uint
-		uintSelInds.push_back(static_cast<uint>(idx));
-	}
-	// TODO: This still limits the data to be drawn to the maximum of unsigned int (i.e. 2^32!)
-	//       but unfortunately, there is no GL_UNSIGNED_LONG_LONG (yet)
-	glDrawElements(GL_POINTS, static_cast<GLsizei>(selInds.size()), GL_UNSIGNED_INT, uintSelInds.data());
-	glDisableClientState( GL_VERTEX_ARRAY );
-	m_pointsBuffer->release();
 
 	// Draw current point
 	double anim = m_viewData->animIn();
@@ -1061,28 +1159,31 @@ void iAScatterPlot::drawPoints( QPainter &painter )
 		drawPoint(painter, p0d[m_prevPtInd], p1d[m_prevPtInd], curPtRad, color);
 	}
 
-	// Draw points:
-	m_curVisiblePts = 0;
-	for (size_t i = 0; i < m_splomData->numPoints(); ++i)
+	if (!m_drawDensity)
 	{
-		if (!m_viewData->matchesFilter(m_splomData, i))
+		// Draw points:
+		m_curVisiblePts = 0;
+		for (size_t i = 0; i < m_splomData->numPoints(); ++i)
 		{
-			continue;
+			if (!m_viewData->matchesFilter(m_splomData, i))
+			{
+				continue;
+			}
+			QColor color(m_lut->getQColor(m_splomData->paramData(m_colInd)[i]));
+			drawPoint(painter, p0d[i], p1d[i], ptRad, color);
+			++m_curVisiblePts;
 		}
-		QColor color(m_lut->getQColor(m_splomData->paramData(m_colInd)[i]));
-		drawPoint(painter, p0d[i], p1d[i], ptRad, color);
-		++m_curVisiblePts;
-	}
-	// Draw selected points:
-	auto const& selInds = m_viewData->selection();
-	for (size_t idx : selInds)
-	{
-		if (!m_viewData->matchesFilter(m_splomData, idx))
+		// Draw selected points:
+		auto const& selInds = m_viewData->selection();
+		for (size_t idx : selInds)
 		{
-			LOG(lvlDebug, QString("Point %1 does not match current filter but is selected anyway!").arg(idx));
-			continue;
+			if (!m_viewData->matchesFilter(m_splomData, idx))
+			{
+				LOG(lvlDebug, QString("Point %1 does not match current filter but is selected anyway!").arg(idx));
+				continue;
+			}
+			drawPoint(painter, p0d[idx], p1d[idx], ptRad, settings.selectionColor);
 		}
-		drawPoint(painter, p0d[idx], p1d[idx], ptRad, settings.selectionColor);
 	}
 
 	// Draw highlighted points
@@ -1132,6 +1233,70 @@ void iAScatterPlot::drawPoints( QPainter &painter )
 	painter.restore();
 }
 
+bool iAScatterPlot::updateDensity()
+{
+	if (m_splomData->numPoints() <= settings.densityThreshold || !m_lut->initialized() ||
+		m_locRect.width() == 0 || m_locRect.height() == 0)
+	{
+		return false;
+	}
+	auto include = m_viewData->filterDefined() ?
+		std::function<bool(size_t)>([this](size_t i) { return m_viewData->matchesFilter(m_splomData, i); }) :
+		std::function<bool(size_t)>();
+	if (m_densityCellsOutdated || m_density->gridSize() != settings.densityGridSize)
+	{
+		m_density->setPoints(m_splomData->paramData(m_paramIndices[0]), m_splomData->paramData(m_paramIndices[1]),
+			m_prX, m_prY, settings.densityGridSize);
+		m_densityCellsOutdated = false;
+		m_densityCountsOutdated = true;
+	}
+	bool selectionOutdated = m_densitySelectionVersion != m_viewData->selectionVersion();
+	if (m_densityCountsOutdated)
+	{
+		auto const& colorData = m_splomData->paramData(m_colInd);
+		m_density->updateCounts(include, [this, &colorData](size_t i) { return m_lut->getQColor(colorData[i]); });
+		m_densityCountsOutdated = false;
+		selectionOutdated = true;
+	}
+	if (selectionOutdated)
+	{
+		m_density->updateSelection(std::as_const(*m_viewData).selection(), include);
+		m_densitySelectionVersion = m_viewData->selectionVersion();
+	}
+	// only draw the density if (even when zoomed in) more points than the threshold are visible:
+	double visX[2] = { revertTransformX(0) / m_locRect.width(), revertTransformX(m_locRect.width()) / m_locRect.width() };
+	double visY[2] = { revertTransformY(0) / m_locRect.height(), revertTransformY(m_locRect.height()) / m_locRect.height() };
+	for (int i = 0; i < 2; ++i)
+	{
+		if (m_viewData->isInverted(m_paramIndices[0]))
+		{
+			visX[i] = 1 - visX[i];
+		}
+		if (m_viewData->isInverted(m_paramIndices[1]))
+		{
+			visY[i] = 1 - visY[i];
+		}
+	}
+	return m_density->count(visX, visY) > settings.densityThreshold;
+}
+
+void iAScatterPlot::drawDensity( QPainter &painter )
+{
+	// the density grid covers the full parameter ranges, i.e. the whole (untransformed) plot rectangle:
+	QRectF target(applyTransformX(m_locRect.left()), applyTransformY(m_locRect.top()),
+		m_locRect.width() * m_scale, m_locRect.height() * m_scale);
+	bool invertX = m_viewData->isInverted(m_paramIndices[0]);
+	bool invertY = m_viewData->isInverted(m_paramIndices[1]);
+	painter.save();
+	painter.setRenderHint(QPainter::SmoothPixmapTransform, target.width() < m_density->gridSize());
+	painter.drawImage(target, m_density->image().mirrored(invertX, invertY));
+	if (m_density->selectedCount() > 0)
+	{
+		painter.drawImage(target, m_density->selectionImage(settings.selectionColor).mirrored(invertX, invertY));
+	}
+	painter.restore();
+}
+
 void iAScatterPlot::drawSelectionPolygon( QPainter &painter )
 {
 	if ( m_selPoly.size() )
@@ -18,8 +18,12 @@ using iAChartParentWidget = QWidget;
 #include <QList>
 #include <QObject>
 
+#include <memory>
+
+class iABitSet;
 class iAColorTheme;
 class iALookupTable;
+class iAScatterPlotDensity;
 class iAScatterPlotViewData;
 class iASPLOMData;
 
@@ -120,6 +124,7 @@ protected:
 	int getBinIndex( int x, int y ) const;                           //!< Get global grid bin offset (index) using X and Y bin indices
 	size_t getPointIndexAtPosition( QPointF mpos ) const;            //!< Get index of data point under cursor, iASPLOMData::NoDataIdx if none
 	QPointF getPositionFromPointIndex( size_t idx ) const;           //!< Get position of a data point with a given index
+	iABitSet pointsInPolygon( QPolygonF const & pPoly ) const;        //!< Determine the (filtered) points inside the given polygon (in parameter space)
 	void updateSelectedPoints( bool append, bool remove);            //!< Update selected points; parameters specify whether to append or to remove from previous selection (or create new if both false). if both append and remove are true, then XOR logic is applied (of newly selected, those already selected will be de-selected, new ones will be added)
 	void updateDrawRect();                                           //!< Re-calculate dimensions of the plot's rectangle
 	QPoint getLocalPos( QPoint pos ) const;                          //!< Local (plot) position from global (SPLOM)
@@ -130,6 +135,8 @@ protected:
 	void drawMaximizedLabels( QPainter &painter );                   //!< Draws additional plot's labels (only maximized plot)
 	void drawSelectionPolygon( QPainter &painter );                  //!< Draws selection-lasso polygon
 	void drawPoints( QPainter &painter );                            //!< Draws plot's points (uses native OpenGL)
+	bool updateDensity();                                            //!< Brings the density grid up to date if required; returns whether points should be drawn as density image
+	void drawDensity( QPainter &painter );                           //!< Draws all (and selected) points as density images
 #ifdef SP_OLDOPENGL
 	void createVBO();                                                //!< Creates and fills VBO with plot's 2D-points.
 	void fillVBO();                                                  //!< Fill existing VBO with plot's 2D-points.
@@ -184,6 +191,8 @@ public:
 		bool selectionEnabled;
 		bool showPCC, showSCC;
 		bool drawGridLines;
+		size_t densityThreshold;   //!< if more points than this are visible, they are drawn as density image instead of individually
+		int densityGridSize;       //!< number of cells in x and y direction of the density image
 	};
 
 	// Members
@@ -227,6 +236,12 @@ protected:
 	bool m_isPreviewPlot;                                            //!< flag telling if a large version of this plot is shown maximized currently
 	size_t m_curVisiblePts;                                          //!< number of currently visible points
 	bool m_dragging;                                                 //!< indicates whether a drag operation is currently going on
+	// density
+	std::unique_ptr<iAScatterPlotDensity> m_density;                 //!< grid of point densities, used for drawing large amounts of points
+	bool m_densityCellsOutdated;                                     //!< whether the points need to be re-assigned to density grid cells
+	bool m_densityCountsOutdated;                                    //!< whether the counts in the density grid need to be updated
+	size_t m_densitySelectionVersion;                                //!< the selection version (see iAScatterPlotViewData::selectionVersion) the density grid reflects
+	bool m_drawDensity;                                              //!< whether points are currently drawn as density image
 private:
 	double scc();
 	double pcc();
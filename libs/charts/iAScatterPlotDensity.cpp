@@ -0,0 +1,216 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iAScatterPlotDensity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	const quint32 NoCell = std::numeric_limits<quint32>::max();
+
+	//! grid coordinate (0..gridSize-1) of a value, or -1 if outside of the given range (or NaN)
+	int gridCoord(double value, double const range[2], int gridSize)
+	{
+		double c = (value - range[0]) / (range[1] - range[0]) * gridSize;
+		if (!(c >= 0 && c <= gridSize))
+		{
+			return -1;
+		}
+		return std::min(static_cast<int>(c), gridSize - 1);
+	}
+}
+
+iAScatterPlotDensity::iAScatterPlotDensity():
+	m_gridSize(0),
+	m_selCount(0)
+{}
+
+void iAScatterPlotDensity::setPoints(std::vector<double> const& x, std::vector<double> const& y,
+	double const xRange[2], double const yRange[2], int gridSize)
+{
+	m_gridSize = gridSize;
+	m_cells.resize(x.size());
+#pragma omp parallel for
+	for (qint64 i = 0; i < static_cast<qint64>(x.size()); ++i)
+	{
+		int cx = gridCoord(x[i], xRange, gridSize);
+		int cy = gridCoord(y[i], yRange, gridSize);
+		m_cells[i] = (cx < 0 || cy < 0) ? NoCell : static_cast<quint32>((gridSize - 1 - cy) * gridSize + cx);
+	}
+	size_t cellCount = static_cast<size_t>(gridSize) * gridSize;
+	m_counts.assign(cellCount, 0);
+	m_colors.assign(cellCount, 0);
+	m_summedCounts.assign(static_cast<size_t>(gridSize + 1) * (gridSize + 1), 0);
+	m_selCounts.assign(cellCount, 0);
+	m_selCount = 0;
+	m_image = QImage();
+	m_selImage = QImage();
+}
+
+void iAScatterPlotDensity::updateCounts(std::function<bool(size_t)> include, std::function<QColor(size_t)> color)
+{
+	size_t const cellCount = m_counts.size();
+	std::fill(m_counts.begin(), m_counts.end(), 0);
+	std::vector<double> colorSums(4 * cellCount, 0.0);
+#pragma omp parallel
+	{
+		std::vector<quint32> privateCounts(cellCount, 0);
+		std::vector<double> privateColorSums(4 * cellCount, 0.0);
+#pragma omp for
+		for (qint64 i = 0; i < static_cast<qint64>(m_cells.size()); ++i)
+		{
+			quint32 cell = m_cells[i];
+			if (cell == NoCell || (include && !include(i)))
+			{
+				continue;
+			}
+			++privateCounts[cell];
+			QColor c = color(i);
+			privateColorSums[4 * cell + 0] += c.redF();
+			privateColorSums[4 * cell + 1] += c.greenF();
+			privateColorSums[4 * cell + 2] += c.blueF();
+			privateColorSums[4 * cell + 3] += c.alphaF();
+		}
+#pragma omp critical
+		{
+			for (size_t c = 0; c < cellCount; ++c)
+			{
+				m_counts[c] += privateCounts[c];
+			}
+			for (size_t c = 0; c < 4 * cellCount; ++c)
+			{
+				colorSums[c] += privateColorSums[c];
+			}
+		}
+	}
+#pragma omp parallel for
+	for (qint64 c = 0; c < static_cast<qint64>(cellCount); ++c)
+	{
+		if (m_counts[c] == 0)
+		{
+			continue;
+		}
+		double n = m_counts[c];
+		m_colors[c] = QColor::fromRgbF(colorSums[4 * c] / n, colorSums[4 * c + 1] / n,
+			colorSums[4 * c + 2] / n, colorSums[4 * c + 3] / n).rgba();
+	}
+	int const stride = m_gridSize + 1;
+	for (int y = 0; y < m_gridSize; ++y)
+	{
+		quint64 rowSum = 0;
+		for (int x = 0; x < m_gridSize; ++x)
+		{
+			rowSum += m_counts[y * m_gridSize + x];
+			m_summedCounts[(y + 1) * stride + x + 1] = m_summedCounts[y * stride + x + 1] + rowSum;
+		}
+	}
+	m_image = QImage();
+}
+
+void iAScatterPlotDensity::updateSelection(std::vector<size_t> const& selection, std::function<bool(size_t)> include)
+{
+	size_t const cellCount = m_selCounts.size();
+	std::fill(m_selCounts.begin(), m_selCounts.end(), 0);
+	size_t selCount = 0;
+#pragma omp parallel reduction(+:selCount)
+	{
+		std::vector<quint32> privateCounts(cellCount, 0);
+#pragma omp for
+		for (qint64 s = 0; s < static_cast<qint64>(selection.size()); ++s)
+		{
+			size_t i = selection[s];
+			if (i >= m_cells.size() || m_cells[i] == NoCell || (include && !include(i)))
+			{
+				continue;
+			}
+			++privateCounts[m_cells[i]];
+			++selCount;
+		}
+#pragma omp critical
+		for (size_t c = 0; c < cellCount; ++c)
+		{
+			m_selCounts[c] += privateCounts[c];
+		}
+	}
+	m_selCount = selCount;
+	m_selImage = QImage();
+}
+
+int iAScatterPlotDensity::gridSize() const
+{
+	return m_gridSize;
+}
+
+size_t iAScatterPlotDensity::count(double const x[2], double const y[2]) const
+{
+	if (m_gridSize == 0)
+	{
+		return 0;
+	}
+	auto cellRange = [this](double const r[2], int out[2])
+	{
+		out[0] = std::clamp(static_cast<int>(std::floor(std::min(r[0], r[1]) * m_gridSize)), 0, m_gridSize);
+		out[1] = std::clamp(static_cast<int>(std::ceil(std::max(r[0], r[1]) * m_gridSize)), 0, m_gridSize);
+	};
+	int cx[2], cy[2];
+	cellRange(x, cx);
+	cellRange(y, cy);
+	int const stride = m_gridSize + 1;
+	return m_summedCounts[cy[1] * stride + cx[1]] - m_summedCounts[cy[0] * stride + cx[1]]
+		- m_summedCounts[cy[1] * stride + cx[0]] + m_summedCounts[cy[0] * stride + cx[0]];
+}
+
+size_t iAScatterPlotDensity::selectedCount() const
+{
+	return m_selCount;
+}
+
+void iAScatterPlotDensity::createImage(QImage& img, std::vector<quint32> const& counts, std::function<QRgb(size_t)> cellColor) const
+{
+	img = QImage(m_gridSize, m_gridSize, QImage::Format_ARGB32);
+	img.fill(Qt::transparent);
+	quint32 maxCount = counts.empty() ? 0 : *std::max_element(counts.begin(), counts.end());
+	if (maxCount == 0)
+	{
+		return;
+	}
+	double const logMax = std::log1p(maxCount);
+#pragma omp parallel for
+	for (int y = 0; y < m_gridSize; ++y)
+	{
+		auto line = reinterpret_cast<QRgb*>(img.scanLine(y));
+		for (int x = 0; x < m_gridSize; ++x)
+		{
+			size_t c = static_cast<size_t>(y) * m_gridSize + x;
+			if (counts[c] == 0)
+			{
+				continue;
+			}
+			QRgb rgb = cellColor(c);
+			double opacity = MinOpacity + (1.0 - MinOpacity) * std::log1p(counts[c]) / logMax;
+			line[x] = qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), static_cast<int>(std::round(opacity * qAlpha(rgb))));
+		}
+	}
+}
+
+QImage const& iAScatterPlotDensity::image() const
+{
+	if (m_image.isNull() && m_gridSize > 0)
+	{
+		createImage(m_image, m_counts, [this](size_t c) { return m_colors[c]; });
+	}
+	return m_image;
+}
+
+QImage const& iAScatterPlotDensity::selectionImage(QColor const& color) const
+{
+	if ((m_selImage.isNull() || m_selImageColor != color) && m_gridSize > 0)
+	{
+		QRgb rgb = qRgb(color.red(), color.green(), color.blue());
+		createImage(m_selImage, m_selCounts, [rgb](size_t) { return rgb; });
+		m_selImageColor = color;
+	}
+	return m_selImage;
+}
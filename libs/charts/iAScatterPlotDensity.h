@@ -0,0 +1,72 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iacharts_export.h"
+
+#include <QColor>
+#include <QImage>
+
+#include <cstddef>    // for size_t
+#include <functional>
+#include <vector>
+
+//! Aggregates the points of a scatter plot into a regular 2D grid, for drawing large numbers of points as density image.
+//!
+//! Updating is split into steps of different cost, such that only the required ones need to be re-done:
+//!   - setPoints assigns each point to a grid cell (required when the data or the displayed value range changes),
+//!   - updateCounts counts the points per cell and averages their colors (required e.g. when the filter or the colors change),
+//!   - updateSelection counts the selected points per cell (only iterates over the selected points).
+//! All of them are parallelized. Cells are stored in image order, i.e., row 0 holds the largest y values.
+class iAcharts_API iAScatterPlotDensity
+{
+public:
+	iAScatterPlotDensity();
+	//! Assign the points to grid cells.
+	//! @param x the x values of the points (e.g. a column of iASPLOMData); only referenced during the call
+	//! @param y the y values of the points
+	//! @param xRange the range of x values covered by the grid; points outside are ignored
+	//! @param yRange the range of y values covered by the grid
+	//! @param gridSize the number of cells in x and y direction
+	void setPoints(std::vector<double> const& x, std::vector<double> const& y,
+		double const xRange[2], double const yRange[2], int gridSize);
+	//! Count the points in each cell and compute the average color of each cell.
+	//! @param include determines whether the point with the given index is considered (all points if not set)
+	//! @param color determines the color of the point with the given index
+	//! Both functions are called concurrently from multiple threads.
+	void updateCounts(std::function<bool(size_t)> include, std::function<QColor(size_t)> color);
+	//! Count the selected points in each cell.
+	//! @param selection the indices of the selected points
+	//! @param include determines whether the point with the given index is considered (all points if not set); called concurrently
+	void updateSelection(std::vector<size_t> const& selection, std::function<bool(size_t)> include);
+	//! The number of cells in x and y direction (0 if setPoints was not called yet).
+	int gridSize() const;
+	//! The number of points (as counted in updateCounts) in all cells overlapping the given rectangle.
+	//! @param x horizontal extent of the rectangle, as fraction of the grid width (0..1, left to right)
+	//! @param y vertical extent of the rectangle, as fraction of the grid height (0..1, top to bottom)
+	size_t count(double const x[2], double const y[2]) const;
+	//! The number of selected points (as counted in updateSelection).
+	size_t selectedCount() const;
+	//! Image with one pixel per cell, in the average color of the cell's points; the opacity increases
+	//! logarithmically with the number of points in the cell (scaled by the average opacity of their colors).
+	QImage const& image() const;
+	//! Image of the selected points in the given color; opacity as in image().
+	QImage const& selectionImage(QColor const& color) const;
+
+	//! minimum opacity of a cell containing a single point
+	static constexpr double MinOpacity = 0.2;
+
+private:
+	//! (lazily) fill the given image from the given counts and colors
+	void createImage(QImage& img, std::vector<quint32> const& counts, std::function<QRgb(size_t)> cellColor) const;
+
+	int m_gridSize;
+	std::vector<quint32> m_cells;          //!< for each point, the index of the cell it falls into (NoCell if outside)
+	std::vector<quint32> m_counts;         //!< for each cell, the number of points in it
+	std::vector<QRgb> m_colors;            //!< for each cell, the average color of its points
+	std::vector<quint64> m_summedCounts;   //!< summed area table of m_counts (one additional row and column), for count()
+	std::vector<quint32> m_selCounts;      //!< for each cell, the number of selected points in it
+	size_t m_selCount;
+	mutable QImage m_image, m_selImage;    //!< cached images (null if outdated)
+	mutable QColor m_selImageColor;        //!< color the cached selection image was created with
+};
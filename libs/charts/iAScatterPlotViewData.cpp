@@ -10,6 +10,7 @@
 iAScatterPlotViewData::iAScatterPlotViewData() :
 	m_animIn(1.0),
 	m_animOut(0.0),
+	m_selectionVersion(0),
 	m_animationIn(this, "m_animIn"),
 	m_animationOut(this, "m_animOut"),
 	m_isAnimated(true)
@@ -87,6 +88,7 @@ void iAScatterPlotViewData::setFilteredSelection(iAScatterPlotViewData::Selectio
 		}
 		++curFilteredIdx;
 	}
+	++m_selectionVersion;
 	emit updateRequired();
 }
 
@@ -94,12 +96,24 @@ void iAScatterPlotViewData::setSelection(SelectionType const& selection)
 {
 	m_selection = selection;
 	std::sort(m_selection.begin(), m_selection.end());
+	++m_selectionVersion;
 	emit updateRequired();
 }
 
 void iAScatterPlotViewData::clearSelection()
 {
 	m_selection.clear();
+	++m_selectionVersion;
+}
+
+size_t iAScatterPlotViewData::selectionVersion() const
+{
+	return m_selectionVersion;
+}
+
+void iAScatterPlotViewData::markSelectionModified()
+{
+	++m_selectionVersion;
 }
 
 iAScatterPlotViewData::SelectionType const& iAScatterPlotViewData::highlightedPoints() const
@@ -204,7 +218,7 @@ void iAScatterPlotViewData::updateAnimation(size_t curPt, size_t prePt)
 	}
 }
 
-bool iAScatterPlotViewData::matchesFilter(std::shared_ptr<iASPLOMData> splomData, size_t ind) const
+bool iAScatterPlotViewData::matchesFilter(std::shared_ptr<iASPLOMData> const & splomData, size_t ind) const
 {
 	if (m_filters.empty())
 	{
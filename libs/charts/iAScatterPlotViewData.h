@@ -41,6 +41,10 @@ public:
 	SelectionType const& filteredSelection(std::shared_ptr<iASPLOMData> splomData) const;
 	void setFilteredSelection(SelectionType const& filteredSelection, std::shared_ptr<iASPLOMData> splomData);
 	void clearSelection();
+	//! A counter which is increased whenever the selection changes; allows to cheaply check whether data derived from the selection is outdated.
+	size_t selectionVersion() const;
+	//! Needs to be called after modifying the selection directly through the reference returned by selection().
+	void markSelectionModified();
 
 	SelectionType const& highlightedPoints() const;
 	bool isPointHighlighted(size_t idx) const;
@@ -62,7 +66,7 @@ public:
 
 	//! @{
 	//! Filtering for data items (matching values)
-	bool matchesFilter(std::shared_ptr<iASPLOMData> splomData, size_t ind) const; //!< Returns true if point with given index matches current filter
+	bool matchesFilter(std::shared_ptr<iASPLOMData> const & splomData, size_t ind) const; //!< Returns true if point with given index matches current filter
 	void addFilter(size_t paramIndex, double value);  //!< Adds a filter on the data to be shown, on the given column (index). The value in this column needs to match the given value; multiple filters added via this function are linked via OR.
 	void removeFilter(size_t paramIndex, double value);//!< Removes the filter on the given column and value.
 	void clearFilters();                              //!< Clear all filters on data; after calling this method, all data points will be shown again.
@@ -84,6 +88,8 @@ private:
 	SelectionType m_selection;
 	//!< contains indices of selected points in filtered list (TODO: update only when selection changes and when filters change, remove mutable)
 	mutable SelectionType m_filteredSelection;
+	//!< increased on every change of m_selection
+	size_t m_selectionVersion;
 	//!< whether to invert a feature
 	std::vector<char> m_inverted;
 	//!< indices of pairs of points which should be connected by a line of the given color
@@ -42,6 +42,7 @@ void iAXYPlotData::addValue(iAPlotData::DataType x, iAPlotData::DataType y)
 	m_values.insert(m_values.begin() + idx, std::make_pair(x, y));
 	adaptBounds(m_xBounds, x);
 	adaptBounds(m_yBounds, y);
+	invalidateLOD();
 }
 
 size_t iAXYPlotData::nearestIdx(double dataX) const
@@ -34,6 +34,7 @@
 
 // base
 #include <iAAttributes.h>    // for loading/storing default settings in XML
+#include <iADataCache.h>
 #include <iALog.h>
 #include <iALogLevelMappings.h>
 #include <iALUT.h>           // for iALUT::loadMaps
@@ -42,6 +43,7 @@
 #include <iASettings.h>      // for loadSettings, storeSettings
 #include <iAStringHelper.h>  // for iAConverter
 #include <iAToolsVTK.h>
+#include <iATrace.h>
 #include <iAXmlSettings.h>
 
 #include <vtkCamera.h>
@@ -86,6 +88,8 @@ namespace
 	constexpr const char SlicerElemName[] = "slicerSettings";
 	constexpr const char SlicerNiceName[] = "Slicer Settings";
 	constexpr const char XMLFileFilter[] = "XML (*.xml)";
+	const QString DataCacheBudgetName("Data cache memory budget (MB)");
+	constexpr size_t BytesPerMB = 1024 * 1024;
 
 	QString slicerNiceName(int m)
 	{
@@ -771,6 +775,7 @@ void MainWindow::prefs()
 	addAttr(params, "Looks", iAValueType::Categorical, looks);
 	addAttr(params, "Font size", iAValueType::Discrete, p.FontSize, 2, 120);
 	addAttr(params, "Size limit for automatic 3D rendering (MB)", iAValueType::Discrete, p.LimitForAuto3DRender, 0);
+	addAttr(params, DataCacheBudgetName, iAValueType::Discrete, static_cast<qulonglong>(iADataCache::get().memoryBudget() / BytesPerMB), 0);
 	const auto AxisColorThemes = QStringList() << "Default (X=red, Y=green, Z=blue)" << "Colorblind safe (Brewer 3-class Dark2)";
 	auto axisColorThemeSel(AxisColorThemes);
 	axisColorThemeSel[axisColorMode()] = "!" + axisColorThemeSel[axisColorMode()];
@@ -803,6 +808,7 @@ void MainWindow::prefs()
 	f.setPointSize(m_defaultPreferences.FontSize);
 	QApplication::setFont(f);
 	m_defaultPreferences.LimitForAuto3DRender = values["Size limit for automatic 3D rendering (MB)"].toInt();
+	iADataCache::get().setMemoryBudget(static_cast<size_t>(values[DataCacheBudgetName].toULongLong()) * BytesPerMB);
 	if (activeMdiChild())
 	{
 		activeMDI()->applyPreferences(m_defaultPreferences);
@@ -1307,6 +1313,8 @@ void MainWindow::readSettings()
 
 	// performance:
 	m_defaultPreferences.LimitForAuto3DRender = settings.value("Preferences/prefLimitForAuto3DRender", defaultPrefs.LimitForAuto3DRender).toInt();
+	iADataCache::get().setMemoryBudget(static_cast<size_t>(settings.value("Preferences/dataCacheBudgetMB",
+		static_cast<qulonglong>(iADataCache::DefaultMemoryBudget / BytesPerMB)).toULongLong()) * BytesPerMB);
 	axisColorMode() = settings.value("Preferences/axisColorTheme", 0).toInt();
 
 	iASlicerSettings fallbackSS;
@@ -1332,6 +1340,7 @@ void MainWindow::writeSettings()
 
 	settings.setValue("Preferences/defaultLayout", m_layout->currentText());
 	settings.setValue("Preferences/prefLimitForAuto3DRender", m_defaultPreferences.LimitForAuto3DRender);
+	settings.setValue("Preferences/dataCacheBudgetMB", static_cast<qulonglong>(iADataCache::get().memoryBudget() / BytesPerMB));
 	settings.setValue("Preferences/axisColorTheme", axisColorMode());
 	settings.setValue("Preferences/prefStatExt", m_defaultPreferences.PositionMarkerSize);
 	settings.setValue("Preferences/prefPrintParameters", m_defaultPreferences.PrintParameters);
@@ -1959,6 +1968,9 @@ int MainWindow::runGUI(int argc, char * argv[], QString const & appName, QString
 #endif
 	Q_INIT_RESOURCE(gui);
 	QApplication app(argc, argv);
+	// if requested, record the time spent in filters, file I/O and rendering (see iATrace), written on exit:
+	QString traceFileName = qEnvironmentVariable("OPENIA_TRACE_FILE");
+	iATrace::setEnabled(!traceFileName.isEmpty());
 	QSplashScreen splashScreen{ QPixmap(splashPath) };
 	//splashScreen.setWindowFlags(splashScreen.windowFlags() | Qt::WindowStaysOnTopHint);   // don't stay on top - otherwise it covers error messages, e.g. by Visual Studio!
 	splashScreen.setWindowOpacity(0.8);
@@ -2011,5 +2023,14 @@ int MainWindow::runGUI(int argc, char * argv[], QString const & appName, QString
 	}
 	mainWin.show();
 	mainWin.loadArguments(argc, argv);
-	return app.exec();
+	int result = app.exec();
+	if (!traceFileName.isEmpty())
+	{
+		iATrace::setEnabled(false);
+		if (!iATrace::writeChromeTrace(traceFileName))
+		{
+			LOG(lvlError, QString("Could not write trace file '%1'!").arg(traceFileName));
+		}
+	}
+	return result;
 }
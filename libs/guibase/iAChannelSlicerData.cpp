@@ -6,27 +6,368 @@
 #include "iALog.h"
 #include "iASlicerMode.h"
 #include "iAToolsVTK.h"		// for convertTFToLUT
+#include "iATrace.h"
 #include "iAvtkActorHelper.h"  // for showActor
 
+#include <vtkAbstractTransform.h>
 #include <vtkActor.h>
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
 #include <vtkImageMapToColors.h>
 #include <vtkImageMapper3D.h>
 #include <vtkImageReslice.h>
+#include <vtkInformationVector.h>
 #include <vtkLookupTable.h>
 #include <vtkMarchingContourFilter.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
 #include <vtkPiecewiseFunction.h>
+#include <vtkPointData.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
 
+#include <QMutex>
 #include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+
+namespace
+{
+	//! number of slices computed in advance in the direction of the last slice change
+	const int SlicePrefetchCount = 4;
+	//! maximum number of slices kept in the cache of a channel
+	const size_t SliceCacheSize = 16;
+	//! indices of the origin in the (row-major) reslice axes matrix
+	const int OriginIdx[3] = { 3, 7, 11 };
+
+	//! The parameters determining the result of reslicing
+	struct iASliceParams
+	{
+		vtkDataObject* input;
+		vtkMTimeType inputMTime;
+		vtkAbstractTransform* transform;
+		vtkMTimeType transformMTime;
+		double axes[16];
+		int interpolationMode, slabMode, slabSlices;
+		double tolerance;    //!< maximum difference in origin coordinates considered as the same slice
+	};
+
+	iASliceParams resliceParams(vtkImageReslice* reslicer, vtkDataObject* input)
+	{
+		iASliceParams p;
+		p.input = input;
+		p.inputMTime = input ? input->GetMTime() : 0;
+		p.transform = reslicer->GetResliceTransform();
+		p.transformMTime = p.transform ? p.transform->GetMTime() : 0;
+		if (reslicer->GetResliceAxes())
+		{
+			vtkMatrix4x4::DeepCopy(p.axes, reslicer->GetResliceAxes());
+		}
+		else
+		{
+			vtkMatrix4x4::Identity(p.axes);
+		}
+		p.interpolationMode = reslicer->GetInterpolationMode();
+		p.slabMode = reslicer->GetSlabMode();
+		p.slabSlices = reslicer->GetSlabNumberOfSlices();
+		p.tolerance = 0;
+		return p;
+	}
+
+	//! whether the two parameter sets result in the same slice, except for its position
+	bool sameSettings(iASliceParams const& a, iASliceParams const& b)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			if (i != OriginIdx[0] && i != OriginIdx[1] && i != OriginIdx[2] && a.axes[i] != b.axes[i])
+			{
+				return false;
+			}
+		}
+		return a.input == b.input && a.inputMTime == b.inputMTime &&
+			a.transform == b.transform && a.transformMTime == b.transformMTime &&
+			a.interpolationMode == b.interpolationMode && a.slabMode == b.slabMode && a.slabSlices == b.slabSlices;
+	}
+
+	//! whether the two parameter sets result in the same slice
+	bool sameSlice(iASliceParams const& a, iASliceParams const& b)
+	{
+		double tolerance = std::max(a.tolerance, b.tolerance);
+		for (int i = 0; i < 3; ++i)
+		{
+			if (std::abs(a.axes[OriginIdx[i]] - b.axes[OriginIdx[i]]) > tolerance)
+			{
+				return false;
+			}
+		}
+		return sameSettings(a, b);
+	}
+
+	//! The parameters determining the result of color mapping
+	struct iAColorParams
+	{
+		vtkScalarsToColors* lut;
+		vtkMTimeType lutMTime;
+		int outputFormat;
+		vtkTypeBool passAlpha;
+		bool operator==(iAColorParams const& other) const
+		{
+			return lut == other.lut && lutMTime == other.lutMTime && outputFormat == other.outputFormat && passAlpha == other.passAlpha;
+		}
+	};
+
+	iAColorParams colorParams(vtkImageMapToColors* colormapper)
+	{
+		auto lut = colormapper->GetLookupTable();
+		return iAColorParams{ lut, lut ? lut->GetMTime() : 0, colormapper->GetOutputFormat(), colormapper->GetPassAlphaToOutput() };
+	}
+}
+
+//! Cache of resliced and color-mapped slices of a channel, filled by background threads.
+//! Entries are only valid for the exact parameters (including modification times of the input
+//! image, the transform and the lookup table) they were computed with, so changes of e.g. the
+//! transfer function automatically invalidate them. All methods are thread-safe.
+class iASliceCache
+{
+public:
+	struct iAEntry
+	{
+		iASliceParams slice;
+		iAColorParams color;
+		vtkSmartPointer<vtkImageData> resliced;
+		vtkSmartPointer<vtkImageData> colored;
+	};
+	//! the cached resliced image for the given parameters (nullptr if there is none)
+	vtkSmartPointer<vtkImageData> resliced(iASliceParams const& p)
+	{
+		QMutexLocker locker(&m_mutex);
+		for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+		{
+			if (sameSlice(it->slice, p))
+			{
+				m_entries.splice(m_entries.begin(), m_entries, it);    // most recently used first
+				return m_entries.front().resliced;
+			}
+		}
+		return nullptr;
+	}
+	//! the cached color-mapped image for the given (cached) resliced scalars and color parameters (nullptr if there is none)
+	vtkSmartPointer<vtkImageData> colored(vtkDataArray* reslicedScalars, iAColorParams const& c)
+	{
+		QMutexLocker locker(&m_mutex);
+		for (auto const& e : m_entries)
+		{
+			if (reslicedScalars && e.resliced->GetPointData()->GetScalars() == reslicedScalars && e.color == c)
+			{
+				return e.colored;
+			}
+		}
+		return nullptr;
+	}
+	//! mark the given slice as being computed
+	//! @return false if the slice is already cached or being computed, true otherwise
+	bool startPrefetch(iASliceParams const& p, iAColorParams const& c)
+	{
+		QMutexLocker locker(&m_mutex);
+		for (auto const& e : m_entries)
+		{
+			if (sameSlice(e.slice, p) && e.color == c)
+			{
+				return false;
+			}
+		}
+		for (auto const& pending : m_pending)
+		{
+			if (sameSlice(pending, p))
+			{
+				return false;
+			}
+		}
+		m_pending.push_back(p);
+		return true;
+	}
+	//! whether the given slice is still required (i.e. it was not discarded since startPrefetch)
+	bool isPending(iASliceParams const& p)
+	{
+		QMutexLocker locker(&m_mutex);
+		return std::any_of(m_pending.begin(), m_pending.end(), [&p](auto const& pending) { return sameSlice(pending, p); });
+	}
+	//! add a computed slice (if it is still required)
+	void add(iAEntry&& entry)
+	{
+		QMutexLocker locker(&m_mutex);
+		auto pendingIt = std::find_if(m_pending.begin(), m_pending.end(), [&entry](auto const& pending) { return sameSlice(pending, entry.slice); });
+		if (pendingIt == m_pending.end())
+		{
+			return;
+		}
+		m_pending.erase(pendingIt);
+		m_entries.remove_if([&entry](iAEntry const& e) { return sameSlice(e.slice, entry.slice); });
+		m_entries.push_front(std::move(entry));
+		while (m_entries.size() > SliceCacheSize)
+		{
+			m_entries.pop_back();
+		}
+	}
+	//! remove all cached and pending slices computed with other settings than the given ones
+	void discardOutdated(iASliceParams const& current)
+	{
+		QMutexLocker locker(&m_mutex);
+		m_entries.remove_if([&current](iAEntry const& e) { return !sameSettings(e.slice, current); });
+		std::erase_if(m_pending, [&current](iASliceParams const& p) { return !sameSettings(p, current); });
+	}
+	//! remove all cached and pending slices
+	void clear()
+	{
+		QMutexLocker locker(&m_mutex);
+		m_entries.clear();
+		m_pending.clear();
+	}
+private:
+	QMutex m_mutex;
+	std::list<iAEntry> m_entries;          //!< cached slices, most recently used first
+	std::vector<iASliceParams> m_pending;  //!< slices currently being computed
+};
+
+namespace
+{
+	//! vtkImageReslice which takes its output from an iASliceCache if the current slice is available there
+	class iAvtkCachedImageReslice : public vtkImageReslice
+	{
+	public:
+		static iAvtkCachedImageReslice* New();
+		vtkTypeMacro(iAvtkCachedImageReslice, vtkImageReslice);
+		void setCache(std::shared_ptr<iASliceCache> cache)
+		{
+			m_cache = cache;
+		}
+	protected:
+		int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector) override
+		{
+			auto output = vtkImageData::GetData(outputVector);
+			auto cached = m_cache ? m_cache->resliced(resliceParams(this, vtkImageData::GetData(inputVector[0]))) : nullptr;
+			if (cached)
+			{
+				output->ShallowCopy(cached);
+				m_servedFromCache = true;
+				return 1;
+			}
+			if (m_servedFromCache)
+			{   // detach the output from the cached image, so that its memory isn't re-used for the output:
+				output->GetPointData()->Initialize();
+				m_servedFromCache = false;
+			}
+			return Superclass::RequestData(request, inputVector, outputVector);
+		}
+	private:
+		std::shared_ptr<iASliceCache> m_cache;
+		bool m_servedFromCache = false;
+	};
+	vtkStandardNewMacro(iAvtkCachedImageReslice);
+
+	//! vtkImageMapToColors which takes its output from an iASliceCache if its input is a cached slice
+	class iAvtkCachedImageMapToColors : public vtkImageMapToColors
+	{
+	public:
+		static iAvtkCachedImageMapToColors* New();
+		vtkTypeMacro(iAvtkCachedImageMapToColors, vtkImageMapToColors);
+		void setCache(std::shared_ptr<iASliceCache> cache)
+		{
+			m_cache = cache;
+		}
+	protected:
+		int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector) override
+		{
+			auto input = vtkImageData::GetData(inputVector[0]);
+			auto output = vtkImageData::GetData(outputVector);
+			auto cached = (m_cache && input) ? m_cache->colored(input->GetPointData()->GetScalars(), colorParams(this)) : nullptr;
+			if (cached)
+			{
+				output->ShallowCopy(cached);
+				m_servedFromCache = true;
+				return 1;
+			}
+			if (m_servedFromCache)
+			{   // detach the output from the cached image, so that its memory isn't re-used for the output:
+				output->GetPointData()->Initialize();
+				m_servedFromCache = false;
+			}
+			return Superclass::RequestData(request, inputVector, outputVector);
+		}
+	private:
+		std::shared_ptr<iASliceCache> m_cache;
+		bool m_servedFromCache = false;
+	};
+	vtkStandardNewMacro(iAvtkCachedImageMapToColors);
+
+	vtkSmartPointer<vtkImageReslice> createReslicer(std::shared_ptr<iASliceCache> cache)
+	{
+		auto reslicer = vtkSmartPointer<iAvtkCachedImageReslice>::New();
+		reslicer->setCache(cache);
+		return reslicer;
+	}
+
+	vtkSmartPointer<vtkImageMapToColors> createColormapper(std::shared_ptr<iASliceCache> cache)
+	{
+		auto colormapper = vtkSmartPointer<iAvtkCachedImageMapToColors>::New();
+		colormapper->setCache(cache);
+		return colormapper;
+	}
+
+	//! Copies of all data required for computing a slice in a background thread
+	//! (separate copies for each slice, since vtk objects are in general not safe for concurrent use)
+	struct iAPrefetchJob
+	{
+		iASliceParams slice;
+		iAColorParams color;
+		vtkSmartPointer<vtkImageData> input;            //!< shallow copy of the input image (sharing the voxel data)
+		vtkSmartPointer<vtkAbstractTransform> transform;
+		vtkSmartPointer<vtkScalarsToColors> lut;
+	};
+
+	void computeSlice(iASliceCache& cache, iAPrefetchJob const& job)
+	{
+		if (!cache.isPending(job.slice))
+		{   // settings changed in the meantime
+			return;
+		}
+		iATraceSpan span("render", "Slice prefetch");
+		auto axes = vtkSmartPointer<vtkMatrix4x4>::New();
+		axes->DeepCopy(job.slice.axes);
+		auto reslicer = vtkSmartPointer<vtkImageReslice>::New();
+		reslicer->SetOutputDimensionality(2);
+		reslicer->AutoCropOutputOn();
+		reslicer->SetNumberOfThreads(1);    // slices are computed in parallel already
+		reslicer->SetInputData(job.input);
+		reslicer->SetInformationInput(job.input);
+		reslicer->SetResliceAxes(axes);
+		reslicer->SetResliceTransform(job.transform);
+		reslicer->SetInterpolationMode(job.slice.interpolationMode);
+		reslicer->SetSlabMode(job.slice.slabMode);
+		reslicer->SetSlabNumberOfSlices(job.slice.slabSlices);
+		auto colormapper = vtkSmartPointer<vtkImageMapToColors>::New();
+		colormapper->SetInputConnection(reslicer->GetOutputPort());
+		colormapper->SetLookupTable(job.lut);
+		colormapper->SetOutputFormat(job.color.outputFormat);
+		colormapper->SetPassAlphaToOutput(job.color.passAlpha);
+		colormapper->SetNumberOfThreads(1);
+		colormapper->Update();
+		iASliceCache::iAEntry entry{ job.slice, job.color, vtkSmartPointer<vtkImageData>::New(), vtkSmartPointer<vtkImageData>::New() };
+		entry.resliced->ShallowCopy(reslicer->GetOutput());
+		entry.colored->ShallowCopy(colormapper->GetOutput());
+		cache.add(std::move(entry));
+	}
+}
 
 iAChannelSlicerData::iAChannelSlicerData(iAChannelData const& chData, int mode) :
+	m_sliceCache(std::make_shared<iASliceCache>()),
 	m_imageActor(vtkSmartPointer<vtkImageActor>::New()),
-	m_reslicer(vtkSmartPointer<vtkImageReslice>::New()),
-	m_colormapper(vtkSmartPointer<vtkImageMapToColors>::New()),
+	m_reslicer(createReslicer(m_sliceCache)),
+	m_colormapper(createColormapper(m_sliceCache)),
 	m_lut(vtkSmartPointer<vtkLookupTable>::New()),
 	m_cTF(nullptr),
 	m_oTF(nullptr),
@@ -47,17 +388,74 @@ iAChannelSlicerData::iAChannelSlicerData(iAChannelData const& chData, int mode)
 	initContours();
 }
 
+iAChannelSlicerData::~iAChannelSlicerData()
+{
+	m_sliceCache->clear();    // stops computation of slices still waiting for a thread
+}
+
 void iAChannelSlicerData::setResliceAxesOrigin(double x, double y, double z)
 {
+	double step[3];
+	m_reslicer->GetResliceAxesOrigin(step);
+	step[0] = x - step[0];
+	step[1] = y - step[1];
+	step[2] = z - step[2];
 	m_reslicer->SetResliceAxesOrigin(x, y, z);
 	if (m_enabled)
 	{
+		prefetchSlices(step);
 		m_reslicer->Update();
 		m_colormapper->Update();
 	}
 	m_imageActor->SetInputData(m_colormapper->GetOutput());
 }
 
+void iAChannelSlicerData::prefetchSlices(double const* step)
+{
+	double const stepLength = std::sqrt(step[0] * step[0] + step[1] * step[1] + step[2] * step[2]);
+	if (stepLength == 0 || !input())
+	{
+		return;
+	}
+	auto current = resliceParams(m_reslicer, input());
+	auto color = colorParams(m_colormapper);
+	m_sliceCache->discardOutdated(current);
+	double const* bounds = input()->GetBounds();
+	for (int s = 1; s <= SlicePrefetchCount; ++s)
+	{
+		iAPrefetchJob job{ current, color, nullptr, nullptr, nullptr };
+		job.slice.tolerance = 1e-3 * stepLength;
+		bool inside = true;
+		for (int i = 0; i < 3; ++i)
+		{
+			double& coord = job.slice.axes[OriginIdx[i]];
+			coord += s * step[i];
+			inside &= (bounds[2 * i] - job.slice.tolerance <= coord && coord <= bounds[2 * i + 1] + job.slice.tolerance);
+		}
+		if (!inside)
+		{
+			break;
+		}
+		if (!m_sliceCache->startPrefetch(job.slice, color))
+		{
+			continue;
+		}
+		job.input = vtkSmartPointer<vtkImageData>::New();
+		job.input->ShallowCopy(input());
+		if (current.transform)
+		{
+			job.transform = vtkSmartPointer<vtkAbstractTransform>::Take(current.transform->MakeTransform());
+			job.transform->DeepCopy(current.transform);
+		}
+		if (color.lut)
+		{
+			job.lut = vtkSmartPointer<vtkScalarsToColors>::Take(color.lut->NewInstance());
+			job.lut->DeepCopy(color.lut);
+		}
+		QThreadPool::globalInstance()->start([cache = m_sliceCache, job]() { computeSlice(*cache, job); });
+	}
+}
+
 void iAChannelSlicerData::resliceAxesOrigin(double* origin)
 {
 	m_reslicer->GetResliceAxesOrigin(origin);
@@ -111,6 +509,7 @@ void iAChannelSlicerData::updateLUT()
 
 void iAChannelSlicerData::update(iAChannelData const& chData)
 {
+	m_sliceCache->clear();
 	assign(chData.image());
 	m_name = chData.name();
 	m_reslicer->Update();
@@ -153,6 +552,7 @@ void iAChannelSlicerData::updateMapper()
 
 void iAChannelSlicerData::setTransform(vtkAbstractTransform* transform)
 {
+	m_sliceCache->clear();
 	m_reslicer->SetResliceTransform(transform);
 }
 
@@ -8,8 +8,10 @@
 
 #include <QString>
 
+#include <memory>
 
 class iAChannelData;
+class iASliceCache;
 
 class vtkAbstractTransform;
 class vtkActor;
@@ -24,11 +26,15 @@ class vtkPiecewiseFunction;
 class vtkRenderer;
 class vtkScalarsToColors;
 
-//! Class storing required data for visualizing a "channel" (iAChannelData) in a slicer
+//! Class storing required data for visualizing a "channel" (iAChannelData) in a slicer.
+//! Resliced and color-mapped slices are kept in a small cache; when the slice position changes,
+//! the next slices in the direction of the change are computed in advance in background threads,
+//! so that scrolling through the slices does not need to wait for reslicing and color mapping.
 class iAguibase_API iAChannelSlicerData
 {
 public:
 	iAChannelSlicerData(iAChannelData const & chData, int mode);
+	~iAChannelSlicerData();
 	void update(iAChannelData const & chData);
 	void setResliceAxesOrigin(double x, double y, double z);
 	void resliceAxesOrigin(double * origin);
@@ -73,7 +79,10 @@ private:
 
 	void assign(vtkSmartPointer<vtkImageData> imageData);
 	void setupOutput(vtkScalarsToColors* ctf, vtkPiecewiseFunction* otf);
+	//! start computing the slices following the current one in the given step direction in the background
+	void prefetchSlices(double const* step);
 
+	std::shared_ptr<iASliceCache>   m_sliceCache;  //! cache of prefetched slices, used by reslicer and colormapper
 	vtkSmartPointer<vtkImageActor>  m_imageActor;
 	vtkSmartPointer<vtkImageReslice> m_reslicer;
 	vtkSmartPointer<vtkImageMapToColors> m_colormapper;
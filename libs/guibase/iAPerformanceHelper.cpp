@@ -82,6 +82,68 @@ size_t getCurrentRSS( )
 #endif
 }
 
+//! Returns the peak (maximum so far) resident set size (physical memory use)
+//! measured in bytes, or zero if the value cannot be determined on this OS.
+size_t getPeakRSS( )
+{
+#if defined(_WIN32)
+	/* Windows -------------------------------------------------- */
+	PROCESS_MEMORY_COUNTERS info;
+	GetProcessMemoryInfo( GetCurrentProcess( ), &info, sizeof(info) );
+	return (size_t)info.PeakWorkingSetSize;
+
+#elif defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+	/* BSD, Linux, and OSX -------------------------------------- */
+	struct rusage rusage;
+	getrusage( RUSAGE_SELF, &rusage );
+#if defined(__APPLE__) && defined(__MACH__)
+	return (size_t)rusage.ru_maxrss;
+#else
+	return (size_t)(rusage.ru_maxrss * 1024L);
+#endif
+
+#else
+	/* Unknown OS ----------------------------------------------- */
+	return (size_t)0L;          /* Unsupported. */
+#endif
+}
+
+bool resetPeakRSS()
+{
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+	// writing 5 to clear_refs resets the peak RSS (VmHWM) of the process (Linux >= 4.0):
+	FILE* fp = nullptr;
+	if ( (fp = fopen( "/proc/self/clear_refs", "w" )) == nullptr )
+		return false;
+	bool result = fputs( "5", fp ) >= 0;
+	fclose( fp );
+	return result;
+#else
+	return false;
+#endif
+}
+
+size_t getCurrentPeakRSS()
+{
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+	// ru_maxrss is not affected by resetPeakRSS, but VmHWM in /proc/self/status is:
+	FILE* fp = nullptr;
+	if ( (fp = fopen( "/proc/self/status", "r" )) == nullptr )
+		return getPeakRSS();
+	char line[128];
+	long hwm = -1L;
+	while ( fgets( line, sizeof(line), fp ) != nullptr )
+	{
+		if ( sscanf( line, "VmHWM: %ld kB", &hwm ) == 1 )
+			break;
+	}
+	fclose( fp );
+	return (hwm < 0) ? getPeakRSS() : (size_t)hwm * 1024;
+#else
+	return getPeakRSS();
+#endif
+}
+
 //! internal data encapsulation class for iAPerformanceTimer (PIMPL idiom).
 class iAPerfTimerImpl
 {
@@ -113,7 +113,21 @@ private:
 
 //! Helper method for getting the current memory usage.
 //! @return the number of bytes currently in use by the application
-size_t getCurrentRSS();
+iAguibase_API size_t getCurrentRSS();
+
+//! Helper method for getting the peak memory usage over the whole lifetime of the application.
+//! @return the maximum number of bytes that were in use by the application at any point in time
+iAguibase_API size_t getPeakRSS();
+
+//! Reset the peak memory usage as returned by getCurrentPeakRSS to the current memory usage.
+//! Only supported on Linux for now.
+//! @return true if the peak memory usage could be reset, false otherwise
+iAguibase_API bool resetPeakRSS();
+
+//! Helper method for getting the peak memory usage since the last call to resetPeakRSS.
+//! Where resetPeakRSS is not supported, this is the same as getPeakRSS.
+//! @return the maximum number of bytes in use since the last reset
+iAguibase_API size_t getCurrentPeakRSS();
 
 //! Format the given time in a human-readable format.
 //! @param duration the time to format (in seconds)
@@ -3,6 +3,7 @@
 #include "iAFileIO.h"
 
 #include "iALog.h"
+#include "iATrace.h"
 
 #include <QElapsedTimer>
 #include <QFileInfo>
@@ -22,6 +23,7 @@ std::shared_ptr<iADataSet> iAFileIO::load(QString const& fileName, QVariantMap c
 	try
 	{
 		QElapsedTimer t; t.start();
+		iATraceSpan span("io", "Load " + name());
 		QVariantMap checkedValues(paramValues);
 		checkParams(checkedValues, Operation::Load, fileName);
 		auto dataSet = loadData(fileName, checkedValues, progress);
@@ -98,6 +100,7 @@ bool iAFileIO::save(QString const& fileName, std::shared_ptr<iADataSet> dataSet,
 	try
 	{
 		QElapsedTimer t; t.start();
+		iATraceSpan span("io", "Save " + name());
 		QVariantMap checkedValues(paramValues);
 		checkParams(checkedValues, Save, fileName);
 		saveData(fileName, dataSet, checkedValues, progress);
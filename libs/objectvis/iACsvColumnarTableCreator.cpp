@@ -0,0 +1,28 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iACsvColumnarTableCreator.h"
+
+#include <iAColumnarTable.h>
+
+iACsvColumnarTableCreator::iACsvColumnarTableCreator()
+	: m_table(std::make_shared<iAColumnarTable>())
+{}
+
+void iACsvColumnarTableCreator::initialize(QStringList const & headers, size_t const rowCount)
+{
+	m_table = std::make_shared<iAColumnarTable>(std::vector<QString>(headers.begin(), headers.end()), rowCount);
+}
+
+void iACsvColumnarTableCreator::addRow(size_t row, std::vector<double> const & values)
+{
+	auto& columns = m_table->columns();
+	for (size_t col = 0; col < values.size(); ++col)
+	{
+		columns[col][row] = values[col];
+	}
+}
+
+std::shared_ptr<iAColumnarTable> iACsvColumnarTableCreator::table()
+{
+	return m_table;
+}
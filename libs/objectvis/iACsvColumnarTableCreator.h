@@ -0,0 +1,24 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iACsvIO.h"
+
+#include "iaobjectvis_export.h"
+
+#include <memory>
+
+class iAColumnarTable;
+
+//! Fills an iAColumnarTable with values from a .csv file.
+//! To be used in conjunction with iACsvIO::loadCSV
+class iAobjectvis_API iACsvColumnarTableCreator : public iACsvTableCreator
+{
+public:
+	iACsvColumnarTableCreator();
+	void initialize(QStringList const & headers, size_t const rowCount) override;
+	void addRow(size_t row, std::vector<double> const & values) override;
+	std::shared_ptr<iAColumnarTable> table();
+private:
+	std::shared_ptr<iAColumnarTable> m_table;   //!< output table
+};
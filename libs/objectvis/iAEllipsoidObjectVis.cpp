@@ -6,42 +6,137 @@
 #include "iAObjectsData.h"
 #include "vtkEllipsoidSource.h"
 
-#include <vtkAppendPolyData.h>
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
 #include <vtkPolyData.h>
 #include <vtkPointData.h>
 #include <vtkTable.h>
 
+#include <cmath>
+
+namespace
+{
+	//! all values of the given table column, converted to double
+	std::vector<double> columnValues(vtkTable* table, vtkIdType col)
+	{
+		std::vector<double> result(table->GetNumberOfRows());
+		auto arr = vtkDataArray::SafeDownCast(table->GetColumn(col));
+		for (vtkIdType row = 0; row < table->GetNumberOfRows(); ++row)
+		{
+			result[row] = arr ? arr->GetTuple1(row) : table->GetValue(row, col).ToDouble();
+		}
+		return result;
+	}
+}
+
 iAEllipsoidObjectVis::iAEllipsoidObjectVis(iAObjectsData const* data,
 	QColor const & color, int phiRes, int thetaRes) :
 	iAColoredPolyObjectVis(data, color),
 	m_pointsPerEllipse((phiRes - 2) * thetaRes + 2)
 {
-	auto fullPolySource = vtkSmartPointer<vtkAppendPolyData>::New();
-	// maybe use vtkParametricFunctionSource with vtkParametricEllipsoid?
-	for (vtkIdType row = 0; row < data->m_table->GetNumberOfRows(); ++row)
+	// all ellipsoids are scaled and translated copies of the same unit sphere, so generate its mesh only once:
+	auto unitSphereSrc = vtkSmartPointer<vtkEllipsoidSource>::New();
+	unitSphereSrc->SetThetaResolution(thetaRes);
+	unitSphereSrc->SetPhiResolution(phiRes);
+	unitSphereSrc->SetXRadius(1.0);
+	unitSphereSrc->SetYRadius(1.0);
+	unitSphereSrc->SetZRadius(1.0);
+	unitSphereSrc->Update();
+	auto unitSphere = unitSphereSrc->GetOutput();
+	assert(unitSphere->GetNumberOfPoints() == m_pointsPerEllipse);
+	std::vector<float> tplPoints(3 * m_pointsPerEllipse), tplNormals(3 * m_pointsPerEllipse);
+	for (vtkIdType p = 0; p < m_pointsPerEllipse; ++p)
+	{
+		double pt[3], n[3];
+		unitSphere->GetPoint(p, pt);
+		unitSphere->GetPointData()->GetNormals()->GetTuple(p, n);
+		for (int i = 0; i < 3; ++i)
+		{
+			tplPoints[3 * p + i] = static_cast<float>(pt[i]);
+			tplNormals[3 * p + i] = static_cast<float>(n[i]);
+		}
+	}
+	std::vector<vtkIdType> tplOffsets(1, 0), tplConnectivity;
+	auto tplPolys = unitSphere->GetPolys();
+	for (vtkIdType c = 0; c < tplPolys->GetNumberOfCells(); ++c)
+	{
+		vtkIdType npts;
+		vtkIdType const* pts;
+		tplPolys->GetCellAtId(c, npts, pts);
+		tplConnectivity.insert(tplConnectivity.end(), pts, pts + npts);
+		tplOffsets.push_back(static_cast<vtkIdType>(tplConnectivity.size()));
+	}
+	vtkIdType const cellsPerEllipse = tplPolys->GetNumberOfCells();
+	vtkIdType const connPerEllipse = static_cast<vtkIdType>(tplConnectivity.size());
+
+	auto table = data->m_table;
+	vtkIdType const objCount = table->GetNumberOfRows();
+	std::vector<double> center[3], dimension[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		center[i] = columnValues(table, data->m_colMapping->value(iACsvConfig::CenterX + i));
+		dimension[i] = columnValues(table, data->m_colMapping->value(iACsvConfig::DimensionX + i));
+	}
+	// the sizes of all arrays are known in advance, so each ellipsoid can be written independently:
+	auto points = vtkSmartPointer<vtkPoints>::New();
+	points->SetDataTypeToFloat();
+	points->SetNumberOfPoints(objCount * m_pointsPerEllipse);
+	auto normals = vtkSmartPointer<vtkFloatArray>::New();
+	normals->SetName("Normals");
+	normals->SetNumberOfComponents(3);
+	normals->SetNumberOfTuples(objCount * m_pointsPerEllipse);
+	auto offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+	offsets->SetNumberOfValues(objCount * cellsPerEllipse + 1);
+	auto connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+	connectivity->SetNumberOfValues(objCount * connPerEllipse);
+	auto ptsOut = static_cast<float*>(points->GetVoidPointer(0));
+	auto normalsOut = normals->GetPointer(0);
+	auto offsetsOut = offsets->GetPointer(0);
+	auto connOut = connectivity->GetPointer(0);
+#pragma omp parallel for
+	for (qint64 row = 0; row < objCount; ++row)
 	{
-		double cx = data->m_table->GetValue(row, data->m_colMapping->value(iACsvConfig::CenterX)).ToDouble();
-		double cy = data->m_table->GetValue(row, data->m_colMapping->value(iACsvConfig::CenterY)).ToDouble();
-		double cz = data->m_table->GetValue(row, data->m_colMapping->value(iACsvConfig::CenterZ)).ToDouble();
-		double dx = data->m_table->GetValue(row, data->m_colMapping->value(iACsvConfig::DimensionX)).ToDouble()/2;
-		double dy = data->m_table->GetValue(row, data->m_colMapping->value(iACsvConfig::DimensionY)).ToDouble()/2;
-		double dz = data->m_table->GetValue(row, data->m_colMapping->value(iACsvConfig::DimensionZ)).ToDouble()/2;
-		auto ellipsoidSrc = vtkSmartPointer<vtkEllipsoidSource>::New();
-		ellipsoidSrc->SetThetaResolution(thetaRes);
-		ellipsoidSrc->SetPhiResolution(phiRes);
-		ellipsoidSrc->SetCenter(cx, cy, cz);
-		ellipsoidSrc->SetXRadius(dx);
-		ellipsoidSrc->SetYRadius(dy);
-		ellipsoidSrc->SetZRadius(dz);
-		ellipsoidSrc->Update();
-		fullPolySource->AddInputData(ellipsoidSrc->GetOutput());
+		double const d[3] = { dimension[0][row] / 2, dimension[1][row] / 2, dimension[2][row] / 2 };   // radii
+		// normals are transformed by the inverse transpose of the scaling; the cofactors
+		// (d1*d2, d0*d2, d0*d1) have the same direction, but also work for zero radii:
+		double const nScale[3] = { d[1] * d[2], d[0] * d[2], d[0] * d[1] };
+		vtkIdType const ptStart = row * m_pointsPerEllipse;
+		for (vtkIdType p = 0; p < m_pointsPerEllipse; ++p)
+		{
+			double n[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				ptsOut[3 * (ptStart + p) + i] = static_cast<float>(center[i][row] + d[i] * tplPoints[3 * p + i]);
+				n[i] = nScale[i] * tplNormals[3 * p + i];
+			}
+			double norm = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (int i = 0; i < 3; ++i)
+			{
+				normalsOut[3 * (ptStart + p) + i] = (norm == 0.0) ? tplNormals[3 * p + i] : static_cast<float>(n[i] / norm);
+			}
+		}
+		vtkIdType const cellStart = row * cellsPerEllipse;
+		vtkIdType const connStart = row * connPerEllipse;
+		for (vtkIdType c = 0; c < cellsPerEllipse; ++c)
+		{
+			offsetsOut[cellStart + c] = connStart + tplOffsets[c];
+		}
+		for (vtkIdType c = 0; c < connPerEllipse; ++c)
+		{
+			connOut[connStart + c] = ptStart + tplConnectivity[c];
+		}
 	}
-	fullPolySource->Update();
+	offsetsOut[objCount * cellsPerEllipse] = objCount * connPerEllipse;
+	auto polys = vtkSmartPointer<vtkCellArray>::New();
+	polys->SetData(offsets, connectivity);
+	m_fullPoly = vtkSmartPointer<vtkPolyData>::New();
+	m_fullPoly->SetPoints(points);
+	m_fullPoly->SetPolys(polys);
+	m_fullPoly->GetPointData()->SetNormals(normals);
 	// TODO: color updates etc. don't work because of this "static" mapping!
-	m_fullPoly = fullPolySource->GetOutput();
 	setupColors();
 	m_fullPoly->GetPointData()->AddArray(m_colors);
-	assert ( objectPointCount(0)*m_data->m_table->GetNumberOfRows() == fullPolySource->GetOutput()->GetNumberOfPoints() );
 	setupOriginalIds();
 }
 
@@ -31,20 +31,22 @@ QString iAObjectsData::info() const
 }
 
 
+#include <iAColumnarTable.h>
+#include <iACsvColumnarTableCreator.h>
 #include <iACsvIO.h>
-#include <iACsvVtkTableCreator.h>
 
 #include <QFileInfo>
 
 std::shared_ptr<iAObjectsData> loadObjectsCSV(iACsvConfig const& csvConfig)
 {
-	iACsvVtkTableCreator creator;
+	iACsvColumnarTableCreator creator;
 	iACsvIO io;
 	if (!io.loadCSV(creator, csvConfig))
 	{
 		return std::shared_ptr<iAObjectsData>();
 	}
-	auto objData = std::make_shared<iAObjectsData>(QFileInfo(csvConfig.fileName).completeBaseName(), csvConfig.visType, creator.table(), io.outputMapping());
+	auto objData = std::make_shared<iAObjectsData>(QFileInfo(csvConfig.fileName).completeBaseName(), csvConfig.visType, creator.table()->vtkView(), io.outputMapping());
+	objData->m_columnarTable = creator.table();
 	if (!csvConfig.curvedFiberFileName.isEmpty())
 	{
 		readCurvedFiberInfo(csvConfig.curvedFiberFileName, objData->m_curvedFiberData);
@@ -10,6 +10,8 @@
 
 #include <vtkSmartPointer.h>
 
+class iAColumnarTable;
+
 class vtkTable;
 
 //! dataset type containing data about a list of objects of same type
@@ -21,6 +23,8 @@ public:
 
 	//! one row per object to visualize
 	vtkSmartPointer<vtkTable> m_table;
+	//! optional (if set) storage of the values in m_table (which is a view on it then), for sharing the values with other views without copying them
+	std::shared_ptr<iAColumnarTable> m_columnarTable;
 	//! mapping of columns (see the respective visualization classes which mappings are required)
 	iAColMapP m_colMapping;
 	//! type of visualization to create
@@ -15,9 +15,12 @@
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
 #include <vtkFloatArray.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
 #include <vtkMath.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
@@ -120,22 +123,15 @@ int iAvtkTubeFilter::RequestData(
   vtkPoints *inPts;
   vtkIdType numPts;
   vtkIdType numLines;
-  vtkIdType numNewPts, numNewCells;
-  vtkPoints *newPts;
-  int deleteNormals=0;
-  vtkFloatArray *newNormals;
-  vtkIdType i;
   double range[2], maxSpeed=0;
-  vtkCellArray *newStrips;
   vtkIdType npts = 0;
 
   const vtkIdType* ptsOrig = nullptr;
-  vtkIdType offset=0;
   vtkFloatArray *newTCoords=nullptr;
-  int abort=0;
-  vtkIdType inCellId;
   double oldRadius=1.0;
 
+  m_finalObjectPointMap.clear();
+
   // Check input and initialize
   //
   vtkDebugMacro(<<"Creating tube");
@@ -148,68 +144,14 @@ int iAvtkTubeFilter::RequestData(
     return 1;
   }
 
-  // Create the geometry and topology
-  numNewPts = numPts * this->NumberOfSides;
-  newPts = vtkPoints::New();
-
-  // Set the desired precision for the points in the output.
-  if(this->OutputPointsPrecision == vtkAlgorithm::DEFAULT_PRECISION)
-  {
-    newPts->SetDataType(inPts->GetDataType());
-  }
-  else if(this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION)
-  {
-    newPts->SetDataType(VTK_FLOAT);
-  }
-  else if(this->OutputPointsPrecision == vtkAlgorithm::DOUBLE_PRECISION)
-  {
-    newPts->SetDataType(VTK_DOUBLE);
-  }
-
-  newPts->Allocate(numNewPts);
-  newNormals = vtkFloatArray::New();
-  newNormals->SetName("TubeNormals");
-  newNormals->SetNumberOfComponents(3);
-  newNormals->Allocate(3*numNewPts);
-  newStrips = vtkCellArray::New();
-  newStrips->Allocate(newStrips->EstimateSize(1, static_cast<int>(numNewPts)));
-  vtkCellArray *singlePolyline = vtkCellArray::New();
-
-  // Point data: copy scalars, vectors, tcoords. Normals may be computed here.
-  outPD->CopyNormalsOff();
-  if ( (this->GenerateTCoords == VTK_TCOORDS_FROM_SCALARS && inScalars) ||
-       this->GenerateTCoords == VTK_TCOORDS_FROM_LENGTH ||
-       this->GenerateTCoords == VTK_TCOORDS_FROM_NORMALIZED_LENGTH )
-  {
-    newTCoords = vtkFloatArray::New();
-    newTCoords->SetNumberOfComponents(2);
-    newTCoords->Allocate(numNewPts);
-    outPD->CopyTCoordsOff();
-  }
-  outPD->CopyAllocate(pd,numNewPts);
-
   int generateNormals = 0;
   if ( !(inNormals=pd->GetNormals()) || this->UseDefaultNormal )
   {
-    deleteNormals = 1;
-    inNormals = vtkFloatArray::New();
-    inNormals->SetNumberOfComponents(3);
-    inNormals->SetNumberOfTuples(numPts);
-
-    if ( this->UseDefaultNormal )
-    {
-      for ( i=0; i < numPts; i++)
-      {
-        inNormals->SetTuple(i,this->DefaultNormal);
-      }
-    }
-    else
-    {
-      // Normal generation has been moved to lower in the function.
-      // This allows each different polylines to share vertices, but have
-      // their normals (and hence their tubes) calculated independently
-      generateNormals = 1;
-    }
+    inNormals = nullptr;
+    // If not using the default normal, normals are generated for each polyline
+    // independently, which allows polylines to share vertices, but have their
+    // normals (and hence their tubes) calculated independently
+    generateNormals = !this->UseDefaultNormal;
   }
 
   // If varying width, get appropriate info.
@@ -241,84 +183,217 @@ int iAvtkTubeFilter::RequestData(
     maxSpeed = inVectors->GetMaxNorm();
   }
 
-  // Copy selected parts of cell data; certainly don't want normals
+  // The tubes of all polylines are generated in parallel. Since the number of
+  // output points and cells of each tube only depend on the number of points of
+  // its polyline, the output arrays are allocated up front and each polyline
+  // writes to its own, precomputed range. Polylines for which no points can be
+  // generated (rare) are removed afterwards.
   //
-  numNewCells = inLines->GetNumberOfCells() * this->NumberOfSides + 2;
-  outCD->CopyNormalsOff();
-  outCD->CopyAllocate(cd,numNewCells);
+  // Make a copy of the point indices of all polylines, to avoid modifying input
+  // polydata cells while removing degenerate lines:
+  std::vector<vtkIdType> linePtsStart(numLines + 1, 0);
+  std::vector<vtkIdType> linePts;
+  linePts.reserve(inLines->GetNumberOfConnectivityIds());
+  vtkIdType lineIdx = 0;
+  for (inLines->InitTraversal(); inLines->GetNextCell(npts,ptsOrig); ++lineIdx)
+  {
+    linePts.insert(linePts.end(), ptsOrig, ptsOrig + npts);
+    linePtsStart[lineIdx + 1] = static_cast<vtkIdType>(linePts.size());
+  }
+  if (this->GetAbortExecute())
+  {
+    return 1;
+  }
+  // number of (non-degenerate) points of each polyline; 0 if the polyline is skipped
+  std::vector<vtkIdType> lineNumPts(numLines, 0);
+#pragma omp parallel for
+  for (vtkIdType l = 0; l < numLines; ++l)
+  {
+    vtkIdType* pts = linePts.data() + linePtsStart[l];
+    vtkIdType numLinePts = linePtsStart[l + 1] - linePtsStart[l];
+    if (numLinePts >= 2)
+    {
+      // remove degenerate lines to avoid warnings
+      numLinePts = static_cast<vtkIdType>(std::unique(pts, pts + numLinePts, IdPointsEqual(inPts)) - pts);
+    }
+    lineNumPts[l] = (numLinePts >= 2) ? numLinePts : 0;
+  }
+  // the line cellIds start after the last vert cellId
+  vtkIdType const firstLineCellId = input->GetNumberOfVerts();
+  std::vector<vtkIdType> tentativeOffset(numLines + 1, 0);
+  for (vtkIdType l = 0; l < numLines; ++l)
+  {
+    if (lineNumPts[l] == 0)
+    {
+      LOG(lvlDebug, QString("Skipping line %1, less than 2 points (after degenerate line removal)").arg(firstLineCellId + l));
+    }
+    tentativeOffset[l + 1] = (lineNumPts[l] == 0) ? tentativeOffset[l] : this->ComputeOffset(tentativeOffset[l], lineNumPts[l]);
+  }
+  this->UpdateProgress(0.1);
+
+  // Create the geometry
+  vtkIdType numNewPts = tentativeOffset[numLines];
+  vtkPoints *newPts = vtkPoints::New();
+
+  // Set the desired precision for the points in the output.
+  if(this->OutputPointsPrecision == vtkAlgorithm::DEFAULT_PRECISION)
+  {
+    newPts->SetDataType(inPts->GetDataType());
+  }
+  else if(this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION)
+  {
+    newPts->SetDataType(VTK_FLOAT);
+  }
+  else if(this->OutputPointsPrecision == vtkAlgorithm::DOUBLE_PRECISION)
+  {
+    newPts->SetDataType(VTK_DOUBLE);
+  }
+
+  newPts->SetNumberOfPoints(numNewPts);
+  vtkFloatArray *newNormals = vtkFloatArray::New();
+  newNormals->SetName("TubeNormals");
+  newNormals->SetNumberOfComponents(3);
+  newNormals->SetNumberOfTuples(numNewPts);
+  std::vector<vtkIdType> newPtsSource(numNewPts);   // input point id for each output point (for copying point data)
 
   //  Create points along each polyline that are connected into NumberOfSides
-  //  triangle strips. Texture coordinates are optionally generated.
+  //  triangle strips.
   //
   this->Theta = 2.0*vtkMath::Pi() / this->NumberOfSides;
-  vtkPolyLine *lineNormalGenerator = vtkPolyLine::New();
-  // the line cellIds start after the last vert cellId
-  inCellId = input->GetNumberOfVerts();
-  for (inLines->InitTraversal();
-       inLines->GetNextCell(npts,ptsOrig) && !abort; inCellId++)
-  {
-    this->UpdateProgress((double)inCellId/numLines);
-    abort = this->GetAbortExecute();
-
-    // Make a copy of point indices to avoid modfiying input polydata cells
-    // while removing degenerate lines.
-    if (npts < 2)
-    {
-      LOG(lvlDebug, QString("Skipping line %1, less than 2 points").arg(inCellId));
-      continue; // skip tubing this polyline
+  std::vector<char const*> lineErrors(numLines, nullptr);
+#pragma omp parallel
+  {
+    // per-thread temporary objects for computing the normals of a single polyline:
+    vtkNew<vtkPoints> singlePolylinePts;
+    vtkNew<vtkCellArray> singlePolyline;
+    vtkNew<vtkFloatArray> lineNormals;
+    lineNormals->SetNumberOfComponents(3);
+#pragma omp for schedule(dynamic, 256)
+    for (vtkIdType l = 0; l < numLines; ++l)
+    {
+      vtkIdType const numLinePts = lineNumPts[l];
+      if (numLinePts == 0)
+      {
+        continue;
+      }
+      vtkIdType* pts = linePts.data() + linePtsStart[l];
+      lineNormals->SetNumberOfTuples(numLinePts);
+      if (generateNormals)
+      {
+        // each polyline calculates its normals independently, avoiding conflicts at shared vertices.
+        singlePolylinePts->SetNumberOfPoints(numLinePts);
+        singlePolyline->Reset();
+        singlePolyline->InsertNextCell(static_cast<int>(numLinePts));
+        for (vtkIdType j = 0; j < numLinePts; ++j)
+        {
+          double p[3];
+          inPts->GetPoint(pts[j], p);
+          singlePolylinePts->SetPoint(j, p);
+          singlePolyline->InsertCellPoint(j);
+        }
+        vtkPolyLine::GenerateSlidingNormals(singlePolylinePts, singlePolyline, lineNormals);
+      }
+      else
+      {
+        for (vtkIdType j = 0; j < numLinePts; ++j)
+        {
+          double n[3];
+          if (inNormals)
+          {
+            inNormals->GetTuple(pts[j], n);
+          }
+          lineNormals->SetTuple(j, inNormals ? n : this->DefaultNormal);
+        }
+      }
+      // Generate the points around the polyline. The tube is not stripped
+      // if the polyline is bad.
+      //
+      lineErrors[l] = this->GeneratePoints(tentativeOffset[l], numLinePts, pts, inPts, newPts,
+        newPtsSource.data(), newNormals, inScalars, range, inVectors, maxSpeed, lineNormals);
     }
-    std::vector<vtkIdType> ptsCopy(ptsOrig, ptsOrig + npts);
-    vtkIdType* pts = ptsCopy.data();
+  }
+  this->UpdateProgress(0.5);
 
-    // remove degenerate lines to avoid warnings
-    npts = static_cast<vtkIdType>(std::unique(pts, pts + npts, IdPointsEqual(inPts)) - pts);
-    if (npts < 2)
+  // Determine the final offset of each polyline; move the points of the
+  // polylines following a skipped one to close the gap
+  std::vector<vtkIdType> offset(numLines, 0);
+  std::vector<vtkIdType> cellOffset(numLines + 1, 0);
+  std::vector<vtkIdType> connOffset(numLines + 1, 0);
+  vtkIdType const numStripsPerLine = (this->NumberOfSides + this->OnRatio - 1) / this->OnRatio;
+  vtkIdType curOffset = 0;
+  for (vtkIdType l = 0; l < numLines; ++l)
+  {
+    npts = lineNumPts[l];
+    if (npts > 0 && lineErrors[l])
     {
-      LOG(lvlDebug, QString("Skipping line %1, less than 2 points after degenerate line removal").arg(inCellId));
-      continue; //skip tubing this polyline
+      vtkWarningMacro(<< lineErrors[l]);
+      vtkWarningMacro(<< "Could not generate points!");
+      lineNumPts[l] = npts = 0;    // skip tubing this polyline
     }
-
-    // If necessary calculate normals, each polyline calculates its
-    // normals independently, avoiding conflicts at shared vertices.
-    if (generateNormals)
+    offset[l] = curOffset;
+    cellOffset[l + 1] = cellOffset[l];
+    connOffset[l + 1] = connOffset[l];
+    if (npts == 0)
     {
-      singlePolyline->Reset(); //avoid instantiation
-      singlePolyline->InsertNextCell(npts,pts);
-      lineNormalGenerator->GenerateSlidingNormals(inPts,singlePolyline, inNormals);
+      continue;
     }
-
-    // Generate the points around the polyline. The tube is not stripped
-    // if the polyline is bad.
-    //
-
-    if ( !this->GeneratePoints(offset,npts,pts,inPts,newPts,pd,outPD,
-                               newNormals,inScalars,range,inVectors,
-                               maxSpeed,inNormals) )
+    vtkIdType lineNewPts = tentativeOffset[l + 1] - tentativeOffset[l];
+    if (curOffset != tentativeOffset[l])
     {
-      vtkWarningMacro(<< "Could not generate points!");
-      continue; //skip tubing this polyline
+      for (vtkIdType i = 0; i < lineNewPts; ++i)
+      {
+        newPts->GetData()->SetTuple(curOffset + i, tentativeOffset[l] + i, newPts->GetData());
+        newNormals->SetTuple(curOffset + i, tentativeOffset[l] + i, newNormals);
+        newPtsSource[curOffset + i] = newPtsSource[tentativeOffset[l] + i];
+      }
     }
-
     //Store number of final points for each line
-    m_finalObjectPointMap.push_back(std::make_pair(offset, newPts->GetNumberOfPoints() - offset));
-
-    // Generate the strips for this polyline (including caps)
-    //
-    this->GenerateStrips(offset,npts,pts,inCellId,cd,outCD,newStrips);
+    m_finalObjectPointMap.push_back(std::make_pair(curOffset, lineNewPts));
+    cellOffset[l + 1] += numStripsPerLine + (this->Capping ? 2 : 0);
+    connOffset[l + 1] += numStripsPerLine * 2 * npts + (this->Capping ? 2 * this->NumberOfSides : 0);
+    // Compute the new offset for the next polyline
+    curOffset = this->ComputeOffset(curOffset, npts);
+  }
+  numNewPts = curOffset;
+  newPts->SetNumberOfPoints(numNewPts);
+  newNormals->SetNumberOfTuples(numNewPts);
+  newPtsSource.resize(numNewPts);
 
-    // Generate the texture coordinates for this polyline
-    //
+  // Generate the strips for each polyline (including caps), and optionally the texture coordinates
+  //
+  vtkIdType const numNewCells = cellOffset[numLines];
+  vtkNew<vtkIdTypeArray> stripOffsets;
+  stripOffsets->SetNumberOfValues(numNewCells + 1);
+  vtkNew<vtkIdTypeArray> stripConnectivity;
+  stripConnectivity->SetNumberOfValues(connOffset[numLines]);
+  std::vector<vtkIdType> newCellsSource(numNewCells);   // input cell id for each output cell (for copying cell data)
+  if ( (this->GenerateTCoords == VTK_TCOORDS_FROM_SCALARS && inScalars) ||
+       this->GenerateTCoords == VTK_TCOORDS_FROM_LENGTH ||
+       this->GenerateTCoords == VTK_TCOORDS_FROM_NORMALIZED_LENGTH )
+  {
+    newTCoords = vtkFloatArray::New();
+    newTCoords->SetNumberOfComponents(2);
+    newTCoords->SetNumberOfTuples(numNewPts);
+    newTCoords->Fill(0.0);
+  }
+#pragma omp parallel for schedule(dynamic, 256)
+  for (vtkIdType l = 0; l < numLines; ++l)
+  {
+    if (lineNumPts[l] == 0)
+    {
+      continue;
+    }
+    vtkIdType* pts = linePts.data() + linePtsStart[l];
+    this->GenerateStrips(offset[l], lineNumPts[l], stripOffsets->GetPointer(cellOffset[l]),
+      stripConnectivity->GetPointer(0), connOffset[l]);
+    std::fill(newCellsSource.begin() + cellOffset[l], newCellsSource.begin() + cellOffset[l + 1], firstLineCellId + l);
     if ( newTCoords )
     {
-      this->GenerateTextureCoords(offset,npts,pts,inPts,inScalars,newTCoords);
+      this->GenerateTextureCoords(offset[l], lineNumPts[l], pts, inPts, inScalars, newTCoords);
     }
-
-    // Compute the new offset for the next polyline
-    offset = this->ComputeOffset(offset,npts);
-
-  }//for all polylines
-
-  singlePolyline->Delete();
+  }
+  stripOffsets->SetValue(numNewCells, connOffset[numLines]);
+  this->UpdateProgress(0.9);
 
   // reset the radius to ite original value if necessary
   if (this->VaryRadius == VTK_VARY_RADIUS_BY_ABSOLUTE_SCALAR)
@@ -326,13 +401,38 @@ int iAvtkTubeFilter::RequestData(
     this->Radius = oldRadius;
   }
 
-  // Update ourselves
+  // Point data: copy scalars, vectors, tcoords. Normals are computed here.
+  outPD->CopyNormalsOff();
+  if ( newTCoords )
+  {
+    outPD->CopyTCoordsOff();
+  }
+  outPD->CopyAllocate(pd,numNewPts);
+  vtkNew<vtkIdList> fromIds, toIds;
+  fromIds->SetNumberOfIds(numNewPts);
+  toIds->SetNumberOfIds(numNewPts);
+  for (vtkIdType i = 0; i < numNewPts; ++i)
+  {
+    fromIds->SetId(i, newPtsSource[i]);
+    toIds->SetId(i, i);
+  }
+  outPD->CopyData(pd, fromIds, toIds);
+
+  // Copy selected parts of cell data; certainly don't want normals
   //
-  if ( deleteNormals )
+  outCD->CopyNormalsOff();
+  outCD->CopyAllocate(cd,numNewCells);
+  fromIds->SetNumberOfIds(numNewCells);
+  toIds->SetNumberOfIds(numNewCells);
+  for (vtkIdType i = 0; i < numNewCells; ++i)
   {
-    inNormals->Delete();
+    fromIds->SetId(i, newCellsSource[i]);
+    toIds->SetId(i, i);
   }
+  outCD->CopyData(cd, fromIds, toIds);
 
+  // Update ourselves
+  //
   if ( newTCoords )
   {
     outPD->SetTCoords(newTCoords);
@@ -342,26 +442,26 @@ int iAvtkTubeFilter::RequestData(
   output->SetPoints(newPts);
   newPts->Delete();
 
+  vtkNew<vtkCellArray> newStrips;
+  newStrips->SetData(stripOffsets, stripConnectivity);
   output->SetStrips(newStrips);
-  newStrips->Delete();
 
   outPD->SetNormals(newNormals);
   newNormals->Delete();
-  lineNormalGenerator->Delete();
 
   output->Squeeze();
 
   return 1;
 }
 
-int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
+char const* iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
                                   vtkIdType npts, vtkIdType *pts,
                                   vtkPoints *inPts, vtkPoints *newPts,
-                                  vtkPointData *pd, vtkPointData *outPD,
+                                  vtkIdType *newPtsSource,
                                   vtkFloatArray *newNormals,
                                   vtkDataArray *inScalars, double range[2],
                                   vtkDataArray *inVectors, double maxSpeed,
-                                  vtkDataArray *inNormals)
+                                  vtkDataArray *lineNormals)
 {
   vtkIdType j;
   int i, k;
@@ -372,7 +472,6 @@ int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
   double startCapNorm[3], endCapNorm[3];
   double n[3];
   double s[3];
-  //double bevelAngle;
   double w[3];
   double nP[3];
   double sFactor=1.0;
@@ -420,12 +519,11 @@ int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
       }
     }
 
-    inNormals->GetTuple(pts[j], n);
+    lineNormals->GetTuple(j, n);
 
     if ( vtkMath::Normalize(sNext) == 0.0 )
     {
-      vtkWarningMacro(<<"Coincident points!");
-      return 0;
+      return "Coincident points!";
     }
 
     for (i=0; i<3; i++)
@@ -435,36 +533,14 @@ int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
     // if s is zero then just use sPrev cross n
     if (vtkMath::Normalize(s) == 0.0)
     {
-      vtkDebugMacro(<< "Using alternate bevel vector");
       vtkMath::Cross(sPrev,n,s);
-      if (vtkMath::Normalize(s) == 0.0)
-      {
-        vtkDebugMacro(<< "Using alternate bevel vector");
-      }
+      vtkMath::Normalize(s);
     }
 
-/*    if ( (bevelAngle = vtkMath::Dot(sNext,sPrev)) > 1.0 )
-      {
-      bevelAngle = 1.0;
-      }
-    if ( bevelAngle < -1.0 )
-      {
-      bevelAngle = -1.0;
-      }
-    bevelAngle = acos((double)bevelAngle) / 2.0; //(0->90 degrees)
-    if ( (bevelAngle = cos(bevelAngle)) == 0.0 )
-      {
-      bevelAngle = 1.0;
-      }
-
-    bevelAngle = this->Radius / bevelAngle; //keep tube constant radius
-*/
     vtkMath::Cross(s,n,w);
     if ( vtkMath::Normalize(w) == 0.0)
     {
-      vtkWarningMacro(<<"Bad normal s = " <<s[0]<<" "<<s[1]<<" "<< s[2]
-                      << " n = " << n[0] << " " << n[1] << " " << n[2]);
-      return 0;
+      return "Bad normal!";
     }
 
     vtkMath::Cross(w,s,nP); //create orthogonal coordinate system
@@ -479,8 +555,9 @@ int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
     }
     else if ( inVectors && this->VaryRadius == VTK_VARY_RADIUS_BY_VECTOR )
     {
-      sFactor =
-        sqrt((double)maxSpeed/vtkMath::Norm(inVectors->GetTuple(pts[j])));
+      double v[3];
+      inVectors->GetTuple(pts[j], v);
+      sFactor = sqrt((double)maxSpeed/vtkMath::Norm(v));
       if ( sFactor > this->RadiusFactor )
       {
         sFactor = this->RadiusFactor;
@@ -494,8 +571,7 @@ int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
         sFactor *= this->IndividualFactors[pts[j]];
       if (sFactor < 0.0)
       {
-        vtkWarningMacro(<<"Scalar value less than zero, skipping line");
-        return 0;
+        return "Scalar value less than zero, skipping line";
       }
     }
 
@@ -510,9 +586,9 @@ int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
             nP[i]*sin((double)k*this->Theta);
           s[i] = p[i] + this->Radius * sFactor * normal[i];
         }
-        newPts->InsertPoint(ptId,s);
-        newNormals->InsertTuple(ptId,normal);
-        outPD->CopyData(pd,pts[j],ptId);
+        newPts->SetPoint(ptId,s);
+        newNormals->SetTuple(ptId,normal);
+        newPtsSource[ptId] = pts[j];
         ptId++;
       }//for each side
     }
@@ -537,12 +613,12 @@ int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
             nP[i]*sin((double)(k+0.5)*this->Theta);
           s[i] = p[i] + this->Radius * sFactor * normal[i];
         }
-        newPts->InsertPoint(ptId,s);
-        newNormals->InsertTuple(ptId,n_right);
-        outPD->CopyData(pd,pts[j],ptId);
-        newPts->InsertPoint(ptId+1,s);
-        newNormals->InsertTuple(ptId+1,n_left);
-        outPD->CopyData(pd,pts[j],ptId+1);
+        newPts->SetPoint(ptId,s);
+        newNormals->SetTuple(ptId,n_right);
+        newPtsSource[ptId] = pts[j];
+        newPts->SetPoint(ptId+1,s);
+        newNormals->SetTuple(ptId+1,n_left);
+        newPtsSource[ptId+1] = pts[j];
         ptId += 2;
       }//for each side
     }//else separate vertices
@@ -563,9 +639,9 @@ int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
     for (k=0; k < numCapSides; k+=capIncr)
     {
       newPts->GetPoint(offset+k,s);
-      newPts->InsertPoint(ptId,s);
-      newNormals->InsertTuple(ptId,startCapNorm);
-      outPD->CopyData(pd,pts[0],ptId);
+      newPts->SetPoint(ptId,s);
+      newNormals->SetTuple(ptId,startCapNorm);
+      newPtsSource[ptId] = pts[0];
       ptId++;
     }
     //the end cap
@@ -577,21 +653,20 @@ int iAvtkTubeFilter::GeneratePoints(vtkIdType offset,
     for (k=0; k < numCapSides; k+=capIncr)
     {
       newPts->GetPoint(endOffset+k,s);
-      newPts->InsertPoint(ptId,s);
-      newNormals->InsertTuple(ptId,endCapNorm);
-      outPD->CopyData(pd,pts[npts-1],ptId);
+      newPts->SetPoint(ptId,s);
+      newNormals->SetTuple(ptId,endCapNorm);
+      newPtsSource[ptId] = pts[npts-1];
       ptId++;
     }
   }//if capping
 
-  return 1;
+  return nullptr;
 }
 
 void iAvtkTubeFilter::GenerateStrips(vtkIdType offset, vtkIdType npts,
-                                   vtkIdType* vtkNotUsed(pts),
-                                   vtkIdType inCellId,
-                                   vtkCellData *cd, vtkCellData *outCD,
-                                   vtkCellArray *newStrips)
+                                   vtkIdType *cellOffsets,
+                                   vtkIdType *connectivity,
+                                   vtkIdType connIdx)
 {
   if (this->SidesShareVertices)
   {
@@ -600,13 +675,12 @@ void iAvtkTubeFilter::GenerateStrips(vtkIdType offset, vtkIdType npts,
     {
       vtkIdType i1 = k % this->NumberOfSides;
       vtkIdType i2 = (k+1) % this->NumberOfSides;
-      vtkIdType outCellId = newStrips->InsertNextCell(static_cast<int>(npts*2));
-      outCD->CopyData(cd,inCellId,outCellId);
+      *cellOffsets++ = connIdx;
       for (vtkIdType i=0; i < npts; i++)
       {
         vtkIdType i3 = i*this->NumberOfSides;
-        newStrips->InsertCellPoint(offset+i2+i3);
-        newStrips->InsertCellPoint(offset+i1+i3);
+        connectivity[connIdx++] = offset+i2+i3;
+        connectivity[connIdx++] = offset+i1+i3;
       }
     } //for each side of the tube
   }
@@ -617,13 +691,12 @@ void iAvtkTubeFilter::GenerateStrips(vtkIdType offset, vtkIdType npts,
     {
       vtkIdType i1 = 2*(k % this->NumberOfSides) + 1;
       vtkIdType i2 = 2*((k+1) % this->NumberOfSides);
-      vtkIdType outCellId = newStrips->InsertNextCell(static_cast<int>(npts*2));
-      outCD->CopyData(cd,inCellId,outCellId);
+      *cellOffsets++ = connIdx;
       for (vtkIdType i=0; i < npts; i++)
       {
         vtkIdType i3 = i*2*this->NumberOfSides;
-        newStrips->InsertCellPoint(offset+i2+i3);
-        newStrips->InsertCellPoint(offset+i1+i3);
+        connectivity[connIdx++] = offset+i2+i3;
+        connectivity[connIdx++] = offset+i1+i3;
       }
     } //for each side of the tube
   }
@@ -633,7 +706,6 @@ void iAvtkTubeFilter::GenerateStrips(vtkIdType offset, vtkIdType npts,
   if (this->Capping)
   {
     vtkIdType startIdx = offset + npts*this->NumberOfSides;
-    vtkIdType idx;
 
     if ( ! this->SidesShareVertices )
     {
@@ -641,44 +713,38 @@ void iAvtkTubeFilter::GenerateStrips(vtkIdType offset, vtkIdType npts,
     }
 
     //The start cap
-    vtkIdType outCellId = newStrips->InsertNextCell(static_cast<int>(this->NumberOfSides));
-    outCD->CopyData(cd,inCellId,outCellId);
-    newStrips->InsertCellPoint(startIdx);
-    newStrips->InsertCellPoint(startIdx+1);
+    *cellOffsets++ = connIdx;
+    connectivity[connIdx++] = startIdx;
+    connectivity[connIdx++] = startIdx+1;
     for (vtkIdType i1=this->NumberOfSides-1, i2=2, k=0; k<(this->NumberOfSides-2); k++)
     {
       if ( (k%2) )
       {
-        idx = startIdx + i2;
-        newStrips->InsertCellPoint(idx);
+        connectivity[connIdx++] = startIdx + i2;
         i2++;
       }
       else
       {
-        idx = startIdx + i1;
-        newStrips->InsertCellPoint(idx);
+        connectivity[connIdx++] = startIdx + i1;
         i1--;
       }
     }
 
     //The end cap - reversed order to be consistent with normal
     startIdx += this->NumberOfSides;
-    outCellId = newStrips->InsertNextCell(static_cast<int>(this->NumberOfSides));
-    outCD->CopyData(cd,inCellId,outCellId);
-    newStrips->InsertCellPoint(startIdx);
-    newStrips->InsertCellPoint(startIdx+this->NumberOfSides-1);
+    *cellOffsets++ = connIdx;
+    connectivity[connIdx++] = startIdx;
+    connectivity[connIdx++] = startIdx+this->NumberOfSides-1;
     for (vtkIdType i1=this->NumberOfSides-2, i2=1, k=0; k<(this->NumberOfSides-2); k++)
     {
       if ( (k%2) )
       {
-        idx = startIdx + i1;
-        newStrips->InsertCellPoint(idx);
+        connectivity[connIdx++] = startIdx + i1;
         i1--;
       }
       else
       {
-        idx = startIdx + i2;
-        newStrips->InsertCellPoint(idx);
+        connectivity[connIdx++] = startIdx + i2;
         i2++;
       }
     }
@@ -710,7 +776,7 @@ void iAvtkTubeFilter::GenerateTextureCoords(vtkIdType offset,
       for (vtkIdType k=0; k < numSides; k++)
       {
         double tcy = static_cast<double>(k) / (numSides - 1);
-        newTCoords->InsertTuple2(offset + i * numSides + k, tc, tcy);
+        newTCoords->SetTuple2(offset + i * numSides + k, tc, tcy);
       }
     }
   }
@@ -726,7 +792,7 @@ void iAvtkTubeFilter::GenerateTextureCoords(vtkIdType offset,
       for (vtkIdType k=0; k < numSides; k++)
       {
         double tcy = static_cast<double>(k) / (numSides - 1);
-        newTCoords->InsertTuple2(offset + i * numSides + k, tc, tcy);
+        newTCoords->SetTuple2(offset + i * numSides + k, tc, tcy);
       }
 
       xPrev[0]=x[0]; xPrev[1]=x[1]; xPrev[2]=x[2];
@@ -752,7 +818,7 @@ void iAvtkTubeFilter::GenerateTextureCoords(vtkIdType offset,
       for (vtkIdType k=0; k < numSides; k++)
       {
         double tcy = static_cast<double>(k) / (numSides - 1);
-        newTCoords->InsertTuple2(offset + i * numSides + k, tc, tcy);
+        newTCoords->SetTuple2(offset + i * numSides + k, tc, tcy);
       }
       xPrev[0]=x[0]; xPrev[1]=x[1]; xPrev[2]=x[2];
     }
@@ -766,13 +832,13 @@ void iAvtkTubeFilter::GenerateTextureCoords(vtkIdType offset,
     //start cap
     for (vtkIdType ik=0; ik < this->NumberOfSides; ik++)
     {
-      newTCoords->InsertTuple2(startIdx+ik,0.0,0.0);
+      newTCoords->SetTuple2(startIdx+ik,0.0,0.0);
     }
 
     //end cap
     for (vtkIdType ik=0; ik < this->NumberOfSides; ik++)
     {
-      newTCoords->InsertTuple2(startIdx+this->NumberOfSides+ik,tc,0.0);
+      newTCoords->SetTuple2(startIdx+this->NumberOfSides+ik,tc,0.0);
     }
   }
 }
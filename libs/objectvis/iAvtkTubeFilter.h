@@ -8,6 +8,7 @@
 *    - the RadiusFactor is applied to the radii retrieved from the scalars
 *    - a separate IndividualFactors array can be set, with additional
 *      diameter adaptation factors for each single point
+* Additionally, the tubes of the single polylines are generated in parallel.
 */
 /*=========================================================================
 
@@ -195,15 +196,17 @@ protected:
   std::vector<std::pair<vtkIdType, vtkIdType>> m_finalObjectPointMap; //! maps the final object ID to (first=) the first index in the points array that belongs to this object, and (second=) the number of points
 
   // Helper methods
-  int GeneratePoints(vtkIdType offset, vtkIdType npts, vtkIdType *pts,
-                     vtkPoints *inPts, vtkPoints *newPts,
-                     vtkPointData *pd, vtkPointData *outPD,
+  //! generate the points (and their normals) of the tube around one polyline, starting at the given offset
+  //! @return nullptr on success, otherwise a description of the problem with the polyline
+  const char* GeneratePoints(vtkIdType offset, vtkIdType npts, vtkIdType *pts,
+                     vtkPoints *inPts, vtkPoints *newPts, vtkIdType *newPtsSource,
                      vtkFloatArray *newNormals, vtkDataArray *inScalars,
                      double range[2], vtkDataArray *inVectors, double maxNorm,
-                     vtkDataArray *inNormals);
-  void GenerateStrips(vtkIdType offset, vtkIdType npts, vtkIdType *pts,
-                      vtkIdType inCellId, vtkCellData *cd, vtkCellData *outCD,
-                      vtkCellArray *newStrips);
+                     vtkDataArray *lineNormals);
+  //! generate the strips (and caps) of the tube around one polyline; writes the offsets
+  //! of the generated cells to cellOffsets, and their points to connectivity, starting at connIdx
+  void GenerateStrips(vtkIdType offset, vtkIdType npts, vtkIdType *cellOffsets,
+                      vtkIdType *connectivity, vtkIdType connIdx);
   void GenerateTextureCoords(vtkIdType offset, vtkIdType npts, vtkIdType *pts,
                              vtkPoints *inPts, vtkDataArray *inScalars,
                             vtkFloatArray *newTCoords);
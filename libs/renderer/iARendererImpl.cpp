@@ -15,6 +15,7 @@
 #include <iASlicerMode.h>
 #include <iAStringHelper.h>
 #include <iAToolsVTK.h>    // for setCamPos
+#include <iATrace.h>
 #include <iAvtkSourcePoly.h>
 #include <iAvtkActorHelper.h>  // for showActor
 
@@ -422,6 +423,7 @@ void iARendererImpl::update()
 		LOG(lvlWarn, "Invalid call to update() on an uninitialized iARendererImpl");
 		return;
 	}
+	iATraceSpan span("render", "3D renderer update");
 	m_ren->Render();
 	m_renWin->Render();
 	m_renWin->GetInteractor()->Render();
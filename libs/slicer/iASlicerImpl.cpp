@@ -22,6 +22,7 @@
 #include <iAStringHelper.h>
 #include <iAToolsITK.h>
 #include <iAToolsVTK.h>
+#include <iATrace.h>
 
 // slicer
 #include "iASlicerInteractorStyle.h"
@@ -502,6 +503,7 @@ void iASlicerImpl::update()
 	{
 		return;
 	}
+	iATraceSpan span("render", "Slicer update");
 	for (auto ch : m_channels)
 	{
 		ch->updateMapper();
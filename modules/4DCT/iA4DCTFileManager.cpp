@@ -2,6 +2,9 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iA4DCTFileManager.h"
 
+#include <iADataCache.h>
+
+#include <vtkImageData.h>
 #include <vtkMetaImageReader.h>
 
 iA4DCTFileManager& iA4DCTFileManager::getInstance( )
@@ -10,25 +13,22 @@ iA4DCTFileManager& iA4DCTFileManager::getInstance( )
 	return instance;
 }
 
-vtkImageData* iA4DCTFileManager::getImage( iA4DCTFileData file )
-{
-	return findOrCreateImage( file )->GetOutput( );
-}
-
-vtkAlgorithmOutput* iA4DCTFileManager::getOutputPort( iA4DCTFileData file )
-{
-	return findOrCreateImage( file )->GetOutputPort( );
-}
-
-iA4DCTFileManager::ReaderType iA4DCTFileManager::findOrCreateImage( iA4DCTFileData file )
+vtkSmartPointer<vtkImageData> iA4DCTFileManager::getImage( iA4DCTFileData file )
 {
-	std::string key = file.Name.toStdString( );
-	if ( !m_map.contains( key ) )
-	{	// the key does not exist
-		ReaderType reader = ReaderType::New();
-		reader->SetFileName(file.Path.toStdString().c_str());
-		reader->Update( );
-		m_map[ key ] = reader;
-	}
-	return m_map[ key ];
+	using ImagePointer = vtkSmartPointer<vtkImageData>;
+	return iADataCache::get( ).load<ImagePointer>( file.Path, QVariantMap( ),
+		[&file]( )
+		{
+			auto reader = vtkSmartPointer<vtkMetaImageReader>::New( );
+			reader->SetFileName( file.Path.toStdString( ).c_str( ) );
+			reader->Update( );
+			// detach image from reader, so that the reader can be released:
+			auto img = ImagePointer::New( );
+			img->ShallowCopy( reader->GetOutput( ) );
+			return img;
+		},
+		[]( ImagePointer const& img )
+		{
+			return static_cast<size_t>( img->GetActualMemorySize( ) ) * 1024;	// GetActualMemorySize is in KiB
+		} );
 }
@@ -3,24 +3,20 @@
 #pragma once
 
 #include "iA4DCTFileData.h"
-// std
-#include <map>
 // vtk
 #include <vtkSmartPointer.h>
 
-class vtkAlgorithmOutput;
-class vtkMetaImageReader;
 class vtkImageData;
 
+//! Provides the images of the 4DCT stages; loaded images are kept in the shared
+//! iADataCache, so they are re-used as long as the cache's memory budget permits.
 class iA4DCTFileManager
 {
-private:
-	typedef vtkSmartPointer<vtkMetaImageReader> ReaderType;
-
 public:
 	static iA4DCTFileManager&	getInstance( );
-	vtkImageData*				getImage( iA4DCTFileData file );
-	vtkAlgorithmOutput*			getOutputPort( iA4DCTFileData file );
+	//! get the image stored in the given file; keep the returned pointer only as long as needed,
+	//! as the image cannot be evicted from the cache while it is referenced
+	vtkSmartPointer<vtkImageData>	getImage( iA4DCTFileData file );
 
 private:
 			iA4DCTFileManager( ) { }
@@ -28,9 +24,4 @@ private:
 
 			iA4DCTFileManager( iA4DCTFileManager const& ) = delete;
 	void	operator=( iA4DCTFileManager const& ) = delete;
-
-	ReaderType	findOrCreateImage( iA4DCTFileData file );
-	ReaderType	findReader( iA4DCTFileData file );
-
-	std::map<std::string, ReaderType> m_map;
 };
@@ -55,7 +55,7 @@ void iAPlaneVisModule::setImage( iA4DCTFileData fileName )
 	shifter->SetShift( 0. );
 	shifter->SetScale( scale );
 	shifter->SetOutputScalarTypeToUnsignedChar( );
-	shifter->SetInputConnection( iA4DCTFileManager::getInstance( ).getOutputPort( fileName ) );
+	shifter->SetInputData( iA4DCTFileManager::getInstance( ).getImage( fileName ) );
 	shifter->ReleaseDataFlagOff( );
 	shifter->Update( );
 
@@ -99,7 +99,7 @@ void iAPlaneVisModule::highlightDefects( QVector<QString> defects, QVector<QColo
 	reader->SetFileName( labeledImgPath.toStdString().c_str( ) );
 	reader->Update( );
 	vtkImageData * labeledImg = reader->GetOutput( );*/
-	vtkImageData * labeledImg = iA4DCTFileManager::getInstance( ).getImage( labeledImgFile );
+	vtkSmartPointer<vtkImageData> labeledImg = iA4DCTFileManager::getInstance( ).getImage( labeledImgFile );
 
 	// hash the defects
 	QVector<iA4DCTDefects::HashDataType> hashes;
@@ -158,7 +158,7 @@ void iAPlaneVisModule::densityMap( QString defect, QColor color, iA4DCTFileData
 	reader->SetFileName( labeledImgPath.toStdString().c_str( ) );
 	reader->Update( );
 	vtkImageData * labeledImg = reader->GetOutput( );*/
-	vtkImageData * labeledImg = iA4DCTFileManager::getInstance( ).getImage( labeledImgFile );
+	vtkSmartPointer<vtkImageData> labeledImg = iA4DCTFileManager::getInstance( ).getImage( labeledImgFile );
 
 	// hash the defect
 	iA4DCTDefects::VectorDataType list = iA4DCTDefects::load( defect );
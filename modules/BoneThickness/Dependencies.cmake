@@ -2,5 +2,5 @@ set(DEPENDENCIES_LIBRARIES
 	iA::guibase
 )
 set(DEPENDENCIES_VTK_MODULES
-	FiltersStatistics       # for vtkPCAStatistics
+	FiltersGeneral          # for vtkOBBTree
 )
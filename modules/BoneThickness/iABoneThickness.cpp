@@ -17,24 +17,25 @@
 
 #include <vtkDoubleArray.h>
 #include <vtkFloatArray.h>
+#include <vtkIdList.h>
 #include <vtkPointData.h>
 #include <vtkCellData.h>
 #include <vtkLineSource.h>
 #include <vtkMath.h>
-#include <vtkPCAStatistics.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataMapper.h>
-#include <vtkPointLocator.h>
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkSphereSource.h>
-#include <vtkTable.h>
+#include <vtkStaticPointLocator.h>
 #include <vtkTubeFilter.h>
 
 #include <QVector>
 
+#include <omp.h>
+
 
 iABoneThickness::iABoneThickness()
 {
@@ -96,147 +97,44 @@ void iABoneThickness::calculate()
 	// if there are landmarks present
 	if (m_pPoints)
 	{
-		// Initialize point locator variable for detecting mesh vertices
-		vtkSmartPointer<vtkPointLocator> pPointLocator(vtkSmartPointer<vtkPointLocator>::New());
-		pPointLocator->SetDataSet(m_pPolyData);
-		pPointLocator->BuildLocator();
-
-		// Initialize OBBTree variable (similar to point locator) for detecting landmarks
-		vtkSmartPointer<vtkOBBTree> pLandmarks(vtkSmartPointer<vtkOBBTree>::New());
-		pLandmarks->SetDataSet(m_pPolyData);
-		pLandmarks->BuildLocator();
-
 		// landmark ids
 		const vtkIdType idPoints(m_pPoints->GetNumberOfPoints());
 
-		// length of the normal vector for intersection test
-		const double dLength(0.5 * m_dRangeMax);
-
-		// Go through each Landmark
-		for (vtkIdType id (0); id < idPoints; ++id)
+		// the measurements only depend on landmarks, mesh and sphere radius, so they only need to be
+		// recomputed if one of these changed (open / set clear them), not if only a maximum changed:
+		if (m_measurements.size() != idPoints || m_dMeasurementSphereRadius != m_dSphereRadius)
 		{
-			// Get landmark position
-			double* pPoint (m_pPoints->GetPoint(id));
-
-			// Calculate normal of mesh at the landmark position
-			// normal vector computed with PC3 of vertex cloud within certain radius around landmark
-			double pNormal[3];
-			getNormalInPoint(pPointLocator, pPoint, pNormal);
-
-			// Allocate intersection variable
-			vtkSmartPointer<vtkPoints> intersectPoints1 = vtkSmartPointer<vtkPoints>::New();	// Intersection of positive normal vector
-			vtkSmartPointer<vtkPoints> intersectPoints2 = vtkSmartPointer<vtkPoints>::New();	// intersection of negative normal vector
-			auto subIds = vtkSmartPointer<vtkIdList>::New();
-
-			// start and end points of finite line to intersect with mesh
-			double pStart[3]{ pPoint[0], pPoint[1], pPoint[2] };
-			double pEnd[3] = { pPoint[0] - dLength * pNormal[0], pPoint[1] - dLength * pNormal[1], pPoint[2] - dLength * pNormal[2] };
-			double pEndShift[3] = { pPoint[0] + dLength * pNormal[0], pPoint[1] + dLength * pNormal[1], pPoint[2] + dLength * pNormal[2] };
-
-			// Initialize relevant intersection points
-			double x1[3] { pStart[0], pStart[1], pStart[2] };
-			double x2[3] { pStart[0], pStart[1], pStart[2] };
-
-			// Temp variables
-			int flag1 = 0;		// flag of return value of intersection function (1: intersection/outside of surface, -1: intersection/indise of surface, 0: no intersection)
-			int flag2 = 0;
-			double distance1;	// distances of start point to intersection points
-			double distance2;
-
-			// check all three intersection variations:
-			// Landmark is inside of mesh
-			// Landmark is outside of mesh, but surfaces are on both sides of the landmark (positive and negative normal direction)
-			// Landmark is outside of mesh and surfaces are only on one normal direction
-
-			// If both normal direction have intersection
-			if ((flag1 = pLandmarks->IntersectWithLine(pStart, pEnd, intersectPoints1, subIds))&
-				(flag2 = pLandmarks->IntersectWithLine(pStart, pEndShift, intersectPoints2, subIds))) {
-
-				// Unknown case where landmark is inside and outside of the mesh at the same time (depends on certain normal vector directions)
-				if (flag1 == -flag2) {
-					if (intersectPoints1->GetNumberOfPoints() >=2) {
-						intersectPoints1->GetPoint(0, x1);
-						intersectPoints1->GetPoint(1, x2);
-					}
-					else {
-						intersectPoints2->GetPoint(0, x1);
-						intersectPoints2->GetPoint(1, x2);
-					}
-				}
-				else {
-					// Get the first intersection of each normal direction
-					intersectPoints1->GetPoint(0, x1);
-					intersectPoints2->GetPoint(0, x2);
+			buildLocators();
 
-					// Compute the distance of each first intersection
-					distance1 = vtkMath::Distance2BetweenPoints(pStart, x1);
-					distance2 = vtkMath::Distance2BetweenPoints(pStart, x2);
-
-					// if landmark is outside of the STL
-					if (flag1 == 1) {
-
-						// the closest of both intersections will be starting point of thickness calculation
-						if (distance1 < distance2) {
-							intersectPoints1->GetPoint(0, x1);
-							intersectPoints1->GetPoint(1, x2);
-						}
-						else {
-							intersectPoints2->GetPoint(0, x1);
-							intersectPoints2->GetPoint(1, x2);
-						}
-					}
-					// if landmark is inside the STL
-					else {
-
-						// Project landmark onto the STL surface shortest away from the landmark
-						if (distance1 < distance2) {
-							intersectPoints1->GetPoint(0, x1);
-							intersectPoints2->GetPoint(0, x2);
-						}
-						else {
-							intersectPoints2->GetPoint(0, x1);
-							intersectPoints1->GetPoint(0, x2);
-						}
-					}
-				}
-			}
-			// If landmark is outside of the mesh and only one normal direction has intersections
-			else {
-				// check in which direction the intersection occured and set first two intersection and start and end point of thickness computation
-				if (flag1) {
-					if (intersectPoints1->GetNumberOfPoints() >= 2) {
-						intersectPoints1->GetPoint(0, x1);
-						intersectPoints1->GetPoint(1, x2);
-					}
-				}
-				else if (flag2) {
-					if (intersectPoints2->GetNumberOfPoints() >= 2) {
-						intersectPoints2->GetPoint(0, x1);
-						intersectPoints2->GetPoint(1, x2);
-					}
-				}
-			}
+			// length of the normal vector for intersection test
+			const double dLength(0.5 * m_dRangeMax);
 
-			// Calculate distances:
-			// Landmark to first intersection
-			// Thickness of mesh: intersection1 to intersection2
-			if (flag1 == -1)
+			m_measurements.resize(idPoints);
+			// landmarks are independent of each other; the point locator is only read here,
+			// and each thread intersects with its own OBB tree
+#pragma omp parallel for schedule(dynamic)
+			for (vtkIdType id = 0; id < idPoints; ++id)
 			{
-				setResults(id, std::sqrt(vtkMath::Distance2BetweenPoints(x1, x2)), -std::sqrt(vtkMath::Distance2BetweenPoints(pStart, x1)));
-			}
-			else
-			{
-				setResults(id, std::sqrt(vtkMath::Distance2BetweenPoints(x1, x2)), std::sqrt(vtkMath::Distance2BetweenPoints(pStart, x1)));
+				double pPoint[3];
+				m_pPoints->GetPoint(id, pPoint);
+				m_measurements[id] = measure(m_pOBBTrees[omp_get_thread_num()], pPoint, dLength);
 			}
+			m_dMeasurementSphereRadius = m_dSphereRadius;
+		}
+
+		for (vtkIdType id(0); id < idPoints; ++id)
+		{
+			auto const& m = m_measurements[id];
+			setResults(id, m.thickness, m.surfaceDistance);
 
 			// Store coordinates in order to draw thickness and projection lines
 			// Projection lines = green
 			// Thickness line = blue
-			m_pThLines[id]->SetPoint1(x1);
-			m_pThLines[id]->SetPoint2(x2);
+			m_pThLines[id]->SetPoint1(m.x1);
+			m_pThLines[id]->SetPoint2(m.x2);
 
-			m_pDaLines[id]->SetPoint1(pStart);
-			m_pDaLines[id]->SetPoint2(x1);
+			m_pDaLines[id]->SetPoint1(m.start);
+			m_pDaLines[id]->SetPoint2(m.x1);
 		}
 
 		// Calculate mean thickness
@@ -277,54 +175,199 @@ void iABoneThickness::calculate()
 
 	}
 }
-bool iABoneThickness::getNormalFromPCA(vtkIdList* _pIdList, double* _pNormal)
-{
-	const vtkIdType idList(_pIdList->GetNumberOfIds());
 
-	if (idList > 2)
+void iABoneThickness::buildLocators()
+{
+	if (!m_pPointLocator)
 	{
-		vtkSmartPointer<vtkDoubleArray> pArrayX(vtkSmartPointer<vtkDoubleArray>::New());
-		pArrayX->SetNumberOfComponents(1);
-		pArrayX->SetName("x");
-
-		vtkSmartPointer<vtkDoubleArray> pArrayY(vtkSmartPointer<vtkDoubleArray>::New());
-		pArrayY->SetNumberOfComponents(1);
-		pArrayY->SetName("y");
-
-		vtkSmartPointer<vtkDoubleArray> pArrayZ(vtkSmartPointer<vtkDoubleArray>::New());
-		pArrayZ->SetNumberOfComponents(1);
-		pArrayZ->SetName("z");
-
-		for (vtkIdType id (0) ; id < idList ; ++id)
+		// Initialize point locator variable for detecting mesh vertices;
+		// in contrast to vtkPointLocator, queries on vtkStaticPointLocator are thread-safe
+		m_pPointLocator = vtkSmartPointer<vtkStaticPointLocator>::New();
+		m_pPointLocator->SetDataSet(m_pPolyData);
+		m_pPointLocator->BuildLocator();
+	}
+	if (m_pOBBTrees.size() != omp_get_max_threads())
+	{
+		// Initialize OBBTree variables (similar to point locator) for detecting landmarks;
+		// vtkOBBTree::IntersectWithLine is not documented as thread-safe, and it accesses cells of the
+		// mesh through the data set (which may use internal buffers), so each thread gets its own tree
+		// on its own copy of the mesh:
+		m_pOBBTrees.resize(omp_get_max_threads());
+#pragma omp parallel for
+		for (int t = 0; t < m_pOBBTrees.size(); ++t)
 		{
-			const double* pPoint (m_pPolyData->GetPoint(_pIdList->GetId(id)));
+			auto mesh = vtkSmartPointer<vtkPolyData>::New();
+			mesh->DeepCopy(m_pPolyData);
+			m_pOBBTrees[t] = vtkSmartPointer<vtkOBBTree>::New();
+			m_pOBBTrees[t]->SetDataSet(mesh);
+			m_pOBBTrees[t]->BuildLocator();
+		}
+	}
+}
 
-			pArrayX->InsertNextValue(pPoint[0]);
-			pArrayY->InsertNextValue(pPoint[1]);
-			pArrayZ->InsertNextValue(pPoint[2]);
+iABoneThickness::iALandmarkMeasurement iABoneThickness::measure(vtkOBBTree* _pOBBTree, double const* _pPoint, double const& _dLength) const
+{
+	// Calculate normal of mesh at the landmark position
+	// normal vector computed with PC3 of vertex cloud within certain radius around landmark
+	double pPoint[3]{ _pPoint[0], _pPoint[1], _pPoint[2] };
+	double pNormal[3];
+	getNormalInPoint(pPoint, pNormal);
+
+	// Allocate intersection variable
+	vtkSmartPointer<vtkPoints> intersectPoints1 = vtkSmartPointer<vtkPoints>::New();	// Intersection of positive normal vector
+	vtkSmartPointer<vtkPoints> intersectPoints2 = vtkSmartPointer<vtkPoints>::New();	// intersection of negative normal vector
+	auto subIds = vtkSmartPointer<vtkIdList>::New();
+
+	// start and end points of finite line to intersect with mesh
+	double pStart[3]{ pPoint[0], pPoint[1], pPoint[2] };
+	double pEnd[3] = { pPoint[0] - _dLength * pNormal[0], pPoint[1] - _dLength * pNormal[1], pPoint[2] - _dLength * pNormal[2] };
+	double pEndShift[3] = { pPoint[0] + _dLength * pNormal[0], pPoint[1] + _dLength * pNormal[1], pPoint[2] + _dLength * pNormal[2] };
+
+	// Initialize relevant intersection points
+	double x1[3] { pStart[0], pStart[1], pStart[2] };
+	double x2[3] { pStart[0], pStart[1], pStart[2] };
+
+	// Temp variables
+	int flag1 = 0;		// flag of return value of intersection function (1: intersection/outside of surface, -1: intersection/indise of surface, 0: no intersection)
+	int flag2 = 0;
+	double distance1;	// distances of start point to intersection points
+	double distance2;
+
+	// check all three intersection variations:
+	// Landmark is inside of mesh
+	// Landmark is outside of mesh, but surfaces are on both sides of the landmark (positive and negative normal direction)
+	// Landmark is outside of mesh and surfaces are only on one normal direction
+
+	// If both normal direction have intersection
+	if ((flag1 = _pOBBTree->IntersectWithLine(pStart, pEnd, intersectPoints1, subIds))&
+		(flag2 = _pOBBTree->IntersectWithLine(pStart, pEndShift, intersectPoints2, subIds))) {
+
+		// Unknown case where landmark is inside and outside of the mesh at the same time (depends on certain normal vector directions)
+		if (flag1 == -flag2) {
+			if (intersectPoints1->GetNumberOfPoints() >=2) {
+				intersectPoints1->GetPoint(0, x1);
+				intersectPoints1->GetPoint(1, x2);
+			}
+			else {
+				intersectPoints2->GetPoint(0, x1);
+				intersectPoints2->GetPoint(1, x2);
+			}
 		}
+		else {
+			// Get the first intersection of each normal direction
+			intersectPoints1->GetPoint(0, x1);
+			intersectPoints2->GetPoint(0, x2);
 
-		vtkSmartPointer<vtkTable> pDatasetTable(vtkSmartPointer<vtkTable>::New());
-		pDatasetTable->AddColumn(pArrayX);
-		pDatasetTable->AddColumn(pArrayY);
-		pDatasetTable->AddColumn(pArrayZ);
+			// Compute the distance of each first intersection
+			distance1 = vtkMath::Distance2BetweenPoints(pStart, x1);
+			distance2 = vtkMath::Distance2BetweenPoints(pStart, x2);
 
-		vtkSmartPointer<vtkPCAStatistics> pPCAStatistics(vtkSmartPointer<vtkPCAStatistics>::New());
-		pPCAStatistics->SetDeriveOption(true);
-		pPCAStatistics->SetInputData(vtkStatisticsAlgorithm::INPUT_DATA, pDatasetTable);
+			// if landmark is outside of the STL
+			if (flag1 == 1) {
 
-		pPCAStatistics->SetColumnStatus("x", 1);
-		pPCAStatistics->SetColumnStatus("y", 1);
-		pPCAStatistics->SetColumnStatus("z", 1);
-		pPCAStatistics->RequestSelectedColumns();
-		pPCAStatistics->Update();
+				// the closest of both intersections will be starting point of thickness calculation
+				if (distance1 < distance2) {
+					intersectPoints1->GetPoint(0, x1);
+					intersectPoints1->GetPoint(1, x2);
+				}
+				else {
+					intersectPoints2->GetPoint(0, x1);
+					intersectPoints2->GetPoint(1, x2);
+				}
+			}
+			// if landmark is inside the STL
+			else {
 
-		vtkSmartPointer<vtkDoubleArray> pEigenVector(vtkSmartPointer<vtkDoubleArray>::New());
-		pPCAStatistics->GetEigenvector(2, pEigenVector);
+				// Project landmark onto the STL surface shortest away from the landmark
+				if (distance1 < distance2) {
+					intersectPoints1->GetPoint(0, x1);
+					intersectPoints2->GetPoint(0, x2);
+				}
+				else {
+					intersectPoints2->GetPoint(0, x1);
+					intersectPoints1->GetPoint(0, x2);
+				}
+			}
+		}
+	}
+	// If landmark is outside of the mesh and only one normal direction has intersections
+	else {
+		// check in which direction the intersection occured and set first two intersection and start and end point of thickness computation
+		if (flag1) {
+			if (intersectPoints1->GetNumberOfPoints() >= 2) {
+				intersectPoints1->GetPoint(0, x1);
+				intersectPoints1->GetPoint(1, x2);
+			}
+		}
+		else if (flag2) {
+			if (intersectPoints2->GetNumberOfPoints() >= 2) {
+				intersectPoints2->GetPoint(0, x1);
+				intersectPoints2->GetPoint(1, x2);
+			}
+		}
+	}
+
+	// Calculate distances:
+	// Landmark to first intersection
+	// Thickness of mesh: intersection1 to intersection2
+	iALandmarkMeasurement result;
+	result.thickness = std::sqrt(vtkMath::Distance2BetweenPoints(x1, x2));
+	result.surfaceDistance = ((flag1 == -1) ? -1 : 1) * std::sqrt(vtkMath::Distance2BetweenPoints(pStart, x1));
+	std::copy(pStart, pStart + 3, result.start);
+	std::copy(x1, x1 + 3, result.x1);
+	std::copy(x2, x2 + 3, result.x2);
+	return result;
+}
 
-		for (vtkIdType id(0); id < 3; ++id)
+bool iABoneThickness::getNormalFromPCA(vtkIdList* _pIdList, double* _pNormal) const
+{
+	const vtkIdType idList(_pIdList->GetNumberOfIds());
+
+	if (idList > 2)
+	{
+		// the normal is the principal component with the smallest variance, i.e. the eigenvector
+		// to the smallest eigenvalue of the covariance matrix of the points:
+		double pMean[3] = { 0.0, 0.0, 0.0 };
+		for (vtkIdType id (0) ; id < idList ; ++id)
+		{
+			double pPoint[3];
+			m_pPolyData->GetPoint(_pIdList->GetId(id), pPoint);
+			for (int i = 0; i < 3; ++i)
+			{
+				pMean[i] += pPoint[i];
+			}
+		}
+		for (int i = 0; i < 3; ++i)
+		{
+			pMean[i] /= idList;
+		}
+		double pCov[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+		for (vtkIdType id (0) ; id < idList ; ++id)
+		{
+			double pPoint[3];
+			m_pPolyData->GetPoint(_pIdList->GetId(id), pPoint);
+			for (int i = 0; i < 3; ++i)
+			{
+				for (int j = i; j < 3; ++j)
+				{
+					pCov[i][j] += (pPoint[i] - pMean[i]) * (pPoint[j] - pMean[j]);
+				}
+			}
+		}
+		pCov[1][0] = pCov[0][1];
+		pCov[2][0] = pCov[0][2];
+		pCov[2][1] = pCov[1][2];
+
+		double pEigenValues[3];
+		double pEigenVectors[3][3];
+		double* pCovRows[3] = { pCov[0], pCov[1], pCov[2] };
+		double* pEigenVectorRows[3] = { pEigenVectors[0], pEigenVectors[1], pEigenVectors[2] };
+		// eigenvalues are sorted in decreasing order, eigenvectors are stored in the columns:
+		vtkMath::Jacobi(pCovRows, pEigenValues, pEigenVectorRows);
+
+		for (int id(0); id < 3; ++id)
 		{
-			_pNormal[id] = pEigenVector->GetValue(id);
+			_pNormal[id] = pEigenVectors[id][2];
 		}
 
 		return true;
@@ -333,10 +376,10 @@ bool iABoneThickness::getNormalFromPCA(vtkIdList* _pIdList, double* _pNormal)
 	return false;
 }
 
-void iABoneThickness::getNormalInPoint(vtkPointLocator* _pPointLocator, double* _pPoint, double* _pNormal)
+void iABoneThickness::getNormalInPoint(double* _pPoint, double* _pNormal) const
 {
 	vtkSmartPointer<vtkIdList> idListPointsWithinRadius(vtkSmartPointer<vtkIdList>::New());
-	_pPointLocator->FindPointsWithinRadius(m_dSphereRadius, _pPoint, idListPointsWithinRadius);
+	m_pPointLocator->FindPointsWithinRadius(m_dSphereRadius, _pPoint, idListPointsWithinRadius);
 
 	if (getNormalFromPCA(idListPointsWithinRadius, _pNormal))
 	{
@@ -373,6 +416,7 @@ void iABoneThickness::open(const QString& _sFilename)
 	if (bOpened)
 	{
 		m_pPoints = vtkSmartPointer<vtkPoints>::New();
+		m_measurements.clear();
 		m_pThLines.clear();
 		m_pDaLines.clear();
 
@@ -471,6 +515,9 @@ void iABoneThickness::set(iARenderer* _iARenderer, vtkPolyData* _pPolyData, iABo
 
 	m_pPolyData = _pPolyData;
 	m_pPolyData->GetBounds(m_pBound);
+	m_pPointLocator = nullptr;
+	m_pOBBTrees.clear();
+	m_measurements.clear();
 
 	m_pRange[0] = m_pBound[1] - m_pBound[0];
 	m_pRange[1] = m_pBound[3] - m_pBound[2];
@@ -10,9 +10,10 @@ class vtkActorCollection;
 class vtkDoubleArray;
 class vtkIdList;
 class vtkLineSource;
-class vtkPointLocator;
+class vtkOBBTree;
 class vtkPoints;
 class vtkPolyData;
+class vtkStaticPointLocator;
 
 class iARenderer;
 
@@ -76,6 +77,16 @@ public:
 	double surfaceDistanceMaximum() const;
 
 private:
+	//! thickness measurement at one landmark, before applying the thickness / surface distance maximum
+	struct iALandmarkMeasurement
+	{
+		double thickness;
+		double surfaceDistance;
+		double start[3];   //!< landmark position
+		double x1[3];      //!< start of thickness line (= end of surface distance line)
+		double x2[3];      //!< end of thickness line
+	};
+
 	double m_pColorNormal[3];
 	double m_pColorSelected[3];
 	double m_pColorMark[3];
@@ -115,8 +126,19 @@ private:
 
 	iARenderer* m_iARenderer = nullptr;
 
-	bool getNormalFromPCA(vtkIdList* _pIdList, double* _pNormal);
-	void getNormalInPoint(vtkPointLocator* _pPointLocator, double* _pPoint, double* _pNormal);
+	//! locators for the current mesh, built on first use and reused by all subsequent calculations
+	vtkSmartPointer<vtkStaticPointLocator> m_pPointLocator;
+	//! one OBB tree per thread, each on its own copy of the mesh (see buildLocators)
+	QVector<vtkSmartPointer<vtkOBBTree>> m_pOBBTrees;
+	//! measurements for the current landmarks, mesh and sphere radius (m_dMeasurementSphereRadius);
+	//! reused when only the thickness / surface distance maximum changes
+	QVector<iALandmarkMeasurement> m_measurements;
+	double m_dMeasurementSphereRadius = -1.0;
+
+	void buildLocators();
+	bool getNormalFromPCA(vtkIdList* _pIdList, double* _pNormal) const;
+	void getNormalInPoint(double* _pPoint, double* _pNormal) const;
+	iALandmarkMeasurement measure(vtkOBBTree* _pOBBTree, double const* _pPoint, double const& _dLength) const;
 	void getSphereColor(const vtkIdType& _id, const double& _dRadius, double* pColor);
 
 	void setSphereOpacity(const double& _dSphereOpacity);
@@ -25,6 +25,8 @@ typedef iAFunctionalBoxplot< unsigned int, double> FunctionalBoxPlot;
 
 struct icData
 {
+	icData() :
+		intensity(0), x(0), y(0), z(0) {}
 	icData(double i, itk::Index<DIM> coord ) :
 		intensity(i), x(static_cast<unsigned int>(coord[0])), y(static_cast<unsigned int>(coord[1])), z(static_cast<unsigned int>(coord[2])) {}
 
@@ -54,6 +56,10 @@ const MapPathNames2PathID PathNameToId = fill_PathNameToId();
 
 const double golden_ratio = 0.618033988749895;
 
+//! intensity range covered by the histogram heatmap (the y-axis of the sub-histograms)
+const int SubHistLowerBound = 0;
+const int SubHistUpperBound = 65535;
+
 inline void updateLegendAndGraphVisibility(QCPPlottableLegendItem *ptliU, QCustomPlot *plotP,
 	int legendPItemIdx,  float alpha, bool visibility)
 {
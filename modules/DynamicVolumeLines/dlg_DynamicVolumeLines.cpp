@@ -114,7 +114,9 @@ dlg_DynamicVolumeLines::dlg_DynamicVolumeLines(QWidget* parent, QDir datasetsDir
 }
 
 dlg_DynamicVolumeLines::~dlg_DynamicVolumeLines()
-{}
+{
+	qDeleteAll(m_segmTreeList);
+}
 
 void dlg_DynamicVolumeLines::setupScaledPlot(QCustomPlot *qcp)
 {
@@ -320,7 +322,8 @@ void dlg_DynamicVolumeLines::generateHilbertIdx()
 {
 	QThread *thread = new QThread;
 	iAIntensityMapper *im = new iAIntensityMapper(m_iMProgress, m_datasetsDir, PathNameToId[m_ui->cb_Paths->currentText()],
-		m_DatasetIntensityMap, m_imgDataList, m_minEnsembleIntensity, m_maxEnsembleIntensity);
+		m_DatasetIntensityMap, m_imgDataList, m_minEnsembleIntensity, m_maxEnsembleIntensity,
+		m_segmTreeList, m_ui->sb_subHistBinCnt->value());
 	iAJobListView::get()->addJob("Running Intensity mapper", &m_iMProgress, thread);
 	im->moveToThread(thread);
 	connect(thread, &QThread::started, im, &iAIntensityMapper::process);
@@ -644,7 +647,7 @@ void dlg_DynamicVolumeLines::calcNonLinearMapping()
 void dlg_DynamicVolumeLines::generateSegmentTree()
 {
 	// TODO: draw after BkgdRanges + draw only the histograms without the BkgdRanes
-	int subhistBinCnt = m_ui->sb_subHistBinCnt->value(), lowerBnd = 0, upperBnd = 65535,
+	int subhistBinCnt = m_ui->sb_subHistBinCnt->value(), lowerBnd = SubHistLowerBound, upperBnd = SubHistUpperBound,
 		plotBinWidth = m_ui->sb_histBinWidth->value(),
 		plotWidth = m_linearScaledPlot->axisRect()->rect().width(),
 		plotBinCnt = std::ceil(plotWidth / (double)plotBinWidth);
@@ -653,18 +656,17 @@ void dlg_DynamicVolumeLines::generateSegmentTree()
 	m_histBinImpFunctAvgVec.clear();
 	m_linearHistBinBoarderVec.clear();
 
+	// the trees are built along with the linearization (see iAIntensityMapper); only rebuild them if the bin count changed
 	if (m_segmTreeList.isEmpty() | m_subHistBinCntChanged)
 	{
+		qDeleteAll(m_segmTreeList);
 		m_segmTreeList.clear();
 		m_subHistBinCntChanged = false;
 		for (int datsetNumber = 0; datsetNumber < m_DatasetIntensityMap.size(); ++datsetNumber)
 		{
-			std::vector<int> intensityVec;
-			for (int hIdx = 0; hIdx < m_DatasetIntensityMap[datsetNumber].second.size(); ++hIdx)
-			{
-				intensityVec.push_back(m_DatasetIntensityMap[datsetNumber].second[hIdx].intensity);
-			}
-			iASegmentTree *segmentTree = new iASegmentTree(intensityVec, subhistBinCnt, lowerBnd, upperBnd);
+			auto const & intensities = m_DatasetIntensityMap[datsetNumber].second;
+			iASegmentTree *segmentTree = new iASegmentTree(intensities.size(), subhistBinCnt, lowerBnd, upperBnd);
+			segmentTree->build([&intensities](size_t hIdx) { return intensities[hIdx].intensity; });
 			m_segmTreeList.append(segmentTree);
 		}
 	}
@@ -718,14 +720,21 @@ void dlg_DynamicVolumeLines::generateSegmentTree()
 
 		m_linearHistBinBoarderVec.append(linearUpperDbl);
 
-		for (int yBinNumber = 0; yBinNumber < subhistBinCnt; ++yBinNumber)
+		std::vector<unsigned int> nonlinear_hist(subhistBinCnt, 0), linear_hist(subhistBinCnt, 0);
+		for (int treeNumber = 0; treeNumber < m_segmTreeList.size(); ++treeNumber)
 		{
-			unsigned int nonlinear_sum = 0, linear_sum = 0;
-			for (int treeNumber = 0; treeNumber < m_segmTreeList.size(); ++treeNumber)
+			auto nonlinearTreeHist = m_segmTreeList[treeNumber]->hist_query(static_cast<int>(nonlinearLowerIdx), static_cast<int>(nonlinearUpperIdx));
+			auto linearTreeHist = m_segmTreeList[treeNumber]->hist_query(linearLowerIdx, linearUpperIdx);
+			for (int yBinNumber = 0; yBinNumber < subhistBinCnt; ++yBinNumber)
 			{
-				nonlinear_sum += m_segmTreeList[treeNumber]->hist_query(static_cast<int>(nonlinearLowerIdx), static_cast<int>(nonlinearUpperIdx))[yBinNumber];
-				linear_sum += m_segmTreeList[treeNumber]->hist_query(linearLowerIdx, linearUpperIdx)[yBinNumber];
+				nonlinear_hist[yBinNumber] += nonlinearTreeHist[yBinNumber];
+				linear_hist[yBinNumber] += linearTreeHist[yBinNumber];
 			}
+		}
+
+		for (int yBinNumber = 0; yBinNumber < subhistBinCnt; ++yBinNumber)
+		{
+			unsigned int nonlinear_sum = nonlinear_hist[yBinNumber], linear_sum = linear_hist[yBinNumber];
 
 			QCPItemRect *nonlin_histRectItem = new QCPItemRect(m_nonlinearScaledPlot);
 			nonlin_histRectItem->setObjectName("histRect");
@@ -1413,6 +1422,8 @@ void dlg_DynamicVolumeLines::updateDynamicVolumeLines()
 {
 	m_imgDataList.clear();
 	m_DatasetIntensityMap.clear();
+	qDeleteAll(m_segmTreeList);
+	m_segmTreeList.clear();
 	generateHilbertIdx();
 }
 
@@ -2,20 +2,30 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "iAIntensityMapper.h"
+#include "iASegmentTree.h"
 #include "iAITKIO.h"
 #include "iATypedCallHelper.h"
 
-#include <itkImageRegionIteratorWithIndex.h>
 #include <itkImageToVTKImageFilter.h>
 
 #include <Hilbert.hpp>
 
 #include <QDir>
 
+#include <array>
+#include <vector>
+
+namespace
+{
+	//! number of Hilbert indices converted to coordinates between two progress updates
+	const qint64 HilbertChunkSize = 1 << 16;
+}
+
 template<class T>
 void getIntensities(iAProgress &imp, PathID m_pathID, iAITKIO::ImagePointer &image, QList<icData> &intensityList,
 	QList<vtkSmartPointer<vtkImageData>> &m_imgDataList, QList<double> &minEnsembleIntensityList,
-	QList<double> &maxEnsembleIntensityList, QList<QVector<unsigned int>> &coordList)
+	QList<double> &maxEnsembleIntensityList, std::vector<std::array<unsigned int, DIM>> &coordList,
+	QList<iASegmentTree*> &segmTreeList, int subHistBinCnt)
 {
 	typedef itk::Image< T, DIM >   InputImageType;
 	InputImageType * input = dynamic_cast<InputImageType*>(image.GetPointer());
@@ -29,87 +39,85 @@ void getIntensities(iAProgress &imp, PathID m_pathID, iAITKIO::ImagePointer &ima
 	maxEnsembleIntensityList.append(imageData->GetScalarRange()[1]);
 	m_imgDataList.append(imageData);
 
-	switch (m_pathID)
+	auto size = input->GetLargestPossibleRegion().GetSize();
+	const qint64 voxelCnt = size[0] * size[1] * size[2];
+	if (m_pathID == P_HILBERT && coordList.empty())
 	{
-		case P_HILBERT:
+		// coordinates along the Hilbert curve are the same for all datasets, compute them only once:
+		coordList.resize(voxelCnt);
+		int nbOfBitsPerDim[DIM];
+		for (int i = 0; i < DIM; ++i)
+		{
+			nbOfBitsPerDim[i] = std::ceil(std::sqrt((size[i] - 1)));
+		}
+		for (qint64 chunkStart = 0; chunkStart < voxelCnt; chunkStart += HilbertChunkSize)
 		{
-			if (coordList.size() == 0)
+			const qint64 chunkEnd = std::min(chunkStart + HilbertChunkSize, voxelCnt);
+#pragma omp parallel for
+			for (qint64 h = chunkStart; h < chunkEnd; ++h)
 			{
-				QVector<unsigned int> coord(3);
-				auto size = input->GetLargestPossibleRegion().GetSize();
-				long long HilbertCnt = size[0] * size[1] * size[2];
-				int nbOfBitsPerDim[DIM];
-				for (int i = 0; i < DIM; ++i)
-				{
-					nbOfBitsPerDim[i] = std::ceil(std::sqrt((size[i] - 1)));
-				}
-
-				#pragma omp parallel for
-				for (long long h = 0; h < HilbertCnt; ++h)
+				CFixBitVec coordPtr[DIM];
+				CFixBitVec compHilbertIdx;
+				compHilbertIdx = (FBV_UINT)h;
+				Hilbert::compactIndexToCoords(coordPtr,
+					nbOfBitsPerDim, DIM, compHilbertIdx);
+				for (int i = 0; i < DIM; i++)
 				{
-					CFixBitVec *coordPtr = new CFixBitVec[DIM];
-					CFixBitVec compHilbertIdx;
-					compHilbertIdx = (FBV_UINT)h;
-					Hilbert::compactIndexToCoords(coordPtr,
-						nbOfBitsPerDim, DIM, compHilbertIdx);
-
-
-					#pragma omp critical
-					{
-						for (int i = 0; i < DIM; i++)
-						{
-							coord[i] = static_cast<unsigned int>(coordPtr[i].rack());
-						}
-
-						delete[] coordPtr;
-						coordList.append(coord);
-						if (coordList.size() % 64 == 0)
-						{
-							imp.emitProgress(coordList.size() * 100.0 / HilbertCnt);
-						}
-					}
+					coordList[h][i] = static_cast<unsigned int>(coordPtr[i].rack());
 				}
 			}
+			imp.emitProgress(chunkEnd * 100.0 / voxelCnt);
+		}
+	}
 
-			for (int h = 0; h < coordList.size(); ++h)
+	// linearize the image along the path and build the segment tree in one pass over bricks
+	// of the path; each brick is entered into the tree right after its intensities are read:
+	intensityList.resize(voxelCnt);
+	icData* intensities = intensityList.data();
+	auto segmentTree = new iASegmentTree(voxelCnt, subHistBinCnt, SubHistLowerBound, SubHistUpperBound);
+	const qint64 brickCnt = static_cast<qint64>(segmentTree->brickCount());
+	const qint64 brickSize = static_cast<qint64>(segmentTree->brickSize());
+#pragma omp parallel for schedule(dynamic, 16)
+	for (qint64 b = 0; b < brickCnt; ++b)
+	{
+		const qint64 brickEnd = std::min((b + 1) * brickSize, voxelCnt);
+		for (qint64 h = b * brickSize; h < brickEnd; ++h)
+		{
+			typename InputImageType::IndexType c;
+			if (m_pathID == P_HILBERT)
 			{
-				typename InputImageType::IndexType c;
 				for (int i = 0; i < DIM; i++)
 				{
 					c[i] = coordList[h][i];
 				}
-				icData data(input->GetPixel(c), c);
-				intensityList.append(data);
 			}
-		}
-		break;
-
-		case P_SCAN_LINE:
-		{
-			itk::ImageRegionIteratorWithIndex<InputImageType> imageIterator(
-				input, input->GetLargestPossibleRegion());
-			for (imageIterator.GoToBegin(); !imageIterator.IsAtEnd(); ++imageIterator)
+			else    // P_SCAN_LINE: x varies fastest, then y, then z
 			{
-				auto coord = imageIterator.GetIndex();
-				icData data(input->GetPixel(coord), coord);
-				intensityList.append(data);
+				c[0] = h % size[0];
+				c[1] = (h / size[0]) % size[1];
+				c[2] = h / (size[0] * size[1]);
 			}
+			intensities[h] = icData(input->GetPixel(c), c);
 		}
-		break;
+		segmentTree->setBrick(b, [intensities](size_t h) { return intensities[h].intensity; });
 	}
+	segmentTree->buildInnerNodes();
+	segmTreeList.append(segmentTree);
 	itkToVTKConverter->ReleaseDataFlagOn();
 }
 
 iAIntensityMapper::iAIntensityMapper(iAProgress &iMProgress, QDir datasetsDir, PathID pathID, QList<QPair<QString,
 	QList<icData>>> &datasetIntensityMap, QList<vtkSmartPointer<vtkImageData>> &imgDataList,
-	double &minEnsembleIntensity, double &maxEnsembleIntensity) :
+	double &minEnsembleIntensity, double &maxEnsembleIntensity, QList<iASegmentTree*> &segmTreeList, int subHistBinCnt) :
 	m_iMProgress(iMProgress),
 	m_datasetsDir(datasetsDir),
 	m_pathID(pathID),
 	m_DatasetIntensityMap(datasetIntensityMap),
 	m_imgDataList(imgDataList),
 	m_minEnsembleIntensity(minEnsembleIntensity),
-	m_maxEnsembleIntensity(maxEnsembleIntensity)
+	m_maxEnsembleIntensity(maxEnsembleIntensity),
+	m_segmTreeList(segmTreeList),
+	m_subHistBinCnt(subHistBinCnt)
 {}
 
 iAIntensityMapper::~iAIntensityMapper()
@@ -120,7 +128,7 @@ void iAIntensityMapper::process()
 	QStringList datasetsList = m_datasetsDir.entryList();
 	QList<double> minEnsembleIntensityList;
 	QList<double> maxEnsembleIntensityList;
-	QList<QVector<unsigned int>> coordList;
+	std::vector<std::array<unsigned int, DIM>> coordList;
 	for (int i = 0; i < datasetsList.size(); ++i)
 	{
 		QList<icData> intensityList;
@@ -131,7 +139,7 @@ void iAIntensityMapper::process()
 		auto image = iAITKIO::readFile(dataset, pixelType, scalarType, true);
 		assert(pixelType == iAITKIO::PixelType::SCALAR);
 		ITK_TYPED_CALL(getIntensities, scalarType,  m_iMProgress, m_pathID, image, intensityList,
-			m_imgDataList, minEnsembleIntensityList, maxEnsembleIntensityList, coordList);
+			m_imgDataList, minEnsembleIntensityList, maxEnsembleIntensityList, coordList, m_segmTreeList, m_subHistBinCnt);
 		m_DatasetIntensityMap.push_back(qMakePair(datasetsList.at(i), intensityList));
 	}
 	m_minEnsembleIntensity = *std::min_element(
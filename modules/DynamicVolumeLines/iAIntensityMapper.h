@@ -10,7 +10,8 @@ class iAIntensityMapper : public QObject
 
 public:
 	iAIntensityMapper(iAProgress &iMProgress, QDir datasetsDir, PathID pathID, QList<QPair<QString, QList<icData>>> &datasetIntensityMap,
-		QList<vtkSmartPointer<vtkImageData>> &m_imgDataList, double &minEnsembleIntensity, double &maxEnsembleIntensity);
+		QList<vtkSmartPointer<vtkImageData>> &m_imgDataList, double &minEnsembleIntensity, double &maxEnsembleIntensity,
+		QList<iASegmentTree*> &segmTreeList, int subHistBinCnt);
 	~iAIntensityMapper();
 
 public slots:
@@ -27,4 +28,6 @@ private:
 	QList<QPair<QString, QList<icData>>> &m_DatasetIntensityMap;
 	QList<vtkSmartPointer<vtkImageData>> &m_imgDataList;
 	double &m_minEnsembleIntensity, &m_maxEnsembleIntensity;
+	QList<iASegmentTree*> &m_segmTreeList;
+	int m_subHistBinCnt;
 };
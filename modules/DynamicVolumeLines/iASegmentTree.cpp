@@ -2,154 +2,110 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iASegmentTree.h"
 
-#include <iAMathUtility.h>
-
-#include <itkImage.h>
-#include <itkImportImageFilter.h>
-#include <itkImageToHistogramFilter.h>
-
-#include <iterator>
+#include <cassert>
 
 // Resource: http://codeforces.com/blog/entry/18051
 
-iASegmentTree::iASegmentTree(const std::vector<int> &input, int binCnt, int lowerBnd, int upperBnd) :
-	m_inputElemCnt(0)
+iASegmentTree::iASegmentTree(size_t elemCnt, int binCnt, int lowerBnd, int upperBnd) :
+	m_inputElemCnt(elemCnt),
+	m_binCnt(binCnt),
+	m_lowerBnd(lowerBnd),
+	m_upperBnd(upperBnd),
+	// a brick holds a multiple of the bins per node, so that the node histograms
+	// take at most about as much memory as the bins of the elements:
+	m_brickSize(std::max(static_cast<size_t>(64), 4 * static_cast<size_t>(binCnt))),
+	m_brickCnt((elemCnt + m_brickSize - 1) / m_brickSize),
+	m_leafOffset(1),
+	m_bins(elemCnt)
 {
-	//NOTE: Currently only hist is needed, others can be disabled
-	m_inputElemCnt = static_cast<int>(input.size());
-	/*m_avg.resize(2 * m_inputElemCnt);
-	m_min.resize(2 * m_inputElemCnt);
-	m_max.resize(2 * m_inputElemCnt);*/
-	m_hist.resize(2 * m_inputElemCnt);
-
-	for (int i = 0; i < m_inputElemCnt; ++i)
+	assert(binCnt > 0 && binCnt <= 65536);
+	// use a power of two as number of leaves, so that each tree level is a contiguous part of the array:
+	while (m_leafOffset < m_brickCnt)
 	{
-		/*m_avg[m_inputElemCnt + i] = input[i];
-		m_min[m_inputElemCnt + i] = input[i];
-		m_max[m_inputElemCnt + i] = input[i];*/
-		std::vector<int> v(binCnt);
-		std::fill(v.begin(), v.end(), 0);
-		v[clamp(0, binCnt - 1, mapValue(lowerBnd, upperBnd, 0, binCnt, input[i]))]++;
-		m_hist[m_inputElemCnt + i] = v;
+		m_leafOffset <<= 1;
 	}
-
-	hist_build();
-	/*sum_build();
-	min_build();
-	max_build();*/
+	m_hist.resize(2 * m_leafOffset * m_binCnt, 0);
 }
 
-iASegmentTree::~iASegmentTree()
+size_t iASegmentTree::elemCount() const
 {
+	return m_inputElemCnt;
 }
 
-void iASegmentTree::hist_build()
+size_t iASegmentTree::brickCount() const
 {
-	for (int i = m_inputElemCnt - 1; i > 0; --i)
-	{
-		std::transform(m_hist[i << 1].begin(), m_hist[i << 1].end(), m_hist[i << 1 | 1].begin(),
-			std::back_inserter(m_hist[i]), std::plus<int>());
-	}
+	return m_brickCnt;
 }
 
-void iASegmentTree::sum_build()
+size_t iASegmentTree::brickSize() const
 {
-	for (int i = m_inputElemCnt - 1; i > 0; --i)
-	{
-		m_avg[i] = m_avg[i << 1] + m_avg[i << 1 | 1];
-	}
+	return m_brickSize;
 }
 
-void iASegmentTree::min_build()
+void iASegmentTree::buildInnerNodes()
 {
-	for (int i = m_inputElemCnt - 1; i > 0; --i)
+	for (size_t levelStart = m_leafOffset / 2; levelStart > 0; levelStart /= 2)
 	{
-		m_min[i] = std::min(m_min[i << 1], m_min[i << 1 | 1]);
+#pragma omp parallel for if (levelStart * m_binCnt > 4096)
+		for (qint64 i = levelStart; i < static_cast<qint64>(2 * levelStart); ++i)
+		{
+			int* node = m_hist.data() + i * m_binCnt;
+			int const* left = m_hist.data() + (2 * i) * m_binCnt;
+			int const* right = left + m_binCnt;
+			for (int b = 0; b < m_binCnt; ++b)
+			{
+				node[b] = left[b] + right[b];
+			}
+		}
 	}
 }
 
-void iASegmentTree::max_build()
+void iASegmentTree::addElements(size_t first, size_t last, int* hist) const
 {
-	for (int i = m_inputElemCnt - 1; i > 0; --i)
+	for (size_t i = first; i < last; ++i)
 	{
-		m_max[i] = std::max(m_max[i << 1], m_max[i << 1 | 1]);
+		++hist[m_bins[i]];
 	}
 }
 
-std::vector<int> iASegmentTree::hist_query(int l, int r)
+void iASegmentTree::addNode(size_t node, int* hist) const
 {
-	std::vector<int> histVec(m_hist.back().size());
-	std::fill(histVec.begin(), histVec.end(), 0);
-	for (l += m_inputElemCnt, r += m_inputElemCnt; l < r; l >>= 1, r >>= 1)
+	int const* nodeHist = m_hist.data() + node * m_binCnt;
+	for (int b = 0; b < m_binCnt; ++b)
 	{
-		if (l & 1)
-		{
-			std::vector<int> a; std::vector<int> b; std::vector<int> c;
-			a = m_hist[l++];
-			b = histVec;
-			std::transform(a.begin(), a.end(), b.begin(), std::back_inserter(c), std::plus<int>());
-			histVec = c;
-		}
-		if (r & 1)
-		{
-			std::vector<int> a; std::vector<int> b; std::vector<int> c;
-			a = m_hist[--r];
-			b = histVec;
-			std::transform(a.begin(), a.end(), b.begin(), std::back_inserter(c), std::plus<int>());
-			histVec = c;
-		}
+		hist[b] += nodeHist[b];
 	}
-	return histVec;
 }
 
-double iASegmentTree::avg_query(int l, int r)
+std::vector<int> iASegmentTree::hist_query(int l, int r) const
 {
-	double avgVal = 0;
-	int left = l, right = r, nbCnt = right - left;
-	for (l += m_inputElemCnt, r += m_inputElemCnt; l < r; l >>= 1, r >>= 1)
+	std::vector<int> histVec(m_binCnt, 0);
+	size_t first = static_cast<size_t>(std::max(l, 0));
+	size_t last = std::min(static_cast<size_t>(std::max(r, 0)), m_inputElemCnt);
+	if (first >= last)
 	{
-		if (l & 1)
-		{
-			avgVal += m_avg[l++];
-		}
-		if (r & 1)
-		{
-			avgVal += m_avg[--r];
-		}
+		return histVec;
 	}
-	return avgVal / nbCnt;
-}
-
-int iASegmentTree::min_query(int l, int r)
-{
-	int minVal = INT_MAX;
-	for (l += m_inputElemCnt, r += m_inputElemCnt; l < r; l >>= 1, r >>= 1)
+	// bricks fully contained in [first, last):
+	size_t firstBrick = (first + m_brickSize - 1) / m_brickSize;
+	size_t lastBrick = last / m_brickSize;
+	if (firstBrick >= lastBrick)
 	{
-		if (l & 1)
-		{
-			minVal = std::min(minVal, m_min[l++]);
-		}
-		if (r & 1)
-		{
-			minVal = std::min(m_min[--r], minVal);
-		}
+		addElements(first, last, histVec.data());
+		return histVec;
 	}
-	return minVal;
-}
-
-int iASegmentTree::max_query(int l, int r)
-{
-	int maxVal = INT_MIN;
-	for (l += m_inputElemCnt, r += m_inputElemCnt; l < r; l >>= 1, r >>= 1)
+	addElements(first, firstBrick * m_brickSize, histVec.data());
+	addElements(lastBrick * m_brickSize, last, histVec.data());
+	for (size_t lNode = firstBrick + m_leafOffset, rNode = lastBrick + m_leafOffset; lNode < rNode; lNode >>= 1, rNode >>= 1)
 	{
-		if (l & 1)
+		if (lNode & 1)
 		{
-			maxVal = std::max(maxVal, m_max[l++]);
+			addNode(lNode++, histVec.data());
 		}
-		if (r & 1)
+		if (rNode & 1)
 		{
-			maxVal = std::max(m_max[--r], maxVal);
+			addNode(--rNode, histVec.data());
 		}
 	}
-	return maxVal;
+	return histVec;
 }
@@ -2,30 +2,87 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #pragma once
 
+#include <iAMathUtility.h>
+
+#include <QtGlobal>
+
+#include <algorithm>
 #include <vector>
 
 // Resource: http://codeforces.com/blog/entry/18051
 
+//! Segment tree for querying the histogram of the values in a range of a (linearized) sequence.
+//!
+//! To keep the tree compact, its leaves are bricks of consecutive elements instead of single elements:
+//! for each element only its histogram bin is stored, and histograms are only stored for bricks and
+//! their ancestors, all in one array (the children of node i are nodes 2i and 2i+1, the leaves are
+//! the nodes [leafOffset, 2*leafOffset)). Queries sum up the histograms of the nodes covering
+//! the full bricks in the range, and count the elements of partially covered bricks directly.
+//!
+//! Construction can be done brick by brick (e.g. interleaved with producing the values), see setBrick.
 class iASegmentTree
 {
-//TODO: to unsigned int or other more general type
 public:
-	iASegmentTree(const std::vector<int> &input, int binCnt, int lowerBnd, int upperBnd);
-	~iASegmentTree();
-	std::vector<int> hist_query(int l, int r);
-	double avg_query(int l, int r);
-	int min_query(int l, int r);
-	int max_query(int l, int r);
+	//! create a tree for elemCnt elements; the values of the elements are mapped linearly from
+	//! [lowerBnd, upperBnd] to binCnt histogram bins. The tree is empty until build, or setBrick
+	//! for all bricks followed by buildInnerNodes, are called.
+	iASegmentTree(size_t elemCnt, int binCnt, int lowerBnd, int upperBnd);
+	//! number of elements in the tree
+	size_t elemCount() const;
+	//! number of bricks (leaves of the tree)
+	size_t brickCount() const;
+	//! number of consecutive elements in one brick
+	size_t brickSize() const;
+	//! Set the values of brick brickIdx, i.e. of elements [brickIdx * brickSize(), min((brickIdx+1) * brickSize(), elemCount())),
+	//! with valueAt(elemIdx) returning the value of element elemIdx.
+	//! Different bricks may be set concurrently from multiple threads.
+	template <typename ValueFunc>
+	void setBrick(size_t brickIdx, ValueFunc valueAt);
+	//! Compute the inner nodes, once all bricks are set
+	void buildInnerNodes();
+	//! Set the values of all elements in parallel, and compute the inner nodes
+	template <typename ValueFunc>
+	void build(ValueFunc valueAt);
+	//! histogram of the values of the elements in [l, r)
+	std::vector<int> hist_query(int l, int r) const;
 
 private:
-	int m_inputElemCnt;
-	std::vector<int> m_input;
-	std::vector<std::vector<int>> m_hist;
-	std::vector<double> m_avg;
-	std::vector<int> m_min;
-	std::vector<int> m_max;
-	void hist_build();
-	void sum_build();
-	void min_build();
-	void max_build();
+	int binOf(int value) const;
+	void addElements(size_t first, size_t last, int* hist) const;
+	void addNode(size_t node, int* hist) const;
+
+	size_t m_inputElemCnt;
+	int m_binCnt, m_lowerBnd, m_upperBnd;
+	size_t m_brickSize, m_brickCnt, m_leafOffset;
+	std::vector<quint16> m_bins;  //!< histogram bin of each element
+	std::vector<int> m_hist;      //!< histograms of all nodes, m_binCnt values per node
 };
+
+template <typename ValueFunc>
+void iASegmentTree::setBrick(size_t brickIdx, ValueFunc valueAt)
+{
+	int* hist = m_hist.data() + (m_leafOffset + brickIdx) * m_binCnt;
+	std::fill(hist, hist + m_binCnt, 0);
+	size_t last = std::min((brickIdx + 1) * m_brickSize, m_inputElemCnt);
+	for (size_t i = brickIdx * m_brickSize; i < last; ++i)
+	{
+		m_bins[i] = static_cast<quint16>(binOf(static_cast<int>(valueAt(i))));
+		++hist[m_bins[i]];
+	}
+}
+
+template <typename ValueFunc>
+void iASegmentTree::build(ValueFunc valueAt)
+{
+#pragma omp parallel for schedule(dynamic, 16)
+	for (qint64 b = 0; b < static_cast<qint64>(m_brickCnt); ++b)
+	{
+		setBrick(b, valueAt);
+	}
+	buildInnerNodes();
+}
+
+inline int iASegmentTree::binOf(int value) const
+{
+	return clamp(0, m_binCnt - 1, mapValue(m_lowerBnd, m_upperBnd, 0, m_binCnt, value));
+}
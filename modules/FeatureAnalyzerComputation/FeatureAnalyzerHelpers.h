@@ -378,6 +378,10 @@ struct IParameterInfo
 	virtual float asFloat() const = 0;
 	virtual double asDouble() const = 0;
 	virtual QString asString() const = 0;
+	//! string uniquely identifying the current value (in contrast to asString, without loss of precision)
+	virtual QString keyString() const = 0;
+	//! copy of this parameter, including its current value
+	virtual IParameterInfo * clone() const = 0;
 
 	QString name;
 	int numSamples;
@@ -446,6 +450,14 @@ struct ParameterInfo : public IParameterInfo
 	{
 		return QString::number( val );
 	}
+	inline QString keyString() const override
+	{
+		return QString::number( static_cast<double>( val ), 'g', 17 );
+	}
+	inline IParameterInfo * clone() const override
+	{
+		return new ParameterInfo<T>( *this );
+	}
 };
 
 inline bool incrementParameterSet( QList<IParameterInfo*> & parameters )
@@ -20,6 +20,7 @@
 #include <QScrollArea>
 #include <QSettings>
 #include <QTextEdit>
+#include <QThread>
 #include <QTime>
 
 
@@ -47,6 +48,8 @@ void iAFeatureAnalyzerComputationModuleInterface::Initialize()
 	m_resultsFolder = settings.value( "FeatureAnalyzer/Computation/resultsFolder", "" ).toString();
 	m_datasetsFolder = settings.value( "FeatureAnalyzer/Computation/datasetsFolder", "" ).toString();
 	m_csvFile = settings.value( "FeatureAnalyzer/Computation/csvFile", "" ).toString();
+	m_parallelRuns = settings.value( "FeatureAnalyzer/Computation/parallelRuns", QThread::idealThreadCount() ).toInt();
+	m_cacheSizeMB = settings.value( "FeatureAnalyzer/Computation/cacheSizeMB", 2048 ).toInt();
 
 	//Initialize compute segmentation window
 	m_compSegmWidget = new QDialog(m_mainWnd);
@@ -57,6 +60,8 @@ void iAFeatureAnalyzerComputationModuleInterface::Initialize()
 	uiComputeSegm.computerName->setText( m_computerName );
 	uiComputeSegm.resultsFolder->setText( m_resultsFolder );
 	uiComputeSegm.datasetsFolder->setText( m_datasetsFolder );
+	uiComputeSegm.sbParallelRuns->setValue( m_parallelRuns );
+	uiComputeSegm.sbCacheSize->setValue( m_cacheSizeMB );
 	uiComputeSegm.pBDatasetPreviewProgress->hide();
 	connect( uiComputeSegm.computerName, &QLineEdit::editingFinished, this, &iAFeatureAnalyzerComputationModuleInterface::compNameChanged);
 	connect( uiComputeSegm.tbReload,  &QToolButton::clicked, this, &iAFeatureAnalyzerComputationModuleInterface::loadCSV);
@@ -295,6 +300,8 @@ void iAFeatureAnalyzerComputationModuleInterface::SaveSettings() const
 	settings.setValue( "FeatureAnalyzer/Computation/resultsFolder", m_resultsFolder );
 	settings.setValue( "FeatureAnalyzer/Computation/datasetsFolder", m_datasetsFolder );
 	settings.setValue( "FeatureAnalyzer/Computation/csvFile", m_csvFile );
+	settings.setValue( "FeatureAnalyzer/Computation/parallelRuns", m_parallelRuns );
+	settings.setValue( "FeatureAnalyzer/Computation/cacheSizeMB", m_cacheSizeMB );
 }
 
 void iAFeatureAnalyzerComputationModuleInterface::updateFromGUI() const
@@ -303,6 +310,8 @@ void iAFeatureAnalyzerComputationModuleInterface::updateFromGUI() const
 	m_resultsFolder = uiComputeSegm.resultsFolder->text();
 	m_datasetsFolder = uiComputeSegm.datasetsFolder->text();
 	m_csvFile = uiComputeSegm.csvFilename->text();
+	m_parallelRuns = uiComputeSegm.sbParallelRuns->value();
+	m_cacheSizeMB = uiComputeSegm.sbCacheSize->value();
 }
 
 void iAFeatureAnalyzerComputationModuleInterface::browserResultsFolder()
@@ -329,7 +338,11 @@ void iAFeatureAnalyzerComputationModuleInterface::runCalculations()
 	rbt->Init(this,
 		m_datasetsFolder,
 		uiComputeSegm.rbNewPipelineDataNoPores->isChecked(),
-		uiComputeSegm.rbNewPipelineData->isChecked());
+		uiComputeSegm.rbNewPipelineData->isChecked(),
+		uiComputeSegm.sbParallelRuns->value(),
+		static_cast<size_t>(uiComputeSegm.sbCacheSize->value()) * 1024 * 1024);
+	rbt->setPaused(uiComputeSegm.rbPause->isChecked());
+	connect( uiComputeSegm.rbPause, &QRadioButton::toggled, rbt, &iARunBatchThread::setPaused);
 	rbt->start();
 }
 
@@ -56,6 +56,8 @@ protected:
 	mutable QString m_resultsFolder;
 	mutable QString m_datasetsFolder;
 	mutable QString m_csvFile;
+	mutable int m_parallelRuns;
+	mutable int m_cacheSizeMB;
 	QString m_cpuVendor;
 	QString m_cpuBrand;
 	QAction *removeRowAction;
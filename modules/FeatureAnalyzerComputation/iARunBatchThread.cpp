@@ -84,13 +84,22 @@
 #include <QElapsedTimer>
 #include <QLocale>
 #include <QMessageBox>
+#include <QMutex>
+#include <QThread>
 #include <QTime>
 
 // OpenMP
 #include <omp.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <future>
+#include <map>
+#include <memory>
 #include <numbers>
+#include <numeric>
 
 namespace
 {
@@ -955,102 +964,292 @@ void computeFhwThreshold(iAITKIO::ImagePointer & image, PorosityFilterID /*filte
 		binaryThresholdFilter->ReleaseDataFlagOn();
 }
 
+//! Intermediate results of pipeline runs, i.e. the state of a RunInfo after a number of pipeline stages,
+//! identified by dataset as well as filters and parameters of these stages. Keeps the most recently
+//! used results within a maximum memory size. Thread-safe; if a result is requested that is
+//! currently computed in another thread, it waits for that computation instead of repeating it.
+class iAPipelineResultCache
+{
+public:
+	using ResultPtr = std::shared_ptr<RunInfo const>;
+	explicit iAPipelineResultCache(size_t maxSize) : m_maxSize(maxSize), m_size(0), m_useCounter(0)
+	{}
+	//! the result for the given key if it is cached, nullptr otherwise
+	ResultPtr find(QString const& key)
+	{
+		QMutexLocker locker(&m_mutex);
+		auto it = m_entries.find(key);
+		if (it == m_entries.end() || !it->second.ready)
+		{
+			return nullptr;
+		}
+		it->second.lastUse = ++m_useCounter;
+		return it->second.result.get();
+	}
+	//! the result for the given key; if it is not cached, it is computed via compute (which needs to
+	//! return the result and its memory size), and kept if it fits into the memory budget.
+	//! Exceptions thrown by compute are passed on to all callers waiting for the result.
+	template <typename ComputeFunc>
+	ResultPtr getOrCompute(QString const& key, ComputeFunc compute)
+	{
+		if (m_maxSize == 0)
+		{
+			return compute().first;
+		}
+		std::promise<ResultPtr> promise;
+		{
+			QMutexLocker locker(&m_mutex);
+			auto it = m_entries.find(key);
+			if (it != m_entries.end())
+			{
+				it->second.lastUse = ++m_useCounter;
+				auto result = it->second.result;
+				locker.unlock();
+				return result.get();
+			}
+			m_entries.emplace(key, iAEntry{ promise.get_future().share(), 0, false, ++m_useCounter });
+		}
+		try
+		{
+			auto [result, size] = compute();
+			promise.set_value(result);
+			QMutexLocker locker(&m_mutex);
+			auto it = m_entries.find(key);
+			if (size > m_maxSize)
+			{
+				m_entries.erase(it);
+			}
+			else
+			{
+				it->second.ready = true;
+				it->second.size = size;
+				m_size += size;
+				shrink();
+			}
+			return result;
+		}
+		catch (...)
+		{
+			promise.set_exception(std::current_exception());
+			QMutexLocker locker(&m_mutex);
+			m_entries.erase(key);
+			throw;
+		}
+	}
+private:
+	struct iAEntry
+	{
+		std::shared_future<ResultPtr> result;
+		size_t size;       //!< approximate memory size of the result (0 while it is computed)
+		bool ready;        //!< whether the computation of the result has finished
+		quint64 lastUse;
+	};
+	//! remove least recently used results until the cache fits into the memory budget
+	void shrink()
+	{
+		while (m_size > m_maxSize)
+		{
+			auto lru = m_entries.end();
+			for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+			{
+				if (it->second.ready && (lru == m_entries.end() || it->second.lastUse < lru->second.lastUse))
+				{
+					lru = it;
+				}
+			}
+			m_size -= lru->second.size;
+			m_entries.erase(lru);
+		}
+	}
+	QMutex m_mutex;
+	std::map<QString, iAEntry> m_entries;
+	size_t m_maxSize, m_size;
+	quint64 m_useCounter;
+};
+
+//! approximate memory size of the images of an intermediate result of a pipeline on an image of type T
 template<class T>
-void runBatch( const QList<PorosityFilterID> & filterIds, iAITKIO::ImagePointer & image, RunInfo & results, const QList<IParameterInfo*> & params )
+size_t resultMemorySize(RunInfo const & results)
+{
+	size_t result = 0;
+	for (auto const & img : { results.maskImage, results.surroundingMaskImage })
+	{
+		if (img)
+		{
+			result += img->GetLargestPossibleRegion().GetNumberOfPixels() *
+				(dynamic_cast<MaskImageType const*>(img.GetPointer()) ? sizeof(MaskImageType::PixelType) : sizeof(T));
+		}
+	}
+	return result;
+}
+
+//! detach the images of an intermediate result from the filters that produced them
+static void disconnectPipeline(RunInfo & results)
+{
+	for (auto img : { results.maskImage, results.surroundingMaskImage })
+	{
+		if (img)
+		{
+			img->DisconnectPipeline();
+		}
+	}
+}
+
+//! run a single stage of a pipeline, with parameters starting at index pind in params
+template<class T>
+void runStage( PorosityFilterID fid, iAITKIO::ImagePointer & image, iAITKIO::ImagePointer curImage, RunInfo & results,
+	const QList<IParameterInfo*> & params, int pind, bool releaseData )
+{
+	QElapsedTimer t;
+	t.start();
+	switch( fid )
+	{
+		case P_BINARY_THRESHOLD:
+			computeThreshold<T>( curImage, results, 0, params[pind]->asFloat(), releaseData );
+			break;
+		case P_GENERAL_THRESHOLD:
+			computeThreshold<T>(curImage, results, params[pind]->asFloat(), params[pind + 1]->asFloat(), releaseData);
+			break;
+		case P_RATS_THRESHOLD:
+			computeRatsThreshold<T>( curImage, results, params[pind]->asFloat(), releaseData );
+			break;
+		case P_MORPH_WATERSHED_MEYER:
+			computeMorphWatershed<T>( curImage, results, params[pind]->asFloat(), params[pind + 1]->asInt(), true, releaseData );
+			break;
+		case P_MORPH_WATERSHED_BEUCHER:
+			computeMorphWatershed<T>( curImage, results, params[pind]->asFloat(), params[pind + 1]->asInt(), false, releaseData );
+			break;
+		case P_OTSU_THRESHOLD:
+		case P_ISODATA_THRESHOLD:
+		case P_MAXENTROPY_THRESHOLD:
+		case P_MOMENTS_THRESHOLD:
+		case P_YEN_THRESHOLD:
+		case P_RENYI_THRESHOLD:
+		case P_SHANBHAG_THRESHOLD:
+		case P_INTERMODES_THRESHOLD:
+		case P_HUANG_THRESHOLD:
+		case P_LI_THRESHOLD:
+		case P_KITTLERILLINGWORTH_THRESHOLD:
+		case P_TRIANGLE_THRESHOLD:
+		case P_MINIMUM_THRESHOLD:
+			computeParamFree<T>( curImage, fid, results, releaseData );
+			break;
+		case P_CONNECTED_THRESHOLD:
+			computeConnThr<T>( image, curImage, results, params[pind]->asInt(), params[pind + 1]->asInt(), releaseData );
+			break;
+		case P_CONFIDENCE_CONNECTED:
+			computeConfiConn<T>( image, curImage, results, params[pind]->asInt(), params[pind + 1]->asFloat(), params[pind + 2]->asInt(), releaseData );
+			break;
+		case P_NEIGHBORHOOD_CONNECTED:
+			computeNeighbConn<T>( image, curImage, results, params[pind]->asInt(), params[pind + 1]->asInt(), params[pind + 2]->asInt(), releaseData );
+			break;
+		case P_MULTIPLE_OTSU:
+			computeMultiOtsu<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asInt(), releaseData );
+			break;
+		case P_REMOVE_SURROUNDING:
+			computeRemoveSurrounding<T>( curImage, fid, results, releaseData );
+			break;
+		case P_GRAD_ANISO_DIFF_SMOOTH:
+			computeGradAnisoDiffSmooth<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asFloat(), params[pind + 2]->asFloat(), releaseData );
+			break;
+		case P_CURV_ANISO_DIFF_SMOOTH:
+			computeCurvAnisoDiffSmooth<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asFloat(), params[pind + 2]->asFloat(), releaseData );
+			break;
+		case P_RECURSIVE_GAUSS_SMOOTH:
+			computeRecursiveGaussSmooth<T>( curImage, fid, results, params[pind]->asFloat(), releaseData );
+			break;
+		case P_BILATERAL_SMOOTH:
+			computeBilateralSmooth<T>( curImage, fid, results, params[pind]->asFloat(), params[pind + 1]->asFloat(), releaseData );
+			break;
+		case P_CURV_FLOW_SMOOTH:
+			computeCurvFlowSmooth<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asFloat(), releaseData );
+			break;
+		case P_MEDIAN_SMOOTH:
+			computeMedianSmooth<T>( curImage, fid, results, params[pind]->asInt(), releaseData );
+			break;
+		case P_ISOX_THRESHOLD:
+			computeIsoXThreshold<T>( curImage, fid, results, params[pind]->asInt(), releaseData );
+			break;
+		case P_FHW_THRESHOLD:
+			computeFhwThreshold<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asInt(), releaseData );
+			break;
+		case P_CREATE_SURROUNDING:
+			computeCreateSurrounding<T>( curImage, fid, results, params[pind]->asFloat(), releaseData );
+			break;
+	}
+	results.elapsedTime += t.elapsed();
+}
+
+//! Run the given pipeline on image. The intermediate results of all but the last stage are taken
+//! from / stored in the cache; the elapsed time reported in results includes the (original)
+//! computation time of reused stages, i.e. it is the time the full pipeline takes.
+template<class T>
+void runBatch( const QList<PorosityFilterID> & filterIds, iAITKIO::ImagePointer & image, RunInfo & results, const QList<IParameterInfo*> & params,
+	iAPipelineResultCache & cache, QString const & datasetName )
 {
-	iAITKIO::ImagePointer curImage = image;
 	results.startTime = QLocale().toString( QDateTime::currentDateTime(), QLocale::ShortFormat );
+	// keys identifying the intermediate results after each stage:
+	QStringList keys;
+	QList<int> paramOffsets;
+	QString key = datasetName;
 	int pind = 0;
 	for (PorosityFilterID fid: filterIds)
 	{
-		QElapsedTimer t;
-		t.start();
-		bool releaseData = (fid != filterIds.last());
-		switch( fid )
+		key += "|" + filterNames.at(fid);
+		for (int i = 0; i < FilterIdToParamList[fid].size(); ++i)
 		{
-			case P_BINARY_THRESHOLD:
-				computeThreshold<T>( curImage, results, 0, params[pind]->asFloat(), releaseData );
-				break;
-			case P_GENERAL_THRESHOLD:
-				computeThreshold<T>(curImage, results, params[pind]->asFloat(), params[pind + 1]->asFloat(), releaseData);
-				break;
-			case P_RATS_THRESHOLD:
-				computeRatsThreshold<T>( curImage, results, params[pind]->asFloat(), releaseData );
-				break;
-			case P_MORPH_WATERSHED_MEYER:
-				computeMorphWatershed<T>( curImage, results, params[pind]->asFloat(), params[pind + 1]->asInt(), true, releaseData );
-				break;
-			case P_MORPH_WATERSHED_BEUCHER:
-				computeMorphWatershed<T>( curImage, results, params[pind]->asFloat(), params[pind + 1]->asInt(), false, releaseData );
-				break;
-			case P_OTSU_THRESHOLD:
-			case P_ISODATA_THRESHOLD:
-			case P_MAXENTROPY_THRESHOLD:
-			case P_MOMENTS_THRESHOLD:
-			case P_YEN_THRESHOLD:
-			case P_RENYI_THRESHOLD:
-			case P_SHANBHAG_THRESHOLD:
-			case P_INTERMODES_THRESHOLD:
-			case P_HUANG_THRESHOLD:
-			case P_LI_THRESHOLD:
-			case P_KITTLERILLINGWORTH_THRESHOLD:
-			case P_TRIANGLE_THRESHOLD:
-			case P_MINIMUM_THRESHOLD:
-				computeParamFree<T>( curImage, fid, results, releaseData );
-				break;
-			case P_CONNECTED_THRESHOLD:
-				computeConnThr<T>( image, curImage, results, params[pind]->asInt(), params[pind + 1]->asInt(), releaseData );
-				break;
-			case P_CONFIDENCE_CONNECTED:
-				computeConfiConn<T>( image, curImage, results, params[pind]->asInt(), params[pind + 1]->asFloat(), params[pind + 2]->asInt(), releaseData );
-				break;
-			case P_NEIGHBORHOOD_CONNECTED:
-				computeNeighbConn<T>( image, curImage, results, params[pind]->asInt(), params[pind + 1]->asInt(), params[pind + 2]->asInt(), releaseData );
-				break;
-			case P_MULTIPLE_OTSU:
-				computeMultiOtsu<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asInt(), releaseData );
-				break;
-			case P_REMOVE_SURROUNDING:
-				computeRemoveSurrounding<T>( curImage, fid, results, releaseData );
-				break;
-			case P_GRAD_ANISO_DIFF_SMOOTH:
-				computeGradAnisoDiffSmooth<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asFloat(), params[pind + 2]->asFloat(), releaseData );
-				break;
-			case P_CURV_ANISO_DIFF_SMOOTH:
-				computeCurvAnisoDiffSmooth<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asFloat(), params[pind + 2]->asFloat(), releaseData );
-				break;
-			case P_RECURSIVE_GAUSS_SMOOTH:
-				computeRecursiveGaussSmooth<T>( curImage, fid, results, params[pind]->asFloat(), releaseData );
-				break;
-			case P_BILATERAL_SMOOTH:
-				computeBilateralSmooth<T>( curImage, fid, results, params[pind]->asFloat(), params[pind + 1]->asFloat(), releaseData );
-				break;
-			case P_CURV_FLOW_SMOOTH:
-				computeCurvFlowSmooth<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asFloat(), releaseData );
-				break;
-			case P_MEDIAN_SMOOTH:
-				computeMedianSmooth<T>( curImage, fid, results, params[pind]->asInt(), releaseData );
-				break;
-			case P_ISOX_THRESHOLD:
-				computeIsoXThreshold<T>( curImage, fid, results, params[pind]->asInt(), releaseData );
-				break;
-			case P_FHW_THRESHOLD:
-				computeFhwThreshold<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asInt(), releaseData );
-				break;
-			case P_CREATE_SURROUNDING:
-				computeCreateSurrounding<T>( curImage, fid, results, params[pind]->asFloat(), releaseData );
-				break;
+			key += " " + params[pind + i]->keyString();
 		}
-		results.elapsedTime += t.elapsed();
-		curImage = results.maskImage;
+		keys << key;
+		paramOffsets << pind;
 		pind += FilterIdToParamList[fid].size();
 	}
+	// state modified by the stages; continue from the longest pipeline prefix computed before:
+	RunInfo stageResults;
+	const qsizetype last = filterIds.size() - 1;
+	qsizetype start = 0;
+	for (qsizetype s = last - 1; s >= 0; --s)
+	{
+		if (auto cached = cache.find(keys[s]))
+		{
+			stageResults = *cached;
+			start = s + 1;
+			break;
+		}
+	}
+	for (qsizetype s = start; s <= last; ++s)
+	{
+		auto curImage = (s == 0) ? image : stageResults.maskImage;
+		if (s == last)
+		{
+			runStage<T>( filterIds[s], image, curImage, stageResults, params, paramOffsets[s], false );
+			break;
+		}
+		stageResults = *cache.getOrCompute(keys[s], [&]()
+		{
+			auto stageResult = std::make_shared<RunInfo>(stageResults);
+			// cached results are used by other (concurrently computed) samples, so their data must not be
+			// released after the first use, and an update of them must not re-run the pipeline producing them:
+			runStage<T>( filterIds[s], image, curImage, *stageResult, params, paramOffsets[s], false );
+			disconnectPipeline( *stageResult );
+			return std::make_pair(iAPipelineResultCache::ResultPtr(stageResult), resultMemorySize<T>(*stageResult));
+		});
+	}
+	results.maskImage = stageResults.maskImage;
+	results.surroundingMaskImage = stageResults.surroundingMaskImage;
+	results.threshold = stageResults.threshold;
+	results.surroundingVoxels = stageResults.surroundingVoxels;
+	results.elapsedTime += stageResults.elapsedTime;
+	results.parameters << stageResults.parameters;
+	results.parameterNames << stageResults.parameterNames;
 }
 
 void iARunBatchThread::Init(iAFeatureAnalyzerComputationModuleInterface * pmi, QString datasetFolder,
-	bool rbNewPipelineDataNoPores, bool rbNewPipelineData)
+	bool rbNewPipelineDataNoPores, bool rbNewPipelineData, int parallelRuns, size_t cacheSize)
 {
 	m_pmi = pmi;
+	m_parallelRuns = std::max(1, parallelRuns);
+	m_cacheSize = cacheSize;
 	m_datasetsDescrFile = datasetFolder + "/" + "DatasetDescription.csv";
 	m_rbNewPipelineDataNoPores = rbNewPipelineDataNoPores;
 	m_rbNewPipelineData = rbNewPipelineData;
@@ -1063,6 +1262,11 @@ void iARunBatchThread::Init(iAFeatureAnalyzerComputationModuleInterface * pmi, Q
 		m_datasetGTs[m_dsDescr.item( i, gtDatasetColInd )->text()] = m_dsDescr.item( i, gtGTSegmColumnIndex )->text();
 }
 
+void iARunBatchThread::setPaused(bool paused)
+{
+	m_paused = paused;
+}
+
 void iARunBatchThread::executeNewBatches( QTableWidget & settingsCSV, QMap<int, bool> & isBatchNew )
 {
 	if ( m_rbNewPipelineDataNoPores || m_rbNewPipelineData )
@@ -1126,33 +1330,35 @@ void iARunBatchThread::initRunsCSVFile( QTableWidget & runsCSV, QString batchDir
 	iACSVToQTableWidgetConverter::saveToCSVFile( runsCSV, runsCSVFile.fileName() );
 }
 
-void iARunBatchThread::saveResultsToRunsCSV( RunInfo & results, QString masksDir, QTableWidget & runsCSV, bool success /*= true */ )
+void iARunBatchThread::saveResultsToRunsCSV( RunInfo & results, QString masksDir, QTableWidget & runsCSV, int row, bool success /*= true */ )
 {
-	int lastRow = runsCSV.rowCount(), col = 0;
-	runsCSV.insertRow( lastRow );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( results.startTime ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.elapsedTime ) ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.porosity ) ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.threshold ) ) );
-	QString maskName = "mask" + QString::number( lastRow ) + ".mhd";
+	QString maskName = "mask" + QString::number( row ) + ".mhd";
 	QString maskFilename = "";
 	if ( success )
 		maskFilename = masksDir + "/" + maskName;
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( maskName ) );
-	//dice metric
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.falsePositiveRate ) ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.falseNegativeRate ) ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.dice ) ) );
-	//avg feature chars
-	runsCSV.setItem(lastRow, col++, new QTableWidgetItem(QString::number(results.featureCnt)));
-	runsCSV.setItem(lastRow, col++, new QTableWidgetItem(QString::number(results.avgFeatureVol)));
-	runsCSV.setItem(lastRow, col++, new QTableWidgetItem(QString::number(results.avgFeaturePhi)));
-	runsCSV.setItem(lastRow, col++, new QTableWidgetItem(QString::number(results.avgFeatureTheta)));
-	runsCSV.setItem(lastRow, col++, new QTableWidgetItem(QString::number(results.avgFeatureRoundness)));
-	runsCSV.setItem(lastRow, col++, new QTableWidgetItem(QString::number(results.avgFeatureLength)));
-	//input params
-	for ( int i = 0; i < results.parameters.size(); ++i )
-		runsCSV.setItem( lastRow, col++, new QTableWidgetItem( results.parameters[i] ) );
+	{
+		QMutexLocker locker( &m_runsCSVMutex );
+		int col = 0;
+		runsCSV.setItem( row, col++, new QTableWidgetItem( results.startTime ) );
+		runsCSV.setItem( row, col++, new QTableWidgetItem( QString::number( results.elapsedTime ) ) );
+		runsCSV.setItem( row, col++, new QTableWidgetItem( QString::number( results.porosity ) ) );
+		runsCSV.setItem( row, col++, new QTableWidgetItem( QString::number( results.threshold ) ) );
+		runsCSV.setItem( row, col++, new QTableWidgetItem( maskName ) );
+		//dice metric
+		runsCSV.setItem( row, col++, new QTableWidgetItem( QString::number( results.falsePositiveRate ) ) );
+		runsCSV.setItem( row, col++, new QTableWidgetItem( QString::number( results.falseNegativeRate ) ) );
+		runsCSV.setItem( row, col++, new QTableWidgetItem( QString::number( results.dice ) ) );
+		//avg feature chars
+		runsCSV.setItem(row, col++, new QTableWidgetItem(QString::number(results.featureCnt)));
+		runsCSV.setItem(row, col++, new QTableWidgetItem(QString::number(results.avgFeatureVol)));
+		runsCSV.setItem(row, col++, new QTableWidgetItem(QString::number(results.avgFeaturePhi)));
+		runsCSV.setItem(row, col++, new QTableWidgetItem(QString::number(results.avgFeatureTheta)));
+		runsCSV.setItem(row, col++, new QTableWidgetItem(QString::number(results.avgFeatureRoundness)));
+		runsCSV.setItem(row, col++, new QTableWidgetItem(QString::number(results.avgFeatureLength)));
+		//input params
+		for ( int i = 0; i < results.parameters.size(); ++i )
+			runsCSV.setItem( row, col++, new QTableWidgetItem( results.parameters[i] ) );
+	}
 
 	iAITKIO::writeFile( maskFilename, results.maskImage, iAITKIO::ScalarType::CHAR, true );
 
@@ -1199,12 +1405,42 @@ void iARunBatchThread::saveResultsToRunsCSV( RunInfo & results, QString masksDir
 			.arg( err.GetDescription() )
 			.arg( err.GetFile() )
 			.arg( err.GetLine() );
-		m_pmi->log( tolog );
+		log( tolog );
 	}
 	catch ( std::exception const & e )
 	{
-		m_pmi->log( e.what() );
+		log( e.what() );
+	}
+}
+
+void iARunBatchThread::log(QString const & text)
+{
+	QMutexLocker locker(&m_logMutex);
+	m_pmi->log(text);
+}
+
+void iARunBatchThread::loadDataset(QString const & datasetName)
+{
+	if (datasetName == m_datasetName)
+	{
+		return;
+	}
+	iAITKIO::PixelType pixelType;
+	m_image = iAITKIO::readFile( datasetName, pixelType, m_scalarType, true);
+	assert(pixelType == iAITKIO::PixelType::SCALAR);
+	//GT image (make sure it is the same likne MaskImageType (CHAR))
+	m_gtMask = nullptr;
+	QString dsFN = QFileInfo( datasetName ).fileName();
+	QString dsPath = QFileInfo( datasetName ).absolutePath();
+	if( m_datasetGTs[dsFN] != "" )
+	{
+		iAITKIO::ScalarType maskScalarType;
+		iAITKIO::PixelType  maskPixelType;
+		QString gtMaskFile = dsPath + "/" + m_datasetGTs[dsFN];
+		m_gtMask = iAITKIO::readFile( gtMaskFile, maskPixelType, maskScalarType, true);
+		assert(maskPixelType == iAITKIO::PixelType::SCALAR);
 	}
+	m_datasetName = datasetName;
 }
 
 void iARunBatchThread::executeBatch( const QList<PorosityFilterID> & filterIds, QString datasetName, QString batchDir, QTableWidget * settingsCSV, int row )
@@ -1241,42 +1477,68 @@ void iARunBatchThread::executeBatch( const QList<PorosityFilterID> & filterIds,
 			totalNumSamples *= params[i]->numSamples;
 		}
 	}
+	const int numSamples = static_cast<int>(std::ceil(totalNumSamples));
+
+	// determine the parameters of all samples up front, so that they can be computed in any order:
+	std::vector<QList<IParameterInfo*>> samples;
+	std::vector<QStringList> sampleKeys;
+	for (int sampleNo = 0; sampleNo < numSamples; ++sampleNo)
+	{
+		QList<IParameterInfo*> sample;
+		QStringList keys;
+		for (auto p : params)
+		{
+			sample.push_back(p->clone());
+			keys << p->keyString();
+		}
+		samples.push_back(sample);
+		sampleKeys.push_back(keys);
+		if (randSampling)
+		{
+			randomlySampleParameters(params);
+		}
+		else
+		{
+			incrementParameterSet(params);
+		}
+	}
+	qDeleteAll(params);
+	// compute samples with the same parameters for the first pipeline stages (parameters are in
+	// pipeline order) right after each other, so that their intermediate results can be reused:
+	std::vector<int> order(numSamples);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sampleKeys](int a, int b)
+	{
+		return std::lexicographical_compare(sampleKeys[a].begin(), sampleKeys[a].end(), sampleKeys[b].begin(), sampleKeys[b].end());
+	});
 
-	// initialize runsCSV data
+	// initialize runsCSV data; one row per sample, in sample order:
 	m_runsCSV.clear();
 	initRunsCSVFile( m_runsCSV, batchDir, paramsNameType );
+	const int firstRow = m_runsCSV.rowCount();
+	m_runsCSV.setRowCount( firstRow + numSamples );
 	// inintialize input datset
-	iAITKIO::ScalarType scalarType;
-	iAITKIO::PixelType pixelType;
-	auto image = iAITKIO::readFile( datasetName, pixelType, scalarType, true);
-	assert(pixelType == iAITKIO::PixelType::SCALAR);
-	//GT image (make sure it is the same likne MaskImageType (CHAR))
-	iAITKIO::ImagePointer gtMask;
-	QString dsFN = QFileInfo( datasetName ).fileName();
-	QString dsPath = QFileInfo( datasetName ).absolutePath();
-	if( m_datasetGTs[dsFN] != "" )
-	{
-		iAITKIO::ScalarType maskScalarType;
-		iAITKIO::PixelType  maskPixelType;
-		QString gtMaskFile = dsPath + "/" + m_datasetGTs[dsFN];
-		gtMask = iAITKIO::readFile( gtMaskFile, maskPixelType, maskScalarType, true);
-		assert(maskPixelType == iAITKIO::PixelType::SCALAR);
-	}
+	loadDataset( datasetName );
+	const bool hasGT = m_gtMask.IsNotNull();
 	emit batchProgress( 0 );
 
-	for( int sampleNo = 0; sampleNo < totalNumSamples; ++sampleNo ) //iterate over parameters
+	std::atomic<int> finishedSamples(0);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(m_parallelRuns)
+	for (qint64 i = 0; i < numSamples; ++i) //iterate over parameters
 	{
-		while (m_pmi->ui()->rbPause->isChecked())
+		while (m_paused)
 		{
-			QCoreApplication::processEvents();
+			QThread::msleep(100);
 		}
 
+		const int sampleNo = order[i];
+		auto const & sampleParams = samples[sampleNo];
 		RunInfo results;
 		//fill in parameters info
-		for( int i = 0; i < numParams; ++i )
+		for( int p = 0; p < numParams; ++p )
 		{
-			results.parameters.push_back( params[i]->asString() );
-			results.parameterNames << params[i]->name;
+			results.parameters.push_back( sampleParams[p]->asString() );
+			results.parameterNames << sampleParams[p]->name;
 		}
 
 		bool success = true;
@@ -1284,10 +1546,10 @@ void iARunBatchThread::executeBatch( const QList<PorosityFilterID> & filterIds,
 
 		try
 		{
-			ITK_TYPED_CALL(runBatch, scalarType, filterIds, image, results, params);
+			ITK_TYPED_CALL(runBatch, m_scalarType, filterIds, m_image, results, sampleParams, *m_resultCache, datasetName);
 			//calculate porosity
 			MaskImageType * mask = dynamic_cast<MaskImageType*>(results.maskImage.GetPointer());
-			MaskImageType * gtImage = dynamic_cast<MaskImageType*>(gtMask.GetPointer());
+			MaskImageType * gtImage = dynamic_cast<MaskImageType*>(m_gtMask.GetPointer());
 			results.porosity = calcPorosity( mask, results.surroundingVoxels );
 
 			if (m_rbNewPipelineData)
@@ -1297,18 +1559,17 @@ void iARunBatchThread::executeBatch( const QList<PorosityFilterID> & filterIds,
 			}
 
 			//Dice metric, false positve error, false negative error
-			if ( m_datasetGTs[dsFN] != "" )
+			if ( hasGT )
 			{
 				MaskImageType::RegionType reg = mask->GetLargestPossibleRegion();
 				long long size = static_cast<long long>(reg.GetSize()[0]) * reg.GetSize()[1] * reg.GetSize()[2];
 				size_t tp = 0, fn = 0, fp = 0, tn = 0;
-				MaskImageType::PixelType gt, m;
 
 #pragma omp parallel for reduction(+:tp,fn,fp,tn)
-				for (long long i = 0; i < size; ++i )
+				for (long long v = 0; v < size; ++v )
 				{
-					gt = gtImage->GetBufferPointer()[i];
-					m = mask->GetBufferPointer()[i];
+					MaskImageType::PixelType gt = gtImage->GetBufferPointer()[v];
+					MaskImageType::PixelType m = mask->GetBufferPointer()[v];
 					if (gt == 1 && m == 1) tp = tp + 1;
 					if (gt == 1 && m == 0) fn = fn + 1;
 					if (gt == 0 && m == 1) fp = fp + 1;
@@ -1318,43 +1579,42 @@ void iARunBatchThread::executeBatch( const QList<PorosityFilterID> & filterIds,
 				results.falseNegativeRate = static_cast<float>(fn) / (tp + fn);
 				results.falsePositiveRate = static_cast<float>(fp) / (tn + fp);
 				results.dice = 2 * static_cast<float>(tp) / (2 * tp + fp + fn);
-				emit batchProgress( ( sampleNo + 1 ) * 100 / totalNumSamples );
 			}
 		}
 		catch( itk::ExceptionObject &excep )
 		{
-			m_pmi->log( tr( "Filter run terminated unexpectedly." ) );
-			m_pmi->log( tr( "  %1 in File %2, Line %3" ).arg( excep.GetDescription() )
+			log( tr( "Filter run terminated unexpectedly." ) );
+			log( tr( "  %1 in File %2, Line %3" ).arg( excep.GetDescription() )
 				.arg( excep.GetFile() )
 				.arg( excep.GetLine() ) );
 			success = false;
 		}
 		catch( ... )
 		{
-			m_pmi->log( tr( "Filter run terminated unexpectedly with unknown exception." ) );
+			log( tr( "Filter run terminated unexpectedly with unknown exception." ) );
 			success = false;
 		}
 
 		try
 		{
-			saveResultsToRunsCSV( results, masksDir, m_runsCSV, success );
+			saveResultsToRunsCSV( results, masksDir, m_runsCSV, firstRow + sampleNo, success );
 		}
 		catch( itk::ExceptionObject &excep )
 		{
-			m_pmi->log( tr( "Writing the mask terminated unexpectedly." ) );
-			m_pmi->log( tr( "  %1 in File %2, Line %3" ).arg( excep.GetDescription() )
+			log( tr( "Writing the mask terminated unexpectedly." ) );
+			log( tr( "  %1 in File %2, Line %3" ).arg( excep.GetDescription() )
 				.arg( excep.GetFile() )
 				.arg( excep.GetLine() ) );
 		}
-
-		if (randSampling)
-		{
-			randomlySampleParameters(params);
-		}
-		else
+		catch( ... )
 		{
-			incrementParameterSet(params);
+			log( tr( "Writing the mask terminated unexpectedly with unknown exception." ) );
 		}
+		emit batchProgress( ( ++finishedSamples ) * 100 / numSamples );
+	}
+	for (auto & sample : samples)
+	{
+		qDeleteAll(sample);
 	}
 	iACSVToQTableWidgetConverter::saveToCSVFile( m_runsCSV, batchDir + "/runs.csv" );
 }
@@ -1499,7 +1759,13 @@ void iARunBatchThread::run()
 	updateBatchesCSVFiles( m_settingsCSV, isBatchNew );
 
 	m_pmi->log( "Executing new batches" );
+	m_resultCache = std::make_shared<iAPipelineResultCache>(m_cacheSize);
 	executeNewBatches( m_settingsCSV, isBatchNew );
+	// free memory of intermediate results and loaded dataset:
+	m_resultCache.reset();
+	m_datasetName.clear();
+	m_image = nullptr;
+	m_gtMask = nullptr;
 }
 
 void iARunBatchThread::calcFeatureCharsForMask(RunInfo& results, QString currMaskFilePath)
@@ -5,33 +5,50 @@
 #include "FeatureAnalyzerHelpers.h"
 
 #include <QList>
+#include <QMutex>
 #include <QString>
 #include <QTableWidget>
 #include <QThread>
 
+#include <atomic>
+#include <memory>
+
 class iAFeatureAnalyzerComputationModuleInterface;
+class iAPipelineResultCache;
 struct RunInfo;
 
+//! Computes the segmentation pipelines defined in the settings CSV for all parameter samples.
+//! Up to a given number of samples of a batch are computed concurrently; intermediate results
+//! of pipeline stages are kept (within a memory budget) and reused by all samples (also across
+//! batches) with the same dataset and the same filters and parameters up to that stage.
 class iARunBatchThread : public QThread
 {
 	Q_OBJECT
 public:
-	iARunBatchThread( QObject * parent) : QThread( parent ) {};
+	iARunBatchThread( QObject * parent) : QThread( parent ), m_paused( false ) {};
 	void Init(iAFeatureAnalyzerComputationModuleInterface* pmi,
 		QString datasetsDescriptionFile,
 		bool rbNewPipelineDataNoPores,
-		bool rbNewPipelineData);
+		bool rbNewPipelineData,
+		int parallelRuns,
+		size_t cacheSize);
+	//! pause (or resume) the computation of samples; can be called from any thread
+	void setPaused(bool paused);
 protected:
 	void run() override;
 	void executeNewBatches( QTableWidget & settingsCSV, QMap<int, bool> & isBatchNew );
 	void executeBatch( const QList<PorosityFilterID> & filterIds, QString datasetName, QString batchDir, QTableWidget * settingsCSV, int row );
 	void initRunsCSVFile( QTableWidget & runsCSV, QString batchDir, const QList<ParamNameType> & paramNames );
-	void saveResultsToRunsCSV( RunInfo & results, QString masksDir, QTableWidget & runsCSV, bool success = true );
+	void saveResultsToRunsCSV( RunInfo & results, QString masksDir, QTableWidget & runsCSV, int row, bool success = true );
 	void updateComputerCSVFile( QTableWidget & settingsCSV );
 	void updateBatchesCSVFiles( QTableWidget & settingsCSV, QMap<int, bool> & isBatchNew );
 	bool updateBatchesCSVFile( QTableWidget & settingsCSV, int row, QString batchesFile );
 	void generateMasksCSVFile( QString batchDir, QString batchesDir );
 	void calcFeatureCharsForMask(RunInfo &results, QString currMaskFilePath);
+	//! thread-safe logging (executeBatch computes samples concurrently)
+	void log(QString const & text);
+	//! load the given dataset and its ground truth (if any), unless it is the same as in the previous batch
+	void loadDataset(QString const & datasetName);
 
 	iAFeatureAnalyzerComputationModuleInterface* m_pmi;
 	QTableWidget m_runsCSV;
@@ -44,6 +61,16 @@ protected:
 	QString m_datasetsDescrFile;
 	bool m_rbNewPipelineDataNoPores;
 	bool m_rbNewPipelineData;
+	int m_parallelRuns;
+	size_t m_cacheSize;
+	std::shared_ptr<iAPipelineResultCache> m_resultCache;
+	QMutex m_runsCSVMutex, m_logMutex;
+	//! the dataset of the last batch
+	QString m_datasetName;
+	iAITKIO::ImagePointer m_image, m_gtMask;
+	iAITKIO::ScalarType m_scalarType;
+	//! whether computation is paused; set from the GUI thread, read by the threads computing samples
+	std::atomic<bool> m_paused;
 signals:
 	void batchProgress( int progress );
 	void totalProgress( int progress );
@@ -26,76 +26,70 @@ IAFILTER_DEFAULT_CLASS(iACalcFeatureCharacteristics);
 
 #include <vtkImageData.h>
 
+#include <omp.h>
+
+#include <atomic>
+#include <charconv>
+#include <fstream>
 #include <numbers>
+#include <type_traits>
 
-template<class T> void calcFeatureCharacteristics(iAFilter* filter, itk::ImageBase<3>* itkImg,
-	QString pathCSV, bool feretDiameter, bool calculateAdvancedChars, bool calculateRoundness, bool computeAverages)
+namespace
 {
-	// Cast image to type long
-	typedef itk::Image< T, DIM > InputImageType;
-	typedef itk::Image<long, DIM> LongImageType;
-	typename InputImageType::Pointer inputImage = dynamic_cast<InputImageType *>(itkImg);
-	auto castfilter = itk::CastImageFilter<InputImageType, LongImageType>::New();
-	castfilter->SetInput( inputImage );
-	castfilter->Update();
-	typename LongImageType::Pointer longImage = castfilter->GetOutput();
+	const QString OutputFormatCSV("CSV");
+	const QString OutputFormatBinary("Binary columnar");
+	const char BinaryMagic[8] = { 'i', 'A', 'C', 'O', 'L', 'S', '0', '1' };
 
-	filter->progress()->setStatus("Computing feature maps");
-	typedef unsigned long LabelType;
-	typedef itk::ShapeLabelObject<LabelType, DIM>	ShapeLabelObjectType;
-	typedef itk::LabelMap<ShapeLabelObjectType>	LabelMapType;
-	typedef itk::LabelImageToShapeLabelMapFilter<LongImageType, LabelMapType> I2LType;
-	typename I2LType::Pointer i2l = I2LType::New();
-	i2l->SetInput( longImage );
-	i2l->SetComputePerimeter(calculateAdvancedChars);
-	i2l->SetComputeFeretDiameter(feretDiameter);
-	i2l->SetComputeOrientedBoundingBox(true);
-	filter->progress()->observe(i2l);
-	i2l->Update();
+	//! names of the columns of the characteristics table
+	QStringList characteristicsColumns(bool calculateAdvancedChars)
+	{
+		QStringList result = QStringList() << "Label Id"
+			<< "X1" << "Y1" << "Z1"
+			<< "X2" << "Y2" << "Z2"
+			<< "a11" << "a22" << "a33" << "a12" << "a13" << "a23"
+			<< "DimX" << "DimY" << "DimZ"
+			<< "phi" << "theta"
+			<< "Xm" << "Ym" << "Zm"
+			<< "Volume"
+			<< "Roundness"
+			<< "FeretDiam"
+			<< "Flatness"
+			<< "VoxDimX" << "VoxDimY" << "VoxDimZ"
+			<< "MajorLength" << "MinorLength";
+		if (calculateAdvancedChars)
+		{
+			result << "Elongation"
+				<< "Perimeter"
+				<< "EquivalentSphericalRadius"
+				<< "MiddleAxisLength"
+				<< "RatioAxisLongToAxisMiddle"
+				<< "RatioMiddleToSmallest"
+				<< "Dir2_X1" << "Dir2_Y1" << "Dir2_Z1"
+				<< "Dir2_X2" << "Dir2_Y2" << "Dir2_Z2";
+		}
+		return result;
+	}
+
+	//! Column indices required for the averages
+	enum { ColPhi = 16, ColTheta = 17, ColVolume = 21, ColRoundness = 22, ColMajorLength = 28 };
 
-	LabelMapType *labelMap = i2l->GetOutput();
-	filter->progress()->setStatus("Computing individual characteristics and writing .csv");
-	// Writing pore csv file
-	double spc = longImage->GetSpacing()[0];
-	std::ofstream fout(pathCSV.toStdString());
-	// Header of pore csv file
-	fout << "Spacing," << spc << '\n'
-		<< "Voids\n\n\n"
-		<< "Label Id,"
-		<< "X1,Y1,Z1,"
-		<< "X2,Y2,Z2,"
-		<< "a11,a22,a33,a12,a13,a23,"
-		<< "DimX,DimY,DimZ,"
-		<< "phi,theta,"
-		<< "Xm,Ym,Zm,"
-		<< "Volume,"
-		<< "Roundness,"
-		<< "FeretDiam,"
-		<< "Flatness,"
-		<< "VoxDimX,VoxDimY,VoxDimZ,"
-		<< "MajorLength,MinorLength,";
-	if (calculateAdvancedChars)
+	//! whether a column holds integer values (which are written without decimal places / exponent)
+	bool isIntegerColumn(QString const& name)
 	{
-		fout << "Elongation,"
-			<< "Perimeter,"
-			<< "EquivalentSphericalRadius,"
-			<< "MiddleAxisLength,"
-			<< "RatioAxisLongToAxisMiddle,"
-			<< "RatioMiddleToSmallest,"
-			<< "Dir2_X1,Dir2_Y1,Dir2_Z1,"
-			<< "Dir2_X2,Dir2_Y2,Dir2_Z2,";
+		return name == "Label Id" || name == "VoxDimX" || name == "VoxDimY" || name == "VoxDimZ";
 	}
-	fout << '\n';
-	std::array<double, 5> sums{};
-	for (itk::SizeValueType labelValue = 0; labelValue < labelMap->GetNumberOfLabelObjects(); ++labelValue)
+
+	//! Compute all characteristics of a single label object, and store them in the given row.
+	template <typename ShapeLabelObjectType>
+	void computeCharacteristics(ShapeLabelObjectType const* labelObject, size_t labelNr, double spc,
+		bool calculateAdvancedChars, bool calculateRoundness, double* row)
 	{
-		ShapeLabelObjectType* labelObject = labelMap->GetNthLabelObject(labelValue);
 		iAVec3d centroid(labelObject->GetCentroid().data());
 		auto const& bb = labelObject->GetBoundingBox();
 		auto const& obbsize = labelObject->GetOrientedBoundingBoxSize();
 		double majorlength = obbsize[2];
 		double minorlength = obbsize[1];
-		auto bbsize = bb.GetSize().data();
+		auto bbsize = bb.GetSize();
 		double half_length = majorlength / 2.0;
 		auto const & eigenvectors = labelObject->GetPrincipalAxes();
 		auto const& eigenvalues = labelObject->GetPrincipalMoments();
@@ -141,8 +135,6 @@ template<class T> void calcFeatureCharacteristics(iAFilter* filter, itk::ImageBa
 			a23 = 0.0;
 		}
 
-		// Calculation of other pore characteristics and writing the csv file
-
 		// apparently the "roundness" delivered by the filter (GetRoundness), is not really reliable
 		// (values up to 2 when it should only produce values up to 1)
 		// So we use the computation as proposed in
@@ -156,81 +148,240 @@ template<class T> void calcFeatureCharacteristics(iAFilter* filter, itk::ImageBa
 				labelObject->GetRoundness() :
 				0.0);
 
-		fout << labelValue+1 << ','
-			<< pt1.x() << ',' << pt1.y() << ',' << pt1.z() << ','     // physical units
-			<< pt2.x() << ',' << pt2.y() << ',' << pt2.z() << ','     // physical units
-			<< a11 << ','<< a22 << ','<< a33 << ','
-			<< a12 << ','<< a13 << ','<< a23 << ','
-			<< bbsize[0] * spc << ','              // physical units
-			<< bbsize[1] * spc << ','              // physical units
-			<< bbsize[2] * spc << ','              // physical units
-			<< phi << ',' << theta << ','              // unit = °
-			<< centroid.x() << ',' << centroid.y() << ',' << centroid.z() << ','     // physical units
-			<< labelObject->GetPhysicalSize() << ','   // physical units
-			<< roundness << ','
-			<< labelObject->GetFeretDiameter() << ','  // physical units
-			<< labelObject->GetFlatness() << ','
-			<< bbsize[0] << ','	<< bbsize[1] << ',' << bbsize[2] << ','	// unit = voxels
-			<< majorlength << ',' << minorlength << ',';                // physical units
+		size_t c = 0;
+		for (double v : {
+			static_cast<double>(labelNr),
+			pt1.x(), pt1.y(), pt1.z(),     // physical units
+			pt2.x(), pt2.y(), pt2.z(),     // physical units
+			a11, a22, a33,
+			a12, a13, a23,
+			bbsize[0] * spc, bbsize[1] * spc, bbsize[2] * spc,    // physical units
+			phi, theta,                                           // unit = °
+			centroid.x(), centroid.y(), centroid.z(),             // physical units
+			labelObject->GetPhysicalSize(),                       // physical units
+			roundness,
+			labelObject->GetFeretDiameter(),                      // physical units
+			labelObject->GetFlatness(),
+			static_cast<double>(bbsize[0]), static_cast<double>(bbsize[1]), static_cast<double>(bbsize[2]), // unit = voxels
+			majorlength, minorlength })                           // physical units
+		{
+			row[c++] = v;
+		}
 
 		if (calculateAdvancedChars)
 		{
-			double elongation = labelObject->GetElongation();
-			double perimeter = labelObject->GetPerimeter();
 			double secondAxisLengh = 4 * std::sqrt(eigenvalues[1]); //second principal axis
-			double equivSphericalRadius = labelObject->GetEquivalentSphericalRadius();
-			double ratioLongestToMiddle = majorlength / secondAxisLengh;
-			double ratioMiddleToSmallest = secondAxisLengh / minorlength;
-
-			std::vector<double> eigenvector_middle(3);
 			int EWPos = 1; //should be lambda2, lambda1 < lambda2 < lambda3
-
 			//represents second principal axis
-			eigenvector_middle[0] = eigenvectors[EWPos][0];
-			eigenvector_middle[1] = eigenvectors[EWPos][1];
-			eigenvector_middle[2] = eigenvectors[EWPos][2];
-
+			iAVec3d eigenvectorMiddle(eigenvectors[EWPos][0], eigenvectors[EWPos][1], eigenvectors[EWPos][2]);
 			double half_axis2 =/* minorlength*/ secondAxisLengh / 2.0;
-
 			//p1 and px2 vector obtained by second eigenvector
-			double p_x1 = centroid[0] + half_axis2 * eigenvector_middle[0];
-			double p_y1 = centroid[1] + half_axis2 * eigenvector_middle[1];
-			double p_z1 = centroid[2] + half_axis2 * eigenvector_middle[2];
-			double p_x2 = centroid[0] - half_axis2 * eigenvector_middle[0];
-			double p_y2 = centroid[1] - half_axis2 * eigenvector_middle[1];
-			double p_z2 = centroid[2] - half_axis2 * eigenvector_middle[2];
+			auto p1 = centroid + half_axis2 * eigenvectorMiddle;
+			auto p2 = centroid - half_axis2 * eigenvectorMiddle;
+			for (double v : {
+				labelObject->GetElongation(),
+				labelObject->GetPerimeter(),
+				labelObject->GetEquivalentSphericalRadius(),
+				secondAxisLengh,
+				majorlength / secondAxisLengh,     // ratio longest to middle
+				secondAxisLengh / minorlength,     // ratio middle to smallest
+				p1.x(), p1.y(), p1.z(),
+				p2.x(), p2.y(), p2.z() })
+			{
+				row[c++] = v;
+			}
+		}
+	}
 
-			fout << elongation << ','
-				<< perimeter << ','
-				<< equivSphericalRadius << ','
-				<< secondAxisLengh << ","
-				<< ratioLongestToMiddle << ","
-				<< ratioMiddleToSmallest << ",";
-			fout << p_x1 << "," << p_y1 << "," << p_z1 << ","
-				 << p_x2 << "," << p_y2 << "," << p_z2 << ",";
+	//! Append the given value to the given buffer, formatted the same way as std::ostream does by default.
+	void appendValue(std::string& buf, double value, bool isInteger)
+	{
+		char tmp[32];
+		auto res = isInteger ?
+			std::to_chars(tmp, tmp + sizeof(tmp), static_cast<unsigned long long>(value)) :
+			std::to_chars(tmp, tmp + sizeof(tmp), value, std::chars_format::general, 6);
+		buf.append(tmp, res.ptr);
+		buf.push_back(',');
+	}
+
+	//! Write the characteristics table as .csv file (in the format expected by FeatureScout).
+	//! Rows are formatted in parallel, in blocks; the blocks are written in order.
+	bool writeCharacteristicsCSV(QString const& fileName, double spc, QStringList const& columns,
+		std::vector<double> const& values, iAProgress* progress)
+	{
+		std::ofstream fout(fileName.toStdString(), std::ios::binary);
+		if (!fout.is_open())
+		{
+			return false;
+		}
+		// Header of pore csv file
+		fout << "Spacing," << spc << '\n'
+			<< "Voids\n\n\n";
+		std::string header;
+		std::vector<char> integerColumn;
+		for (auto const& c : columns)
+		{
+			header += c.toStdString() + ",";
+			integerColumn.push_back(isIntegerColumn(c));
 		}
-		fout << '\n';
-		if (computeAverages)
+		fout << header << '\n';
+		size_t const colCount = columns.size();
+		qint64 const rowCount = static_cast<qint64>(values.size() / colCount);
+		const qint64 RowsPerBlock = 4096;
+		qint64 const blocksPerBatch = 4 * omp_get_max_threads();    // limits memory used for formatted text
+		qint64 const blockCount = (rowCount + RowsPerBlock - 1) / RowsPerBlock;
+		std::vector<std::string> blocks(blocksPerBatch);
+		for (qint64 batchStart = 0; batchStart < blockCount; batchStart += blocksPerBatch)
 		{
-			sums[0] += labelObject->GetPhysicalSize();
-			sums[1] += phi;
-			sums[2] += theta;
-			sums[3] += roundness;
-			sums[4] += majorlength;
+			qint64 const batchEnd = std::min(blockCount, batchStart + blocksPerBatch);
+#pragma omp parallel for schedule(dynamic, 1)
+			for (qint64 b = batchStart; b < batchEnd; ++b)
+			{
+				auto& buf = blocks[b - batchStart];
+				buf.clear();
+				for (qint64 r = b * RowsPerBlock; r < std::min(rowCount, (b + 1) * RowsPerBlock); ++r)
+				{
+					for (size_t c = 0; c < colCount; ++c)
+					{
+						appendValue(buf, values[r * colCount + c], integerColumn[c]);
+					}
+					buf.push_back('\n');
+				}
+			}
+			for (qint64 b = batchStart; b < batchEnd; ++b)
+			{
+				auto const& buf = blocks[b - batchStart];
+				fout.write(buf.data(), buf.size());
+			}
+			progress->emitProgress(50 + 50.0 * batchEnd / blockCount);
 		}
-		filter->progress()->emitProgress(labelValue * 100.0 / labelMap->GetNumberOfLabelObjects());
+		return fout.good();
 	}
-	if (computeAverages)
+
+	//! Write the characteristics table as binary columnar file.
+	//! For the format, see the description of iACalcFeatureCharacteristics.
+	bool writeCharacteristicsBinary(QString const& fileName, double spc, QStringList const& columns,
+		std::vector<double> const& values, iAProgress* progress)
+	{
+		std::ofstream fout(fileName.toStdString(), std::ios::binary);
+		if (!fout.is_open())
+		{
+			return false;
+		}
+		auto writeRaw = [&fout](auto value)
+		{
+			fout.write(reinterpret_cast<char const*>(&value), sizeof(value));
+		};
+		size_t const colCount = columns.size();
+		size_t const rowCount = values.size() / colCount;
+		fout.write(BinaryMagic, sizeof(BinaryMagic));
+		writeRaw(static_cast<quint64>(rowCount));
+		writeRaw(static_cast<quint32>(colCount));
+		writeRaw(spc);
+		for (auto const& c : columns)
+		{
+			auto name = c.toStdString();
+			writeRaw(static_cast<quint32>(name.size()));
+			fout.write(name.data(), name.size());
+		}
+		std::vector<double> column(rowCount);
+		for (size_t c = 0; c < colCount; ++c)
+		{
+#pragma omp parallel for
+			for (qint64 r = 0; r < static_cast<qint64>(rowCount); ++r)
+			{
+				column[r] = values[r * colCount + c];
+			}
+			fout.write(reinterpret_cast<char const*>(column.data()), rowCount * sizeof(double));
+			progress->emitProgress(50 + 50.0 * (c + 1) / colCount);
+		}
+		return fout.good();
+	}
+}
+
+template<class T> void calcFeatureCharacteristics(iAFilter* filter, itk::ImageBase<3>* itkImg,
+	QString pathCSV, bool feretDiameter, bool calculateAdvancedChars, bool calculateRoundness, bool computeAverages,
+	bool binaryOutput)
+{
+	typedef itk::Image< T, DIM > InputImageType;
+	typename InputImageType::Pointer inputImage = dynamic_cast<InputImageType *>(itkImg);
+	typedef unsigned long LabelType;
+	typedef itk::ShapeLabelObject<LabelType, DIM>	ShapeLabelObjectType;
+	typedef itk::LabelMap<ShapeLabelObjectType>	LabelMapType;
+	filter->progress()->setStatus("Computing feature maps");
+	typename LabelMapType::Pointer labelMap;
+	auto createLabelMap = [&](auto img)
 	{
-		filter->addOutputValue("Number of objects", static_cast<quint64>(labelMap->GetNumberOfLabelObjects()));
-		filter->addOutputValue("Volume average", sums[0] / labelMap->GetNumberOfLabelObjects());
-		filter->addOutputValue("Phi average", sums[1] / labelMap->GetNumberOfLabelObjects());
-		filter->addOutputValue("Theta average", sums[2] / labelMap->GetNumberOfLabelObjects());
-		filter->addOutputValue("Roundness average", sums[3] / labelMap->GetNumberOfLabelObjects());
-		filter->addOutputValue("Length average", sums[4] / labelMap->GetNumberOfLabelObjects());
+		using ImageType = typename std::remove_pointer_t<decltype(img)>;
+		typedef itk::LabelImageToShapeLabelMapFilter<ImageType, LabelMapType> I2LType;
+		typename I2LType::Pointer i2l = I2LType::New();
+		i2l->SetInput(img);
+		i2l->SetComputePerimeter(calculateAdvancedChars);
+		i2l->SetComputeFeretDiameter(feretDiameter);
+		i2l->SetComputeOrientedBoundingBox(true);
+		filter->progress()->observe(i2l);
+		i2l->Update();
+		labelMap = i2l->GetOutput();
+	};
+	if constexpr (std::is_integral_v<T>)
+	{   // label map (run-length encoded) is built directly from the input image, no copy required
+		createLabelMap(inputImage.GetPointer());
+	}
+	else
+	{   // label maps require integer labels
+		typedef itk::Image<long, DIM> LongImageType;
+		auto castfilter = itk::CastImageFilter<InputImageType, LongImageType>::New();
+		castfilter->SetInput( inputImage );
+		castfilter->Update();
+		createLabelMap(castfilter->GetOutput());
 	}
 
-	fout.close();
+	filter->progress()->setStatus("Computing individual characteristics");
+	double spc = inputImage->GetSpacing()[0];
+	auto columns = characteristicsColumns(calculateAdvancedChars);
+	size_t const colCount = columns.size();
+	// GetNthLabelObject has linear complexity, so collect all objects once:
+	auto labelObjects = labelMap->GetLabelObjects();
+	qint64 const objCount = static_cast<qint64>(labelObjects.size());
+	std::vector<double> values(objCount * colCount);
+	std::atomic<qint64> finished(0);
+#pragma omp parallel for schedule(dynamic, 256)
+	for (qint64 l = 0; l < objCount; ++l)
+	{
+		computeCharacteristics(labelObjects[l].GetPointer(), l + 1, spc,
+			calculateAdvancedChars, calculateRoundness, values.data() + l * colCount);
+		auto done = ++finished;
+		if (omp_get_thread_num() == 0)
+		{
+			filter->progress()->emitProgress(done * 50.0 / objCount);
+		}
+	}
+	if (computeAverages)
+	{
+		std::array<double, 5> sums{};
+		for (qint64 l = 0; l < objCount; ++l)
+		{
+			auto row = values.data() + l * colCount;
+			sums[0] += row[ColVolume];
+			sums[1] += row[ColPhi];
+			sums[2] += row[ColTheta];
+			sums[3] += row[ColRoundness];
+			sums[4] += row[ColMajorLength];
+		}
+		filter->addOutputValue("Number of objects", static_cast<quint64>(objCount));
+		filter->addOutputValue("Volume average", sums[0] / objCount);
+		filter->addOutputValue("Phi average", sums[1] / objCount);
+		filter->addOutputValue("Theta average", sums[2] / objCount);
+		filter->addOutputValue("Roundness average", sums[3] / objCount);
+		filter->addOutputValue("Length average", sums[4] / objCount);
+	}
+	filter->progress()->setStatus("Writing characteristics");
+	if (!(binaryOutput ?
+		writeCharacteristicsBinary(pathCSV, spc, columns, values, filter->progress()) :
+		writeCharacteristicsCSV(pathCSV, spc, columns, values, filter->progress())))
+	{
+		throw std::runtime_error(QString("Could not write characteristics to file %1!").arg(pathCSV).toStdString());
+	}
 }
 
 iACalcFeatureCharacteristics::iACalcFeatureCharacteristics():
@@ -248,6 +399,13 @@ iACalcFeatureCharacteristics::iACalcFeatureCharacteristics():
 		"When <em>Calculate averages</em> is enabled, the filter will also compute "
 		"average volume, phi, theta, roundness and length "
 		"and return them as output values.<br/>"
+		"Instead of a .csv file, the table can also be written in a binary columnar format "
+		"by choosing the according <em>Output format</em>, which is much faster to write and read. "
+		"Such a file consists of (all numbers in native byte order, i.e. little-endian on all supported platforms): the 8 characters 'iACOLS01'; "
+		"the number of rows (unsigned 64 bit integer); the number of columns (unsigned 32 bit integer); "
+		"the spacing (64 bit floating point); for each column, its name "
+		"(length as unsigned 32 bit integer, followed by that many UTF-8 characters); "
+		"and finally the values of each column, one column after the other, as 64 bit floating point numbers.<br/>"
 		"For more information, see the "
 		"<a href=\"https://itk.org/Doxygen/html/classitk_1_1LabelImageToShapeLabelMapFilter.html\">"
 		"Label Image to Shape Label Map Filter </a> "
@@ -258,6 +416,7 @@ iACalcFeatureCharacteristics::iACalcFeatureCharacteristics():
 	addParameter("Calculate roundness", iAValueType::Boolean, false);
 	addParameter("Calculate advanced void parameters", iAValueType::Boolean, false);
 	addParameter("Calculate averages", iAValueType::Boolean, false);
+	addParameter("Output format", iAValueType::Categorical, QStringList() << OutputFormatCSV << OutputFormatBinary);
 }
 
 void iACalcFeatureCharacteristics::performWork(QVariantMap const & parameters)
@@ -267,6 +426,7 @@ void iACalcFeatureCharacteristics::performWork(QVariantMap const & parameters)
 		parameters["Calculate Feret Diameter"].toBool(),
 		parameters["Calculate advanced void parameters"].toBool(),
 		parameters["Calculate roundness"].toBool(),
-		parameters["Calculate averages"].toBool());
+		parameters["Calculate averages"].toBool(),
+		parameters["Output format"].toString() == OutputFormatBinary);
 	LOG(lvlInfo, QString("Feature csv file created in: %1").arg(pathCSV));
 }
@@ -9,11 +9,13 @@
 #include <iAValueTypeVectorHelpers.h>
 
 #include <iACsvIO.h>
-#include <iACsvVtkTableCreator.h>
+#include <iACsvVectorTableCreator.h>
 
 #include <vtkImageData.h>
-#include <vtkTable.h>
-#include <vtkVariant.h>
+
+#include <omp.h>
+
+#include <atomic>
 
 namespace
 {
@@ -63,101 +65,46 @@ iASpatialFeatureSummary::iASpatialFeatureSummary():
 
 namespace
 {
-	std::vector<iAVec3i> findCellIdsBresenham3D(iAVec3i const& start, iAVec3i const& end)
+	//! Visits all cells on the discrete line from start to end (both inclusive), using 3D Bresenham.
+	//! See http://www.ict.griffith.edu.au/anthony/info/graphics/bresenham.procs
+	//! Does not allocate any memory; each visited cell is passed to the given function.
+	//! @param visit function taking an iAVec3i const&; called for each cell on the line
+	template <typename VisitFunc>
+	void visitCellsBresenham3D(iAVec3i const& start, iAVec3i const& end, VisitFunc visit)
 	{
-		//bresenham 3D
-		//http://www.ict.griffith.edu.au/anthony/info/graphics/bresenham.procs
-
-		int i, l, m, n, x_inc, y_inc, z_inc, err_1, err_2, dx2, dy2, dz2;
-		//int id = 0;
-		std::vector<iAVec3i> cellIds;
-
 		iAVec3i pixel = start;
 		auto dir = end - start;
-		x_inc = (dir.x() < 0) ? -1 : 1;
-		l = std::abs(dir.x());
-		y_inc = (dir.y() < 0) ? -1 : 1;
-		m = std::abs(dir.y());
-		z_inc = (dir.z() < 0) ? -1 : 1;
-		n = std::abs(dir.z());
-		dx2 = l << 1;
-		dy2 = m << 1;
-		dz2 = n << 1;
-
-		if ((l >= m) && (l >= n))
+		iAVec3i inc(dir.x() < 0 ? -1 : 1, dir.y() < 0 ? -1 : 1, dir.z() < 0 ? -1 : 1);
+		iAVec3i len(std::abs(dir.x()), std::abs(dir.y()), std::abs(dir.z()));
+		// a = index of the driving axis (the one with the largest extent), b, c = the other two axes:
+		int const a = (len[0] >= len[1] && len[0] >= len[2]) ? 0 : ((len[1] >= len[2]) ? 1 : 2);
+		int const b = (a + 1) % 3, c = (a + 2) % 3;
+		int const da2 = len[a] << 1, db2 = len[b] << 1, dc2 = len[c] << 1;
+		int errB = db2 - len[a];
+		int errC = dc2 - len[a];
+		for (int i = 0; i < len[a]; ++i)
 		{
-			err_1 = dy2 - l;
-			err_2 = dz2 - l;
-			for (i = 0; i < l; i++)
+			visit(pixel);
+			if (errB > 0)
 			{
-				cellIds.push_back(pixel);
-				//id++;
-				if (err_1 > 0)
-				{
-					pixel[1] += y_inc;
-					err_1 -= dx2;
-				}
-				if (err_2 > 0)
-				{
-					pixel[2] += z_inc;
-					err_2 -= dx2;
-				}
-				err_1 += dy2;
-				err_2 += dz2;
-				pixel[0] += x_inc;
+				pixel[b] += inc[b];
+				errB -= da2;
 			}
-		}
-		else if ((m >= l) && (m >= n))
-		{
-			err_1 = dx2 - m;
-			err_2 = dz2 - m;
-			for (i = 0; i < m; i++)
+			if (errC > 0)
 			{
-				cellIds.push_back(pixel);
-				//id++;
-				if (err_1 > 0)
-				{
-					pixel[0] += x_inc;
-					err_1 -= dy2;
-				}
-				if (err_2 > 0)
-				{
-					pixel[2] += z_inc;
-					err_2 -= dy2;
-				}
-				err_1 += dx2;
-				err_2 += dz2;
-				pixel[1] += y_inc;
+				pixel[c] += inc[c];
+				errC -= da2;
 			}
+			errB += db2;
+			errC += dc2;
+			pixel[a] += inc[a];
 		}
-		else
-		{
-			err_1 = dy2 - n;
-			err_2 = dx2 - n;
-			for (i = 0; i < n; i++)
-			{
-				cellIds.push_back(pixel);
-				//id++;
-				if (err_1 > 0)
-				{
-					pixel[1] += y_inc;
-					err_1 -= dz2;
-				}
-				if (err_2 > 0)
-				{
-					pixel[0] += x_inc;
-					err_2 -= dz2;
-				}
-				err_1 += dy2;
-				err_2 += dx2;
-				pixel[2] += z_inc;
-			}
-		}
-		cellIds.push_back(pixel);
-		//id++;
-
-		return cellIds;
+		visit(pixel);
 	}
+
+	//! maximum amount of memory used for thread-local accumulation images;
+	//! if more would be required, all threads directly (atomically) add to the output images
+	const size_t MaxThreadLocalAccumulationBytes = 2048 * 1024 * 1024ull;
 }
 
 void iASpatialFeatureSummary::performWork(QVariantMap const & parameters)
@@ -170,9 +117,9 @@ void iASpatialFeatureSummary::performWork(QVariantMap const & parameters)
 		columns = stringToVector<QVector<int>, int>(parameters[Columns].toString());
 	}
 
-	// load csv:
+	// load csv (into plain columns of doubles, avoiding conversions from vtkVariant for each access):
 	iACsvIO io;
-	iACsvVtkTableCreator tableCreator;
+	iACsvVectorTableCreator tableCreator;
 	auto config = iACsvConfig::getFCPFiberFormat(csvFileName);
 	if (!io.loadCSV(tableCreator, config))
 	{
@@ -180,11 +127,24 @@ void iASpatialFeatureSummary::performWork(QVariantMap const & parameters)
 		return;
 	}
 	auto headers = io.outputHeaders();
-	auto csvTable = tableCreator.table();
+	auto const& csvTable = tableCreator.table();
+	for (auto col : columns)
+	{
+		if (col < 0 || static_cast<size_t>(col) >= csvTable.size())
+		{
+			LOG(lvlError, QString("Invalid column index %1; the table only has %2 columns!").arg(col).arg(csvTable.size()));
+			return;
+		}
+	}
+	auto const fiberCount = static_cast<qint64>(csvTable.empty() ? 0 : csvTable[0].size());
 
 	// compute overall bounding box:
 	iAVec3i startIdx(config.columnMapping[iACsvConfig::StartX], config.columnMapping[iACsvConfig::StartY], config.columnMapping[iACsvConfig::StartZ]);
 	iAVec3i endIdx(config.columnMapping[iACsvConfig::EndX], config.columnMapping[iACsvConfig::EndY], config.columnMapping[iACsvConfig::EndZ]);
+	auto point = [&csvTable](iAVec3i const& idx, qint64 row)
+	{
+		return iAVec3d(csvTable[idx[0]][row], csvTable[idx[1]][row], csvTable[idx[2]][row]);
+	};
 
 	auto minCorner = iAVec3d( variantToVector<double>(parameters[MinCorner]).data() );
 	auto maxCorner = iAVec3d( variantToVector<double>(parameters[MaxCorner]).data() );
@@ -197,12 +157,10 @@ void iASpatialFeatureSummary::performWork(QVariantMap const & parameters)
 	}
 	else
 	{
-		for (int o = 0; o < csvTable->GetNumberOfRows(); ++o)
+		for (qint64 o = 0; o < fiberCount; ++o)
 		{
-			iAVec3d startPoint(csvTable->GetValue(o, startIdx[0]).ToDouble(), csvTable->GetValue(o, startIdx[1]).ToDouble(), csvTable->GetValue(o, startIdx[2]).ToDouble());
-			iAVec3d endPoint(csvTable->GetValue(o, endIdx[0]).ToDouble(), csvTable->GetValue(o, endIdx[1]).ToDouble(), csvTable->GetValue(o, endIdx[2]).ToDouble());
-			overallBB.addPointToBox(startPoint);
-			overallBB.addPointToBox(endPoint);
+			overallBB.addPointToBox(point(startIdx, o));
+			overallBB.addPointToBox(point(endIdx, o));
 		}
 	}
 
@@ -216,74 +174,173 @@ void iASpatialFeatureSummary::performWork(QVariantMap const & parameters)
 		QString("spacing: %1, %2, %3; ").arg(metaSpacing[0]).arg(metaSpacing[1]).arg(metaSpacing[2]) +
 		QString("origin: %1, %2, %3; ").arg(metaOrigin[0]).arg(metaOrigin[1]).arg(metaOrigin[2]));
 
-
-	// determine number of fibers in each cell:
 	auto numberOfFibersImage = allocateImage(VTK_INT, metaDim.data(), metaSpacing.data());
 	auto numberOfPointsImage = allocateImage(VTK_INT, metaDim.data(), metaSpacing.data());
 	fillImage(numberOfFibersImage, 0.0);
 	fillImage(numberOfPointsImage, 0.0);
-	for (int o = 0; o < csvTable->GetNumberOfRows(); ++o)
+	std::vector<vtkSmartPointer<vtkImageData>> columnImages;
+	for (qsizetype c = 0; c < columns.size(); ++c)
 	{
-		iAVec3i startVoxel(iAVec3d(csvTable->GetValue(o, startIdx[0]).ToDouble(), csvTable->GetValue(o, startIdx[1]).ToDouble(), csvTable->GetValue(o, startIdx[2]).ToDouble()) / metaSpacing);
-		iAVec3i endVoxel(iAVec3d(csvTable->GetValue(o, endIdx[0]).ToDouble(), csvTable->GetValue(o, endIdx[1]).ToDouble(), csvTable->GetValue(o, endIdx[2]).ToDouble()) / metaSpacing);
-		numberOfPointsImage->SetScalarComponentFromDouble(startVoxel.x(), startVoxel.y(), startVoxel.z(), 0,
-			numberOfPointsImage->GetScalarComponentAsDouble(startVoxel.x(), startVoxel.y(), startVoxel.z(), 0) + 1);
-		numberOfPointsImage->SetScalarComponentFromDouble(endVoxel.x(), endVoxel.y(), endVoxel.z(), 0,
-			numberOfPointsImage->GetScalarComponentAsDouble(endVoxel.x(), endVoxel.y(), endVoxel.z(), 0) + 1);
-		auto cellIds = findCellIdsBresenham3D(startVoxel, endVoxel);
-		for (auto c : cellIds)
+		auto metaImage = allocateImage(VTK_DOUBLE, metaDim.data(), metaSpacing.data());
+		metaImage->SetOrigin(metaOrigin);
+		fillImage(metaImage, 0.0);
+		columnImages.push_back(metaImage);
+	}
+
+	// single pass over all fibers, accumulating fiber/point counts and column sums for all cells;
+	// fibers are distributed over threads, each thread accumulates into its own images
+	// (merged afterwards), or, if that would take too much memory, directly into the output images:
+	size_t const cellCount = static_cast<size_t>(metaDim[0]) * metaDim[1] * metaDim[2];
+	size_t const colCount = columns.size();
+	int const numThreads = omp_get_max_threads();
+	bool const threadLocal = numThreads > 1 &&
+		cellCount * (2 * sizeof(int) + colCount * sizeof(double)) * (numThreads - 1) <= MaxThreadLocalAccumulationBytes;
+	// accumulation buffers of all threads; thread 0 (and all threads if !threadLocal) uses the output images:
+	std::vector<int*> fiberAcc(numThreads, static_cast<int*>(numberOfFibersImage->GetScalarPointer()));
+	std::vector<int*> pointAcc(numThreads, static_cast<int*>(numberOfPointsImage->GetScalarPointer()));
+	std::vector<std::vector<double*>> sumAcc(numThreads);
+	for (auto img : columnImages)
+	{
+		for (int t = 0; t < numThreads; ++t)
 		{
-			if (c[0] < 0 || c[0] >= metaDim[0] || c[1] < 0 || c[1] >= metaDim[1] || c[2] < 0 || c[2] >= metaDim[2])
+			sumAcc[t].push_back(static_cast<double*>(img->GetScalarPointer()));
+		}
+	}
+	std::vector<std::vector<int>> localCounts(threadLocal ? numThreads : 0);
+	std::vector<std::vector<double>> localSums(threadLocal ? numThreads : 0);
+	for (int t = 1; t < static_cast<int>(localCounts.size()); ++t)
+	{
+		localCounts[t].resize(2 * cellCount, 0);
+		localSums[t].resize(colCount * cellCount, 0.0);
+		fiberAcc[t] = localCounts[t].data();
+		pointAcc[t] = localCounts[t].data() + cellCount;
+		for (size_t c = 0; c < colCount; ++c)
+		{
+			sumAcc[t][c] = localSums[t].data() + c * cellCount;
+		}
+	}
+	iAVec3i const dim(metaDim.data());
+	auto inside = [&dim](iAVec3i const& c)
+	{
+		return c[0] >= 0 && c[0] < dim[0] && c[1] >= 0 && c[1] < dim[1] && c[2] >= 0 && c[2] < dim[2];
+	};
+	auto cellIdx = [&dim](iAVec3i const& c)
+	{
+		return static_cast<size_t>(c[0]) + static_cast<size_t>(dim[0]) * (c[1] + static_cast<size_t>(dim[1]) * c[2]);
+	};
+	std::atomic<qint64> invalidCells(0);
+	std::atomic<qint64> processedFibers(0);
+	std::atomic<bool> stop(false);
+	bool const continueOnError = parameters[ContinueOnError].toBool();
+#pragma omp parallel
+	{
+		int const t = omp_get_thread_num();
+		bool const useAtomic = !threadLocal && numThreads > 1;
+		auto add = [useAtomic](auto* acc, size_t idx, auto val)
+		{
+			if (useAtomic)
 			{
-				LOG(lvlWarn, QString("Invalid coordinate %1; given volume dimensions are probably too small to contain the fibers in the .csv!").arg(c.toString()));
-				if (parameters[ContinueOnError].toBool())
+#pragma omp atomic
+				acc[idx] += val;
+			}
+			else
+			{
+				acc[idx] += val;
+			}
+		};
+		std::vector<double> vals(colCount);
+#pragma omp for schedule(dynamic, 256)
+		for (qint64 o = 0; o < fiberCount; ++o)
+		{
+			if (stop)
+			{
+				continue;
+			}
+			iAVec3i startVoxel(point(startIdx, o) / metaSpacing);
+			iAVec3i endVoxel(point(endIdx, o) / metaSpacing);
+			for (auto const& v : { startVoxel, endVoxel })
+			{
+				if (inside(v))
 				{
-					continue;
+					add(pointAcc[t], cellIdx(v), 1);
 				}
-				else
+			}
+			for (size_t c = 0; c < colCount; ++c)
+			{
+				vals[c] = csvTable[columns[c]][o];
+			}
+			visitCellsBresenham3D(startVoxel, endVoxel, [&](iAVec3i const& c)
+			{
+				if (!inside(c))
 				{
+					++invalidCells;
+					if (!continueOnError)
+					{
+						stop = true;
+					}
 					return;
 				}
+				auto idx = cellIdx(c);
+				add(fiberAcc[t], idx, 1);
+				for (size_t col = 0; col < colCount; ++col)
+				{
+					add(sumAcc[t][col], idx, vals[col]);
+				}
+			});
+			auto processed = ++processedFibers;
+			if (t == 0)
+			{
+				progress()->emitProgress(90.0 * processed / fiberCount);
+			}
+		}
+	}
+	if (invalidCells > 0)
+	{
+		LOG(lvlWarn, QString("%1 cells on fiber paths were outside of the given volume; "
+			"given volume dimensions are probably too small to contain the fibers in the .csv!").arg(invalidCells));
+		if (!continueOnError)
+		{
+			return;
+		}
+	}
+	// merge thread-local results and turn column sums into averages:
+	auto outFibers = fiberAcc[0];
+	auto outPoints = pointAcc[0];
+#pragma omp parallel for
+	for (qint64 i = 0; i < static_cast<qint64>(cellCount); ++i)
+	{
+		for (int t = 1; t < static_cast<int>(localCounts.size()); ++t)
+		{
+			outFibers[i] += fiberAcc[t][i];
+			outPoints[i] += pointAcc[t][i];
+			for (size_t c = 0; c < colCount; ++c)
+			{
+				sumAcc[0][c][i] += sumAcc[t][c][i];
 			}
-			numberOfFibersImage->SetScalarComponentFromDouble(c.x(), c.y(), c.z(), 0,
-				numberOfFibersImage->GetScalarComponentAsDouble(c.x(), c.y(), c.z(), 0) + 1);
+		}
+		for (size_t c = 0; c < colCount; ++c)
+		{
+			sumAcc[0][c][i] = (outFibers[i] == 0) ? 0.0 : sumAcc[0][c][i] / outFibers[i];
 		}
 	}
+	progress()->emitProgress(100);
+	numberOfFibersImage->Modified();
+	numberOfPointsImage->Modified();
+
 	addOutput(std::make_shared<iAImageData>(numberOfFibersImage));
 	addOutput(std::make_shared<iAImageData>(numberOfPointsImage));
 	auto r = numberOfFibersImage->GetScalarRange();
 	LOG(lvlDebug, QString("Number of fibers: from %1 to %2").arg(r[0]).arg(r[1]));
 
-	// determine characteristics averages:
 	auto curOutput = 2;
-	for (auto col : columns)
+	for (size_t c = 0; c < colCount; ++c)
 	{
-		auto metaImage = allocateImage(VTK_DOUBLE, metaDim.data(), metaSpacing.data());
-		metaImage->SetOrigin(metaOrigin);
-		fillImage(metaImage, 0.0);
-		for (int o = 0; o < csvTable->GetNumberOfRows(); ++o)
-		{
-			iAVec3i startVoxel(iAVec3d(csvTable->GetValue(o, startIdx[0]).ToDouble(), csvTable->GetValue(o, startIdx[1]).ToDouble(), csvTable->GetValue(o, startIdx[2]).ToDouble()) / metaSpacing);
-			iAVec3i endVoxel(iAVec3d(csvTable->GetValue(o, endIdx[0]).ToDouble(), csvTable->GetValue(o, endIdx[1]).ToDouble(), csvTable->GetValue(o, endIdx[2]).ToDouble()) / metaSpacing);
-			auto val = csvTable->GetValue(o, col).ToDouble();
-			auto cellIds = findCellIdsBresenham3D(startVoxel, endVoxel);
-			for (auto c : cellIds)
-			{
-				if (c[0] < 0 || c[0] >= metaDim[0] || c[1] < 0 || c[1] >= metaDim[1] || c[2] < 0 || c[2] >= metaDim[2])
-				{
-					LOG(lvlWarn, QString("Invalid coordinate %1").arg(c.toString()));
-					continue;
-				}
-				auto cellValue = metaImage->GetScalarComponentAsDouble(c.x(), c.y(), c.z(), 0);
-				auto numOfFibersInCell = numberOfFibersImage->GetScalarComponentAsDouble(c.x(), c.y(), c.z(), 0);
-				assert(numOfFibersInCell != 0); // should not happen, since above we visited the same cells
-				metaImage->SetScalarComponentFromDouble(c.x(), c.y(), c.z(), 0, cellValue + val / numOfFibersInCell	);
-			}
-		}
-		setOutputName(curOutput, headers[col]);
+		auto metaImage = columnImages[c];
+		metaImage->Modified();
+		setOutputName(curOutput, headers[columns[c]]);
 		addOutput(std::make_shared<iAImageData>(metaImage));
 		auto rng = metaImage->GetScalarRange();
-		LOG(lvlDebug, QString("Output %1: values from %2 to %3").arg(headers[col]).arg(rng[0]).arg(rng[1]));
+		LOG(lvlDebug, QString("Output %1: values from %2 to %3").arg(headers[columns[c]]).arg(rng[0]).arg(rng[1]));
 		++curOutput;
 	}
 }
@@ -226,6 +226,7 @@ dlg_FeatureScout::dlg_FeatureScout(iAMdiChild* parent, iAObjectType objectType,
 	m_sourcePath(parent->filePath()),
 	m_columnMapping(objData->m_colMapping),
 	m_csvTable(objData->m_table),
+	m_columnarTable(objData->m_columnarTable),
 	m_elementTable(vtkSmartPointer<vtkTable>::New()),
 	m_chartTable(vtkSmartPointer<vtkTable>::New()),
 	m_columnVisibility(m_colCnt, false),
@@ -255,7 +256,7 @@ dlg_FeatureScout::dlg_FeatureScout(iAMdiChild* parent, iAObjectType objectType,
 {
 	setupPolarPlotResolution(3.0);
 
-	m_chartTable->DeepCopy(m_csvTable);
+	m_chartTable->ShallowCopy(m_csvTable);   // values are not modified through the chart table, so no need to copy them
 	m_tableList.push_back(m_chartTable); // at start, the unclassified class contains all objects; could be skipped if classes are loaded later...
 
 	initFeatureScoutUI();
@@ -328,7 +329,7 @@ void dlg_FeatureScout::setPCChartData(bool specialRendering)
 	if (specialRendering)
 	{   // for the special renderings, we use all data:
 		m_chartTable = vtkSmartPointer<vtkTable>::New();
-		m_chartTable->DeepCopy(m_csvTable);
+		m_chartTable->ShallowCopy(m_csvTable);
 	}
 	if (m_pcView->GetScene()->GetNumberOfItems() > 0)
 	{
@@ -649,14 +650,20 @@ void dlg_FeatureScout::renderSelection(std::vector<size_t> const& selInds)
 		return;
 	}
 
-	auto sortedSelInds = selInds;
-	std::sort(sortedSelInds.begin(), sortedSelInds.end());
+	// selections coming from the scatter plots are already sorted; avoid copying and sorting them again:
+	std::vector<size_t> sortedSelInds;
+	if (!std::is_sorted(selInds.begin(), selInds.end()))
+	{
+		sortedSelInds = selInds;
+		std::sort(sortedSelInds.begin(), sortedSelInds.end());
+	}
+	auto const& renderedSelInds = sortedSelInds.empty() ? selInds : sortedSelInds;
 
 	int selectedClassID = m_activeClassItem->index().row();
 	QColor classColor = m_colorList.at(selectedClassID);
 	if (m_3dvis)
 	{
-		m_3dvis->renderSelection(sortedSelInds, selectedClassID, classColor, m_activeClassItem);
+		m_3dvis->renderSelection(renderedSelInds, selectedClassID, classColor, m_activeClassItem);
 	}
 }
 
@@ -1776,7 +1783,7 @@ void dlg_FeatureScout::showScatterPlot()
 		return;
 	}
 	QSignalBlocker spmBlock(m_splom.get()); // no need to trigger updates while we're creating SPM
-	m_splom->initScatterPlot(m_csvTable, m_columnVisibility);
+	m_splom->initScatterPlot(m_csvTable, m_columnarTable, m_columnVisibility);
 	m_dwSPM = new iADockWidgetWrapper(m_splom->matrixWidget(), "Scatter Plot Matrix", "FeatureScoutSPM",
 		"https://github.com/3dct/open_iA/wiki/FeatureScout");
 	m_activeChild->splitDockWidget(m_activeChild->renderDockWidget(), m_dwSPM, Qt::Vertical);
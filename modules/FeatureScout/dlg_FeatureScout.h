@@ -27,6 +27,7 @@ class iARenderer;
 class iAMdiChild;
 class iAQVTKWidget;
 
+class iAColumnarTable;
 class iAObjectsData;
 class iAObjectVis;
 class iAObjectVisActor;
@@ -152,6 +153,7 @@ private:
 	iAColMapP m_columnMapping;    //!< mapping of which column stores which characteristic
 
 	vtkSmartPointer<vtkTable> m_csvTable;          //!< Input csv table with all objects
+	std::shared_ptr<iAColumnarTable> m_columnarTable; //!< storage of the values of m_csvTable, if available (shared with SPLOM)
 	vtkSmartPointer<vtkTable> m_elementTable;      //! Characteristic statistics (min, max, avg) for current class
 	vtkSmartPointer<vtkTable> m_chartTable;        //! Objects currently shown in PC view (i.e., obj. in current class)
 	QList<vtkSmartPointer<vtkTable>> m_tableList;  //!< The data table for each class.
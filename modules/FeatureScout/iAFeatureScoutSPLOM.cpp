@@ -46,12 +46,21 @@ iAFeatureScoutSPLOM::iAFeatureScoutSPLOM():
 	selectionEnabled(true)
 {}
 
-void iAFeatureScoutSPLOM::initScatterPlot(vtkTable* csvTable, std::vector<char> const & columnVisibility)
+void iAFeatureScoutSPLOM::initScatterPlot(vtkTable* csvTable, std::shared_ptr<iAColumnarTable> columnarTable, std::vector<char> const & columnVisibility)
 {
 	assert(!matrix);
 	matrix = new iAQSplom();
 	matrix->setSelectionMode(iAScatterPlot::Rectangle);
-	auto spInput = createSPLOMData(csvTable);
+	std::shared_ptr<iASPLOMData> spInput;
+	if (columnarTable)
+	{   // share values with the csv table instead of copying them:
+		spInput = std::make_shared<iASPLOMData>(columnarTable);
+		spInput->updateRanges();
+	}
+	else
+	{
+		spInput = createSPLOMData(csvTable);
+	}
 	matrix->showAllPlots(false);
 	matrix->setData(spInput, columnVisibility);
 	matrix->setSelectionColor(QColor(255, 40, 0, 255));
@@ -6,8 +6,10 @@
 #include <QObject>
 
 #include <cstddef>    // for size_t
+#include <memory>
 #include <vector>
 
+class iAColumnarTable;
 class iALookupTable;
 class iAQSplom;
 
@@ -20,7 +22,8 @@ class iAFeatureScoutSPLOM: public QObject
 	Q_OBJECT
 public:
 	iAFeatureScoutSPLOM();
-	void initScatterPlot(vtkTable* csvTable, std::vector<char> const & columnVisibility);  //!< initialize SPLOM
+	//! initialize SPLOM; if columnarTable is given, the SPLOM directly uses its values (it then needs to hold the same values as csvTable)
+	void initScatterPlot(vtkTable* csvTable, std::shared_ptr<iAColumnarTable> columnarTable, std::vector<char> const & columnVisibility);
 	void updateColumnVisibility(std::vector<char> const & columnVisibility); //!< update column visibility
 	void setParameterVisibility(size_t paramIndex, bool visible);      //!< matrix proxy method
 	void setDotColor(QColor const & color);                            //!< set color for all SPLOM dots (TODO: move range calculations to iASplomData!)
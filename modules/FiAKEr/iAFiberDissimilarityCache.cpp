@@ -0,0 +1,111 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iAFiberDissimilarityCache.h"
+
+#include "iARefDistCompute.h"    // for CacheFileQtDataStreamVersion
+
+#include <iALog.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace
+{
+	const QString FiberDissimilarityCacheFileIdentifier("FiberDissimilarityCache");
+	const quint32 FiberDissimilarityCacheFileVersion(2);
+
+	//! results are identified by their file name only, so that the cache stays valid if the folder is moved
+	QString resultKey(QString const& resultFileName)
+	{
+		return QFileInfo(resultFileName).fileName();
+	}
+
+	//! size and modification time of a result file, to detect results modified since an entry was written
+	QString resultStamp(QString const& resultFileName)
+	{
+		QFileInfo fi(resultFileName);
+		return QString("%1@%2").arg(fi.size()).arg(fi.lastModified().toMSecsSinceEpoch());
+	}
+}
+
+iAFiberDissimilarityCache::iAFiberDissimilarityCache(QString const& folder) :
+	m_folder(folder)
+{}
+
+QString iAFiberDissimilarityCache::fileName(QString const& result1, QString const& result2, int measure) const
+{
+	auto pairHash = QCryptographicHash::hash((resultKey(result1) + "\n" + resultKey(result2)).toUtf8(),
+		QCryptographicHash::Sha1).toHex();
+	return QString("%1/%2-m%3.cache").arg(m_folder).arg(QString::fromLatin1(pairHash)).arg(measure);
+}
+
+bool iAFiberDissimilarityCache::read(QString const& result1, QString const& result2, int measure, size_t fiberCount,
+	double diagonalLength, double maxLength, FiberMatchesT& matches) const
+{
+	QFile cacheFile(fileName(result1, result2, measure));
+	if (!cacheFile.exists())
+	{
+		return false;
+	}
+	if (!cacheFile.open(QFile::ReadOnly))
+	{
+		LOG(lvlWarn, QString("Couldn't open file %1 for reading!").arg(cacheFile.fileName()));
+		return false;
+	}
+	QDataStream in(&cacheFile);
+	in.setVersion(CacheFileQtDataStreamVersion);
+	QString identifier, r1, r2, stamp1, stamp2;
+	quint32 version;
+	qint32 cachedMeasure;
+	quint64 cachedFiberCount;
+	double cachedDiagonalLength, cachedMaxLength;
+	in >> identifier >> version;
+	if (identifier != FiberDissimilarityCacheFileIdentifier || version != FiberDissimilarityCacheFileVersion)
+	{
+		LOG(lvlWarn, QString("FIAKER cache file '%1': Unknown format or version (%2 / %3); ignoring it, it will be recreated.")
+			.arg(cacheFile.fileName()).arg(identifier).arg(version));
+		return false;
+	}
+	in >> r1 >> r2 >> stamp1 >> stamp2 >> cachedMeasure >> cachedFiberCount >> cachedDiagonalLength >> cachedMaxLength;
+	if (r1 != resultKey(result1) || r2 != resultKey(result2) || cachedMeasure != measure || cachedFiberCount != fiberCount)
+	{   // hash collision, or result was modified (different fiber count); either way, recompute
+		return false;
+	}
+	if (stamp1 != resultStamp(result1) || stamp2 != resultStamp(result2) ||
+		cachedDiagonalLength != diagonalLength || cachedMaxLength != maxLength)
+	{   // a result file was modified, or the ensemble changed in a way affecting the normalization; recompute
+		return false;
+	}
+	in >> matches;
+	return in.status() == QDataStream::Ok && static_cast<size_t>(matches.size()) == fiberCount;
+}
+
+bool iAFiberDissimilarityCache::write(QString const& result1, QString const& result2, int measure,
+	double diagonalLength, double maxLength, FiberMatchesT const& matches) const
+{
+	if (!QDir(m_folder).mkpath("."))
+	{
+		LOG(lvlError, QString("Could not create cache directory '%1'").arg(m_folder));
+		return false;
+	}
+	// QSaveFile: only replace an existing file once the new one is completely written,
+	// so that an aborted computation never leaves a truncated cache file behind
+	QSaveFile cacheFile(fileName(result1, result2, measure));
+	if (!cacheFile.open(QFile::WriteOnly))
+	{
+		LOG(lvlError, QString("Couldn't open file %1 for writing!").arg(cacheFile.fileName()));
+		return false;
+	}
+	QDataStream out(&cacheFile);
+	out.setVersion(CacheFileQtDataStreamVersion);
+	out << FiberDissimilarityCacheFileIdentifier << FiberDissimilarityCacheFileVersion;
+	out << resultKey(result1) << resultKey(result2) << resultStamp(result1) << resultStamp(result2)
+		<< static_cast<qint32>(measure) << static_cast<quint64>(matches.size()) << diagonalLength << maxLength;
+	out << matches;
+	return cacheFile.commit();
+}
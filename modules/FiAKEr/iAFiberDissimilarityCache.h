@@ -0,0 +1,46 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iAFiberResult.h"    // for iAFiberSimilarity
+
+#include <QString>
+#include <QVector>
+
+//! Persistent cache for the best matching fibers between two results, stored per dissimilarity measure.
+//! For a directed pair of results (identified by the names of their files) and a single dissimilarity
+//! measure, the cache stores, for every fiber of the first result, the best matching fibers in the
+//! second result. Besides the two result files and the measure, the dissimilarities depend on the
+//! normalization ranges (diagonal length and maximum length), which are determined over the whole
+//! ensemble; an entry is therefore only used if these ranges, as well as the size and modification
+//! time of both result files, are the same as when it was written. Adding measures, or results not
+//! changing these ranges, only requires computing the entries for the new result pairs / measures.
+class iAFiberDissimilarityCache
+{
+public:
+	//! for each fiber of the first result, the best matches in the second result (in order of ascending dissimilarity);
+	//! an empty list means that there is no fiber with an intersecting bounding box in the second result
+	using FiberMatchesT = QVector<QVector<iAFiberSimilarity>>;
+	//! create a cache storing its files in the given folder
+	explicit iAFiberDissimilarityCache(QString const& folder);
+	//! read the cached matches for the given result pair and measure.
+	//! @param result1 file name of the first result
+	//! @param result2 file name of the second result
+	//! @param measure the ID of the dissimilarity measure
+	//! @param fiberCount the number of fibers in the first result (used to verify the cache is consistent)
+	//! @param diagonalLength the diagonal length used for normalizing the dissimilarities
+	//! @param maxLength the maximum length used for normalizing the dissimilarities
+	//! @param matches the read matches are stored here
+	//! @return true if a valid cache entry was found, false otherwise
+	bool read(QString const& result1, QString const& result2, int measure, size_t fiberCount,
+		double diagonalLength, double maxLength, FiberMatchesT& matches) const;
+	//! store the given matches for the given result pair, measure and normalization ranges
+	//! @return true if writing was successful
+	bool write(QString const& result1, QString const& result2, int measure,
+		double diagonalLength, double maxLength, FiberMatchesT const& matches) const;
+	//! the name of the cache file for the given result pair and measure
+	QString fileName(QString const& result1, QString const& result2, int measure) const;
+
+private:
+	QString m_folder;
+};
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iASensitivityData.h"
 
+#include "iAFiberDissimilarityCache.h"
 #include "iAFiberResult.h"
 #include "iARefDistCompute.h"    // for CacheFileQtDataStreamVersion, etc.
 
@@ -27,6 +28,12 @@
 #include <QFileInfo>
 #include <QTextStream>
 
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
 namespace
 {
 	using HistogramType = QVector<double>;
@@ -70,18 +77,83 @@ namespace
 		}
 	}
 
-	std::vector<size_t> intersectingBoundingBox(iAAABB const& fixedFiberBB, std::vector<iAAABB> const& otherFiberBBs)
+	//! Uniform grid over the bounding boxes of the fibers of a result, for quickly finding
+	//! all fibers whose bounding box intersects a given box (instead of testing against all fibers).
+	class iAFiberBBGrid
 	{
-		std::vector<size_t> fiberIDs;
-		for (size_t f = 0; f < otherFiberBBs.size(); ++f)
+	public:
+		explicit iAFiberBBGrid(std::vector<iAAABB> const& fiberBBs) :
+			m_fiberBBs(fiberBBs)
 		{
-			if (fixedFiberBB.intersects(otherFiberBBs[f]))
+			for (auto const& bb : fiberBBs)
 			{
-				fiberIDs.push_back(f);
+				m_bounds.merge(bb);
+			}
+			// roughly one fiber per cell for evenly distributed fibers; limited to keep memory usage in check
+			m_cellsPerAxis = std::clamp(static_cast<int>(std::cbrt(static_cast<double>(fiberBBs.size()))), 1, 64);
+			for (int i = 0; i < 3; ++i)
+			{
+				double extent = m_bounds.maxCorner()[i] - m_bounds.minCorner()[i];
+				m_invCellSize[i] = (extent > 0) ? m_cellsPerAxis / extent : 0;
+			}
+			m_cells.resize(static_cast<size_t>(m_cellsPerAxis) * m_cellsPerAxis * m_cellsPerAxis);
+			for (size_t f = 0; f < fiberBBs.size(); ++f)
+			{
+				visitCells(fiberBBs[f], [this, f](size_t cellIdx) { m_cells[cellIdx].push_back(f); });
 			}
 		}
-		return fiberIDs;
-	}
+		//! IDs of all fibers whose bounding box intersects the given box, in ascending order
+		std::vector<size_t> intersecting(iAAABB const& bb) const
+		{
+			std::vector<size_t> fiberIDs;
+			if (m_fiberBBs.empty() || !bb.intersects(m_bounds))
+			{
+				return fiberIDs;
+			}
+			visitCells(bb, [this, &fiberIDs](size_t cellIdx)
+				{
+					fiberIDs.insert(fiberIDs.end(), m_cells[cellIdx].begin(), m_cells[cellIdx].end());
+				});
+			// fibers spanning multiple cells are found multiple times; sorting also ensures the same
+			// candidate order (and therefore the same results) as a linear search over all fibers
+			std::sort(fiberIDs.begin(), fiberIDs.end());
+			fiberIDs.erase(std::unique(fiberIDs.begin(), fiberIDs.end()), fiberIDs.end());
+			fiberIDs.erase(std::remove_if(fiberIDs.begin(), fiberIDs.end(),
+				[this, &bb](size_t f) { return !bb.intersects(m_fiberBBs[f]); }), fiberIDs.end());
+			return fiberIDs;
+		}
+
+	private:
+		int cellCoord(double value, int axis) const
+		{
+			return std::clamp(static_cast<int>((value - m_bounds.minCorner()[axis]) * m_invCellSize[axis]), 0, m_cellsPerAxis - 1);
+		}
+		template <typename VisitFunc>
+		void visitCells(iAAABB const& bb, VisitFunc visit) const
+		{
+			int minC[3], maxC[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				minC[i] = cellCoord(bb.minCorner()[i], i);
+				maxC[i] = cellCoord(bb.maxCorner()[i], i);
+			}
+			for (int z = minC[2]; z <= maxC[2]; ++z)
+			{
+				for (int y = minC[1]; y <= maxC[1]; ++y)
+				{
+					for (int x = minC[0]; x <= maxC[0]; ++x)
+					{
+						visit((static_cast<size_t>(z) * m_cellsPerAxis + y) * m_cellsPerAxis + x);
+					}
+				}
+			}
+		}
+		std::vector<iAAABB> const& m_fiberBBs;
+		iAAABB m_bounds;
+		int m_cellsPerAxis;
+		double m_invCellSize[3];
+		std::vector<std::vector<size_t>> m_cells;
+	};
 
 	void getBestMatches2(iAFiberData const& fiber, std::vector<iAFiberData> const& otherFibers,
 		QVector<QVector<iAFiberSimilarity>>& bestMatches, std::vector<size_t> const& candidates, double diagonalLength,
@@ -764,121 +836,29 @@ void iASensitivityData::compute(iAProgress* progress)
 	progress->setStatus("Loading cached dissimilarities between all result pairs.");
 	progress->emitProgress(0);
 	QVector<int> measures;
-
-	if (readDissimilarityMatrixCache(measures))
-	{
-		m_resultDissimMeasures.clear();
+	int resultCount = static_cast<int>(m_data->result.size());
+	bool matrixCacheRead = readDissimilarityMatrixCache(measures);
+	if (matrixCacheRead && m_resultDissimMeasures.empty())
+	{   // no measures chosen by user (since the matrix cache existed) - use those from the cache
 		for (auto m : measures)
 		{
 			m_resultDissimMeasures.push_back(std::make_pair(m, true));
 		}
 	}
-	else
+	QVector<int> requestedMeasures;
+	for (auto m : m_resultDissimMeasures)
 	{
-		progress->setStatus("Computing dissimilarity between all result pairs.");
-		// Thoughts on per-object sensitivity:
-		// required: 1-1 match between fibers
-		// currently compute on the fly, based on bounding boxes of fibers;
-		// for further improvement, spatial subdivision structure would be required
-
-		// Questions:
-		// options for characteristic comparison:
-		//    1. compute characteristic distribution difference
-		//        - advantage: dissimilarity measure independent
-		//        - disadvantage: distribution could be same even if lots of differences for single fibers
-		//    2. compute matching fibers; then compute characteristic difference; then average this
-		//        - advantage: represents actual differences better
-		//        - disadvantage: depending on dissimilarity measure (since best match could be computed per dissimiliarity measure
-		//    example: compare
-		//         - result 1 with fibers a (len=5), b (len=3) and c (len=2)
-		//         - result 2 with fibers A (len 3), B (len=2) and C (len=5)
-		//         - best matches between result1&2: a <-> A, b <-> B, c <-> C
-		//         - option 1 -> exactly the same, 1x5, 1x3, 1x2
-		//         - option 2 -> length differences: 2, 1, 3
-		int measureCount = static_cast<int>(m_resultDissimMeasures.size());
-		int resultCount = static_cast<int>(m_data->result.size());
-		m_resultDissimMatrix = iADissimilarityMatrixType(
-			resultCount,
-			QVector<iAResultPairInfo>(resultCount, iAResultPairInfo(measureCount)));
-
-		for (size_t m = 0; m < m_resultDissimMeasures.size(); ++m)
-		{
-			measures.push_back(m_resultDissimMeasures[m].first);
-		}
-
-		//double overallPairs = resultCount * (resultCount - 1) / 2;
-		// for all result pairs r1 and r2, for every fiber f in r1 find those fibers in r2 which best match f
-		double overallPairs = static_cast<double>(resultCount) * resultCount;
-		size_t curCheckedPairs = 0;
-		for (int r1 = 0; r1 < resultCount && !m_aborted; ++r1)
-		{
-			auto& res1 = m_data->result[r1];
-			auto const& mapping = *res1.objData->m_colMapping.get();
-			// TODO: only center -> should use bounding box instead!
-			double const* cxr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterX]),
-				* cyr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterY]),
-				* czr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterZ]);
-			double a = cxr[1] - cxr[0], b = cyr[1] - cyr[0], c = czr[1] - czr[0];
-			double diagonalLength = std::sqrt(std::pow(a, 2) + std::pow(b, 2) + std::pow(c, 2));
-			double const* lengthRange = m_data->spmData->paramRange(mapping[iACsvConfig::Length]);
-			double maxLength = lengthRange[1] - lengthRange[0];
-			for (int r2 = 0; r2 < resultCount && !m_aborted; ++r2)
-			{
-				auto& mat = m_resultDissimMatrix[r1][r2];
-				for (int m = 0; m < measureCount; ++m)
-				{
-					mat.avgDissim[m] = 0;
-				}
-				if (r1 == r2)
-				{
-					continue;
-				}
-				progress->setStatus(QString("Computing dissimilarity between results %1 and %2.").arg(r1).arg(r2));
-				int r1FibCount = static_cast<int>(m_data->result[r1].fiberCount);
-				std::vector<int> r2MatchCount(measureCount, 0);
-				auto& dissimilarities = mat.fiberDissim;
-				dissimilarities.resize(r1FibCount);
-				// not ideal: for loop seems to be not ideally parallelizable,
-				// one spike where 100% is used, then going down to nearly 0, until next loop starts
-				int noCanDo = 0;
-				size_t candSum = 0;
-#pragma omp parallel for reduction(+ : noCanDo, candSum)
-				for (int fiberID = 0; fiberID < r1FibCount; ++fiberID)
-				{
-					auto candidates = intersectingBoundingBox(m_data->result[r1].fiberBB[fiberID], m_data->result[r2].fiberBB);
-					if (candidates.size() == 0)
-					{
-						++noCanDo; // thread-safe
-						continue;
-					}
-					candSum += candidates.size();
-					getBestMatches2(m_data->result[r1].fiberData[fiberID], m_data->result[r2].fiberData,
-						dissimilarities[fiberID], candidates, diagonalLength, maxLength,
-						m_resultDissimMeasures);
-					for (int m = 0; m < measureCount; ++m)
-					{
-						if (dissimilarities[fiberID][m].size() > 0)
-						{
-							++r2MatchCount[m];
-							mat.avgDissim[m] += dissimilarities[fiberID][m][0].dissimilarity;
-						}
-					}
-				}
-				LOG(lvlDebug, QString("Result %1x%2: %3 candidates on average, %4 with no bounding box intersections out of %5")
-					.arg(r1).arg(r2).arg(static_cast<double>(candSum) / r1FibCount).arg(noCanDo).arg(r1FibCount));
-				for (int m = 0; m < measureCount; ++m)
-				{
-					mat.avgDissim[m] /= r2MatchCount[m];
-				}
-				++curCheckedPairs;
-				progress->emitProgress(curCheckedPairs * 100.0 / overallPairs);
-			}
-		}
+		requestedMeasures.push_back(m.first);
+	}
+	if (!matrixCacheRead || m_resultDissimMatrix.size() != resultCount || measures != requestedMeasures)
+	{   // matrix cache missing or outdated (e.g. results or measures were added); only compute the
+		// missing result pairs / measures, re-using the per-pair cache entries of previous computations
+		computeDissimilarityMatrix(progress);
 		if (m_aborted)
 		{
 			return;
 		}
-		writeDissimilarityMatrixCache(measures);
+		writeDissimilarityMatrixCache(requestedMeasures);
 	}
 	if (m_resultDissimMatrix.size() == 0)
 	{
@@ -1198,6 +1178,194 @@ double iASensitivityData::characteristicsDifference(int charIdx, qvectorsizetype
 	// compute geometric average
 }
 
+void iASensitivityData::computeDissimilarityMatrix(iAProgress* progress)
+{
+	progress->setStatus("Computing dissimilarity between all result pairs.");
+	// Thoughts on per-object sensitivity:
+	// required: 1-1 match between fibers
+	// currently compute on the fly, based on bounding boxes of fibers (found via a uniform grid per result)
+
+	// Questions:
+	// options for characteristic comparison:
+	//    1. compute characteristic distribution difference
+	//        - advantage: dissimilarity measure independent
+	//        - disadvantage: distribution could be same even if lots of differences for single fibers
+	//    2. compute matching fibers; then compute characteristic difference; then average this
+	//        - advantage: represents actual differences better
+	//        - disadvantage: depending on dissimilarity measure (since best match could be computed per dissimiliarity measure
+	//    example: compare
+	//         - result 1 with fibers a (len=5), b (len=3) and c (len=2)
+	//         - result 2 with fibers A (len 3), B (len=2) and C (len=5)
+	//         - best matches between result1&2: a <-> A, b <-> B, c <-> C
+	//         - option 1 -> exactly the same, 1x5, 1x3, 1x2
+	//         - option 2 -> length differences: 2, 1, 3
+	int measureCount = static_cast<int>(m_resultDissimMeasures.size());
+	int resultCount = static_cast<int>(m_data->result.size());
+	m_resultDissimMatrix = iADissimilarityMatrixType(
+		resultCount,
+		QVector<iAResultPairInfo>(resultCount, iAResultPairInfo(measureCount)));
+
+	// the best matches for all fibers of r1 in r2 only depend on r1, r2, the measure and the normalization
+	// ranges determined over the whole ensemble; so load all of those already computed before (for the same
+	// ranges), and only compute the missing ones:
+	struct iAPairTask
+	{
+		int r1, r2;
+		double diagonalLength, maxLength;
+		std::vector<iAFiberDissimilarityCache::FiberMatchesT> matches;  // per measure
+		std::vector<std::pair<int, bool>> missingMeasures;
+		std::vector<int> missingMeasureIdx;
+	};
+	iAFiberDissimilarityCache cache(cacheFileName("fiberDissimilarity"));
+	std::vector<iAPairTask> pairs;
+	for (int r1 = 0; r1 < resultCount; ++r1)
+	{
+		for (int r2 = 0; r2 < resultCount; ++r2)
+		{
+			if (r1 == r2)
+			{
+				continue;
+			}
+			auto const& mapping = *m_data->result[r1].objData->m_colMapping.get();
+			// TODO: only center -> should use bounding box instead!
+			double const* cxr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterX]),
+				* cyr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterY]),
+				* czr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterZ]);
+			double a = cxr[1] - cxr[0], b = cyr[1] - cyr[0], c = czr[1] - czr[0];
+			double const* lengthRange = m_data->spmData->paramRange(mapping[iACsvConfig::Length]);
+			iAPairTask pair{r1, r2,
+				std::sqrt(std::pow(a, 2) + std::pow(b, 2) + std::pow(c, 2)), lengthRange[1] - lengthRange[0],
+				std::vector<iAFiberDissimilarityCache::FiberMatchesT>(measureCount), {}, {}};
+			for (int m = 0; m < measureCount; ++m)
+			{
+				if (!cache.read(m_data->result[r1].fileName, m_data->result[r2].fileName, m_resultDissimMeasures[m].first,
+					m_data->result[r1].fiberCount, pair.diagonalLength, pair.maxLength, pair.matches[m]))
+				{
+					pair.missingMeasures.push_back(m_resultDissimMeasures[m]);
+					pair.missingMeasureIdx.push_back(m);
+				}
+			}
+			pairs.push_back(std::move(pair));
+		}
+	}
+	std::vector<size_t> pendingPairs;
+	std::vector<bool> gridRequired(resultCount, false);
+	for (size_t p = 0; p < pairs.size(); ++p)
+	{
+		if (!pairs[p].missingMeasures.empty())
+		{
+			pendingPairs.push_back(p);
+			gridRequired[pairs[p].r2] = true;
+		}
+	}
+	LOG(lvlInfo, QString("Fiber dissimilarities: %1 of %2 result pairs loaded from cache, %3 need to be computed.")
+		.arg(pairs.size() - pendingPairs.size()).arg(pairs.size()).arg(pendingPairs.size()));
+
+	std::vector<std::unique_ptr<iAFiberBBGrid>> grids(resultCount);
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int r = 0; r < resultCount; ++r)
+	{
+		if (gridRequired[r])
+		{
+			grids[r] = std::make_unique<iAFiberBBGrid>(m_data->result[r].fiberBB);
+		}
+	}
+
+	// with enough result pairs, compute them in parallel (avoids the idle times of a parallel
+	// loop over the fibers of a single pair); otherwise parallelize over the fibers of each pair
+	bool parallelPairs = static_cast<int>(pendingPairs.size()) >= 2 * omp_get_max_threads();
+	std::atomic<size_t> finishedPairs(0);
+	int pendingCount = static_cast<int>(pendingPairs.size());
+#pragma omp parallel for schedule(dynamic, 1) if (parallelPairs)
+	for (int p = 0; p < pendingCount; ++p)
+	{
+		if (m_aborted)
+		{
+			continue;
+		}
+		auto& pair = pairs[pendingPairs[p]];
+		auto const& res1 = m_data->result[pair.r1];
+		auto const& res2 = m_data->result[pair.r2];
+		int r1FibCount = static_cast<int>(res1.fiberCount);
+		for (auto m : pair.missingMeasureIdx)
+		{
+			pair.matches[m].resize(r1FibCount);
+		}
+		int noCanDo = 0;
+		size_t candSum = 0;
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : noCanDo, candSum) if (!parallelPairs)
+		for (int fiberID = 0; fiberID < r1FibCount; ++fiberID)
+		{
+			auto candidates = grids[pair.r2]->intersecting(res1.fiberBB[fiberID]);
+			if (candidates.size() == 0)
+			{
+				++noCanDo;
+				continue;
+			}
+			candSum += candidates.size();
+			QVector<QVector<iAFiberSimilarity>> fiberMatches;
+			getBestMatches2(res1.fiberData[fiberID], res2.fiberData, fiberMatches, candidates, pair.diagonalLength,
+				pair.maxLength, pair.missingMeasures);
+			for (size_t i = 0; i < pair.missingMeasureIdx.size(); ++i)
+			{
+				pair.matches[pair.missingMeasureIdx[i]][fiberID] = std::move(fiberMatches[static_cast<qvectorsizetype>(i)]);
+			}
+		}
+		LOG(lvlDebug, QString("Result %1x%2: %3 candidates on average, %4 with no bounding box intersections out of %5")
+			.arg(pair.r1).arg(pair.r2).arg(static_cast<double>(candSum) / r1FibCount).arg(noCanDo).arg(r1FibCount));
+		if (m_aborted)
+		{
+			continue;
+		}
+		for (auto m : pair.missingMeasureIdx)
+		{
+			cache.write(res1.fileName, res2.fileName, m_resultDissimMeasures[m].first,
+				pair.diagonalLength, pair.maxLength, pair.matches[m]);
+		}
+		progress->emitProgress(++finishedPairs * 100.0 / pendingCount);
+	}
+	if (m_aborted)
+	{
+		return;
+	}
+
+	progress->setStatus("Collecting dissimilarities between all result pairs.");
+	for (auto& pair : pairs)
+	{
+		auto& mat = m_resultDissimMatrix[pair.r1][pair.r2];
+		auto& dissimilarities = mat.fiberDissim;
+		int r1FibCount = static_cast<int>(m_data->result[pair.r1].fiberCount);
+		dissimilarities.resize(r1FibCount);
+		for (int m = 0; m < measureCount; ++m)
+		{
+			int matchCount = 0;
+			double dissimSum = 0;
+			for (int fiberID = 0; fiberID < r1FibCount; ++fiberID)
+			{
+				if (pair.matches[m][fiberID].size() > 0)
+				{
+					++matchCount;
+					dissimSum += pair.matches[m][fiberID][0].dissimilarity;
+				}
+			}
+			mat.avgDissim[m] = dissimSum / matchCount;
+		}
+		// as before, a fiber without candidates has an empty list of measures:
+		for (int fiberID = 0; fiberID < r1FibCount; ++fiberID)
+		{
+			if (measureCount == 0 || pair.matches[0][fiberID].size() == 0)
+			{
+				continue;
+			}
+			dissimilarities[fiberID].resize(measureCount);
+			for (int m = 0; m < measureCount; ++m)
+			{
+				dissimilarities[fiberID][m] = std::move(pair.matches[m][fiberID]);
+			}
+		}
+	}
+}
+
 void iASensitivityData::computeSpatialOverview(iAProgress* progress)
 {
 	// initialize 3D overview:
@@ -221,6 +221,8 @@ private:
 	QString uniqueFiberVarCacheFileName(size_t uIdx) const;
 	QString resultFiberCacheFileName(size_t uIdx) const;
 	QString volumePercentageCacheFileName() const;
+	//! compute the best matching fibers for all result pairs; re-uses the matches cached per result pair and measure
+	void computeDissimilarityMatrix(iAProgress* progress);
 	bool readDissimilarityMatrixCache(QVector<int>& measures);
 	void writeDissimilarityMatrixCache(QVector<int> const& measures) const;
 
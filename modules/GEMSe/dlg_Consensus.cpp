@@ -9,6 +9,7 @@
 #include "iASingleResult.h"
 
 // LabelVoting:
+#include <iALabelVoteCounts.h>
 #include <iAMaskingLabelOverlapMeasuresImageFilter.h>
 #include <iAParametrizableLabelVotingImageFilter.h>
 #include <iAProbabilisticVotingImageFilter.h>
@@ -366,51 +367,64 @@ LabelVotingType::Pointer GetLabelVotingFilter(
 	return labelVotingFilter;
 }
 
+LabelImagePointer ClassifyUndecidedPixels(QVector<std::shared_ptr<iASingleResult> > const & selection,
+	LabelImagePointer labelResult, int labelCount)
+{
+	auto undec = iAUndecidedPixelClassifierImageFilter<LabelImageType>::New();
+	typedef LabelVotingType::DoubleImg DblImg;
+	typedef DblImg::Pointer DblImgPtr;
+	for (unsigned int i = 0; i < static_cast<unsigned int>(selection.size()); ++i)
+	{
+		std::vector<DblImgPtr> probImgs;
+		for (int l = 0; l < labelCount; ++l)
+		{
+			iAITKIO::ImagePointer p = selection[i]->probabilityImg(l);
+			DblImgPtr dp = dynamic_cast<DblImg *>(p.GetPointer());
+			probImgs.push_back(dp);
+		}
+		undec->SetProbabilityImages(i, probImgs);
+	}
+	undec->SetInput(labelResult);
+	undec->SetUndecidedPixelLabel(labelCount);
+	undec->Update();
+	return undec->GetOutput();
+}
+
+//! voteCounts: if given, majority voting with equal weights (without label voters and pixel entropy limit)
+//! is determined from these counts instead of from the label images of the selection
 iAITKIO::ImagePointer GetVotingImage(QVector<std::shared_ptr<iASingleResult> > selection,
 	double minAbsPercentage, double minDiffPercentage, double minRatio, double maxPixelEntropy,
-	int labelVoters, int weightType, int labelCount, bool undecidedPixels, double & undecided)
+	int labelVoters, int weightType, int labelCount, bool undecidedPixels, double & undecided,
+	iALabelVoteCounts<LabelImageType> const * voteCounts = nullptr)
 {
 	if (selection.size() == 0)
 	{
 		LOG(lvlError, "Please select a cluster from the tree!");
 		return iAITKIO::ImagePointer();
 	}
-	auto labelVotingFilter = GetLabelVotingFilter(
-		selection, minAbsPercentage, minDiffPercentage, minRatio, maxPixelEntropy, labelVoters, weightType, labelCount);
-	if (!labelVotingFilter)
+	LabelImagePointer labelResult;
+	if (voteCounts && weightType == Equal && labelVoters <= 0 && maxPixelEntropy < 0)
 	{
-		return iAITKIO::ImagePointer();
+		size_t undecidedCount;
+		labelResult = voteCounts->vote(minAbsPercentage, minDiffPercentage, minRatio, undecidedCount);
+		undecided = undecidedCount;
 	}
-	LabelImagePointer labelResult = labelVotingFilter->GetOutput();
-	undecided = labelVotingFilter->GetUndecided();
-	iAITKIO::ImagePointer result;
-	if (undecidedPixels)
+	else
 	{
-		auto undec = iAUndecidedPixelClassifierImageFilter<LabelImageType>::New();
-		typedef LabelVotingType::DoubleImg DblImg;
-		typedef DblImg::Pointer DblImgPtr;
-		for (unsigned int i = 0; i < static_cast<unsigned int>(selection.size()); ++i)
+		auto labelVotingFilter = GetLabelVotingFilter(
+			selection, minAbsPercentage, minDiffPercentage, minRatio, maxPixelEntropy, labelVoters, weightType, labelCount);
+		if (!labelVotingFilter)
 		{
-			std::vector<DblImgPtr> probImgs;
-			for (int l = 0; l < labelCount; ++l)
-			{
-				iAITKIO::ImagePointer p = selection[i]->probabilityImg(l);
-				DblImgPtr dp = dynamic_cast<DblImg *>(p.GetPointer());
-				probImgs.push_back(dp);
-			}
-			undec->SetProbabilityImages(i, probImgs);
+			return iAITKIO::ImagePointer();
 		}
-		undec->SetInput(labelResult);
-		undec->SetUndecidedPixelLabel(labelCount);
-		undec->Update();
-		LabelImagePointer undecResult = undec->GetOutput();
-		result = dynamic_cast<iAITKIO::ImageBaseType *>(undecResult.GetPointer());
+		labelResult = labelVotingFilter->GetOutput();
+		undecided = labelVotingFilter->GetUndecided();
 	}
-	else
+	if (undecidedPixels)
 	{
-		result = dynamic_cast<iAITKIO::ImageBaseType *>(labelResult.GetPointer());
+		labelResult = ClassifyUndecidedPixels(selection, labelResult, labelCount);
 	}
-	return result;
+	return dynamic_cast<iAITKIO::ImageBaseType *>(labelResult.GetPointer());
 }
 
 
@@ -466,24 +480,7 @@ iAITKIO::ImagePointer GetProbVotingImage(QVector<std::shared_ptr<iASingleResult>
 	iAITKIO::ImagePointer result;
 	if (undecidedPixels)
 	{
-		auto undec = iAUndecidedPixelClassifierImageFilter<LabelImageType>::New();
-		typedef LabelVotingType::DoubleImg DblImg;
-		typedef DblImg::Pointer DblImgPtr;
-		for (unsigned int i = 0; i < static_cast<unsigned int>(selection.size()); ++i)
-		{
-			std::vector<DblImgPtr> probImgs;
-			for (int l = 0; l < labelCount; ++l)
-			{
-				iAITKIO::ImagePointer p = selection[i]->probabilityImg(l);
-				DblImgPtr dp = dynamic_cast<DblImg *>(p.GetPointer());
-				probImgs.push_back(dp);
-			}
-			undec->SetProbabilityImages(i, probImgs);
-		}
-		undec->SetInput(labelResult);
-		undec->SetUndecidedPixelLabel(labelCount);
-		undec->Update();
-		LabelImagePointer undecResult = undec->GetOutput();
+		LabelImagePointer undecResult = ClassifyUndecidedPixels(selection, labelResult, labelCount);
 		result = dynamic_cast<iAITKIO::ImageBaseType *>(undecResult.GetPointer());
 
 		// calculate dice for undecided pixels:
@@ -550,7 +547,8 @@ void dlg_Consensus::AbsMinPercentSlider(int)
 	lbValue->setText(name);
 	UpdateWeightPlot();
 	double undecided;
-	m_lastMVResult = GetVotingImage(selection, minAbs, -1, -1, -1, -1, GetWeightType(), m_labelCount, cbUndecidedPixels->isChecked(), undecided);
+	m_lastMVResult = GetVotingImage(selection, minAbs, -1, -1, -1, -1, GetWeightType(), m_labelCount, cbUndecidedPixels->isChecked(), undecided,
+		VoteCounts(selection, GetWeightType()));
 	m_dlgGEMSe->AddConsensusImage(m_lastMVResult, name );
 }
 
@@ -568,7 +566,8 @@ void dlg_Consensus::MinDiffPercentSlider(int)
 	lbValue->setText(name);
 	UpdateWeightPlot();
 	double undecided;
-	m_lastMVResult = GetVotingImage(selection, -1, minDiff, -1, -1, -1, GetWeightType(), m_labelCount, cbUndecidedPixels->isChecked(), undecided);
+	m_lastMVResult = GetVotingImage(selection, -1, minDiff, -1, -1, -1, GetWeightType(), m_labelCount, cbUndecidedPixels->isChecked(), undecided,
+		VoteCounts(selection, GetWeightType()));
 	m_dlgGEMSe->AddConsensusImage(m_lastMVResult, name);
 }
 
@@ -586,7 +585,8 @@ void dlg_Consensus::MinRatioSlider(int)
 	lbValue->setText(name);
 	UpdateWeightPlot();
 	double undecided;
-	m_lastMVResult = GetVotingImage(selection, -1, -1, minRatio, -1, -1, GetWeightType(), m_labelCount, cbUndecidedPixels->isChecked(), undecided);
+	m_lastMVResult = GetVotingImage(selection, -1, -1, minRatio, -1, -1, GetWeightType(), m_labelCount, cbUndecidedPixels->isChecked(), undecided,
+		VoteCounts(selection, GetWeightType()));
 	m_dlgGEMSe->AddConsensusImage(m_lastMVResult, name);
 }
 
@@ -1181,6 +1181,40 @@ void dlg_Consensus::UpdateWeightPlot()
 	lbWeight->setText("Weight: " + GetWeightName(GetWeightType()));
 }
 
+iALabelVoteCounts<LabelImageType> const * dlg_Consensus::VoteCounts(QVector<std::shared_ptr<iASingleResult> > const & selection, int weightType)
+{
+	if (weightType != Equal || selection.isEmpty())
+	{
+		return nullptr;
+	}
+	if (!m_voteCounts)
+	{
+		m_voteCounts = std::make_unique<iALabelVoteCounts<LabelImageType> >(m_labelCount);
+	}
+	// only the label images of results added to or removed from the selection need to be read;
+	// a result contained multiple times in the selection votes multiple times, as in the label voting filter:
+	auto added = selection;
+	for (int m = m_voteCountMembers.size() - 1; m >= 0; --m)
+	{
+		int idx = added.indexOf(m_voteCountMembers[m]);
+		if (idx != -1)
+		{
+			added.remove(idx);
+			continue;
+		}
+		iAITKIO::ImagePointer img = m_voteCountMembers[m]->labelImage();
+		m_voteCounts->removeMember(dynamic_cast<LabelImageType const*>(img.GetPointer()));
+		m_voteCountMembers.remove(m);
+	}
+	for (auto const & result : added)
+	{
+		iAITKIO::ImagePointer img = result->labelImage();
+		m_voteCounts->addMember(dynamic_cast<LabelImageType const*>(img.GetPointer()));
+		m_voteCountMembers.push_back(result);
+	}
+	return m_voteCounts.get();
+}
+
 void dlg_Consensus::Sample()
 {
 	QVector<std::shared_ptr<iASingleResult> > selection;
@@ -1291,9 +1325,10 @@ void dlg_Consensus::Sample(QVector<std::shared_ptr<iASingleResult> > const & sel
 			iAITKIO::ImagePointer result[ResultCount];
 			QVector<double> undecided(ResultCount);
 			const int ProbVoteCount = 5;
-			result[0] = GetVotingImage(selection, value[0], -1, -1, -1, -1, weightType, m_labelCount, true, undecided[0]);
-			result[1] = GetVotingImage(selection, -1, value[1], -1, -1, -1, weightType, m_labelCount, true, undecided[1]);
-			result[2] = GetVotingImage(selection, -1, -1, value[2], -1, -1, weightType, m_labelCount, true, undecided[2]);
+			auto voteCounts = VoteCounts(selection, weightType);
+			result[0] = GetVotingImage(selection, value[0], -1, -1, -1, -1, weightType, m_labelCount, true, undecided[0], voteCounts);
+			result[1] = GetVotingImage(selection, -1, value[1], -1, -1, -1, weightType, m_labelCount, true, undecided[1], voteCounts);
+			result[2] = GetVotingImage(selection, -1, -1, value[2], -1, -1, weightType, m_labelCount, true, undecided[2], voteCounts);
 			result[3] = GetVotingImage(selection, -1, -1, -1, value[3], -1, weightType, m_labelCount, true, undecided[3]);
 			result[4] = GetVotingImage(selection, -1, -1, -1, -1, value[4], weightType, m_labelCount, true, undecided[4]);
 			QVector<QVector<double>>  probVoteDice;
@@ -1303,7 +1338,7 @@ void dlg_Consensus::Sample(QVector<std::shared_ptr<iASingleResult> > const & sel
 				probVoteDice.push_back(QVector<double>());
 				undecidedDice.push_back(QVector<double>());
 				result[pv + 5] = GetProbVotingImage(selection, value[pv + 5],
-					static_cast<VotingRule>(pv), m_labelCount, true, undecided[i+5],
+					static_cast<VotingRule>(pv), m_labelCount, true, undecided[pv+5],
 					probVoteDice[pv], undecidedDice[pv], m_groundTruthImage, m_cachePath, 5+pv, i);
 			}
 			for (int r = 0; r < ResultCount; ++r)
@@ -21,6 +21,8 @@ class iALookupTable;
 class iASamplingResults;
 class iAMdiChild;
 
+template <typename TLabelImage> class iALabelVoteCounts;
+
 class vtkChartXY;
 class vtkPlot;
 class vtkTable;
@@ -68,6 +70,9 @@ private:
 		QVector<std::shared_ptr<iASingleResult> > const & selection,
 		QString const & name);
 	void StartNextSampler();
+	//! the vote counts of the given selection if they can be used for the given weight type (otherwise nullptr);
+	//! updates the counts incrementally from the previously used selection
+	iALabelVoteCounts<LabelImageType> const * VoteCounts(QVector<std::shared_ptr<iASingleResult> > const & selection, int weightType);
 
 	iAMdiChild*  m_mdiChild;
 	dlg_GEMSe* m_dlgGEMSe;
@@ -95,4 +100,7 @@ private:
 	int m_comparisonWeightType;
 	dlg_samplings * m_dlgSamplings;
 	QString m_cachePath;
+	//! vote counts for majority voting with equal weights, and the results currently contributing to them
+	std::unique_ptr<iALabelVoteCounts<LabelImageType> > m_voteCounts;
+	QVector<std::shared_ptr<iASingleResult> > m_voteCountMembers;
 };
@@ -9,12 +9,11 @@
 #include "iARepresentative.h"
 #include "iASingleResult.h"
 
+#include <iACompressedLabelImage.h>
 #include <iAImageComparisonMetrics.h>
 #include <iALog.h>
 #include <iAProgress.h>
 
-#include <itkLabelOverlapMeasuresImageFilter.h>
-
 #include <QMap>
 
 #include <utility>
@@ -43,31 +42,9 @@ std::shared_ptr<iAImageTree > iAImageClusterer::GetResult()
 }
 
 
-double CalcDistance(ClusterImageType img1, ClusterImageType img2)
+double CalcDistance(iACompressedLabelImage const & img1, iACompressedLabelImage const & img2)
 {
-	assert (img1);
-	assert (img2);
-	double meanOverlap = 0;
-	try
-	{
-		LabelImageType * img1t = dynamic_cast<LabelImageType*>(img1.GetPointer());
-		LabelImageType * img2t = dynamic_cast<LabelImageType*>(img2.GetPointer());
-		auto filter = itk::LabelOverlapMeasuresImageFilter<LabelImageType>::New();
-		filter->SetSourceImage(img1t);
-		filter->SetTargetImage(img2t);
-		filter->Update();
-		meanOverlap = filter->GetMeanOverlap();
-		/*
-		// not working at the moment for larger images:
-		iAImageComparisonResult r = CompareImages(img1, img2);
-		meanOverlap = r.equalPixelRate;
-		*/
-	}
-	catch (itk::ExceptionObject & e)
-	{
-		LOG(lvlError, QString("itk Exception: %1\n").arg(e.GetDescription()));
-		return 0.0;
-	}
+	double meanOverlap = iALabelOverlapMeasures(img1, img2).meanOverlap();
 	if (qIsNaN(meanOverlap))
 	{
 		LOG(lvlError, "ERROR: CalcDistance -> NAN!");
@@ -285,51 +262,64 @@ void iAImageClusterer::run()
 #ifdef CLUSTER_DEBUGGING
 	std::ofstream distFile("cluster-debugging.txt");
 #endif
+	// load each label image only once, and keep it in compressed form (typically more than
+	// 10 times smaller than the int image) for the pairwise distance computations:
+	std::vector<iACompressedLabelImage> compressedImages(m_images.size());
+	for (qsizetype i = 0; i < m_images.size() && !m_aborted; ++i)
+	{
+		m_progress->setStatus(QString("Loading and compressing label image %1 of %2").arg(i).arg(m_images.size()));
+		ClusterImageType img = m_images[i]->GetRepresentativeImage(
+			iARepresentativeType::Difference, LabelImagePointer()).GetPointer();
+		if (!img)
+		{
+			LOG(lvlError, QString("Could not load label image for result with id %1. Aborting clustering!").arg(i));
+			m_aborted = true;
+			return;
+		}
+		try
+		{
+			compressedImages[i] = iACompressedLabelImage::create(img);
+		}
+		catch (std::exception const & e)
+		{
+			LOG(lvlError, QString("Could not compress label image for result with id %1: %2. Aborting clustering!").arg(i).arg(e.what()));
+			m_aborted = true;
+			return;
+		}
+		img = nullptr;
+		m_images[i]->DiscardDetails();
+	}
 	for (m_currImage=0; m_currImage<m_images.size() && !m_aborted; ++m_currImage)
 	{
 		m_progress->setStatus(QString("Calculating distances for image pairs, image ") + QString::number(m_currImage) +
 			" of " + QString::number(m_images.size()));
 		// assuming here that the metric is symmetric
-#ifdef CLUSTER_DEBUGGING
-		std::ostringstream distFileLine;
-		distFileLine << m_currImage << ":";
-#endif
-		for (int j=m_currImage+1; j<m_images.size() && !m_aborted; ++j)
+		int const imageCount = static_cast<int>(m_images.size());
+		int const curImage = static_cast<int>(m_currImage);
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int j=curImage+1; j<imageCount; ++j)
 		{
-			ClusterImageType img1 = m_images[m_currImage]->GetRepresentativeImage(
-				iARepresentativeType::Difference, LabelImagePointer()).GetPointer();
-			ClusterImageType img2 = m_images[j]->GetRepresentativeImage(
-				iARepresentativeType::Difference, LabelImagePointer()).GetPointer();
-			float distance = 1.0;
-			if (!img1 || !img2)
-			{
-				LOG(lvlError, QString("Could not load label image for result with id %1 or %2. Aborting clustering!").arg(m_currImage).arg(j));
-				m_aborted = true;
-				return;
-			}
-			else
+			if (m_aborted)
 			{
-				distance = CalcDistance(img1, img2);
+				continue;
 			}
+			float distance = CalcDistance(compressedImages[curImage], compressedImages[j]);
 			if (qIsNaN(distance))
 			{
 				LOG(lvlError, QString("ERROR: %1, %2 -> NAN!")
-					.arg(m_currImage)
+					.arg(curImage)
 					.arg(j));
 				distance = 1.0;
 			}
-			// itk unloads images after filter is applied to them
-			// (which at the moment happens in CalcDistance)
-			// so we can just discard the smart pointers here,
-			// the images need to be reloaded anyway!
-			m_images[j]->DiscardDetails();
-			m_images[m_currImage]->DiscardDetails();
-			distances.SetValue(m_currImage, j, distance);
-#ifdef CLUSTER_DEBUGGING
-			distFileLine<<" "<<j<<":"<<distance;
-#endif
+			distances.SetValue(curImage, j, distance);  // distinct entries per j, so no synchronization required
 		}
 #ifdef CLUSTER_DEBUGGING
+		std::ostringstream distFileLine;
+		distFileLine << m_currImage << ":";
+		for (int j = curImage + 1; j < imageCount; ++j)
+		{
+			distFileLine<<" "<<j<<":"<<distances.GetValue(curImage, j);
+		}
 		distFile << distFileLine.str() << std::endl;
 #endif
 		m_progress->emitProgress(SplitFactorDistanceCalc *
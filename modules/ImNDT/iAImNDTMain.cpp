@@ -606,10 +606,10 @@ void iAImNDTMain::pickFibersinRegion(double eventPosition[3], double eventOrient
 void iAImNDTMain::pickFibersinRegion(vtkIdType leafRegion)
 {
 	std::vector<size_t> selection = std::vector<size_t>();
-	for (auto const & fiber : *m_fiberCoverageCalc->getObjectCoverage()->at(m_currentOctreeLevel).at(leafRegion))
+	for (auto const & fiber : m_fiberCoverageCalc->getObjectCoverage()->at(m_currentOctreeLevel).at(leafRegion))
 	{
-		//LOG(lvlImportant,QString("Nr. [%1]").arg(fiber.first));
-		selection.push_back(fiber.first);
+		//LOG(lvlImportant,QString("Nr. [%1]").arg(fiber.objectID));
+		selection.push_back(fiber.objectID);
 	}
 	std::sort(selection.begin(), selection.end());
 
@@ -662,9 +662,9 @@ void iAImNDTMain::multiPickMiMRegion()
 
 		for (size_t i = 0; i < m_multiPickIDs.size(); i++)
 		{
-			for (auto const & fiber : *m_fiberCoverageCalc->getObjectCoverage()->at(m_currentOctreeLevel).at(m_multiPickIDs.at(i)))
+			for (auto const & fiber : m_fiberCoverageCalc->getObjectCoverage()->at(m_currentOctreeLevel).at(m_multiPickIDs.at(i)))
 			{
-				selection.push_back(fiber.first);
+				selection.push_back(fiber.objectID);
 			}
 		}
 
@@ -102,7 +102,7 @@ void iAVRCubicVis::hide()
 	m_visible = false;
 }
 
-void iAVRCubicVis::setFiberCoverageData(std::vector<std::vector<std::unordered_map<vtkIdType, double>*>> const * fiberCoverage)
+void iAVRCubicVis::setFiberCoverageData(iAVRObjectCoverageData const * fiberCoverage)
 {
 	m_fiberCoverage = fiberCoverage;
 }
@@ -282,7 +282,7 @@ void iAVRCubicVis::calculateStartPoints()
 		//if(m_octree->getLevel() == 2) text.show();
 
 		//If regions have no coverage resize this 'empty' cube to zero
-		if (!m_fiberCoverage->at(m_octree->getLevel()).at(i)->empty()) {
+		if (!m_fiberCoverage->at(m_octree->getLevel()).at(i).empty()) {
 			double regionSize[3];
 			m_octree->calculateOctreeRegionSize(i, regionSize);
 			m_glyphScales->InsertNextTuple3(regionSize[0], regionSize[1], regionSize[2]);
@@ -2,14 +2,13 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #pragma once
 
+#include "iAVRLevelCoverage.h"
 #include "iAVROctree.h"
 
 #include <vtkSmartPointer.h>
 
 #include <QColor>
 
-#include <unordered_map>
-
 class vtkActor;
 class vtkDoubleArray;
 class vtkGlyph3D;
@@ -30,7 +29,7 @@ public:
 	//! Hides the cubes
 	void hide();
 	//! Sets the fiber coverage data, which is a vector for every octree level and each region, in which every fiber is stored with its coverage in that particular region.
-	void setFiberCoverageData(std::vector<std::vector<std::unordered_map<vtkIdType, double>*>> const * fiberCoverage);
+	void setFiberCoverageData(iAVRObjectCoverageData const * fiberCoverage);
 	//! Returns the Actor for the glyphs
 	vtkSmartPointer<vtkActor> getActor();
 	//! Returns the vtkPolyData for the center points of the glyphs
@@ -78,7 +77,7 @@ protected:
 	vtkSmartPointer<vtkDoubleArray> m_glyphScales;
 	vtkSmartPointer<vtkUnsignedCharArray> m_glyphColor;
 	//Stores for the [octree level] in an [octree region] a map of its fiberIDs with their coverage
-	std::vector<std::vector<std::unordered_map<vtkIdType, double>*>> const * m_fiberCoverage;
+	iAVRObjectCoverageData const * m_fiberCoverage;
 	//Currently selected cubes
 	std::vector<vtkIdType> m_activeRegions;
 	std::vector<QColor> m_activeColors;
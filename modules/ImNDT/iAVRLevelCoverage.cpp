@@ -0,0 +1,86 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iAVRLevelCoverage.h"
+
+#include <algorithm>
+
+iAVRLevelCoverage::iAVRLevelCoverage(size_t regionCount) :
+	m_offsets(regionCount + 1, 0)
+{}
+
+iAVRLevelCoverage::iAVRLevelCoverage(size_t regionCount, std::vector<std::vector<iAContribution>> const& contributions) :
+	m_offsets(regionCount + 1, 0)
+{
+	// counting sort of the contributions by region; regionStart[r] is the start of region r in the scattered array:
+	std::vector<size_t> regionStart(regionCount + 1, 0);
+	for (auto const& list : contributions)
+	{
+		for (auto const& c : list)
+		{
+			++regionStart[c.region + 1];
+		}
+	}
+	for (size_t r = 0; r < regionCount; ++r)
+	{
+		regionStart[r + 1] += regionStart[r];
+	}
+	std::vector<iAVRCoverageEntry> scattered(regionStart[regionCount]);
+	auto insertPos = regionStart;
+	for (auto const& list : contributions)
+	{
+		for (auto const& c : list)
+		{
+			scattered[insertPos[c.region]++] = iAVRCoverageEntry{ c.objectID, c.coverage };
+		}
+	}
+
+	// sort the entries of each region by object ID and sum up the contributions of the same object;
+	// the sort is stable so that the coverage is summed in the order it was computed in:
+	std::vector<size_t> entryCount(regionCount, 0);
+#pragma omp parallel for schedule(dynamic, 16)
+	for (vtkIdType r = 0; r < static_cast<vtkIdType>(regionCount); ++r)
+	{
+		auto begin = scattered.begin() + regionStart[r];
+		auto end = scattered.begin() + regionStart[r + 1];
+		std::stable_sort(begin, end, [](iAVRCoverageEntry const& a, iAVRCoverageEntry const& b)
+			{
+				return a.objectID < b.objectID;
+			});
+		auto out = begin;
+		for (auto it = begin; it != end; ++it)
+		{
+			if (out != begin && (out - 1)->objectID == it->objectID)
+			{
+				(out - 1)->coverage += it->coverage;
+			}
+			else
+			{
+				*out++ = *it;
+			}
+		}
+		entryCount[r] = out - begin;
+	}
+
+	// compact the merged entries into the final layout:
+	for (size_t r = 0; r < regionCount; ++r)
+	{
+		m_offsets[r + 1] = m_offsets[r] + entryCount[r];
+	}
+	m_entries.resize(m_offsets[regionCount]);
+#pragma omp parallel for schedule(dynamic, 16)
+	for (vtkIdType r = 0; r < static_cast<vtkIdType>(regionCount); ++r)
+	{
+		auto begin = scattered.begin() + regionStart[r];
+		std::copy(begin, begin + entryCount[r], m_entries.begin() + m_offsets[r]);
+	}
+}
+
+iAVRCoverageEntry const* iAVRLevelCoverage::find(size_t region, vtkIdType objectID) const
+{
+	auto entries = at(region);
+	auto it = std::lower_bound(entries.begin(), entries.end(), objectID, [](iAVRCoverageEntry const& e, vtkIdType id)
+		{
+			return e.objectID < id;
+		});
+	return (it != entries.end() && it->objectID == objectID) ? &(*it) : nullptr;
+}
@@ -0,0 +1,62 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <vtkType.h>
+
+#include <span>
+#include <vector>
+
+//! Coverage of one object in an octree region
+struct iAVRCoverageEntry
+{
+	vtkIdType objectID;   //!< row of the object in the object table
+	double coverage;      //!< part of the object (0..1) inside the region
+};
+
+//! The coverage of all objects in one region of an octree level, sorted by object ID
+using iAVRRegionCoverage = std::span<iAVRCoverageEntry const>;
+
+//! Coverage of the objects in all regions of one octree level, stored in compressed sparse row (CSR) layout:
+//! the entries of all regions lie in one contiguous array, region after region, and the entries of
+//! region r are the ones in [m_offsets[r], m_offsets[r+1]).
+class iAVRLevelCoverage
+{
+public:
+	//! A (partial) coverage of an object in a region, as collected during the coverage computation
+	struct iAContribution
+	{
+		vtkIdType region;
+		vtkIdType objectID;
+		double coverage;
+	};
+	//! create the coverage for a level with the given number of regions, without any objects
+	explicit iAVRLevelCoverage(size_t regionCount = 0);
+	//! create the coverage for a level from (unordered) contributions, e.g. one list collected per thread;
+	//! multiple contributions of the same object to the same region are summed up
+	iAVRLevelCoverage(size_t regionCount, std::vector<std::vector<iAContribution>> const& contributions);
+	//! number of regions in the level
+	size_t size() const
+	{
+		return m_offsets.size() - 1;
+	}
+	//! the objects in the given region, with their coverage
+	iAVRRegionCoverage at(size_t region) const
+	{
+		return iAVRRegionCoverage(m_entries.data() + m_offsets[region], m_offsets[region + 1] - m_offsets[region]);
+	}
+	//! the coverage entry for the given object in the given region, or nullptr if the object does not cover the region
+	iAVRCoverageEntry const* find(size_t region, vtkIdType objectID) const;
+	//! total number of (region, object) entries over all regions
+	size_t entryCount() const
+	{
+		return m_entries.size();
+	}
+
+private:
+	std::vector<size_t> m_offsets;
+	std::vector<iAVRCoverageEntry> m_entries;
+};
+
+//! Coverage of objects for each octree level (index = level)
+using iAVRObjectCoverageData = std::vector<iAVRLevelCoverage>;
@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #pragma once
 
+#include "iAVRLevelCoverage.h"
+
 #include <vtkType.h>
 
 #include <vtkSmartPointer.h>
@@ -17,7 +19,7 @@ class iAVRMetrics
 {
 public:
 	iAVRMetrics(vtkTable* objectTable, std::vector<iAVROctree*> const & octrees);
-	void setFiberCoverageData(std::vector<std::vector<std::unordered_map<vtkIdType, double>*>> const * fiberCoverage);
+	void setFiberCoverageData(iAVRObjectCoverageData const * fiberCoverage);
 	vtkIdType getNumberOfFeatures();
 	QString getFeatureName(vtkIdType feature);
 
@@ -30,8 +32,8 @@ protected:
 	//Stores the for a [feature] the [0] min and the [1] max value from the csv file
 	static std::vector<std::vector<double>>* m_minMaxValues;
 
-	//Stores for the [octree level] in an [octree region] a map of its fiberIDs with their coverage
-	std::vector<std::vector<std::unordered_map<vtkIdType, double>*>> const * m_fiberCoverage;
+	//Stores for the [octree level] in an [octree region] its fiberIDs with their coverage
+	iAVRObjectCoverageData const * m_fiberCoverage;
 	vtkSmartPointer<vtkTable> m_objectTable;
 	std::vector<iAVROctree*> const & m_octrees;
 
@@ -11,14 +11,14 @@
 
 #include <vtkOctreePointLocator.h>
 #include <vtkPointData.h>
-#include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkTable.h>
 
+#include <omp.h>
+
 iAVRObjectCoverage::iAVRObjectCoverage(vtkTable* objectTable, iAColMapP mapping, iACsvConfig csvConfig, std::vector<iAVROctree*> const & octrees, iAVRObjectModel* volume)
 	: m_objectTable(objectTable), m_mapping(mapping), m_csvConfig(csvConfig), m_octrees(octrees), m_volume(volume), m_objectCoverage()
 {
-	initialize();
 }
 
 //! Computes the coverage of objects in every octree level and region.
@@ -43,7 +43,7 @@ void iAVRObjectCoverage::calculateObjectCoverage()
 	//printObjectCoverage();
 }
 
-std::vector<std::vector<std::unordered_map<vtkIdType, double>*>> const * iAVRObjectCoverage::getObjectCoverage()
+iAVRObjectCoverageData const * iAVRObjectCoverage::getObjectCoverage()
 {
 	return &m_objectCoverage;
 }
@@ -67,19 +67,43 @@ vtkIdType iAVRObjectCoverage::getObjectiD(vtkIdType polyPoint)
 	}
 }
 
-void iAVRObjectCoverage::initialize()
+//! Computes the coverage of all objects for every octree level, in parallel over the objects.
+//! objectCoverage(row, level, contributions) has to add the coverage of the object in the given row
+//! to the regions of the given level (level > 0) to contributions; it is called concurrently for different objects.
+//! Every thread collects the contributions of its objects separately, they are merged when building the level's coverage.
+template <typename ObjectCoverageFunc>
+void iAVRObjectCoverage::computeCoverage(ObjectCoverageFunc objectCoverage)
 {
-	//Initialize new Vectors
-	for (size_t level = 0; level < m_octrees.size(); level++)
+	m_objectCoverage.clear();
+	if (m_octrees.empty())
+	{
+		return;
+	}
+	vtkIdType const objectCount = m_objectTable->GetNumberOfRows();
+
+	//Skip intersection test on lowest Octree level - every object is 100% in the one region
+	std::vector<std::vector<iAVRLevelCoverage::iAContribution>> levelZero(1);
+	levelZero[0].reserve(objectCount);
+	for (vtkIdType row = 0; row < objectCount; ++row)
 	{
-		//Initialize the region vec for every level
-		m_objectCoverage.push_back(std::vector<std::unordered_map<vtkIdType, double>*>());
+		levelZero[0].push_back(iAVRLevelCoverage::iAContribution{ 0, row, 1.0 });
+	}
+	m_objectCoverage.push_back(iAVRLevelCoverage(m_octrees.at(0)->getNumberOfLeafNodes(), levelZero));
 
-		for (vtkIdType i = 0; i < m_octrees.at(level)->getNumberOfLeafNodes(); i++)
+	for (size_t level = 1; level < m_octrees.size(); level++)
+	{
+		std::vector<std::vector<iAVRLevelCoverage::iAContribution>> threadContributions(omp_get_max_threads());
+#pragma omp parallel
 		{
-			//Initialize a vec of Maps for every region
-			m_objectCoverage.at(level).push_back(new std::unordered_map<vtkIdType, double>());
+			auto& contributions = threadContributions[omp_get_thread_num()];
+#pragma omp for schedule(dynamic, 64)
+			for (vtkIdType row = 0; row < objectCount; ++row)
+			{
+				objectCoverage(row, static_cast<vtkIdType>(level), contributions);
+			}
 		}
+		m_objectCoverage.push_back(iAVRLevelCoverage(m_octrees.at(level)->getNumberOfLeafNodes(), threadContributions));
+		m_octrees.at(level)->getRegionsInLineOfRay();
 	}
 }
 
@@ -87,90 +111,60 @@ void iAVRObjectCoverage::initialize()
 //! Calculates possible intersection between start- and endpoint with the bounding box of the octree regions.
 void iAVRObjectCoverage::calculateLineCoverage()
 {
-	// For every fiber in csv table
-	for (vtkIdType row = 0; row < m_objectTable->GetNumberOfRows(); ++row)
+	// the object table is only read serially, the per-object computation runs in parallel
+	vtkIdType const objectCount = m_objectTable->GetNumberOfRows();
+	std::vector<double> startPos(3 * objectCount), endPos(3 * objectCount), lineLength(objectCount);
+	for (vtkIdType row = 0; row < objectCount; ++row)
 	{
-		double startPos[3]{}, endPos[3]{};
 		for (int k = 0; k < 3; ++k)
 		{
-			startPos[k] = m_objectTable->GetValue(row, m_mapping->value(iACsvConfig::StartX + k)).ToFloat();
-			endPos[k] = m_objectTable->GetValue(row, m_mapping->value(iACsvConfig::EndX + k)).ToFloat();
-		}
-
-		//For every Octree Level
-		//for (int level = OCTREE_MIN_LEVEL; level <= 1; level++)
-		for (size_t level = 0; level < m_octrees.size(); level++)
-		{
-			//Skip intersection test on lowest Octree level
-			if (level == 0)
-			{
-				//Every fiber is 100% in the one region
-				m_objectCoverage.at(0).at(0)->insert(std::make_pair(row, 1.0));
-			}
-			else
-			{
-				double lineLength = m_objectTable->GetValue(row, m_mapping->value(iACsvConfig::Length)).ToFloat();
-
-				getOctreeFiberCoverage(startPos, endPos, level, row, lineLength);
-
-			}
+			startPos[3 * row + k] = m_objectTable->GetValue(row, m_mapping->value(iACsvConfig::StartX + k)).ToFloat();
+			endPos[3 * row + k] = m_objectTable->GetValue(row, m_mapping->value(iACsvConfig::EndX + k)).ToFloat();
 		}
+		lineLength[row] = m_objectTable->GetValue(row, m_mapping->value(iACsvConfig::Length)).ToFloat();
 	}
 
-	for (size_t level = 1; level < m_octrees.size(); level++)
-	{
-		m_octrees.at(level)->getRegionsInLineOfRay();
-	}
+	computeCoverage([&](vtkIdType row, vtkIdType level, std::vector<iAVRLevelCoverage::iAContribution>& contributions)
+		{
+			double start[3] = { startPos[3 * row], startPos[3 * row + 1], startPos[3 * row + 2] };
+			double end[3] = { endPos[3 * row], endPos[3 * row + 1], endPos[3 * row + 2] };
+			getOctreeFiberCoverage(start, end, level, row, lineLength[row], contributions);
+		});
 }
 
 //! Computes the coverage of line objects (including optional additional sample points) for every octree level and region.
 //! Calculates possible intersection between parts of the line (formed by two points) with the bounding box of the octree regions.
 void iAVRObjectCoverage::calculateCurvedLineCoverage()
 {
-	// For every fiber in csv table
-	for (vtkIdType row = 0; row < m_objectTable->GetNumberOfRows(); ++row)
+	// Only use Curved Length where curved is 1 and for the remaining Straight length
+	vtkIdType const objectCount = m_objectTable->GetNumberOfRows();
+	std::vector<double> lineLength(objectCount);
+	for (vtkIdType row = 0; row < objectCount; ++row)
 	{
-		//For every Octree Level
-		for (size_t level = 0; level < m_octrees.size(); level++)
+		if (m_objectTable->GetValue(row, 13).ToInt())
 		{
-			//Skip intersection test on lowest Octree level
-			if (level == 0)
-			{
-				//Every fiber is 100% in the one region
-				m_objectCoverage.at(0).at(0)->insert(std::make_pair(row, 1.0));
-			}
-			else
-			{
-				// Only use Curved Length where curved is 1 and for the remaining Straight length
-				double lineLength = 0;
-
-				if(m_objectTable->GetValue(row, 13).ToInt())
-				{
-					lineLength = m_objectTable->GetValue(row, 8).ToFloat(); // Curved Length
-				}
-				else
-				{
-					lineLength = m_objectTable->GetValue(row, m_mapping->value(iACsvConfig::Length)).ToFloat();
-				}
-
-				auto endPointID = m_volume->getPolyObject()->objectStartPointIdx(row) + m_volume->getPolyObject()->objectPointCount(row);
-
-				for (auto pointID = m_volume->getPolyObject()->objectStartPointIdx(row); pointID < endPointID - 1; ++pointID)
-				{
-					double startPos[3]{}, endPos[3]{};
-					m_volume->getPolyObject()->polyData()->GetPoint(pointID, startPos);
-					m_volume->getPolyObject()->polyData()->GetPoint(pointID+1, endPos);
-
-					getOctreeFiberCoverage(startPos, endPos, level, row, lineLength);
-				}
-			}
+			lineLength[row] = m_objectTable->GetValue(row, 8).ToFloat(); // Curved Length
+		}
+		else
+		{
+			lineLength[row] = m_objectTable->GetValue(row, m_mapping->value(iACsvConfig::Length)).ToFloat();
 		}
 	}
 
-	for (size_t level = 1; level < m_octrees.size(); level++)
-	{
-		m_octrees.at(level)->getRegionsInLineOfRay();
-	}
+	auto polyObject = m_volume->getPolyObject();
+	auto polyData = polyObject->polyData();
+	computeCoverage([&](vtkIdType row, vtkIdType level, std::vector<iAVRLevelCoverage::iAContribution>& contributions)
+		{
+			auto endPointID = polyObject->objectStartPointIdx(row) + polyObject->objectPointCount(row);
+			for (auto pointID = polyObject->objectStartPointIdx(row); pointID < endPointID - 1; ++pointID)
+			{
+				double startPos[3]{}, endPos[3]{};
+				polyData->GetPoint(pointID, startPos);
+				polyData->GetPoint(pointID + 1, endPos);
+
+				getOctreeFiberCoverage(startPos, endPos, level, row, lineLength[row], contributions);
+			}
+		});
 }
 
 //! Computes the coverage of ellipsoid objects for every octree level and region.
@@ -178,74 +172,58 @@ void iAVRObjectCoverage::calculateCurvedLineCoverage()
 //!  points within radius distance.
 void iAVRObjectCoverage::calculateEllipsoidCoverage()
 {
-	// For every pore in csv table
-	for (vtkIdType row = 0; row < m_objectTable->GetNumberOfRows(); ++row)
+	vtkIdType const objectCount = m_objectTable->GetNumberOfRows();
+	std::vector<double> centers(3 * objectCount), radii(3 * objectCount);
+	for (vtkIdType row = 0; row < objectCount; ++row)
 	{
-
-		double center[3]{}, radius[3]{};
 		for (vtkIdType k = 0; k < 3; ++k)
 		{
-			radius[k] = m_objectTable->GetValue(row, 13 + k).ToFloat();
-			center[k] = m_objectTable->GetValue(row, 18 + k).ToFloat();
+			radii[3 * row + k] = m_objectTable->GetValue(row, 13 + k).ToFloat();
+			centers[3 * row + k] = m_objectTable->GetValue(row, 18 + k).ToFloat();
 		}
+	}
 
-		//For every Octree Level
-		for (size_t level = 0; level < m_octrees.size(); level++)
+	computeCoverage([&](vtkIdType row, vtkIdType level, std::vector<iAVRLevelCoverage::iAContribution>& contributions)
 		{
-			//Skip intersection test on lowest Octree level
-			if (level == 0)
+			double const* radius = &radii[3 * row];
+			double center[3] = { centers[3 * row], centers[3 * row + 1], centers[3 * row + 2] };
+
+			double xMinus[3] = { center[0] - radius[0], center[1], center[2] };
+			double xPlus[3] = { center[0] + radius[0], center[1], center[2] };
+			double yMinus[3] = { center[0], center[1] - radius[1], center[2] };
+			double yPlus[3] = { center[0], center[1] + radius[1], center[2] };
+			double zMinus[3] = { center[0], center[1], center[2] - radius[2] };
+			double zPlus[3] = { center[0], center[1], center[2] + radius[2] };
+
+			double xSize = calculateLineCoverageRatio(xMinus, xPlus, 1.0);
+			double ySize = calculateLineCoverageRatio(yMinus, yPlus, 1.0);
+			double zSize = calculateLineCoverageRatio(zMinus, zPlus, 1.0);
+			double ellipseSize = xSize + ySize + zSize;
+
+			//Only if at least one radius is > 0
+			if (ellipseSize != 0)
 			{
-				//Every fiber is 100% in the one region
-				m_objectCoverage.at(0).at(0)->insert(std::make_pair(row, 1.0));
+				getOctreeFiberCoverage(center, xMinus, level, row, ellipseSize, contributions);
+				getOctreeFiberCoverage(center, xPlus, level, row, ellipseSize, contributions);
+				getOctreeFiberCoverage(center, yMinus, level, row, ellipseSize, contributions);
+				getOctreeFiberCoverage(center, yPlus, level, row, ellipseSize, contributions);
+				getOctreeFiberCoverage(center, zMinus, level, row, ellipseSize, contributions);
+				getOctreeFiberCoverage(center, zPlus, level, row, ellipseSize, contributions);
 			}
 			else
 			{
-
-				double xMinus[3] = { center[0] - radius[0], center[1], center[2] };
-				double xPlus[3] = { center[0] + radius[0], center[1], center[2] };
-				double yMinus[3] = { center[0], center[1] - radius[1], center[2] };
-				double yPlus[3] = { center[0], center[1] + radius[1], center[2] };
-				double zMinus[3] = { center[0], center[1], center[2] - radius[2] };
-				double zPlus[3] = { center[0], center[1], center[2] + radius[2] };
-
-				double xSize = calculateLineCoverageRatio(xMinus, xPlus, 1.0);
-				double ySize = calculateLineCoverageRatio(yMinus, yPlus, 1.0);
-				double zSize = calculateLineCoverageRatio(zMinus, zPlus, 1.0);
-				double ellipseSize = xSize + ySize + zSize;
-
-				//Only if at least one radius is > 0
-				if (ellipseSize != 0)
-				{
-					getOctreeFiberCoverage(center, xMinus, level, row, ellipseSize);
-					getOctreeFiberCoverage(center, xPlus, level, row, ellipseSize);
-					getOctreeFiberCoverage(center, yMinus, level, row, ellipseSize);
-					getOctreeFiberCoverage(center, yPlus, level, row, ellipseSize);
-					getOctreeFiberCoverage(center, zMinus, level, row, ellipseSize);
-					getOctreeFiberCoverage(center, zPlus, level, row, ellipseSize);
-				}
-				else
-				{
-					// ellipse is a single point
-					double eps = 0.00001;
-					getOctreeFiberCoverage(center, xMinus, level, row, eps);
-				}
-
-
+				// ellipse is a single point
+				double eps = 0.00001;
+				getOctreeFiberCoverage(center, xMinus, level, row, eps, contributions);
 			}
-		}
-	}
-
-	for (size_t level = 1; level < m_octrees.size(); level++)
-	{
-		m_octrees.at(level)->getRegionsInLineOfRay();
-	}
+		});
 }
 
-//! The calculated intersection points are returned as vtkPoints
-vtkSmartPointer<vtkPoints> iAVRObjectCoverage::getOctreeFiberCoverage(double startPoint[3], double endPoint[3], vtkIdType octreeLevel, vtkIdType fiber, double fiberLength)
+//! Adds the coverage of the part of the fiber between start- and endpoint in the regions of the given octree level to contributions.
+//! Only reads the octree, so it can be called concurrently.
+void iAVRObjectCoverage::getOctreeFiberCoverage(double startPoint[3], double endPoint[3], vtkIdType octreeLevel, vtkIdType fiber, double fiberLength,
+	std::vector<iAVRLevelCoverage::iAContribution>& contributions)
 {
-	auto additionalIntersectionPoints = vtkSmartPointer<vtkPoints>::New();
-
 	//m_octree->calculateOctree(octreeLevel, OCTREE_POINTS_PER_REGION);
 	vtkIdType leafNodes = m_octrees.at(octreeLevel)->getNumberOfLeafNodes();
 	vtkIdType startPointInsideRegion = m_octrees.at(octreeLevel)->getOctree()->GetRegionContainingPoint(startPoint[0], startPoint[1], startPoint[2]);
@@ -282,17 +260,16 @@ vtkSmartPointer<vtkPoints> iAVRObjectCoverage::getOctreeFiberCoverage(double sta
 			{
 				double coverage = calculateLineCoverageRatio(startPoint, endPoint, fiberLength);
 				pointsInRegion = 2;
-				storeObjectCoverage(octreeLevel, region, fiber, coverage);
-				return additionalIntersectionPoints; // whole fiber is in one region -> no intersection possible
+				contributions.push_back(iAVRLevelCoverage::iAContribution{ region, fiber, coverage });
+				return; // whole fiber is in one region -> no intersection possible
 			}
 			else if (startPointInsideRegion == region)
 			{
 				if (checkIntersectionWithBox(startPoint, endPoint, bounds, intersectionPoint))
 				{
-					additionalIntersectionPoints->InsertNextPoint(intersectionPoint);
 					double coverage = calculateLineCoverageRatio(startPoint, intersectionPoint, fiberLength);
 					pointsInRegion = 2;
-					storeObjectCoverage(octreeLevel, region, fiber, coverage);
+					contributions.push_back(iAVRLevelCoverage::iAContribution{ region, fiber, coverage });
 					break;
 				}
 				else
@@ -305,10 +282,9 @@ vtkSmartPointer<vtkPoints> iAVRObjectCoverage::getOctreeFiberCoverage(double sta
 			{
 				if (checkIntersectionWithBox(endPoint, startPoint, bounds, intersectionPoint))
 				{
-					additionalIntersectionPoints->InsertNextPoint(intersectionPoint);
 					double coverage = calculateLineCoverageRatio(intersectionPoint, endPoint, fiberLength);
 					pointsInRegion = 2;
-					storeObjectCoverage(octreeLevel, region, fiber, coverage);
+					contributions.push_back(iAVRLevelCoverage::iAContribution{ region, fiber, coverage });
 					break;
 				}
 				else
@@ -324,20 +300,16 @@ vtkSmartPointer<vtkPoints> iAVRObjectCoverage::getOctreeFiberCoverage(double sta
 				{
 					if (checkIntersectionWithBox(lastIntersection, endPoint, bounds, intersectionPoint))
 					{
-						additionalIntersectionPoints->InsertNextPoint(lastIntersection);
-						additionalIntersectionPoints->InsertNextPoint(intersectionPoint);
 						double coverage = calculateLineCoverageRatio(lastIntersection, intersectionPoint, fiberLength);
 						pointsInRegion = 2;
-						storeObjectCoverage(octreeLevel, region, fiber, coverage);
+						contributions.push_back(iAVRLevelCoverage::iAContribution{ region, fiber, coverage });
 						break;
 					}
 					else if (checkIntersectionWithBox(lastIntersection, startPoint, bounds, intersectionPoint))
 					{
-						additionalIntersectionPoints->InsertNextPoint(lastIntersection);
-						additionalIntersectionPoints->InsertNextPoint(intersectionPoint);
 						double coverage = calculateLineCoverageRatio(lastIntersection, intersectionPoint, fiberLength);
 						pointsInRegion = 2;
-						storeObjectCoverage(octreeLevel, region, fiber, coverage);
+						contributions.push_back(iAVRLevelCoverage::iAContribution{ region, fiber, coverage });
 						break;
 					}
 					else
@@ -365,8 +337,6 @@ vtkSmartPointer<vtkPoints> iAVRObjectCoverage::getOctreeFiberCoverage(double sta
 			}
 		}
 	}
-
-	return additionalIntersectionPoints;
 }
 
 //! Calculates the interesection of a line (start- to endpoint) with the six planes of a bounding box
@@ -445,23 +415,6 @@ double iAVRObjectCoverage::calculateLineCoverageRatio(double startPoint[3], doub
 	return ratio;
 }
 
-//! Stores the objects coverage into the map
-//! If the object has already a coverage in that specific region it gets summed up
-void iAVRObjectCoverage::storeObjectCoverage(vtkIdType octreeLevel, vtkIdType region, vtkIdType fiber, double coverage)
-{
-	auto it = m_objectCoverage.at(octreeLevel).at(region)->find(fiber);
-	if(it != m_objectCoverage.at(octreeLevel).at(region)->end())
-	{
-		it->second = it->second + coverage; // add additional coverage of this object in this region
-	}
-	else
-	{
-		m_objectCoverage.at(octreeLevel).at(region)->insert(std::make_pair(fiber, coverage)); // first coverage
-	}
-
-	//TODO CHECK if <1 ?
-}
-
 //! Checks if two pos arrays are the same
 bool iAVRObjectCoverage::checkEqualArrays(float pos1[3], float pos2[3])
 {
@@ -554,11 +507,11 @@ void iAVRObjectCoverage::printObjectCoverage()
 
 			for (size_t region = 0; region < m_objectCoverage.at(level).size(); region++)
 			{
-				auto it = m_objectCoverage.at(level).at(region)->find(row);
+				auto entry = m_objectCoverage.at(level).find(region, row);
 
-				if (it != m_objectCoverage.at(level).at(region)->end())
+				if (entry)
 				{
-					output.append(QString("  > Region %1 -- %2 \n").arg(region).arg(it->second));
+					output.append(QString("  > Region %1 -- %2 \n").arg(region).arg(entry->coverage));
 				}
 			}
 
@@ -233,9 +233,9 @@ void iAVRObjectModel::moveFibersbyAllCoveredRegions(double offset, bool relative
 
 	for (vtkIdType region = 0; region < m_octree->getNumberOfLeafNodes(); region++)
 	{
-		for (auto const & element : *m_fiberCoverage->at(m_octree->getLevel()).at(region))
+		for (auto const & element : m_fiberCoverage->at(m_octree->getLevel()).at(region))
 		{
-			iAVec3d currentPoint = iAVec3d(m_polyObject->finalPolyData()->GetPoint(element.first));
+			iAVec3d currentPoint = iAVec3d(m_polyObject->finalPolyData()->GetPoint(element.objectID));
 
 			iAVec3d regionCenterPoint = iAVec3d(m_glyph3D->GetPolyDataInput(0)->GetPoint(region));
 			iAVec3d normDirection = regionCenterPoint - centerPos;
@@ -244,11 +244,11 @@ void iAVRObjectModel::moveFibersbyAllCoveredRegions(double offset, bool relative
 
 			//Offset gets smaller with coverage
 			iAVec3d move = (relativeMovement)
-				? normDirection * offset * element.second * (currentLength / maxLength)
-				: normDirection * offset * element.second;
+				? normDirection * offset * element.coverage * (currentLength / maxLength)
+				: normDirection * offset * element.coverage;
 			iAVec3d newPoint = currentPoint + move;
 
-			m_polyObject->finalPolyData()->GetPoints()->SetPoint(element.first, newPoint.data());
+			m_polyObject->finalPolyData()->GetPoints()->SetPoint(element.objectID, newPoint.data());
 		}
 	}
 	m_polyObject->finalPolyData()->GetPoints()->GetData()->Modified();
@@ -419,7 +419,7 @@ void iAVRObjectModel::createRegionNodes(double maxFibersInRegions, double worldS
 
 	for (vtkIdType p = 0; p < regionNodes->GetNumberOfPoints(); p++)
 	{
-		double fibersInRegion = (double)(m_fiberCoverage->at(m_octree->getLevel()).at(p)->size());
+		double fibersInRegion = (double)(m_fiberCoverage->at(m_octree->getLevel()).at(p).size());
 		double sizeLog = 0;
 		double rgb[3] = { 0,0,0 };
 		if (fibersInRegion > 0)
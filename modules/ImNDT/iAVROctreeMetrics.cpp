@@ -2,9 +2,54 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iAVROctreeMetrics.h"
 
+#include <iABitSet.h>
+
 #include <vtkTable.h>
 #include <vtkVariant.h>
 
+namespace
+{
+	//! Counts the fibers contained in both regions; as both are sorted by fiber ID, one merge-like pass suffices
+	size_t sharedFiberCount(iAVRRegionCoverage fibersInRegion1, iAVRRegionCoverage fibersInRegion2)
+	{
+		if (fibersInRegion1.empty() || fibersInRegion2.empty() ||
+			fibersInRegion1.back().objectID < fibersInRegion2.front().objectID ||
+			fibersInRegion2.back().objectID < fibersInRegion1.front().objectID)
+		{
+			return 0;    // ID ranges do not overlap
+		}
+		size_t sizeIntersection = 0;
+		auto it1 = fibersInRegion1.begin();
+		auto it2 = fibersInRegion2.begin();
+		while (it1 != fibersInRegion1.end() && it2 != fibersInRegion2.end())
+		{
+			if (it1->objectID < it2->objectID)
+			{
+				++it1;
+			}
+			else if (it2->objectID < it1->objectID)
+			{
+				++it2;
+			}
+			else
+			{
+				++sizeIntersection;
+				++it1;
+				++it2;
+			}
+		}
+		return sizeIntersection;
+	}
+
+	//! Size of the intersection divided by the size of the union of two regions; 0 if one of them is empty
+	double jaccardIndex(double sizeRegion1, double sizeRegion2, double sizeIntersection)
+	{
+		if (sizeRegion1 == 0 || sizeRegion2 == 0) return 0.0;
+
+		return sizeIntersection / (sizeRegion1 + sizeRegion2 - sizeIntersection);
+	}
+}
+
 iAVROctreeMetrics::iAVROctreeMetrics(vtkTable* objectTable,	std::vector<iAVROctree*> const & octrees) : iAVRMetrics(objectTable, octrees),
 	m_maxCoverage(),
 	m_calculatedAverage(m_octrees.size(), std::vector<std::vector<double>>(numberOfFeatures, std::vector<double>())),
@@ -25,13 +70,13 @@ void iAVROctreeMetrics::calculateWeightedAverage(vtkIdType octreeLevel, vtkIdTyp
 			int fibersInRegion = 0;
 			//LOG(lvlDebug,QString(">>> REGION %1 <<<\n").arg(region));
 
-			for (auto const & element : *m_fiberCoverage->at(octreeLevel).at(region))
+			for (auto const & element : m_fiberCoverage->at(octreeLevel).at(region))
 			{
-				//LOG(lvlDebug,QString("[%1] --- %2 \%").arg(element.first).arg(element.second));
+				//LOG(lvlDebug,QString("[%1] --- %2 \%").arg(element.objectID).arg(element.coverage));
 
-				//double fiberAttribute = m_objectTable->GetValue(element.first, m_io.getOutputMapping()->value(feature)).ToFloat();
-				double fiberAttribute = m_objectTable->GetValue(element.first, feature).ToFloat();
-				double weightedAttribute = fiberAttribute * element.second;
+				//double fiberAttribute = m_objectTable->GetValue(element.objectID, m_io.getOutputMapping()->value(feature)).ToFloat();
+				double fiberAttribute = m_objectTable->GetValue(element.objectID, feature).ToFloat();
+				double weightedAttribute = fiberAttribute * element.coverage;
 
 				metricResultPerRegion += weightedAttribute;
 				fibersInRegion++;
@@ -86,9 +131,9 @@ std::vector<double> iAVROctreeMetrics::getRegionValues(vtkIdType octreeLevel, vt
 	auto fibersInRegion = m_fiberCoverage->at(octreeLevel).at(region);
 	std::vector<double> values = std::vector<double>();
 
-	for (auto const & fiber : *fibersInRegion)
+	for (auto const & fiber : fibersInRegion)
 	{
-		auto value = m_objectTable->GetValue(fiber.first, feature).ToFloat();
+		auto value = m_objectTable->GetValue(fiber.objectID, feature).ToFloat();
 		values.push_back(value);
 	}
 
@@ -149,13 +194,13 @@ void iAVROctreeMetrics::findBiggestCoverage(vtkIdType level, vtkIdType fiber)
 
 	for (size_t region = 0; region < m_fiberCoverage->at(level).size(); region++)
 	{
-		auto it = m_fiberCoverage->at(level).at(region)->find(fiber);
+		auto entry = m_fiberCoverage->at(level).find(region, fiber);
 		//If fiber has a coverage...
-		if (it != m_fiberCoverage->at(level).at(region)->end())
+		if (entry)
 		{
-			if (currentMaxCoverage < it->second)
+			if (currentMaxCoverage < entry->coverage)
 			{
-				currentMaxCoverage = it->second;
+				currentMaxCoverage = entry->coverage;
 				regionWithMaxCoverage = region;
 			}
 
@@ -169,27 +214,73 @@ void iAVROctreeMetrics::findBiggestCoverage(vtkIdType level, vtkIdType fiber)
 
 void iAVROctreeMetrics::calculateJaccardIndex(vtkIdType level)
 {
-	for (size_t region = 0; region < m_fiberCoverage->at(level).size(); region++)
+	auto const & levelCoverage = m_fiberCoverage->at(level);
+	vtkIdType const regionCount = static_cast<vtkIdType>(levelCoverage.size());
+	auto & jaccardValues = m_jaccardValues.at(level);
+
+	// a region is only similar to itself if it contains fibers:
+	jaccardValues.assign(regionCount, std::vector<double>(regionCount, 0.0));
+	for (vtkIdType region = 0; region < regionCount; ++region)
 	{
-		m_jaccardValues.at(level).push_back(std::vector<double>());
+		jaccardValues[region][region] = levelCoverage.at(region).empty() ? 0.0 : 1.0;
+	}
+	// If only one Region
+	if (regionCount == 1)
+	{
+		return;
+	}
 
-		// If only one Region
-		if (m_fiberCoverage->at(level).size() == 1)
+	// Regions containing at least one fiber per 64 fibers of the whole dataset are additionally represented as bitset,
+	// for intersecting them via popcount (such a bitset needs less memory than the region's coverage entries).
+	// For sparse regions, the sorted fiber list is used directly.
+	size_t const objectCount = m_objectTable->GetNumberOfRows();
+	std::vector<iABitSet> bitSets(regionCount);
+#pragma omp parallel for schedule(dynamic)
+	for (vtkIdType region = 0; region < regionCount; ++region)
+	{
+		auto fibers = levelCoverage.at(region);
+		if (!fibers.empty() && fibers.size() * iABitSet::WordBits >= objectCount)
 		{
-			m_jaccardValues.at(level).at(region).push_back(1);
-			return;
+			bitSets[region] = iABitSet(objectCount);
+			for (auto const & fiber : fibers)
+			{
+				bitSets[region].set(fiber.objectID);
+			}
 		}
+	}
 
-		for (size_t region2 = 0; region2 < m_fiberCoverage->at(level).size(); region2++)
+	// The index is symmetric, so only compute it for each unordered pair of regions
+#pragma omp parallel for schedule(dynamic)
+	for (vtkIdType region = 0; region < regionCount; ++region)
+	{
+		auto fibersInRegion1 = levelCoverage.at(region);
+		bool const dense1 = bitSets[region].size() > 0;
+		for (vtkIdType region2 = region + 1; region2 < regionCount; ++region2)
 		{
-			double index = 0;
-
-			index = calculateJaccardIndex(level, region, region2);
-
-			m_jaccardValues.at(level).at(region).push_back(index);
+			auto fibersInRegion2 = levelCoverage.at(region2);
+			bool const dense2 = bitSets[region2].size() > 0;
+			size_t sizeIntersection = 0;
+			if (dense1 && dense2)
+			{
+				sizeIntersection = bitSets[region].intersectionCount(bitSets[region2]);
+			}
+			else if (dense1 || dense2)
+			{
+				auto const & bitSet = dense1 ? bitSets[region] : bitSets[region2];
+				for (auto const & fiber : dense1 ? fibersInRegion2 : fibersInRegion1)
+				{
+					sizeIntersection += bitSet.test(fiber.objectID);
+				}
+			}
+			else
+			{
+				sizeIntersection = sharedFiberCount(fibersInRegion1, fibersInRegion2);
+			}
+			double index = jaccardIndex(fibersInRegion1.size(), fibersInRegion2.size(), sizeIntersection);
+			jaccardValues[region][region2] = index;
+			jaccardValues[region2][region] = index;
 
-			//LOG(lvlDebug,QString("jaccardValue for [%1][%2] is %3").arg(region).arg(region2).arg(test));
-			//LOG(lvlDebug,QString("Weighted jaccardValue for [%1][%2] is %3\n").arg(region).arg(region2).arg(m_jaccardValues->at(level).at(region).at(region2)));
+			//LOG(lvlDebug,QString("jaccardValue for [%1][%2] is %3").arg(region).arg(region2).arg(index));
 		}
 	}
 }
@@ -201,24 +292,7 @@ double iAVROctreeMetrics::calculateJaccardIndex(vtkIdType level, vtkIdType regio
 	auto fibersInRegion1 = m_fiberCoverage->at(level).at(region1);
 	auto fibersInRegion2 = m_fiberCoverage->at(level).at(region2);
 
-	double sizeRegion1 = fibersInRegion1->size();
-	double sizeRegion2 = fibersInRegion2->size();
-
-	if (sizeRegion1 == 0 || sizeRegion2 == 0) return 0.0;
-
-	double sizeintersection = 0;
-
-	for (auto const & fiber : *fibersInRegion1)
-	{
-		if (fibersInRegion2->count(fiber.first) == 1)
-		{
-			sizeintersection++;
-		}
-	}
-
-	double jaccard_index = sizeintersection / (sizeRegion1 + sizeRegion2 - sizeintersection);
-
-	return jaccard_index;
+	return jaccardIndex(fibersInRegion1.size(), fibersInRegion2.size(), sharedFiberCount(fibersInRegion1, fibersInRegion2));
 }
 
 double iAVROctreeMetrics::calculateWeightedJaccardIndex(vtkIdType level, vtkIdType region1, vtkIdType region2)
@@ -228,8 +302,8 @@ double iAVROctreeMetrics::calculateWeightedJaccardIndex(vtkIdType level, vtkIdTy
 	auto fibersInRegion1 = m_fiberCoverage->at(level).at(region1);
 	auto fibersInRegion2 = m_fiberCoverage->at(level).at(region2);
 
-	double sizeRegion1 = fibersInRegion1->size();
-	double sizeRegion2 = fibersInRegion2->size();
+	double sizeRegion1 = fibersInRegion1.size();
+	double sizeRegion2 = fibersInRegion2.size();
 	//double sizeShared = 0;
 
 	if (sizeRegion1 == 0 || sizeRegion2 == 0) return 0.0;
@@ -239,24 +313,30 @@ double iAVROctreeMetrics::calculateWeightedJaccardIndex(vtkIdType level, vtkIdTy
 	double sharedfibers = 0;
 
 	//Count in region 1 the shared fibers (to region2), save them combined and individual and then delete them...
-	for (auto const & fiber : *fibersInRegion1)
+	//(both regions are sorted by object ID, so the shared fibers are found in one merge-like pass)
+	auto it2 = fibersInRegion2.begin();
+	for (auto const & fiber : fibersInRegion1)
 	{
-		fibersOfRegion1 += fiber.second;
+		fibersOfRegion1 += fiber.coverage;
 
-		if (fibersInRegion2->count(fiber.first) == 1)
+		while (it2 != fibersInRegion2.end() && it2->objectID < fiber.objectID)
+		{
+			++it2;
+		}
+		if (it2 != fibersInRegion2.end() && it2->objectID == fiber.objectID)
 		{
 			//sizeShared++;
-			sharedfibers += fiber.second;
-			sharedfibers += fibersInRegion2->at(fiber.first);
+			sharedfibers += fiber.coverage;
+			sharedfibers += it2->coverage;
 		}
 	}
 
 	if (sharedfibers == 0) return 0.0; // nothing in common
 
 	//.. then sum up the remaining
-	for (auto const & fiber : *fibersInRegion2)
+	for (auto const & fiber : fibersInRegion2)
 	{
-		fibersOfRegion2 += fiber.second;
+		fibersOfRegion2 += fiber.coverage;
 	}
 
 	//Divide to stay between 0 and 1
@@ -283,7 +363,7 @@ void iAVROctreeMetrics::calculateMaxNumberOfFibersInRegion()
 
 		for (size_t region = 0; region < m_fiberCoverage->at(level).size(); region++)
 		{
-			auto fibers = m_fiberCoverage->at(level).at(region)->size();
+			auto fibers = m_fiberCoverage->at(level).at(region).size();
 
 			if (numberOfFibers < fibers) numberOfFibers = fibers;
 		}
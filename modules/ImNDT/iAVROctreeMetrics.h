@@ -46,7 +46,8 @@ private:
 	void calculateMaxCoverageFiberPerRegion();
 	//! Returns the biggest coverage value for a specific fiber over all regions at the given octree level
 	void findBiggestCoverage(vtkIdType level, vtkIdType fiber);
-	//! Iterates through all permutations of region pairs and calculates the jaccard index (calls calculateJaccardIndex with two distinct regions)
+	//! Calculates the jaccard index for all pairs of regions in the given level (in parallel, each unordered pair only once).
+	//! Dense regions are intersected as bitsets via popcount, sparse ones via their sorted fiber lists.
 	void calculateJaccardIndex(vtkIdType level);
 	//! Calculates the size of the intersection divided by the size of the union of the chosen regions;
 	//! calculated from the fiber intersection data.
@@ -99,6 +99,7 @@ CountType iAAccumulatedXRFData::spectraHistogramMax() const
 void iAAccumulatedXRFData::setFct(int fctIdx)
 {
 	m_accumulateFct = static_cast<AccumulateFct>(fctIdx);
+	invalidateLOD();
 }
 
 iAAccumulatedXRFData::DataType const * iAAccumulatedXRFData::avgData() const
@@ -6,9 +6,11 @@
 #include "iASamplingResults.h"
 
 #include <iAAttributeDescriptor.h>
+#include <iADataCache.h>
 #include <iALog.h>
 #include <iANameMapper.h>
 #include <iAToolsITK.h>
+#include <iATypedCallHelper.h>
 #include <iAFileUtils.h>
 #include <iAITKIO.h>
 
@@ -155,32 +157,54 @@ iASingleResult::iASingleResult(int id, iASamplingResults const & sampling):
 {
 }
 
-iAITKIO::ImagePointer const iASingleResult::labelImage()
+namespace
 {
-	if (!m_labelImg)
+	template <typename T>
+	void componentSize(size_t& size)
+	{
+		size = sizeof(T);
+	}
+
+	size_t imageBytes(iAITKIO::ImagePointer const& img)
 	{
-		loadLabelImage();
+		size_t size = 0;
+		ITK_TYPED_CALL(componentSize, itkScalarType(img), size);
+		return size * img->GetNumberOfComponentsPerPixel() * img->GetLargestPossibleRegion().GetNumberOfPixels();
+	}
+}
+
+iAITKIO::ImagePointer const iASingleResult::labelImage()
+{
+	if (m_labelImg)
+	{   // image set from a computation, not loaded from disk
+		return m_labelImg;
 	}
-	return m_labelImg;
+	return loadLabelImage();
 }
 
-bool iASingleResult::loadLabelImage()
+iAITKIO::ImagePointer iASingleResult::loadLabelImage()
 {
 	QFileInfo f(labelPath());
 	if (!f.exists() || f.isDir())
 	{
 		LOG(lvlError, QString("Label Image %1 does not exist, or is not a file!").arg(labelPath()));
-		return false;
+		return nullptr;
 	}
-	iAITKIO::PixelType pixelType;
-	iAITKIO::ScalarType scalarType;
-	m_labelImg = iAITKIO::readFile(labelPath(), pixelType, scalarType, false);
-	assert(pixelType == iAITKIO::PixelType::SCALAR);
-	if (scalarType != iAITKIO::ScalarType::INT)
-	{
-		m_labelImg = castImageTo<int>(m_labelImg);
-	}
-	return (m_labelImg);
+	// loaded images are kept in the shared cache; they stay there while the returned pointer is held,
+	// and afterwards as long as the memory budget allows
+	return iADataCache::get().load<iAITKIO::ImagePointer>(labelPath(), QVariantMap{{"Cast to", "int"}},
+		[this]()
+		{
+			iAITKIO::PixelType pixelType;
+			iAITKIO::ScalarType scalarType;
+			auto img = iAITKIO::readFile(labelPath(), pixelType, scalarType, false);
+			assert(pixelType == iAITKIO::PixelType::SCALAR);
+			if (scalarType != iAITKIO::ScalarType::INT)
+			{
+				img = castImageTo<int>(img);
+			}
+			return img;
+		}, imageBytes);
 }
 
 void iASingleResult::discardDetails()
@@ -213,23 +237,24 @@ void iASingleResult::setAttribute(int id, double value)
 
 iAITKIO::ImagePointer iASingleResult::probabilityImg(int label)
 {
-	if (m_probabilityImg.size() <= label)
-	{
-		m_probabilityImg.resize(label +1);
+	if (label < m_probabilityImg.size() && m_probabilityImg[label])
+	{   // image set from a computation, not loaded from disk
+		return m_probabilityImg[label];
 	}
-	if (!m_probabilityImg[label])
+	QString probFile(probabilityPath(label));
+	if (!QFile::exists(probFile))
 	{
-		QString probFile(probabilityPath(label));
-		if (!QFile::exists(probFile))
-		{
-			throw std::runtime_error(QString("File %1 does not exist!").arg(probFile).toStdString().c_str());
-		}
-		iAITKIO::PixelType pixelType;
-		iAITKIO::ScalarType scalarType;
-		m_probabilityImg[label] = iAITKIO::readFile(probFile, pixelType, scalarType, false);
-		assert(pixelType == iAITKIO::PixelType::SCALAR);
+		throw std::runtime_error(QString("File %1 does not exist!").arg(probFile).toStdString().c_str());
 	}
-	return m_probabilityImg[label];
+	return iADataCache::get().load<iAITKIO::ImagePointer>(probFile, QVariantMap(),
+		[&probFile]()
+		{
+			iAITKIO::PixelType pixelType;
+			iAITKIO::ScalarType scalarType;
+			auto img = iAITKIO::readFile(probFile, pixelType, scalarType, false);
+			assert(pixelType == iAITKIO::PixelType::SCALAR);
+			return img;
+		}, imageBytes);
 }
 
 QVector<ProbabilityImagePointer> iASingleResult::probabilityImgs(int labelCount)
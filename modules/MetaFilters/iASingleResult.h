@@ -36,11 +36,11 @@ public:
 	//! (such as can be passed into Create method above)
 	QString toString(std::shared_ptr<iAAttributes> attributes, int type);
 
-	//! retrieve labelled image
+	//! retrieve labelled image; images loaded from disk are held in the shared iADataCache
 	iAITKIO::ImagePointer const labelImage();
 
-	//! discards full detail images from memory
-	// TODO: check if that can be done automatically somehow
+	//! discards full detail images (set via setLabelImage) from memory;
+	//! loaded images are automatically discarded by iADataCache when no longer in use
 	void discardDetails();
 
 	void discardProbability();
@@ -78,7 +78,7 @@ private:
 	QVector<iAITKIO::ImagePointer> m_probabilityImg;
 	QString m_fileName;
 
-	bool loadLabelImage();
+	iAITKIO::ImagePointer loadLabelImage();
 
 	QString labelPath() const;
 	QString probabilityPath(int label) const;
@@ -2,75 +2,19 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iASegmentationMetrics.h"
 
+#include <iACompressedLabelImage.h>
 #include <iAImageData.h>
-#include <iALog.h>
-#include <iATypedCallHelper.h>
 
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wshorten-64-to-32"
-#endif
-#if __clang_major__ >= 10 || __GNUC__ >= 9
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wdeprecated-copy"
-#endif
-#include <itkLabelOverlapMeasuresImageFilter.h>
-#if __clang_major__ >= 10 || __GNUC__ >= 9
-#pragma GCC diagnostic pop
-#endif
-#ifdef __clang__
-#pragma clang diagnostic pop
-#endif
-
-template <typename ImagePixelType>
-void CalculateSegmentationMetrics(iAFilter* filter)
-{
-	typedef itk::Image<ImagePixelType, 3> ImageType;
-	typedef typename ImageType::Pointer ImagePointer;
-	typedef itk::LabelOverlapMeasuresImageFilter<ImageType > DiceFilterType;
-	auto diceFilter = DiceFilterType::New();
-	ImagePointer groundTruthPtr = dynamic_cast<ImageType*>(filter->imageInput(0)->itkImage());
-	ImagePointer segmentedPtr = dynamic_cast<ImageType*>(filter->imageInput(1)->itkImage());
-	if (!groundTruthPtr || !segmentedPtr)
-	{
-		LOG(lvlError, "Input images do not have the same type, but are required to!");
-		return;
-	}
-	diceFilter->SetSourceImage(groundTruthPtr);
-	diceFilter->SetTargetImage(segmentedPtr);
-	diceFilter->Update();
-
-	filter->addOutputValue("Total Overlap", diceFilter->GetTotalOverlap());
-	filter->addOutputValue("Union Overlap (Jaccard)", diceFilter->GetUnionOverlap());
-	filter->addOutputValue("Mean Overlap (Dice)", diceFilter->GetMeanOverlap());
-	filter->addOutputValue("Volume Similarity", diceFilter->GetVolumeSimilarity());
-	//filter->addOutputValue("False negatives", diceFilter->GetFalseNegativeError());
-	//filter->addOutputValue("False positives", diceFilter->GetFalsePositiveError());
-
-	auto labelMap = diceFilter->GetLabelSetMeasures();
-	for (auto it = labelMap.cbegin(); it != labelMap.cend(); ++it)
-	{
-		if ((*it).first == 0)
-		{
-			continue;
-		}
-		auto label = (*it).first;
-		filter->addOutputValue(QString("Label %1 Target Overlap").arg(label), diceFilter->GetTargetOverlap(label));
-		filter->addOutputValue(QString("Label %1 Union Overlap").arg(label), diceFilter->GetUnionOverlap(label));
-		filter->addOutputValue(QString("Label %1 Mean Overlap").arg(label), diceFilter->GetMeanOverlap(label));
-		filter->addOutputValue(QString("Label %1 Volume Similarity").arg(label), diceFilter->GetVolumeSimilarity(label));
-		//filter->addOutputValue(QString("Label %1 False negatives").arg(label), diceFilter->GetFalseNegativeError(label));
-		//filter->addOutputValue(QString("Label %1 False positives").arg(label), diceFilter->GetFalsePositiveError(label));
-	}
-}
 iASegmentationMetrics::iASegmentationMetrics() :
 	iAFilter("Segmentation Quality", "Metrics",
 		"Computes metrics for the quality of a segmentation as compared to a reference image.<br/>"
 		"The currently selected (=first) image is used as the image to be judged, "
-		"the additional input (=second) is used as reference image.<br/>"
-		"For more information, see the <a href="
+		"the additional input (=second) is used as reference image. "
+		"Both images need to be of an integer type (but not necessarily the same one).<br/>"
+		"The measures are the same as computed by the <a href="
 		"\"https://itk.org/Doxygen/html/classitk_1_1LabelOverlapMeasuresImageFilter.html\">"
-		"Label Overlap Measures Filter</a> in the ITK documentation.", 2, 0)
+		"Label Overlap Measures Filter</a> (see the ITK documentation for details); "
+		"they are computed on run-length compressed versions of the two images.", 2, 0)
 {
 	addOutputValue("Total Overlap");
 	addOutputValue("Union Overlap (Jaccard)");
@@ -80,18 +24,29 @@ iASegmentationMetrics::iASegmentationMetrics() :
 
 void iASegmentationMetrics::performWork(QVariantMap const & /*parameters*/)
 {
-	switch (inputScalarType())
-	{	// only int types, so ITK_TYPED_CALL won't work
-	case iAITKIO::ScalarType::UCHAR: CalculateSegmentationMetrics<unsigned char> (this); break;
-	case iAITKIO::ScalarType::CHAR:  CalculateSegmentationMetrics<char>          (this); break;
-	case iAITKIO::ScalarType::SHORT: CalculateSegmentationMetrics<short>         (this); break;
-	case iAITKIO::ScalarType::USHORT:CalculateSegmentationMetrics<unsigned short>(this); break;
-	case iAITKIO::ScalarType::INT:   CalculateSegmentationMetrics<int>           (this); break;
-	case iAITKIO::ScalarType::UINT:  CalculateSegmentationMetrics<unsigned int>  (this); break;
-	case iAITKIO::ScalarType::LONG:  CalculateSegmentationMetrics<long>          (this); break;
-	case iAITKIO::ScalarType::ULONG: CalculateSegmentationMetrics<unsigned long> (this); break;
-	default:
-		throw itk::ExceptionObject(__FILE__, __LINE__,
-			"Segmentation Metrics: Only Integer image types are allowed as input!");
+	// create() throws for non-integer image types:
+	auto groundTruth = iACompressedLabelImage::create(imageInput(0)->itkImage());
+	auto segmented = iACompressedLabelImage::create(imageInput(1)->itkImage());
+	iALabelOverlapMeasures measures(groundTruth, segmented);
+
+	addOutputValue("Total Overlap", measures.totalOverlap());
+	addOutputValue("Union Overlap (Jaccard)", measures.unionOverlap());
+	addOutputValue("Mean Overlap (Dice)", measures.meanOverlap());
+	addOutputValue("Volume Similarity", measures.volumeSimilarity());
+	//addOutputValue("False negatives", measures.falseNegativeError());
+	//addOutputValue("False positives", measures.falsePositiveError());
+
+	for (auto label : measures.labels())
+	{
+		if (label == 0)
+		{
+			continue;
+		}
+		addOutputValue(QString("Label %1 Target Overlap").arg(label), measures.targetOverlap(label));
+		addOutputValue(QString("Label %1 Union Overlap").arg(label), measures.unionOverlap(label));
+		addOutputValue(QString("Label %1 Mean Overlap").arg(label), measures.meanOverlap(label));
+		addOutputValue(QString("Label %1 Volume Similarity").arg(label), measures.volumeSimilarity(label));
+		//addOutputValue(QString("Label %1 False negatives").arg(label), measures.falseNegativeError(label));
+		//addOutputValue(QString("Label %1 False positives").arg(label), measures.falsePositiveError(label));
 	}
 }
@@ -46,6 +46,199 @@
 #include <QStatusBar>
 #include <QVBoxLayout>
 
+#include <algorithm>
+#include <cstdlib>    // for std::abs
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+	//! Sentinel distance for voxels which are never reached by dilating the specimen (i.e. if there is no specimen voxel)
+	constexpr quint32 Unreached = std::numeric_limits<quint32>::max();
+
+	//! Morphological closing of the specimen (mask value 0) in a thresholded mask, with the number of dilations chosen
+	//! such that at most regionCountGoal background regions (connected components of non-zero voxels) remain;
+	//! equivalent to dilating with a radius 1 ball (18-neighborhood) until the goal is reached, then eroding the
+	//! same number of times, but in a constant number of passes over the volume:
+	//!   1. one breadth-first distance transform yields the number of dilations d(v) after which each voxel v
+	//!      belongs to the specimen; after k dilations, the background consists of the voxels with d(v) > k;
+	//!   2. adding the voxels by decreasing distance to a union-find structure (face connectivity, as in
+	//!      itk::ConnectedComponentImageFilter) yields the number of background regions for all k at once;
+	//!   3. a second distance transform from the remaining background, limited to k steps, performs the erosions.
+	//! @param mask the thresholded mask (0 = specimen, non-zero = background)
+	//! @param out output mask (1 = closed specimen, 0 = background); needs to have the same size as mask
+	//! @param size the image dimensions
+	//! @param counts receives the number of background regions after 0, 1, ..., k dilations
+	//! @param canceled checked between the passes; computation is aborted if it becomes true
+	//! @return the number of dilations k, or -1 if canceled
+	template <typename IndexT>
+	int distanceClosing(unsigned short const* mask, unsigned short* out, size_t const size[3], int regionCountGoal,
+		std::vector<int>& counts, bool const& canceled)
+	{
+		IndexT const sx = static_cast<IndexT>(size[0]), sy = static_cast<IndexT>(size[1]), sz = static_cast<IndexT>(size[2]);
+		IndexT const voxelCount = sx * sy * sz;
+		IndexT const NotAdded = std::numeric_limits<IndexT>::max();
+
+		// calls func(neighbor) for all in-image neighbors of voxel v in the 18-neighborhood (radius 1 ball)
+		// or in the 6-neighborhood (face connectivity)
+		auto forNeighbors = [sx, sy, sz](IndexT v, bool faceOnly, auto func)
+		{
+			IndexT const x = v % sx, y = (v / sx) % sy, z = v / (sx * sy);
+			for (int dz = -1; dz <= 1; ++dz)
+			{
+				if ((dz < 0 && z == 0) || (dz > 0 && z == sz - 1))
+				{
+					continue;
+				}
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					if ((dy < 0 && y == 0) || (dy > 0 && y == sy - 1))
+					{
+						continue;
+					}
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						int const manhattan = std::abs(dx) + std::abs(dy) + std::abs(dz);
+						if (manhattan == 0 || manhattan > (faceOnly ? 1 : 2) ||
+							(dx < 0 && x == 0) || (dx > 0 && x == sx - 1))
+						{
+							continue;
+						}
+						func(v + dx + static_cast<std::make_signed_t<IndexT>>(sx) * dy +
+							static_cast<std::make_signed_t<IndexT>>(sx * sy) * dz);
+					}
+				}
+			}
+		};
+
+		// 1. distance transform; the queue of the breadth-first search is ordered by distance, and kept for step 2
+		std::vector<quint32> dist(voxelCount, Unreached);
+		std::vector<IndexT> queue;
+		queue.reserve(voxelCount);
+		for (IndexT v = 0; v < voxelCount; ++v)
+		{
+			if (mask[v] == 0)
+			{
+				dist[v] = 0;
+				queue.push_back(v);
+			}
+		}
+		for (size_t head = 0; head < queue.size(); ++head)
+		{
+			IndexT const v = queue[head];
+			forNeighbors(v, false, [&](IndexT n)
+				{
+					if (dist[n] == Unreached)
+					{
+						dist[n] = dist[v] + 1;
+						queue.push_back(n);
+					}
+				});
+		}
+		quint32 const maxDist = queue.empty() ? 0 : dist[queue.back()];
+		if (canceled)
+		{
+			return -1;
+		}
+
+		// 2. number of background regions regionCount[k] = components of {v : dist[v] > k}, for k = 0..maxDist
+		std::vector<IndexT> parent(voxelCount, NotAdded);
+		auto findRoot = [&parent](IndexT v)
+		{
+			while (parent[v] != v)
+			{
+				parent[v] = parent[parent[v]];  // path halving
+				v = parent[v];
+			}
+			return v;
+		};
+		qint64 components = 0;
+		auto add = [&](IndexT v)
+		{
+			parent[v] = v;
+			++components;
+			forNeighbors(v, true, [&](IndexT n)
+				{
+					if (parent[n] == NotAdded)
+					{
+						return;
+					}
+					IndexT r1 = findRoot(v), r2 = findRoot(n);
+					if (r1 != r2)
+					{
+						parent[std::max(r1, r2)] = std::min(r1, r2);
+						--components;
+					}
+				});
+		};
+		for (IndexT v = 0; v < voxelCount; ++v)
+		{
+			if (dist[v] == Unreached)
+			{
+				add(v);
+			}
+		}
+		std::vector<qint64> regionCount(maxDist + 1);
+		regionCount[maxDist] = components;
+		for (size_t i = queue.size(); i > 0 && dist[queue[i - 1]] > 0; --i)
+		{
+			IndexT const v = queue[i - 1];
+			add(v);
+			if (dist[queue[i - 2]] != dist[v])  // index valid since dist > 0 voxels are preceded by dist 0 voxels
+			{
+				regionCount[dist[v] - 1] = components;
+			}
+		}
+		parent = std::vector<IndexT>();
+		quint32 k = 0;
+		while (k < maxDist && regionCount[k] > regionCountGoal)
+		{
+			++k;
+		}
+		counts.clear();
+		for (quint32 i = 0; i <= k; ++i)
+		{
+			counts.push_back(static_cast<int>(std::min<qint64>(regionCount[i], std::numeric_limits<int>::max())));
+		}
+		if (canceled)
+		{
+			return -1;
+		}
+
+		// 3. erosion: voxels within k steps of the background remaining after k dilations are background again
+		queue.clear();
+		for (IndexT v = 0; v < voxelCount; ++v)
+		{
+			bool const background = dist[v] > k;
+			out[v] = background ? 0 : 1;
+			if (background)
+			{
+				queue.push_back(v);
+			}
+		}
+		std::fill(dist.begin(), dist.end(), Unreached);   // reused for the distance to the background
+		for (IndexT v : queue)
+		{
+			dist[v] = 0;
+		}
+		for (size_t head = 0; head < queue.size() && dist[queue[head]] < k; ++head)
+		{
+			IndexT const v = queue[head];
+			forNeighbors(v, false, [&](IndexT n)
+				{
+					if (dist[n] == Unreached)
+					{
+						dist[n] = dist[v] + 1;
+						out[n] = 0;
+						queue.push_back(n);
+					}
+				});
+		}
+		return static_cast<int>(k);
+	}
+}
+
 template <class T>
 void iANModalDilationBackgroundRemover::itkBinaryThreshold(iAConnector& conn, int loThresh, int upThresh)
 {
@@ -228,7 +421,9 @@ void iANModalDilationBackgroundRemover::showMask(ImagePointer itkImgPtr)
 }
 #endif
 
-iANModalDilationBackgroundRemover::iANModalDilationBackgroundRemover(iAMdiChild* mdiChild) : m_mdiChild(mdiChild)
+iANModalDilationBackgroundRemover::iANModalDilationBackgroundRemover(iAMdiChild* mdiChild, Mode mode) :
+	m_mdiChild(mdiChild),
+	m_mode(mode)
 {
 	m_colorTf = vtkSmartPointer<vtkLookupTable>::New();
 	m_colorTf->SetNumberOfTableValues(2);
@@ -425,7 +620,7 @@ bool iANModalDilationBackgroundRemover::iterativeDilation(ImagePointer mask, int
 	constexpr int PROGS = 3;
 	iAProgress* progs[PROGS] = {new iAProgress(), new iAProgress(), new iAProgress()};
 
-	auto thread = new iANModalIterativeDilationThread(pw, progs, mask, regionCountGoal);
+	auto thread = new iANModalIterativeDilationThread(pw, progs, mask, regionCountGoal, m_mode);
 	connect(thread, &iANModalIterativeDilationThread::addValue, plot, &iANModalIterativeDilationPlot::addValue);
 	connect(thread, &QThread::finished, thread, &QObject::deleteLater);
 	connect(thread, &QThread::finished, pw, &QObject::deleteLater);
@@ -458,14 +653,15 @@ bool iANModalDilationBackgroundRemover::iterativeDilation(ImagePointer mask, int
 // iANModalIterativeDilationThread
 // ----------------------------------------------------------------------------------------------
 
-iANModalIterativeDilationThread::iANModalIterativeDilationThread(
-	iANModalProgressWidget* progressWidget, iAProgress* progress[3], ImagePointer mask, int regionCountGoal) :
+iANModalIterativeDilationThread::iANModalIterativeDilationThread(iANModalProgressWidget* progressWidget,
+	iAProgress* progress[3], ImagePointer mask, int regionCountGoal, iANModalDilationBackgroundRemover::Mode mode) :
 	iANModalProgressUpdater(progressWidget),
 	m_progDil(progress[0]),
 	m_progCc(progress[1]),
 	m_progEro(progress[2]),
 	m_mask(mask),
-	m_regionCountGoal(regionCountGoal)
+	m_regionCountGoal(regionCountGoal),
+	m_mode(mode)
 {
 }
 
@@ -482,8 +678,50 @@ void iANModalIterativeDilationThread::setCanceled(bool c)
 	}
 #endif
 
+void iANModalIterativeDilationThread::distanceTransformClosing()
+{
+	typedef itk::Image<unsigned short, DIM> ImageType;
+	auto input = dynamic_cast<ImageType*>(m_mask.GetPointer());
+	auto region = input->GetLargestPossibleRegion();
+	auto output = ImageType::New();
+	output->SetRegions(region);
+	output->CopyInformation(input);
+	output->Allocate();
+
+	size_t const size[3] = {region.GetSize()[0], region.GetSize()[1], region.GetSize()[2]};
+	size_t const voxelCount = size[0] * size[1] * size[2];
+
+	emit setValue("status", 1);
+	IANMODAL_REQUIRE_NCANCELED();
+	std::vector<int> counts;
+	// 32 bit voxel indices halve the memory required for the index arrays, wherever they suffice
+	int dilationCount = (voxelCount < std::numeric_limits<quint32>::max())
+		? distanceClosing<quint32>(input->GetBufferPointer(), output->GetBufferPointer(), size, m_regionCountGoal, counts, m_canceled)
+		: distanceClosing<quint64>(input->GetBufferPointer(), output->GetBufferPointer(), size, m_regionCountGoal, counts, m_canceled);
+	IANMODAL_REQUIRE_NCANCELED();
+	for (int c : counts)
+	{
+		emit addValue(c);
+	}
+	emit setValue("dil", 100);
+	emit setValue("cc", 100);
+	emit setValue("ero", 100);
+	emit setValue("status", 2);
+	emit setText("ero", "Erosion (" + QString::number(dilationCount) + ")");
+	m_mask = output;
+
+	IANMODAL_REQUIRE_NCANCELED();
+	emit finish();
+}
+
 void iANModalIterativeDilationThread::run()
 {
+	if (m_mode == iANModalDilationBackgroundRemover::DistanceTransform)
+	{
+		distanceTransformClosing();
+		return;
+	}
+
 	int connectedComponents;
 
 	emit setValue("dil", 100);
@@ -52,12 +52,22 @@ private slots:
 	void setThreshold(int);
 };
 
+//! Removes the background via a morphological closing of a thresholded mask, with the number of
+//! dilations/erosions chosen such that only a given number of background regions remains.
 class iANModalDilationBackgroundRemover : public QObject, public iANModalBackgroundRemover
 {
 	Q_OBJECT
 
 public:
-	iANModalDilationBackgroundRemover(iAMdiChild* mdiChild);
+	enum Mode
+	{
+		//! determine the number of dilations for all possible counts at once from a distance transform of the
+		//! mask, then perform the closing via a second distance transform (constant number of passes)
+		DistanceTransform,
+		//! dilate and count connected components repeatedly until the goal is reached, then erode
+		Iterative
+	};
+	iANModalDilationBackgroundRemover(iAMdiChild* mdiChild, Mode mode = DistanceTransform);
 	Mask removeBackground(const QList<std::shared_ptr<iAImageData>>&) override;
 
 private:
@@ -69,6 +79,7 @@ private:
 	ImagePointer m_itkTempImg;
 
 	iAMdiChild* m_mdiChild;
+	Mode m_mode;
 
 	// return - true if a dataset and a threshold were successfully chosen
 	//        - false otherwise
@@ -113,7 +124,9 @@ private:
 	iAProgress* m_progEro;
 	ImagePointer m_mask;
 	int m_regionCountGoal;
+	iANModalDilationBackgroundRemover::Mode m_mode;
 
+	void distanceTransformClosing();
 	void itkDilateAndCountConnectedComponents(ImagePointer itkImgPtr, int& connectedComponents, bool dilate = true);
 	void itkCountConnectedComponents(ImagePointer itkImgPtr, int& connectedComponents);
 	void itkDilate(ImagePointer itkImgPtr);
@@ -122,8 +135,8 @@ private:
 	bool m_canceled = false;
 
 public:
-	iANModalIterativeDilationThread(
-		iANModalProgressWidget* progressWidget, iAProgress* progress[3], ImagePointer mask, int regionCountGoal);
+	iANModalIterativeDilationThread(iANModalProgressWidget* progressWidget, iAProgress* progress[3], ImagePointer mask,
+		int regionCountGoal, iANModalDilationBackgroundRemover::Mode mode);
 	void run() override;
 	ImagePointer mask()
 	{
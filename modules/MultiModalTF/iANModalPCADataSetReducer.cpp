@@ -19,10 +19,46 @@
 #include <itkImageRegionConstIterator.h>
 #include <itkImageRegionIterator.h>
 
+#include <vnl/algo/vnl_symmetric_eigensystem.h>
+
 #include <vtkImageData.h>
 
 #include <omp.h>    // for  omp_get_thread_num
 
+#include <algorithm>
+
+namespace
+{
+	//! number of voxels processed as one unit of work in streamingPCA
+	const qint64 SlabSize = 1 << 16;
+
+	//! Mean and co-moments (sums of products of the deviations from the mean) of n-dimensional samples.
+	//! Partial results (e.g. of different slabs) are merged with the pairwise update formulas by Chan et al.
+	struct iAMoments
+	{
+		explicit iAMoments(uint dim) : count(0), mean(dim, 0.0), comoments(dim, dim, 0.0)
+		{}
+		void merge(iAMoments const& other)
+		{
+			if (other.count == 0)
+			{
+				return;
+			}
+			double newCount = count + other.count;
+			vnl_vector<double> delta = other.mean - mean;
+			comoments += other.comoments + outer_product(delta, delta) * (count * other.count / newCount);
+			mean += delta * (other.count / newCount);
+			count = newCount;
+		}
+		double count;
+		vnl_vector<double> mean;
+		vnl_matrix<double> comoments;
+	};
+}
+
+iANModalPCADataSetReducer::iANModalPCADataSetReducer(Mode mode) : m_mode(mode)
+{}
+
 // Input datasets must have the exact same dimensions
 QList<std::shared_ptr<iAImageData>> iANModalPCADataSetReducer::reduce(
 	const QList<std::shared_ptr<iAImageData>>& dataSets_in)
@@ -39,7 +75,14 @@ QList<std::shared_ptr<iAImageData>> iANModalPCADataSetReducer::reduce(
 
 	// Go!
 	//ITK_TYPED_CALL(itkPCA, connectors[0].itkScalarType(), connectors);
-	ITK_TYPED_CALL(ownPCA, connectors[0].itkScalarType(), connectors);
+	if (m_mode == Streaming)
+	{
+		ITK_TYPED_CALL(streamingPCA, connectors[0].itkScalarType(), connectors);
+	}
+	else
+	{
+		ITK_TYPED_CALL(ownPCA, connectors[0].itkScalarType(), connectors);
+	}
 
 	// Set up output list
 	auto dataSets_out = QList<std::shared_ptr<iAImageData>>();
@@ -423,3 +466,168 @@ void iANModalPCADataSetReducer::ownPCA(std::vector<iAConnector>& c)
 		c[out_i].setImage(output);
 	}
 }
+
+template <class T>
+void iANModalPCADataSetReducer::streamingPCA(std::vector<iAConnector>& c)
+{
+	typedef itk::Image<T, DIM> ImageType;
+
+	assert(c.size() > 0);
+
+	iATimeGuard tg("Perform streaming PCA");
+
+	auto itkImg0 = c[0].itkImage();
+	auto size = itkImg0->GetBufferedRegion().GetSize();
+	qint64 numVoxels = 1;
+	for (unsigned int dim_i = 0; dim_i < DIM; dim_i++)
+	{
+		numVoxels *= size[dim_i];
+	}
+	uint numInputs = static_cast<uint>(c.size());
+	uint numOutputs = std::min(numInputs, maxOutputLength());
+	std::vector<T const*> inputs(numInputs);
+	for (uint i = 0; i < numInputs; i++)
+	{
+		inputs[i] = dynamic_cast<const ImageType*>(c[i].itkImage())->GetBufferPointer();
+	}
+	qint64 numSlabs = (numVoxels + SlabSize - 1) / SlabSize;
+
+	// Single pass: accumulate means and co-moments slab by slab. Within a slab, sums are computed
+	// relative to the slab's first voxel values, to avoid cancellation when computing the co-moments
+	iAMoments moments(numInputs);
+#pragma omp parallel
+	{
+		iAMoments threadMoments(numInputs);
+		iAMoments slabMoments(numInputs);
+		std::vector<double> shift(numInputs), dev(numInputs), sums(numInputs), prodSums(numInputs * numInputs);
+#pragma omp for schedule(dynamic)
+		for (qint64 slab = 0; slab < numSlabs; ++slab)
+		{
+			qint64 begin = slab * SlabSize, end = std::min(begin + SlabSize, numVoxels);
+			std::fill(sums.begin(), sums.end(), 0.0);
+			std::fill(prodSums.begin(), prodSums.end(), 0.0);
+			for (uint i = 0; i < numInputs; ++i)
+			{
+				shift[i] = inputs[i][begin];
+			}
+			for (qint64 v = begin; v < end; ++v)
+			{
+				for (uint i = 0; i < numInputs; ++i)
+				{
+					dev[i] = inputs[i][v] - shift[i];
+					sums[i] += dev[i];
+					for (uint j = 0; j <= i; ++j)
+					{
+						prodSums[i * numInputs + j] += dev[i] * dev[j];
+					}
+				}
+			}
+			double count = static_cast<double>(end - begin);
+			slabMoments.count = count;
+			for (uint i = 0; i < numInputs; ++i)
+			{
+				slabMoments.mean[i] = shift[i] + sums[i] / count;
+				for (uint j = 0; j <= i; ++j)
+				{
+					slabMoments.comoments[i][j] = slabMoments.comoments[j][i] = prodSums[i * numInputs + j] - sums[i] * sums[j] / count;
+				}
+			}
+			threadMoments.merge(slabMoments);
+		}
+#pragma omp critical
+		moments.merge(threadMoments);
+	}
+
+#ifndef NDEBUG
+	DebugLogVector(moments.mean, "Means");
+#endif
+
+	// Make covariance matrix (divide by N-1) and solve eigenproblem
+	vnl_matrix<double> covariance = (numVoxels > 1) ? moments.comoments / (numVoxels - 1.0) : moments.comoments * 0.0;
+#ifndef NDEBUG
+	DebugLogMatrix(covariance, "Covariance matrix");
+#endif
+	vnl_symmetric_eigensystem<double> eigenSystem(covariance);
+	// eigenvalues are sorted in ascending order; keep the eigenvectors of the 'numOutputs' largest ones
+	vnl_matrix<double> evecs(numInputs, numOutputs);
+	for (uint out_i = 0; out_i < numOutputs; ++out_i)
+	{
+		evecs.set_column(out_i, eigenSystem.get_eigenvector(numInputs - 1 - out_i));
+	}
+#ifndef NDEBUG
+	DebugLogMatrix(evecs, "Eigenvectors");
+	DebugLogVector(eigenSystem.D.diagonal(), "Eigenvalues");
+#endif
+
+	// Transform images to principal components: determine the range of each component first,
+	// then compute the components again and directly write them normalized to range 0..65535
+	std::vector<double> minVal(numOutputs, DBL_MAX), maxVal(numOutputs, -DBL_MAX);
+#pragma omp parallel
+	{
+		std::vector<double> minThread(numOutputs, DBL_MAX), maxThread(numOutputs, -DBL_MAX);
+#pragma omp for schedule(dynamic)
+		for (qint64 slab = 0; slab < numSlabs; ++slab)
+		{
+			qint64 begin = slab * SlabSize, end = std::min(begin + SlabSize, numVoxels);
+			for (qint64 v = begin; v < end; ++v)
+			{
+				for (uint out_i = 0; out_i < numOutputs; ++out_i)
+				{
+					double rec = 0;
+					for (uint in_i = 0; in_i < numInputs; ++in_i)
+					{
+						rec += inputs[in_i][v] * evecs[in_i][out_i];
+					}
+					minThread[out_i] = std::min(minThread[out_i], rec);
+					maxThread[out_i] = std::max(maxThread[out_i], rec);
+				}
+			}
+		}
+#pragma omp critical
+		for (uint out_i = 0; out_i < numOutputs; ++out_i)
+		{
+			minVal[out_i] = std::min(minVal[out_i], minThread[out_i]);
+			maxVal[out_i] = std::max(maxVal[out_i], maxThread[out_i]);
+		}
+	}
+
+	std::vector<typename ImageType::Pointer> outputImages(numOutputs);
+	std::vector<T*> outputs(numOutputs);
+	std::vector<double> scale(numOutputs);
+	for (uint out_i = 0; out_i < numOutputs; ++out_i)
+	{
+		auto output = ImageType::New();
+		typename ImageType::RegionType region;
+		region.SetSize(itkImg0->GetLargestPossibleRegion().GetSize());
+		region.SetIndex(itkImg0->GetLargestPossibleRegion().GetIndex());
+		output->SetRegions(region);
+		output->SetSpacing(itkImg0->GetSpacing());
+		output->Allocate();
+		outputImages[out_i] = output;
+		outputs[out_i] = output->GetBufferPointer();
+		scale[out_i] = (maxVal[out_i] > minVal[out_i]) ? 65535.0 / (maxVal[out_i] - minVal[out_i]) : 0.0;
+	}
+#pragma omp parallel for schedule(dynamic)
+	for (qint64 slab = 0; slab < numSlabs; ++slab)
+	{
+		qint64 begin = slab * SlabSize, end = std::min(begin + SlabSize, numVoxels);
+		for (qint64 v = begin; v < end; ++v)
+		{
+			for (uint out_i = 0; out_i < numOutputs; ++out_i)
+			{
+				double rec = 0;
+				for (uint in_i = 0; in_i < numInputs; ++in_i)
+				{
+					rec += inputs[in_i][v] * evecs[in_i][out_i];
+				}
+				outputs[out_i][v] = static_cast<T>((rec - minVal[out_i]) * scale[out_i]);
+			}
+		}
+	}
+
+	c.resize(numOutputs);
+	for (uint out_i = 0; out_i < numOutputs; out_i++)
+	{
+		c[out_i].setImage(outputImages[out_i]);
+	}
+}
@@ -6,9 +6,19 @@
 
 #include <iAConnector.h>
 
+//! Reduces the given datasets to their principal components with largest variance.
 class iANModalPCADataSetReducer : public iANModalDataSetReducer
 {
 public:
+	enum Mode
+	{
+		//! accumulate the statistics required for the covariance matrix slab by slab in parallel in
+		//! a single pass over the data, then project without intermediate copies of the data
+		Streaming,
+		//! copy all voxel values into one matrix, then compute covariance matrix and projection on it
+		FullMatrix
+	};
+	iANModalPCADataSetReducer(Mode mode = Streaming);
 	QList<std::shared_ptr<iAImageData>> reduce(const QList<std::shared_ptr<iAImageData>>&) override;
 
 private:
@@ -16,4 +26,8 @@ private:
 	void itkPCA(std::vector<iAConnector>& connectors);
 	template <class T>
 	void ownPCA(std::vector<iAConnector>& connectors);
+	template <class T>
+	void streamingPCA(std::vector<iAConnector>& connectors);
+
+	Mode m_mode;
 };
@@ -168,13 +168,19 @@ iANModalPreprocessor::Pipeline iANModalPreprocessor::choosePipeline()
 std::shared_ptr<iANModalDataSetReducer> iANModalPreprocessor::chooseDataSetReducer()
 {
 	const QString PCA = "PCA";
+	const QString PCA_FULL = "PCA (full matrix)";
 	const QString NONE = "Skip";
 
 	auto sel = new iANModalPreprocessorSelector("n-Modal Transfer Function preprocessing: choose Dataset Reducer");
 	sel->addOption(PCA,
 		{PCA,
 			"Perform Principal Component Analysis on the input datasets and use the principal components with "
-			"largest variance"});
+			"largest variance.\n\nThe statistics are accumulated in a single parallel pass over the datasets, "
+			"without copying their voxel values"});
+	sel->addOption(PCA_FULL,
+		{PCA_FULL,
+			"Perform Principal Component Analysis as above, but on a matrix containing a copy of all voxel values "
+			"of all input datasets (requires a lot of memory for large datasets)"});
 	sel->addOption(NONE, {NONE, "Skip dataset reduction and use any four dataset"});
 	QString selection = sel->exec();
 	sel->deleteLater();
@@ -185,7 +191,11 @@ std::shared_ptr<iANModalDataSetReducer> iANModalPreprocessor::chooseDataSetReduc
 	}
 	else if (selection == PCA)
 	{
-		return std::shared_ptr<iANModalDataSetReducer>(new iANModalPCADataSetReducer());
+		return std::shared_ptr<iANModalDataSetReducer>(new iANModalPCADataSetReducer(iANModalPCADataSetReducer::Streaming));
+	}
+	else if (selection == PCA_FULL)
+	{
+		return std::shared_ptr<iANModalDataSetReducer>(new iANModalPCADataSetReducer(iANModalPCADataSetReducer::FullMatrix));
 	}
 	else
 	{
@@ -196,6 +206,7 @@ std::shared_ptr<iANModalDataSetReducer> iANModalPreprocessor::chooseDataSetReduc
 std::shared_ptr<iANModalBackgroundRemover> iANModalPreprocessor::chooseBackgroundRemover()
 {
 	const QString CLOSING = "Morphological Closing";
+	const QString CLOSING_ITERATIVE = "Morphological Closing (iterative)";
 	const QString NONE = "Skip";
 
 	auto sel = new iANModalPreprocessorSelector("n-Modal Transfer Function preprocessing: choose Background Remover");
@@ -206,7 +217,15 @@ std::shared_ptr<iANModalBackgroundRemover> iANModalPreprocessor::chooseBackgroun
 			"1) Make an initial rough background selection (with simple thresholding), resulting in a binary mask;\n"
 			"2) Then perform N morphological dilations (until the mask has only one region);\n"
 			"3) Then perform N morphological erosions.\n\n"
-			"This method only works if the input specimen has only one foreground region"  // However, it can later be adapted to support more regions! TODO
+			"This method only works if the input specimen has only one foreground region\n\n"  // However, it can later be adapted to support more regions! TODO
+			"N is determined from a distance transform of the mask, dilations and erosions are computed via distance "
+			"transforms as well (fast, independent of N)"
+		});
+	sel->addOption(CLOSING_ITERATIVE,
+		{
+			CLOSING_ITERATIVE,
+			"Morphological closing as above, but performing the dilations one by one (counting the connected "
+			"regions after each), then the erosions one by one (slow for large N)"
 		});
 	sel->addOption(NONE, {NONE, "Skip background removal (do not remove background)"});
 	QString selection = sel->exec();
@@ -218,7 +237,13 @@ std::shared_ptr<iANModalBackgroundRemover> iANModalPreprocessor::chooseBackgroun
 	}
 	else if (selection == CLOSING)
 	{
-		return std::shared_ptr<iANModalBackgroundRemover>(new iANModalDilationBackgroundRemover(m_mdiChild));
+		return std::shared_ptr<iANModalBackgroundRemover>(
+			new iANModalDilationBackgroundRemover(m_mdiChild, iANModalDilationBackgroundRemover::DistanceTransform));
+	}
+	else if (selection == CLOSING_ITERATIVE)
+	{
+		return std::shared_ptr<iANModalBackgroundRemover>(
+			new iANModalDilationBackgroundRemover(m_mdiChild, iANModalDilationBackgroundRemover::Iterative));
 	}
 	else
 	{
@@ -117,4 +117,24 @@ BEGIN_TEST
 	TestEqualFloatingPoint( 0.004196113731758, csd.GetDistance(fct4.get(1), fct4.get(0)) );
 	TestEqualFloatingPoint( 0.140929535232384, emd.GetDistance(fct4.get(1), fct4.get(0)) );
 
+	// batch computation needs to give the same results as computing the distance for each pair:
+	std::vector<iAVectorDataType> fct4Values(fct4.size() * fct4.channelCount());
+	for (size_t c = 0; c < fct4.channelCount(); ++c)
+	{
+		fct4.getChannel(c, fct4Values.data() + c * fct4.size());
+	}
+	iAChannelMajorData fct4Data{ fct4Values.data(), fct4.size(), fct4.channelCount() };
+	iAVectorIndexPair pairs[] = { {0, 1}, {1, 0}, {0, 0} };
+	iASquaredDistance sqd;
+	iAVectorDistance const * measures[] = { &l1, &l2, &lid, &sad, &jsd, &kld, &csd, &emd, &sqd };
+	for (auto measure : measures)
+	{
+		double batchResult[3];
+		measure->GetDistances(fct4Data, pairs, 3, batchResult);
+		for (size_t i = 0; i < 3; ++i)
+		{
+			TestEqualFloatingPoint( measure->GetDistance(fct4.get(pairs[i].first), fct4.get(pairs[i].second)), batchResult[i] );
+		}
+	}
+
 END_TEST
@@ -1,5 +1,7 @@
 // Copyright (c) open_iA contributors
 // SPDX-License-Identifier: GPL-3.0-or-later
+#include "iAFuzzyCMeansClustering.h"
+
 #include <defines.h>    // for DIM
 #include <iAAutoRegistration.h>
 #include <iAFilter.h>
@@ -9,21 +11,13 @@
 #include <iAProgress.h>
 #include <iATypedCallHelper.h>
 
-#include <itkConfigure.h>    // for ITK_VERSION...
-#include <itkFCMClassifierInitializationImageFilter.h>
+#include <itkFlatStructuringElement.h>
 #include <itkFuzzyClassifierImageFilter.h>
-#include <itkKFCMSClassifierInitializationImageFilter.h>
-#if ITK_VERSION_MAJOR < 5
-// MSKFCM filter is implemented with the help of itk Barriers, which got removed with ITK 5
-#include <itkMSKFCMClassifierInitializationImageFilter.h>
-#endif
 #include <itkVectorImage.h>
 #include <itkVectorIndexSelectionCastImageFilter.h>
 
 //#include <vtkImageData.h>
 
-#include <itkConfigure.h>    // for ITK_VERSION_MAJOR
-
 typedef iAAttributeDescriptor ParamDesc;
 
 class iAFCMFilter : public iAFilter, private iAAutoRegistration<iAFilter, iAFCMFilter, iAFilterRegistry>
@@ -42,7 +36,6 @@ public:
 	void performWork(QVariantMap const & parameters) override;
 };
 
-#if ITK_VERSION_MAJOR < 5
 class iAMSKFCMFilter : public iAFilter, private iAAutoRegistration<iAFilter, iAMSKFCMFilter, iAFilterRegistry>
 {
 public:
@@ -50,7 +43,6 @@ public:
 	bool checkParameters(QVariantMap const & parameters) override;
 	void performWork(QVariantMap const & parameters) override;
 };
-#endif
 
 using ProbabilityPixelType = double;
 using VectorImageType = itk::VectorImage<ProbabilityPixelType, DIM>;
@@ -58,21 +50,10 @@ using LabelPixelType = unsigned int;
 using ScalarProbabilityImageType = itk::Image<ProbabilityPixelType, DIM>;
 using IndexSelectionType = itk::VectorIndexSelectionCastImageFilter<VectorImageType, ScalarProbabilityImageType>;
 using TLabelClassifier = itk::FuzzyClassifierImageFilter<VectorImageType, LabelPixelType>;
+using StructuringElementType = itk::FlatStructuringElement<DIM>;
 
 namespace
 {
-	void setProbabilities(VectorImageType::Pointer vectorImg, iAFilter* filter)
-	{
-		for (unsigned int p = 0; p < vectorImg->GetVectorLength(); ++p)
-		{
-			auto indexSelectionFilter = IndexSelectionType::New();
-			indexSelectionFilter->SetIndex(p);
-			indexSelectionFilter->SetInput(vectorImg);
-			indexSelectionFilter->Update();
-			filter->addOutput(std::make_shared<iAImageData>(indexSelectionFilter->GetOutput()));
-		}
-	}
-
 	void addFCMParameters(iAFilter & filter)
 	{
 		filter.addParameter("Maximum Iterations", iAValueType::Discrete, 500, 1);
@@ -123,6 +104,83 @@ namespace
 		QVector<double> centroids;
 		return convertStringToCentroids(parameters["Centroids"].toString(), numberOfClasses, centroids);
 	}
+
+	//! add the label image (the class with maximum membership for each pixel) and the probability images as outputs
+	void addClassificationOutputs(VectorImageType::Pointer vectorImg, iAFilter* filter)
+	{
+		auto labelClass = TLabelClassifier::New();
+		labelClass->SetInput(vectorImg);
+		labelClass->Update();
+		filter->addOutput(std::make_shared<iAImageData>(labelClass->GetOutput()));
+		for (unsigned int p = 0; p < vectorImg->GetVectorLength(); ++p)
+		{
+			auto indexSelectionFilter = IndexSelectionType::New();
+			indexSelectionFilter->SetIndex(p);
+			indexSelectionFilter->SetInput(vectorImg);
+			indexSelectionFilter->Update();
+			filter->addOutput(std::make_shared<iAImageData>(indexSelectionFilter->GetOutput()));
+		}
+	}
+
+	//! create the image holding the memberships to all classes, with the same geometry as the given input
+	template <typename InputImageType>
+	VectorImageType::Pointer allocateProbabilities(InputImageType* input, size_t numberOfClasses)
+	{
+		auto probs = VectorImageType::New();
+		probs->SetRegions(input->GetLargestPossibleRegion());
+		probs->SetSpacing(input->GetSpacing());
+		probs->SetOrigin(input->GetOrigin());
+		probs->SetDirection(input->GetDirection());
+		probs->SetVectorLength(static_cast<unsigned int>(numberOfClasses));
+		probs->Allocate();
+		return probs;
+	}
+
+	template <typename InputImageType>
+	std::array<int, 3> imageSize(InputImageType* input)
+	{
+		auto size = input->GetLargestPossibleRegion().GetSize();
+		return {static_cast<int>(size[0]), static_cast<int>(size[1]), static_cast<int>(size[2])};
+	}
+
+	template <typename InputPixelType>
+	void setFCMParameters(iAFCMParameters& fcmParams, QVariantMap const& params)
+	{
+		QVector<double> centroids;
+		convertStringToCentroids(params["Centroids"].toString(), params["Number of Classes"].toUInt(), centroids);
+		fcmParams.centroids.assign(centroids.begin(), centroids.end());
+		fcmParams.m = params["M"].toDouble();
+		fcmParams.maxIterations = params["Maximum Iterations"].toUInt();
+		fcmParams.maxError = params["Maximum Error"].toDouble();
+		fcmParams.ignoreBackground = params["Ignore Background"].toBool();
+		// as in the ITK fuzzy classifiers, the background value is compared in the input pixel type:
+		fcmParams.backgroundValue = static_cast<InputPixelType>(params["Background Value"].toDouble());
+		fcmParams.threadCount = params["Number of Threads"].toInt();
+	}
+
+	StructuringElementType::RadiusType structuringElementRadius(QVariantMap const& params)
+	{
+		StructuringElementType::RadiusType radius;
+		radius[0] = params["StructRadius X"].toUInt();
+		radius[1] = params["StructRadius Y"].toUInt();
+		radius[2] = params["StructRadius Z"].toUInt();
+		return radius;
+	}
+
+	//! the offsets of all active pixels of the given structuring element
+	std::vector<std::array<int, 3>> neighborOffsets(StructuringElementType const& structuringElement, bool includeCenter)
+	{
+		std::vector<std::array<int, 3>> offsets;
+		for (unsigned int i = 0; i < structuringElement.Size(); ++i)
+		{
+			auto offset = structuringElement.GetOffset(i);
+			if (structuringElement[i] && (includeCenter || offset[0] != 0 || offset[1] != 0 || offset[2] != 0))
+			{
+				offsets.push_back({static_cast<int>(offset[0]), static_cast<int>(offset[1]), static_cast<int>(offset[2])});
+			}
+		}
+		return offsets;
+	}
 }
 
 
@@ -132,34 +190,15 @@ template <typename InputPixelType>
 void fcm(iAFilter* filter, QVariantMap const & params)
 {
 	typedef itk::Image<InputPixelType, DIM> InputImageType;
-	typedef itk::FuzzyClassifierInitializationImageFilter<InputImageType> TFuzzyClassifier;
-	typedef itk::FCMClassifierInitializationImageFilter<InputImageType> TClassifierFCM;
-
-	unsigned int numberOfClasses = params["Number of Classes"].toUInt();
-	QVector<double> centroids;
-	convertStringToCentroids(params["Centroids"].toString(), numberOfClasses, centroids);
-	auto classifier = TClassifierFCM::New();
-	filter->progress()->observe(classifier);
-	classifier->SetMaximumNumberOfIterations(params["Maximum Iterations"].toUInt());
-	classifier->SetMaximumError(params["Maximum Error"].toDouble());
-	classifier->SetM(params["M"].toDouble());
-	classifier->SetNumberOfWorkUnits(params["Number of Threads"].toUInt());
-	classifier->SetNumberOfClasses(numberOfClasses);
-	typename TFuzzyClassifier::CentroidArrayType centroidsArray;
-	for (int i = 0; static_cast<unsigned int>(i) < numberOfClasses; i++)
-	{
-		centroidsArray.push_back(centroids[i]);
-	}
-	classifier->SetCentroids(centroidsArray);
-	classifier->SetIgnoreBackgroundPixels(params["Ignore Background"].toBool());
-	classifier->SetBackgroundPixel(params["Background Value"].toDouble());
-	classifier->SetInput(dynamic_cast<InputImageType *>(filter->imageInput(0)->itkImage()));
-	classifier->Update();
-	auto probs = classifier->GetOutput();
-	auto labelClass = TLabelClassifier::New();
-	labelClass->SetInput(probs);
-	filter->addOutput(std::make_shared<iAImageData>(labelClass->GetOutput()));
-	setProbabilities(probs, filter);
+	iAFCMParameters fcmParams;
+	setFCMParameters<InputPixelType>(fcmParams, params);
+	fcmParams.useHistogram = params["Histogram Acceleration"].toBool();
+	auto input = dynamic_cast<InputImageType *>(filter->imageInput(0)->itkImage());
+	auto probs = allocateProbabilities(input, fcmParams.centroids.size());
+	auto result = fuzzyCMeans(input->GetBufferPointer(), input->GetLargestPossibleRegion().GetNumberOfPixels(),
+		fcmParams, probs->GetBufferPointer(), filter->progress());
+	LOG(lvlInfo, QString("FCM finished after %1 iterations (remaining error: %2).").arg(result.iterations).arg(result.error));
+	addClassificationOutputs(probs, filter);
 }
 
 iAFCMFilter::iAFCMFilter() :
@@ -167,9 +206,15 @@ iAFCMFilter::iAFCMFilter() :
 		"Pixel Classification based on Fuzzy C-Means (FCM). <br/>"
 		"This implementation is based on Bezdek et al.'s paper \"FCM: The fuzzy "
 		"c-means clustering algorithm\" (Computers & Geosciences, 10 (2), 191-203., "
-		"1984).")
+		"1984).<br/>"
+		"If <em>Histogram Acceleration</em> is enabled, the iterations operate on the histogram of "
+		"the input instead of on each voxel; for integer images with at most 65536 distinct values "
+		"in their range, this gives the same result; for other images, the values are binned into "
+		"65536 bins for computing the centroids, and only the final memberships are computed for "
+		"each voxel.")
 {
 	addFCMParameters(*this);
+	addParameter("Histogram Acceleration", iAValueType::Boolean, false);
 }
 
 bool iAFCMFilter::checkParameters(QVariantMap const & parameters)
@@ -207,58 +252,19 @@ bool iAKFCMFilter::checkParameters(QVariantMap const & parameters)
 template <typename InputPixelType>
 void kfcm(iAFilter* filter, QVariantMap const & parameters)
 {
-	unsigned int numberOfClasses = parameters["Number of Classes"].toUInt();
-	QVector<double> centroids;
-	convertStringToCentroids(parameters["Centroids"].toString(), numberOfClasses, centroids);
-	unsigned int seRadius[3] = {
-		parameters["StructRadius X"].toUInt(),
-		parameters["StructRadius Y"].toUInt(),
-		parameters["StructRadius Z"].toUInt()
-	};
 	typedef itk::Image<InputPixelType, DIM> InputImageType;
-	typedef itk::FuzzyClassifierInitializationImageFilter<InputImageType> TFuzzyClassifier;
-	typedef itk::KFCMSClassifierInitializationImageFilter<InputImageType> TClassifierKFCMS;
-	typedef typename TClassifierKFCMS::KernelDistanceMetricPointer KernelDistMetricPtr;
-	typedef typename TFuzzyClassifier::CentroidType TCentroid;
-	typedef itk::Statistics::RBFKernelInducedDistanceMetric<TCentroid> RBFKernelType;
-	typedef itk::FlatStructuringElement<DIM> StructuringElementType;
-
-	auto classifier = TClassifierKFCMS::New();
-	filter->progress()->observe(classifier);
-	classifier->SetMaximumNumberOfIterations(parameters["Maximum Iterations"].toUInt());
-	classifier->SetMaximumError(parameters["Maximum Error"].toDouble());
-	classifier->SetM(parameters["M"].toDouble());
-	classifier->SetAlpha(parameters["Alpha"].toDouble());
-	classifier->SetNumberOfWorkUnits(parameters["Number of Threads"].toUInt());
-	classifier->SetNumberOfClasses(numberOfClasses);
-	typename TFuzzyClassifier::CentroidArrayType centroidsArray;
-	for (int i = 0; static_cast<unsigned int>(i) < numberOfClasses; i++)
-	{
-		centroidsArray.push_back(centroids[i]);
-	}
-	classifier->SetCentroids(centroidsArray);
-	auto kernelDistancePtr = RBFKernelType::New();
-	kernelDistancePtr->SetA(2.0);		// make a parameter?
-	kernelDistancePtr->SetB(1.0);		// make a parameter?
-	kernelDistancePtr->SetSigma(parameters["Sigma"].toDouble());
-	classifier->SetKernelDistanceMetric(static_cast<KernelDistMetricPtr>(kernelDistancePtr));
-	typename StructuringElementType::RadiusType elementRadius;
-	for (int i = 0; i < DIM; i++)
-	{
-		elementRadius[i] = seRadius[i];
-	}
-	auto structuringElement = StructuringElementType::Box(elementRadius);
-	classifier->SetStructuringElement(structuringElement);
-	classifier->SetIgnoreBackgroundPixels(parameters["Ignore Background"].toBool());
-	classifier->SetBackgroundPixel(parameters["Background Value"].toDouble());
-	classifier->SetInput(dynamic_cast<InputImageType *>(filter->imageInput(0)->itkImage()));
-	classifier->Update();
-	auto probs = classifier->GetOutput();
-	auto labelClass = TLabelClassifier::New();
-	labelClass->SetInput(probs);
-	labelClass->Update();
-	filter->addOutput(std::make_shared<iAImageData>(labelClass->GetOutput()));
-	setProbabilities(probs, filter);
+	iAKFCMParameters kfcmParams;
+	setFCMParameters<InputPixelType>(kfcmParams, parameters);
+	kfcmParams.sigma = parameters["Sigma"].toDouble();
+	kfcmParams.alpha = parameters["Alpha"].toDouble();
+	auto structuringElement = StructuringElementType::Box(structuringElementRadius(parameters));
+	kfcmParams.neighborOffsets = neighborOffsets(structuringElement, false);
+	auto input = dynamic_cast<InputImageType *>(filter->imageInput(0)->itkImage());
+	auto probs = allocateProbabilities(input, kfcmParams.centroids.size());
+	auto result = kernelizedFCMS(input->GetBufferPointer(), imageSize(input).data(), kfcmParams,
+		probs->GetBufferPointer(), filter->progress());
+	LOG(lvlInfo, QString("Kernelized FCM finished after %1 iterations (remaining error: %2).").arg(result.iterations).arg(result.error));
+	addClassificationOutputs(probs, filter);
 }
 
 void iAKFCMFilter::performWork(QVariantMap const & parameters)
@@ -273,7 +279,6 @@ void iAKFCMFilter::performWork(QVariantMap const & parameters)
 
 // MSKFCM
 
-#if ITK_VERSION_MAJOR < 5
 iAMSKFCMFilter::iAMSKFCMFilter() :
 	iAFilter("MSKFCM", "Segmentation/Fuzzy C-Means",
 		"Modified Spatial Kernelized Fuzzy C-Means. <br/>"
@@ -297,61 +302,19 @@ template <typename InputPixelType>
 void mskfcm(iAFilter* filter, QVariantMap const & parameters)
 {
 	typedef itk::Image<InputPixelType, DIM> InputImageType;
-	typedef itk::FuzzyClassifierInitializationImageFilter<InputImageType> TFuzzyClassifier;
-	typedef itk::MSKFCMClassifierInitializationImageFilter<InputImageType> TClassifierMSKFCM;
-	typedef typename TClassifierMSKFCM::KernelDistanceMetricPointer KernelDistMetricPtr;
-
-	unsigned int numberOfClasses = parameters["Number of Classes"].toUInt();
-	QVector<double> centroids;
-	convertStringToCentroids(parameters["Centroids"].toString(), numberOfClasses, centroids);
-	unsigned int seRadius[3] = {
-		parameters["StructRadius X"].toUInt(),
-		parameters["StructRadius Y"].toUInt(),
-		parameters["StructRadius Z"].toUInt()
-	};
-	auto classifier = TClassifierMSKFCM::New();
-	filter->progress()->observe(classifier);
-	classifier->SetMaximumNumberOfIterations(parameters["Maximum Iterations"].toUInt());
-	classifier->SetMaximumError(parameters["Maximum Error"].toDouble());
-	classifier->SetM(parameters["M"].toDouble());
-	//classifier->SetAlpha(parameters["Alpha"].toDouble());
-	classifier->SetP(parameters["P"].toDouble());
-	classifier->SetQ(parameters["Q"].toDouble());
-	classifier->SetNumberOfWorkUnits(parameters["Number of Threads"].toUInt());
-	classifier->SetNumberOfClasses(numberOfClasses);
-	typename TFuzzyClassifier::CentroidArrayType centroidsArray;
-	for (unsigned int i = 0; i < numberOfClasses; i++)
-	{
-		centroidsArray.push_back(centroids[i]);
-	}
-	classifier->SetCentroids(centroidsArray);
-
-	typedef typename TFuzzyClassifier::CentroidType TCentroid;
-	typedef itk::Statistics::RBFKernelInducedDistanceMetric<TCentroid>
-		RBFKernelType;
-	auto kernelDistancePtr = RBFKernelType::New();
-	kernelDistancePtr->SetA(2.0);		// make a parameter?
-	kernelDistancePtr->SetB(1.0);		// make a parameter?
-	kernelDistancePtr->SetSigma(parameters["Sigma"].toDouble());
-	classifier->SetKernelDistanceMetric(static_cast<KernelDistMetricPtr>(kernelDistancePtr));
-	typedef itk::FlatStructuringElement<DIM> StructuringElementType;
-	typename StructuringElementType::RadiusType elementRadius;
-	for (int i = 0; i < DIM; i++)
-	{
-		elementRadius[i] = seRadius[i];
-	}
-	auto structuringElement = StructuringElementType::Ball(elementRadius);
-	classifier->SetStructuringElement(structuringElement);
-	classifier->SetIgnoreBackgroundPixels(parameters["Ignore Background"].toBool());
-	classifier->SetBackgroundPixel(parameters["Background Value"].toDouble());
-	classifier->SetInput(dynamic_cast<InputImageType *>(filter->imageInput(0)->itkImage()));
-	classifier->Update();
-	auto probs = classifier->GetOutput();
-	auto labelClass = TLabelClassifier::New();
-	labelClass->SetInput(probs);
-	labelClass->Update();
-	filter->addOutput(labelClass->GetOutput());
-	setProbabilities(probs, filter);
+	iAKFCMParameters kfcmParams;
+	setFCMParameters<InputPixelType>(kfcmParams, parameters);
+	kfcmParams.sigma = parameters["Sigma"].toDouble();
+	kfcmParams.p = parameters["P"].toDouble();
+	kfcmParams.q = parameters["Q"].toDouble();
+	auto structuringElement = StructuringElementType::Ball(structuringElementRadius(parameters));
+	kfcmParams.neighborOffsets = neighborOffsets(structuringElement, true);
+	auto input = dynamic_cast<InputImageType *>(filter->imageInput(0)->itkImage());
+	auto probs = allocateProbabilities(input, kfcmParams.centroids.size());
+	auto result = modifiedSpatialKFCM(input->GetBufferPointer(), imageSize(input).data(), kfcmParams,
+		probs->GetBufferPointer(), filter->progress());
+	LOG(lvlInfo, QString("MSKFCM finished after %1 iterations (remaining error: %2).").arg(result.iterations).arg(result.error));
+	addClassificationOutputs(probs, filter);
 }
 
 void iAMSKFCMFilter::performWork(QVariantMap const & parameters)
@@ -362,4 +325,3 @@ void iAMSKFCMFilter::performWork(QVariantMap const & parameters)
 	}
 	ITK_TYPED_CALL(mskfcm, inputScalarType(), this, parameters);
 }
-#endif
@@ -0,0 +1,601 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <iAProgress.h>
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <omp.h>
+
+//! Parameters of a fuzzy c-means (FCM) clustering of scalar values
+struct iAFCMParameters
+{
+	std::vector<double> centroids;   //!< initial centroids, one per class
+	double m = 2;                    //!< fuzziness, must be larger than 1
+	unsigned int maxIterations = 500;
+	double maxError = 0.0001;        //!< stop once the root mean square of the centroid changes drops below this value
+	bool ignoreBackground = false;   //!< whether values equal to backgroundValue are excluded (their membership is -1 for all classes)
+	double backgroundValue = 0;
+	int threadCount = 1;
+	//! whether to iterate on a histogram of the values instead of on each value; exact for integer types
+	//! with at most HistogramBins distinct values in the input range, otherwise the values are binned
+	//! and only the final memberships are computed from the actual values
+	bool useHistogram = false;
+};
+
+//! Result of a fuzzy c-means clustering
+struct iAFCMResult
+{
+	std::vector<double> centroids;   //!< final centroids
+	unsigned int iterations = 0;     //!< number of performed iterations
+	double error = 0;                //!< root mean square of the centroid changes in the last iteration
+};
+
+//! Parameters of the kernelized, spatially constrained FCM variants (see kernelizedFCMS and modifiedSpatialKFCM).
+//! The distance to the centroids is induced by the RBF kernel K(x, c) = exp(-(|x - c|^a)^b / sigma^2)
+//! (as in itk::Statistics::RBFKernelInducedDistanceMetric); useHistogram is not used, since the
+//! neighborhood terms do not reduce to a histogram.
+struct iAKFCMParameters : public iAFCMParameters
+{
+	double sigma = 1;     //!< width of the RBF kernel
+	double a = 2;         //!< exponent of the distance in the RBF kernel
+	double b = 1;         //!< exponent of the powered distance in the RBF kernel
+	double alpha = 1;     //!< (KFCMS only) weight of the neighborhood term
+	double p = 2;         //!< (MSKFCM only) exponent of a voxel's own membership
+	double q = 1;         //!< (MSKFCM only) exponent of the membership summed over the neighborhood
+	//! offsets (x, y, z) of the neighbors of a voxel considered in the spatial terms
+	std::vector<std::array<int, 3>> neighborOffsets;
+};
+
+namespace iAFCM
+{
+	//! maximum number of bins used for the histogram variant
+	constexpr size_t HistogramBins = 65536;
+
+	//! membership value assigned to all classes for ignored background values (as in the ITK fuzzy classifiers)
+	constexpr double BackgroundMembership = -1;
+
+	//! Replaces the centroids by num_k / den_k (centroids without any contribution are kept).
+	//! @return the root mean square of the centroid changes (the error measure of itk::FuzzyClassifierInitializationImageFilter)
+	inline double updateCentroids(std::vector<double>& centroids, std::vector<double> const& num, std::vector<double> const& den)
+	{
+		double sum = 0;
+		for (size_t k = 0; k < centroids.size(); ++k)
+		{
+			double newCentroid = (den[k] > 0) ? num[k] / den[k] : centroids[k];
+			sum += (newCentroid - centroids[k]) * (newCentroid - centroids[k]);
+			centroids[k] = newCentroid;
+		}
+		return std::sqrt(sum / centroids.size());
+	}
+
+	//! Computes the membership u of value x to each of the classCount classes for the given centroids:
+	//! u_k = w_k / sum_j w_j with w_k = |x - c_k|^(-2/(m-1)); if x coincides with one or more centroids,
+	//! the membership is split among those
+	inline void membership(double x, double const* centroids, size_t classCount, double exponent, double* u)
+	{
+		double sum = 0;
+		size_t zeroCount = 0;
+		for (size_t k = 0; k < classCount; ++k)
+		{
+			double d2 = (x - centroids[k]) * (x - centroids[k]);
+			if (d2 == 0)
+			{
+				++zeroCount;
+			}
+			// exponent == -1 for the default m = 2; avoid the costly pow for it:
+			u[k] = (d2 == 0) ? 0 : ((exponent == -1) ? 1 / d2 : std::pow(d2, exponent));
+			sum += u[k];
+		}
+		if (zeroCount > 0)
+		{
+			for (size_t k = 0; k < classCount; ++k)
+			{
+				u[k] = ((x - centroids[k]) * (x - centroids[k]) == 0) ? 1.0 / zeroCount : 0.0;
+			}
+			return;
+		}
+		for (size_t k = 0; k < classCount; ++k)
+		{
+			u[k] /= sum;
+		}
+	}
+
+	//! Sums up the per-thread partial sums of the centroid numerators and denominators, in thread order
+	inline void combinePartialSums(std::vector<double> const& partialNum, std::vector<double> const& partialDen,
+		int threadCount, size_t classCount, std::vector<double>& num, std::vector<double>& den)
+	{
+		num.assign(classCount, 0.0);
+		den.assign(classCount, 0.0);
+		for (int t = 0; t < threadCount; ++t)
+		{
+			for (size_t k = 0; k < classCount; ++k)
+			{
+				num[k] += partialNum[t * classCount + k];
+				den[k] += partialDen[t * classCount + k];
+			}
+		}
+	}
+
+	//! One membership update over count (optionally weighted) values, accumulated directly into the sums
+	//! required for the centroid update: num_k = sum w*u_k^m*x, den_k = sum w*u_k^m.
+	//! Each thread accumulates into its own partial sums, which are combined in thread order afterwards
+	//! so that the result does not depend on the scheduling.
+	template <typename T>
+	void accumulateCentroids(T const* values, double const* weights, size_t count, std::vector<double> const& centroids,
+		iAFCMParameters const& params, std::vector<double>& num, std::vector<double>& den)
+	{
+		size_t const classCount = centroids.size();
+		double const exponent = -1.0 / (params.m - 1);
+		int const threadCount = std::max(1, params.threadCount);
+		std::vector<double> partialNum(threadCount * classCount, 0.0), partialDen(threadCount * classCount, 0.0);
+#pragma omp parallel num_threads(threadCount)
+		{
+			double* tNum = partialNum.data() + omp_get_thread_num() * classCount;
+			double* tDen = partialDen.data() + omp_get_thread_num() * classCount;
+			std::vector<double> u(classCount);
+#pragma omp for schedule(static)
+			for (qint64 i = 0; i < static_cast<qint64>(count); ++i)
+			{
+				double x = values[i];
+				double w = weights ? weights[i] : 1.0;
+				// (background values are already excluded from the histogram)
+				if (w == 0 || (!weights && params.ignoreBackground && x == params.backgroundValue))
+				{
+					continue;
+				}
+				membership(x, centroids.data(), classCount, exponent, u.data());
+				for (size_t k = 0; k < classCount; ++k)
+				{
+					double um = w * ((params.m == 2) ? u[k] * u[k] : std::pow(u[k], params.m));
+					tNum[k] += um * x;
+					tDen[k] += um;
+				}
+			}
+		}
+		combinePartialSums(partialNum, partialDen, threadCount, classCount, num, den);
+	}
+
+	//! Builds a histogram of the (non-background) values: the representative value of each bin
+	//! (the mean of the values in it) and the number of values in it. Empty bins get weight 0.
+	template <typename T>
+	void buildHistogram(T const* values, size_t count, iAFCMParameters const& params,
+		std::vector<double>& binValues, std::vector<double>& binWeights)
+	{
+		auto skip = [&params](double x) { return params.ignoreBackground && x == params.backgroundValue; };
+		double minVal = std::numeric_limits<double>::max(), maxVal = std::numeric_limits<double>::lowest();
+#pragma omp parallel for num_threads(std::max(1, params.threadCount)) reduction(min:minVal) reduction(max:maxVal)
+		for (qint64 i = 0; i < static_cast<qint64>(count); ++i)
+		{
+			if (!skip(values[i]))
+			{
+				minVal = std::min(minVal, static_cast<double>(values[i]));
+				maxVal = std::max(maxVal, static_cast<double>(values[i]));
+			}
+		}
+		if (minVal > maxVal)    // all values are background
+		{
+			binValues.clear();
+			binWeights.clear();
+			return;
+		}
+		// for integer types with a small enough range, each bin holds exactly one value:
+		bool exact = std::is_integral_v<T> && (maxVal - minVal) < HistogramBins;
+		size_t binCount = exact ? static_cast<size_t>(maxVal - minVal) + 1 : HistogramBins;
+		double binScale = (exact || maxVal == minVal) ? 1.0 : binCount / (maxVal - minVal);
+		int const threadCount = std::max(1, params.threadCount);
+		std::vector<double> sums(threadCount * binCount, 0.0), counts(threadCount * binCount, 0.0);
+#pragma omp parallel num_threads(threadCount)
+		{
+			double* tSums = sums.data() + omp_get_thread_num() * binCount;
+			double* tCounts = counts.data() + omp_get_thread_num() * binCount;
+#pragma omp for schedule(static)
+			for (qint64 i = 0; i < static_cast<qint64>(count); ++i)
+			{
+				double x = values[i];
+				if (skip(x))
+				{
+					continue;
+				}
+				size_t bin = std::min(binCount - 1, static_cast<size_t>((x - minVal) * binScale));
+				tSums[bin] += x;
+				tCounts[bin] += 1;
+			}
+		}
+		binValues.assign(binCount, 0.0);
+		binWeights.assign(binCount, 0.0);
+		for (int t = 0; t < threadCount; ++t)
+		{
+			for (size_t b = 0; b < binCount; ++b)
+			{
+				binValues[b] += sums[t * binCount + b];
+				binWeights[b] += counts[t * binCount + b];
+			}
+		}
+		for (size_t b = 0; b < binCount; ++b)
+		{
+			binValues[b] = (binWeights[b] > 0) ? binValues[b] / binWeights[b] : minVal;
+		}
+	}
+}
+
+//! Fuzzy c-means clustering of count scalar values (Bezdek et al., "FCM: The fuzzy c-means clustering
+//! algorithm", Computers & Geosciences, 10 (2), 191-203, 1984).
+//! Alternates membership and centroid updates until the centroids converge or the maximum number of
+//! iterations is reached; both updates are done in one parallel pass over the values (or over their
+//! histogram, see iAFCMParameters::useHistogram).
+//! @param values the values to cluster
+//! @param count the number of values
+//! @param params the clustering parameters
+//! @param membership output; the membership of each value to each class for the final centroids,
+//!        stored value by value (i.e. count * number of classes values, as in an itk::VectorImage)
+//! @param progress optional progress indicator
+template <typename T>
+iAFCMResult fuzzyCMeans(T const* values, size_t count, iAFCMParameters const& params, double* membership,
+	iAProgress const* progress = nullptr)
+{
+	iAFCMResult result;
+	result.centroids = params.centroids;
+	size_t const classCount = params.centroids.size();
+	std::vector<double> binValues, binWeights;
+	if (params.useHistogram)
+	{
+		iAFCM::buildHistogram(values, count, params, binValues, binWeights);
+	}
+	std::vector<double> num, den;
+	do
+	{
+		if (params.useHistogram)
+		{
+			iAFCM::accumulateCentroids(binValues.data(), binWeights.data(), binValues.size(), result.centroids, params, num, den);
+		}
+		else
+		{
+			iAFCM::accumulateCentroids(values, nullptr, count, result.centroids, params, num, den);
+		}
+		result.error = iAFCM::updateCentroids(result.centroids, num, den);
+		++result.iterations;
+		if (progress)
+		{
+			progress->emitProgress(100.0 * result.iterations / params.maxIterations);
+		}
+	} while (result.error > params.maxError && result.iterations < params.maxIterations);
+
+	double const exponent = -1.0 / (params.m - 1);
+#pragma omp parallel for num_threads(std::max(1, params.threadCount)) schedule(static)
+	for (qint64 i = 0; i < static_cast<qint64>(count); ++i)
+	{
+		double* u = membership + i * classCount;
+		if (params.ignoreBackground && values[i] == params.backgroundValue)
+		{
+			std::fill(u, u + classCount, iAFCM::BackgroundMembership);
+		}
+		else
+		{
+			iAFCM::membership(values[i], result.centroids.data(), classCount, exponent, u);
+		}
+	}
+	return result;
+}
+
+namespace iAFCM
+{
+	//! u^m, without the costly pow for the default m = 2
+	inline double powM(double u, double m)
+	{
+		return (m == 2) ? u * u : std::pow(u, m);
+	}
+
+	//! x^exponent for the membership exponent -1/(m-1), without the costly pow for the default m = 2
+	inline double powMembership(double x, double exponent)
+	{
+		return (exponent == -1) ? 1 / x : std::pow(x, exponent);
+	}
+
+	//! Computes the RBF kernel values K(x, c_k) of each (non-background) value to all centroids,
+	//! stored value by value in kernel (count * number of classes values)
+	template <typename T>
+	void computeKernel(T const* values, qint64 count, std::vector<double> const& centroids,
+		iAKFCMParameters const& params, double* kernel)
+	{
+		size_t const classCount = centroids.size();
+		double const invSigma2 = 1.0 / (params.sigma * params.sigma);
+		bool const squared = params.a == 2 && params.b == 1;    // default kernel, avoid pow
+#pragma omp parallel for num_threads(std::max(1, params.threadCount)) schedule(static)
+		for (qint64 i = 0; i < count; ++i)
+		{
+			double x = values[i];
+			if (params.ignoreBackground && x == params.backgroundValue)
+			{
+				continue;
+			}
+			double* k = kernel + i * classCount;
+			for (size_t c = 0; c < classCount; ++c)
+			{
+				double d = std::abs(x - centroids[c]);
+				k[c] = std::exp(-(squared ? d * d : std::pow(std::pow(d, params.a), params.b)) * invSigma2);
+			}
+		}
+	}
+
+	//! Calls func(i, x, y, z) for each voxel i = (x, y, z) of an image of the given size, in parallel over the
+	//! image lines; each thread keeps its own scratch data created by makeThreadData(threadIndex),
+	//! which func gets passed as additional, last argument.
+	template <typename MakeThreadData, typename Func>
+	void forEachVoxel(int const dim[3], int threadCount, MakeThreadData makeThreadData, Func func)
+	{
+		qint64 const lineCount = static_cast<qint64>(dim[1]) * dim[2];
+#pragma omp parallel num_threads(threadCount)
+		{
+			auto threadData = makeThreadData(omp_get_thread_num());
+#pragma omp for schedule(static)
+			for (qint64 line = 0; line < lineCount; ++line)
+			{
+				int y = static_cast<int>(line % dim[1]);
+				int z = static_cast<int>(line / dim[1]);
+				for (int x = 0; x < dim[0]; ++x)
+				{
+					func(line * dim[0] + x, x, y, z, threadData);
+				}
+			}
+		}
+	}
+
+	//! whether the neighbor at the given offset of voxel (x, y, z) lies within an image of the given size
+	inline bool neighborInside(int x, int y, int z, std::array<int, 3> const& o, int const dim[3])
+	{
+		return x + o[0] >= 0 && x + o[0] < dim[0] &&
+			y + o[1] >= 0 && y + o[1] < dim[1] &&
+			z + o[2] >= 0 && z + o[2] < dim[2];
+	}
+
+	//! the offsets of the neighbors in the (x-y-z ordered) voxel buffer of an image of the given size
+	inline std::vector<qint64> linearOffsets(std::vector<std::array<int, 3>> const& offsets, int const dim[3])
+	{
+		std::vector<qint64> result;
+		for (auto const& o : offsets)
+		{
+			result.push_back(o[0] + static_cast<qint64>(o[1]) * dim[0] + static_cast<qint64>(o[2]) * dim[0] * dim[1]);
+		}
+		return result;
+	}
+
+	//! per-thread scratch data of the kernelized FCM variants
+	struct iAKFCMThreadData
+	{
+		double* num;    //!< partial sums of the centroid numerators
+		double* den;    //!< partial sums of the centroid denominators
+		std::vector<double> a, b, c, d;    //!< per-class temporaries
+	};
+}
+
+//! Spatially constrained fuzzy c-means based on a kernel-induced distance (KFCMS; S.C. Chen and D.Q. Zhang,
+//! "Robust image segmentation using FCM with spatial constraints based on new kernel-induced distance
+//! measure", IEEE Transactions on Systems, Man, and Cybernetics, Part B, 34(4), 1907-1916, 2004), computing
+//! the same as itk::KFCMSClassifierInitializationImageFilter.
+//! Per iteration, the kernel values of all voxels are computed in one parallel pass; a second parallel pass
+//! computes the memberships from them and accumulates the centroid updates into per-thread partial sums
+//! (combined in thread order, so the result does not depend on the scheduling).
+//! @param values the (x-y-z ordered) voxel values of the image to cluster
+//! @param dim the size of the image
+//! @param params the clustering parameters; neighborOffsets should not contain the voxel itself
+//! @param membership output; the membership of each voxel to each class, computed in the last iteration
+//!        (i.e. with the centroids before their last update), stored voxel by voxel
+//! @param progress optional progress indicator
+template <typename T>
+iAFCMResult kernelizedFCMS(T const* values, int const dim[3], iAKFCMParameters const& params, double* membership,
+	iAProgress const* progress = nullptr)
+{
+	iAFCMResult result;
+	result.centroids = params.centroids;
+	size_t const classCount = params.centroids.size();
+	qint64 const count = static_cast<qint64>(dim[0]) * dim[1] * dim[2];
+	double const exponent = -1.0 / (params.m - 1);
+	int const threadCount = std::max(1, params.threadCount);
+	auto const offsets = iAFCM::linearOffsets(params.neighborOffsets, dim);
+	auto isBackground = [&params](double x) { return params.ignoreBackground && x == params.backgroundValue; };
+	std::vector<double> kernel(count * classCount);
+	std::vector<double> partialNum(threadCount * classCount), partialDen(threadCount * classCount), num, den;
+	auto makeThreadData = [&](int t)
+	{
+		return iAFCM::iAKFCMThreadData{partialNum.data() + t * classCount, partialDen.data() + t * classCount,
+			std::vector<double>(classCount), std::vector<double>(classCount),
+			std::vector<double>(classCount), std::vector<double>(classCount)};
+	};
+	do
+	{
+		iAFCM::computeKernel(values, count, result.centroids, params, kernel.data());
+		std::fill(partialNum.begin(), partialNum.end(), 0.0);
+		std::fill(partialDen.begin(), partialDen.end(), 0.0);
+		iAFCM::forEachVoxel(dim, threadCount, makeThreadData,
+			[&](qint64 i, int x, int y, int z, iAFCM::iAKFCMThreadData& t)
+			{
+				double* u = membership + i * classCount;
+				double v = values[i];
+				if (isBackground(v))
+				{
+					std::fill(u, u + classCount, iAFCM::BackgroundMembership);
+					return;
+				}
+				// neighborhood terms: sum of (1-K)^m, K*value and K over all (non-background) neighbors:
+				auto& nMembership = t.a;
+				auto& nNum = t.b;
+				auto& nDen = t.c;
+				auto& uNum = t.d;
+				std::fill(nMembership.begin(), nMembership.end(), 0.0);
+				std::fill(nNum.begin(), nNum.end(), 0.0);
+				std::fill(nDen.begin(), nDen.end(), 0.0);
+				int neighborCount = 0;
+				for (size_t o = 0; o < offsets.size(); ++o)
+				{
+					if (!iAFCM::neighborInside(x, y, z, params.neighborOffsets[o], dim))
+					{
+						continue;
+					}
+					qint64 n = i + offsets[o];
+					double nv = values[n];
+					if (isBackground(nv))
+					{
+						continue;
+					}
+					double const* kn = kernel.data() + n * classCount;
+					for (size_t k = 0; k < classCount; ++k)
+					{
+						nMembership[k] += iAFCM::powM(1.0 - kn[k], params.m);
+						nNum[k] += kn[k] * nv;
+						nDen[k] += kn[k];
+					}
+					++neighborCount;
+				}
+				double penalty = (neighborCount == 0) ? 0 : params.alpha / neighborCount;
+				double const* kx = kernel.data() + i * classCount;
+				double uDen = 0;
+				for (size_t k = 0; k < classCount; ++k)
+				{
+					uNum[k] = iAFCM::powMembership((1.0 - kx[k]) + penalty * nMembership[k], exponent);
+					uDen += uNum[k];
+				}
+				for (size_t k = 0; k < classCount; ++k)
+				{
+					u[k] = (std::isinf(uNum[k]) && std::isinf(uDen)) ? 1.0 : uNum[k] / uDen;
+					double um = iAFCM::powM(u[k], params.m);
+					t.num[k] += um * (kx[k] * v + penalty * nNum[k]);
+					t.den[k] += um * (kx[k] + penalty * nDen[k]);
+				}
+			});
+		iAFCM::combinePartialSums(partialNum, partialDen, threadCount, classCount, num, den);
+		result.error = iAFCM::updateCentroids(result.centroids, num, den);
+		++result.iterations;
+		if (progress)
+		{
+			progress->emitProgress(100.0 * result.iterations / params.maxIterations);
+		}
+	} while (result.error > params.maxError && result.iterations < params.maxIterations);
+	return result;
+}
+
+//! Modified spatial kernelized fuzzy c-means (MSKFCM; Castro et al., "Comparison of various fuzzy clustering
+//! algorithms in the detection of ROI in lung CT and a modified kernelized-spatial fuzzy c-means algorithm",
+//! Proc. of 10th IEEE Int. Conf. On Inf. Tech. and Appl. in Biom., 2010), computing the same as
+//! itk::MSKFCMClassifierInitializationImageFilter.
+//! Per iteration, a first parallel pass computes the kernel values and the KFCM memberships of all voxels; a
+//! second parallel pass combines them with the memberships summed over the neighborhood and accumulates the
+//! centroid updates into per-thread partial sums (combined in thread order).
+//! @param values the (x-y-z ordered) voxel values of the image to cluster
+//! @param dim the size of the image
+//! @param params the clustering parameters; neighborOffsets typically contains the voxel itself
+//! @param membership output; the membership of each voxel to each class, computed in the last iteration
+//!        (i.e. with the centroids before their last update), stored voxel by voxel
+//! @param progress optional progress indicator
+template <typename T>
+iAFCMResult modifiedSpatialKFCM(T const* values, int const dim[3], iAKFCMParameters const& params, double* membership,
+	iAProgress const* progress = nullptr)
+{
+	iAFCMResult result;
+	result.centroids = params.centroids;
+	size_t const classCount = params.centroids.size();
+	qint64 const count = static_cast<qint64>(dim[0]) * dim[1] * dim[2];
+	double const exponent = -1.0 / (params.m - 1);
+	int const threadCount = std::max(1, params.threadCount);
+	auto const offsets = iAFCM::linearOffsets(params.neighborOffsets, dim);
+	auto isBackground = [&params](double x) { return params.ignoreBackground && x == params.backgroundValue; };
+	// the kernel values are stored in the membership output; each voxel only needs its own kernel
+	// values in the second pass, before it overwrites them with its memberships
+	double* kernel = membership;
+	std::vector<double> kfcmMembership(count * classCount);
+	std::vector<double> partialNum(threadCount * classCount), partialDen(threadCount * classCount), num, den;
+	auto makeThreadData = [&](int t)
+	{
+		return iAFCM::iAKFCMThreadData{partialNum.data() + t * classCount, partialDen.data() + t * classCount,
+			std::vector<double>(classCount), std::vector<double>(), std::vector<double>(), std::vector<double>()};
+	};
+	do
+	{
+		iAFCM::computeKernel(values, count, result.centroids, params, kernel);
+#pragma omp parallel for num_threads(threadCount) schedule(static)
+		for (qint64 i = 0; i < count; ++i)
+		{
+			double* u = kfcmMembership.data() + i * classCount;
+			if (isBackground(values[i]))
+			{
+				std::fill(u, u + classCount, iAFCM::BackgroundMembership);
+				continue;
+			}
+			double const* kx = kernel + i * classCount;
+			double uDen = 0;
+			for (size_t k = 0; k < classCount; ++k)
+			{
+				u[k] = iAFCM::powMembership(1.0 - kx[k], exponent);
+				uDen += u[k];
+			}
+			for (size_t k = 0; k < classCount; ++k)
+			{
+				u[k] = (std::isinf(u[k]) && std::isinf(uDen)) ? 1.0 : u[k] / uDen;
+			}
+		}
+		std::fill(partialNum.begin(), partialNum.end(), 0.0);
+		std::fill(partialDen.begin(), partialDen.end(), 0.0);
+		iAFCM::forEachVoxel(dim, threadCount, makeThreadData,
+			[&](qint64 i, int x, int y, int z, iAFCM::iAKFCMThreadData& t)
+			{
+				double* u = membership + i * classCount;
+				double v = values[i];
+				if (isBackground(v))
+				{
+					std::fill(u, u + classCount, iAFCM::BackgroundMembership);
+					return;
+				}
+				// spatial function h: KFCM memberships summed over all (non-background) neighbors:
+				auto& h = t.a;
+				std::fill(h.begin(), h.end(), 0.0);
+				for (size_t o = 0; o < offsets.size(); ++o)
+				{
+					if (!iAFCM::neighborInside(x, y, z, params.neighborOffsets[o], dim))
+					{
+						continue;
+					}
+					qint64 n = i + offsets[o];
+					if (isBackground(values[n]))
+					{
+						continue;
+					}
+					double const* un = kfcmMembership.data() + n * classCount;
+					for (size_t k = 0; k < classCount; ++k)
+					{
+						h[k] += un[k];
+					}
+				}
+				double const* ux = kfcmMembership.data() + i * classCount;
+				double uDen = 0;
+				for (size_t k = 0; k < classCount; ++k)
+				{   // u is still holding the kernel values of this voxel; h is not needed anymore after this:
+					h[k] = std::pow(ux[k], params.p) * std::pow(h[k], params.q);
+					uDen += h[k];
+				}
+				for (size_t k = 0; k < classCount; ++k)
+				{
+					double kx = u[k];
+					u[k] = h[k] / uDen;
+					double um = iAFCM::powM(u[k], params.m);
+					t.num[k] += v * kx * um;
+					t.den[k] += um * kx;
+				}
+			});
+		iAFCM::combinePartialSums(partialNum, partialDen, threadCount, classCount, num, den);
+		result.error = iAFCM::updateCentroids(result.centroids, num, den);
+		++result.iterations;
+		if (progress)
+		{
+			progress->emitProgress(100.0 * result.iterations / params.maxIterations);
+		}
+	} while (result.error > params.maxError && result.iterations < params.maxIterations);
+	return result;
+}
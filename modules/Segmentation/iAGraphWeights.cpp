@@ -9,11 +9,16 @@
 
 #include <algorithm>
 #include <cassert>
+#include <vector>
 
 iAGraphWeights::iAGraphWeights(iAEdgeIndexType edgeCount):
 m_weights(edgeCount)
 {}
 
+iAGraphWeights::iAGraphWeights(QVector<iAEdgeWeightType> const & weights):
+m_weights(weights)
+{}
+
 iAEdgeWeightType iAGraphWeights::GetMaxWeight() const
 {
 	return *std::max_element(m_weights.begin(), m_weights.end());
@@ -34,7 +39,8 @@ void iAGraphWeights::Normalize(std::shared_ptr<iANormalizer> normalizeFunc)
 {
 	iAEdgeWeightType max = GetMaxWeight();
 	normalizeFunc->SetMaxValue(max);
-	for (int i=0; i<m_weights.size(); ++i)
+#pragma omp parallel for
+	for (qsizetype i=0; i<m_weights.size(); ++i)
 	{
 					// 1-x - because we need "resistance" for RW, not "conductance"
 		m_weights[i] = 1 - normalizeFunc->Normalize(m_weights[i]);
@@ -51,14 +57,19 @@ std::shared_ptr<iAGraphWeights> CalculateGraphWeights(
 	iAVectorArray const & voxelData,
 	iAVectorDistance const & distanceFunc)
 {
-	auto result = std::make_shared<iAGraphWeights>(graph.edgeCount());
-	for (iAEdgeIndexType i=0; i<graph.edgeCount(); ++i)
+	// copy the voxel data into channel-major layout once, so that the distance measure
+	// can process all edges in a single call, with direct access to the values:
+	size_t voxelCount = voxelData.size();
+	size_t channelCount = voxelData.channelCount();
+	std::vector<iAVectorDataType> values(voxelCount * channelCount);
+	for (size_t c = 0; c < channelCount; ++c)
 	{
-		iAEdgeType edge = graph.edge(i);
-		iADistanceType dist = distanceFunc.GetDistance(voxelData.get(edge.first), voxelData.get(edge.second));
-		result->SetWeight(i, dist);
+		voxelData.getChannel(c, values.data() + c * voxelCount);
 	}
-	return result;
+	QVector<iAEdgeWeightType> weights(graph.edgeCount());
+	distanceFunc.GetDistances(iAChannelMajorData{ values.data(), voxelCount, channelCount },
+		graph.edges().constData(), graph.edgeCount(), weights.data());
+	return std::make_shared<iAGraphWeights>(weights);
 }
 
 
@@ -70,10 +81,11 @@ std::shared_ptr<iAGraphWeights const> CombineGraphWeights(
 	assert(graphWeights.size() == weight.size());
 	auto edgeCount = graphWeights[0]->GetEdgeCount();
 	std::shared_ptr<iAGraphWeights> result(new iAGraphWeights(edgeCount));
-	for (int edgeIdx=0; edgeIdx<edgeCount; ++edgeIdx)
+#pragma omp parallel for
+	for (qsizetype edgeIdx=0; edgeIdx<edgeCount; ++edgeIdx)
 	{
 		double combinedWeight = 0;
-		for (int channelIdx=0; channelIdx<graphWeights.size(); ++channelIdx)
+		for (qsizetype channelIdx=0; channelIdx<graphWeights.size(); ++channelIdx)
 		{
 			combinedWeight += weight[channelIdx] * graphWeights[channelIdx]->GetWeight(edgeIdx);
 		}
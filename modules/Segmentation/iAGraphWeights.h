@@ -17,6 +17,7 @@ class iAGraphWeights
 {
 public:
 	iAGraphWeights(iAEdgeIndexType edgeCount);
+	iAGraphWeights(QVector<iAEdgeWeightType> const & weights);
 	void Normalize(std::shared_ptr<iANormalizer> normalizeFunc);
 	iAEdgeWeightType GetMaxWeight() const;
 	iAEdgeWeightType GetWeight(iAEdgeIndexType edgeIdx) const;
@@ -167,6 +167,11 @@ iAEdgeType const & iAImageGraph::edge(iAEdgeIndexType idx) const
 	return m_edges[idx];
 }
 
+QVector<iAEdgeType> const & iAImageGraph::edges() const
+{
+	return m_edges;
+}
+
 void iAImageGraph::addEdge(iAImageCoordinate voxel1, iAImageCoordinate voxel2)
 {
 	auto idx1 = m_converter.indexFromCoordinates(voxel1);
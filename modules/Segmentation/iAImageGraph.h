@@ -38,6 +38,8 @@ public:
 
 	iAEdgeIndexType edgeCount() const;
 	iAEdgeType const & edge(iAEdgeIndexType idx) const;
+	//! all edges of the graph (the index of an edge in this list is its edge index)
+	QVector<iAEdgeType> const & edges() const;
 	bool containsEdge(iAFlatIndexType voxel1, iAFlatIndexType voxel2);
 	bool containsEdge(iAImageCoordinate voxel1, iAImageCoordinate voxel2);
 	iAImageCoordConverter const & converter() const;
@@ -16,4 +16,6 @@ public:
 	virtual size_t channelCount() const =0;
 	virtual std::shared_ptr<iAVectorType const> get(size_t voxelIdx) const =0;
 	virtual iAVectorDataType get(size_t voxelIdx, size_t channelIdx) const =0;
+	//! copy the values of all voxels for the given channel into out (which needs space for size() values)
+	virtual void getChannel(size_t channelIdx, iAVectorDataType* out) const;
 };
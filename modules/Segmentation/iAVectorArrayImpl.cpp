@@ -2,9 +2,22 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iAVectorArrayImpl.h"
 
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+
+#include <QtGlobal>    // for qint64
+
 iAVectorArray::~iAVectorArray()
 {}
 
+void iAVectorArray::getChannel(size_t channelIdx, iAVectorDataType* out) const
+{
+	for (size_t voxelIdx = 0; voxelIdx < size(); ++voxelIdx)
+	{
+		out[voxelIdx] = get(voxelIdx, channelIdx);
+	}
+}
+
 iAvtkPixelVectorArray::iAvtkPixelVectorArray(int const * dim):
 	m_coordConv(dim[0], dim[1], dim[2])
 {}
@@ -40,3 +53,21 @@ iAVectorDataType iAvtkPixelVectorArray::get(size_t voxelIdx, size_t channelIdx)
 	iAVectorDataType value = m_images[channelIdx]->GetScalarComponentAsDouble(coords.x, coords.y, coords.z, 0);
 	return value;
 }
+
+void iAvtkPixelVectorArray::getChannel(size_t channelIdx, iAVectorDataType* out) const
+{
+	// m_coordConv uses the same x, y, z ordering as vtk, so the flat index is the point ID
+	// and the scalars can be read directly, without converting coordinates for each voxel
+	vtkDataArray* scalars = m_images[channelIdx]->GetPointData()->GetScalars();
+	if (!scalars)
+	{
+		iAVectorArray::getChannel(channelIdx, out);
+		return;
+	}
+	qint64 const voxelCount = static_cast<qint64>(size());
+#pragma omp parallel for
+	for (qint64 voxelIdx = 0; voxelIdx < voxelCount; ++voxelIdx)
+	{
+		out[voxelIdx] = scalars->GetComponent(voxelIdx, 0);
+	}
+}
@@ -30,6 +30,7 @@ public:
 	size_t channelCount() const override;
 	std::shared_ptr<iAVectorType const> get(size_t voxelIdx) const override;
 	iAVectorDataType get(size_t voxelIdx, size_t channelIdx) const override;
+	void getChannel(size_t channelIdx, iAVectorDataType* out) const override;
 	void AddImage(vtkSmartPointer<vtkImageData> img);
 private:
 	std::vector<vtkSmartPointer<vtkImageData> > m_images;
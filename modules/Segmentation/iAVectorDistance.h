@@ -4,7 +4,25 @@
 
 #include "iAVectorType.h"
 
+#include <cstddef> // for size_t
 #include <memory>
+#include <utility> // for std::pair
+
+//! read-only view on multi-channel data stored channel-major, i.e. the values of all voxels
+//! for the first channel, followed by the values of all voxels for the second channel, and so on
+struct iAChannelMajorData
+{
+	iAVectorDataType const * values; //!< channelCount * voxelCount values
+	size_t voxelCount;
+	size_t channelCount;
+	iAVectorDataType get(size_t voxelIdx, size_t channelIdx) const
+	{
+		return values[channelIdx * voxelCount + voxelIdx];
+	}
+};
+
+//! indices of two voxels whose vectors should be compared
+using iAVectorIndexPair = std::pair<size_t, size_t>;
 
 //! abstract base class for the distance between two vectors of same length
 class Segmentation_API iAVectorDistance
@@ -15,5 +33,10 @@ public:
 	virtual char const * GetShortName() const =0;
 	virtual char const * name() const =0;
 	virtual double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const = 0;
+	//! Computes the distances for many pairs of vectors at once, in parallel:
+	//! result[i] is the distance between the vectors of voxels pairs[i].first and pairs[i].second in data.
+	//! The default implementation calls GetDistance for each pair; the measures in iAVectorDistanceImpl.h
+	//! override it with kernels processing blocks of pairs channel by channel.
+	virtual void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const;
 	virtual bool isSymmetric() const;
 };
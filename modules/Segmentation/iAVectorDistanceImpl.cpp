@@ -6,6 +6,7 @@
 
 #include <QVector>
 
+#include <algorithm>
 #include <numeric>
 #include <cmath>
 
@@ -74,6 +75,93 @@ namespace
 		// ----------
 		std::make_shared<iANullDistance>()
 	};
+
+	//! a single vector in channel-major data (for the default implementation of the batch distance computation)
+	class iAChannelMajorVector : public iAVectorType
+	{
+	public:
+		iAChannelMajorVector(iAChannelMajorData const & data, size_t voxelIdx) :
+			m_data(data),
+			m_voxelIdx(voxelIdx)
+		{}
+		iAVectorDataType get(IndexType channelIdx) const override
+		{
+			return m_data.get(m_voxelIdx, channelIdx);
+		}
+		IndexType size() const override
+		{
+			return m_data.channelCount;
+		}
+	private:
+		iAChannelMajorData const & m_data;
+		size_t m_voxelIdx;
+	};
+
+	//! number of pairs processed together by the batch kernels; the kernels keep a few accumulators
+	//! per pair, for this block size all of them fit into the L1 cache
+	constexpr size_t BlockSize = 256;
+
+	//! Calls blockFunc(pairs, count, result) for consecutive blocks of at most BlockSize pairs, in parallel
+	template <typename BlockFunc>
+	void forPairBlocks(iAVectorIndexPair const * pairs, size_t pairCount, double * result, BlockFunc blockFunc)
+	{
+		qint64 const blockCount = static_cast<qint64>((pairCount + BlockSize - 1) / BlockSize);
+#pragma omp parallel for schedule(static) if (blockCount > 1)
+		for (qint64 b = 0; b < blockCount; ++b)
+		{
+			size_t const start = b * BlockSize;
+			blockFunc(pairs + start, std::min(BlockSize, pairCount - start), result + start);
+		}
+	}
+
+	//! For each pair in a block, accumulates a term over all channels, in channel order:
+	//! acc[i] = op(acc[i], value of first vector, value of second vector).
+	//! Iterating over the channels in the outer loop accesses each channel's data in one sweep
+	//! and leaves an inner loop without dependencies between iterations.
+	template <typename Op>
+	void accumulate(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t count, double * acc, Op op)
+	{
+		for (size_t c = 0; c < data.channelCount; ++c)
+		{
+			iAVectorDataType const * channel = data.values + c * data.voxelCount;
+			for (size_t i = 0; i < count; ++i)
+			{
+				acc[i] = op(acc[i], channel[pairs[i].first], channel[pairs[i].second]);
+			}
+		}
+	}
+
+	//! the sums over all channels of the two vectors of each pair (required for normalizing them)
+	void vectorSums(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t count, double * sum1, double * sum2)
+	{
+		std::fill(sum1, sum1 + count, 0.0);
+		std::fill(sum2, sum2 + count, 0.0);
+		for (size_t c = 0; c < data.channelCount; ++c)
+		{
+			iAVectorDataType const * channel = data.values + c * data.voxelCount;
+			for (size_t i = 0; i < count; ++i)
+			{
+				sum1[i] += channel[pairs[i].first];
+				sum2[i] += channel[pairs[i].second];
+			}
+		}
+	}
+
+	//! adds the term of one channel to the Kullback-Leibler divergence of normalized values s1 and s2
+	double addKLDTerm(double kldiv, double s1, double s2)
+	{
+		double logTerm = (s2 == 0)? 0 : (s1 / s2);
+		if (qIsInf(logTerm) || qIsNaN(logTerm))
+		{
+			logTerm = 0;
+		}
+		kldiv += (logTerm == 0)? 0 : (std::log(logTerm) * s1);
+		if (qIsInf(kldiv) || qIsNaN(kldiv))
+		{
+			kldiv = 0;
+		}
+		return kldiv;
+	}
 }
 
 
@@ -131,6 +219,18 @@ std::shared_ptr<iAVectorDistance> GetDistanceMeasureFromShortName(QString const
 iAVectorDistance::~iAVectorDistance()
 {}
 
+void iAVectorDistance::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [this, &data](iAVectorIndexPair const * blockPairs, size_t count, double * blockResult)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			blockResult[i] = GetDistance(std::make_shared<iAChannelMajorVector>(data, blockPairs[i].first),
+				std::make_shared<iAChannelMajorVector>(data, blockPairs[i].second));
+		}
+	});
+}
+
 bool iAVectorDistance::isSymmetric() const
 {
 	return true;
@@ -170,6 +270,35 @@ double iASpectralAngularDistance::GetDistance(std::shared_ptr<iAVectorType const
 	return clamp(-1.0, 1.0, cosAngle);
 }
 
+void iASpectralAngularDistance::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [&data](iAVectorIndexPair const * blockPairs, size_t count, double * prod)
+	{
+		double len1[BlockSize], len2[BlockSize];
+		std::fill(prod, prod + count, 0.0);
+		std::fill(len1, len1 + count, 0.0);
+		std::fill(len2, len2 + count, 0.0);
+		for (size_t c = 0; c < data.channelCount; ++c)
+		{
+			iAVectorDataType const * channel = data.values + c * data.voxelCount;
+			for (size_t i = 0; i < count; ++i)
+			{
+				double v1 = channel[blockPairs[i].first];
+				double v2 = channel[blockPairs[i].second];
+				prod[i] += v1 * v2;
+				len1[i] += v1 * v1;
+				len2[i] += v2 * v2;
+			}
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			double l1 = std::sqrt(len1[i]);
+			double l2 = std::sqrt(len2[i]);
+			prod[i] = (l1 == 0 || l2 == 0) ? 0 : clamp(-1.0, 1.0, prod[i] / (l1 * l2));
+		}
+	});
+}
+
 char const * iAL1NormDistance::GetShortName() const
 {
 	return MeasureShortNames[dmL1];
@@ -191,6 +320,15 @@ double iAL1NormDistance::GetDistance(std::shared_ptr<iAVectorType const> spec1,
 	return sum;
 }
 
+void iAL1NormDistance::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [&data](iAVectorIndexPair const * blockPairs, size_t count, double * sum)
+	{
+		std::fill(sum, sum + count, 0.0);
+		accumulate(data, blockPairs, count, sum, [](double acc, double v1, double v2) { return acc + std::abs(v1 - v2); });
+	});
+}
+
 char const * iAL2NormDistance::GetShortName() const
 {
 	return MeasureShortNames[dmL2];
@@ -213,6 +351,19 @@ double iAL2NormDistance::GetDistance(std::shared_ptr<iAVectorType const> spec1,
 	return std::sqrt(sum);
 }
 
+void iAL2NormDistance::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [&data](iAVectorIndexPair const * blockPairs, size_t count, double * sum)
+	{
+		std::fill(sum, sum + count, 0.0);
+		accumulate(data, blockPairs, count, sum, [](double acc, double v1, double v2) { return acc + (v1 - v2) * (v1 - v2); });
+		for (size_t i = 0; i < count; ++i)
+		{
+			sum[i] = std::sqrt(sum[i]);
+		}
+	});
+}
+
 char const * iALInfNormDistance::GetShortName() const
 {
 	return MeasureShortNames[dmLinf];
@@ -238,6 +389,15 @@ double iALInfNormDistance::GetDistance(std::shared_ptr<iAVectorType const> spec1
 	return maxDist;
 }
 
+void iALInfNormDistance::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [&data](iAVectorIndexPair const * blockPairs, size_t count, double * maxDist)
+	{
+		std::fill(maxDist, maxDist + count, 0.0);
+		accumulate(data, blockPairs, count, maxDist, [](double acc, double v1, double v2) { return std::max(acc, std::abs(v1 - v2)); });
+	});
+}
+
 char const * iAJensenShannonDistance::GetShortName() const
 {
 	return MeasureShortNames[dmJensenShannon];
@@ -254,6 +414,32 @@ double iAJensenShannonDistance::GetDistance(std::shared_ptr<iAVectorType const>
 	return std::sqrt(0.5 * kld.GetDistance(spec1, spec2) + 0.5 * kld.GetDistance(spec2, spec1));
 }
 
+void iAJensenShannonDistance::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [&data](iAVectorIndexPair const * blockPairs, size_t count, double * jsd)
+	{
+		double sum1[BlockSize], sum2[BlockSize], kld12[BlockSize], kld21[BlockSize];
+		vectorSums(data, blockPairs, count, sum1, sum2);
+		std::fill(kld12, kld12 + count, 0.0);
+		std::fill(kld21, kld21 + count, 0.0);
+		for (size_t c = 0; c < data.channelCount; ++c)
+		{
+			iAVectorDataType const * channel = data.values + c * data.voxelCount;
+			for (size_t i = 0; i < count; ++i)
+			{
+				double s1 = channel[blockPairs[i].first] / sum1[i];
+				double s2 = channel[blockPairs[i].second] / sum2[i];
+				kld12[i] = addKLDTerm(kld12[i], s1, s2);
+				kld21[i] = addKLDTerm(kld21[i], s2, s1);
+			}
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			jsd[i] = std::sqrt(0.5 * kld12[i] + 0.5 * kld21[i]);
+		}
+	});
+}
+
 char const * iAKullbackLeiblerDivergence::GetShortName() const
 {
 	return MeasureShortNames[dmKullbackLeibler];
@@ -272,20 +458,29 @@ double iAKullbackLeiblerDivergence::GetDistance(std::shared_ptr<iAVectorType con
 	std::shared_ptr<iAVectorType const> s2 = spec2->normalized();
 	for(iAVectorType::IndexType i = 0; i<s1->size(); ++i)
 	{
-		double logTerm = (s2->get(i) == 0)? 0 : (s1->get(i) / s2->get(i));
-		if (qIsInf(logTerm) || qIsNaN(logTerm))
-		{
-			logTerm = 0;
-		}
-		kldiv += (logTerm == 0)? 0 : (std::log(logTerm) * (s1->get(i)));
-		if (qIsInf(kldiv) || qIsNaN(kldiv))
-		{
-			kldiv = 0;
-		}
+		kldiv = addKLDTerm(kldiv, s1->get(i), s2->get(i));
 	}
 	return kldiv;
 }
 
+void iAKullbackLeiblerDivergence::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [&data](iAVectorIndexPair const * blockPairs, size_t count, double * kldiv)
+	{
+		double sum1[BlockSize], sum2[BlockSize];
+		vectorSums(data, blockPairs, count, sum1, sum2);
+		std::fill(kldiv, kldiv + count, 0.0);
+		for (size_t c = 0; c < data.channelCount; ++c)
+		{
+			iAVectorDataType const * channel = data.values + c * data.voxelCount;
+			for (size_t i = 0; i < count; ++i)
+			{
+				kldiv[i] = addKLDTerm(kldiv[i], channel[blockPairs[i].first] / sum1[i], channel[blockPairs[i].second] / sum2[i]);
+			}
+		}
+	});
+}
+
 char const * iAChiSquareDistance::GetShortName() const
 {
 	return MeasureShortNames[dmChiSquare];
@@ -309,6 +504,30 @@ double iAChiSquareDistance::GetDistance(std::shared_ptr<iAVectorType const> spec
 	return chiSquare / 2.0;
 }
 
+void iAChiSquareDistance::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [&data](iAVectorIndexPair const * blockPairs, size_t count, double * chiSquare)
+	{
+		double sum1[BlockSize], sum2[BlockSize];
+		vectorSums(data, blockPairs, count, sum1, sum2);
+		std::fill(chiSquare, chiSquare + count, 0.0);
+		for (size_t c = 0; c < data.channelCount; ++c)
+		{
+			iAVectorDataType const * channel = data.values + c * data.voxelCount;
+			for (size_t i = 0; i < count; ++i)
+			{
+				double s1 = channel[blockPairs[i].first] / sum1[i];
+				double s2 = channel[blockPairs[i].second] / sum2[i];
+				chiSquare[i] += (s1 - s2) * (s1 - s2) / (s1 + s2);
+			}
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			chiSquare[i] /= 2.0;
+		}
+	});
+}
+
 char const * iAEarthMoversDistance::GetShortName() const
 {
 	return MeasureShortNames[dmEarthMovers];
@@ -336,6 +555,27 @@ double iAEarthMoversDistance::GetDistance(std::shared_ptr<iAVectorType const> sp
 	return emd;
 }
 
+void iAEarthMoversDistance::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [&data](iAVectorIndexPair const * blockPairs, size_t count, double * emd)
+	{
+		double sum1[BlockSize], sum2[BlockSize], lastEmd[BlockSize];
+		vectorSums(data, blockPairs, count, sum1, sum2);
+		std::fill(emd, emd + count, 0.0);
+		std::fill(lastEmd, lastEmd + count, 0.0);
+		for (size_t c = 0; c < data.channelCount; ++c)
+		{
+			iAVectorDataType const * channel = data.values + c * data.voxelCount;
+			for (size_t i = 0; i < count; ++i)
+			{
+				double newEmd = channel[blockPairs[i].first] / sum1[i] + lastEmd[i] - channel[blockPairs[i].second] / sum2[i];
+				emd[i] += std::abs(newEmd);
+				lastEmd[i] = newEmd;
+			}
+		}
+	});
+}
+
 char const * iASquaredDistance::GetShortName() const
 {
 	return MeasureShortNames[dmSquared];
@@ -357,6 +597,20 @@ double iASquaredDistance::GetDistance(std::shared_ptr<iAVectorType const> spec1,
 	return sum;
 }
 
+void iASquaredDistance::GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const
+{
+	forPairBlocks(pairs, pairCount, result, [&data](iAVectorIndexPair const * blockPairs, size_t count, double * sum)
+	{
+		std::fill(sum, sum + count, 0.0);
+		accumulate(data, blockPairs, count, sum, [](double acc, double v1, double v2) { return acc + (v1 - v2) * (v1 - v2); });
+	});
+}
+
+void iANullDistance::GetDistances(iAChannelMajorData const & /*data*/, iAVectorIndexPair const * /*pairs*/, size_t pairCount, double * result) const
+{
+	std::fill(result, result + pairCount, 0.0);
+}
+
 
 /*
 
@@ -34,6 +34,7 @@ public:
 	char const * name() const override;
 	char const * GetShortName() const override;
 	double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const override;
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 };
 
 class Segmentation_API iAL1NormDistance: public iAVectorDistance
@@ -42,6 +43,7 @@ public:
 	char const * name() const override;
 	char const * GetShortName() const override;
 	double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const override;
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 };
 
 class Segmentation_API iAL2NormDistance: public iAVectorDistance
@@ -50,6 +52,7 @@ public:
 	char const * name() const override;
 	char const * GetShortName() const override;
 	double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const override;
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 };
 
 class Segmentation_API iALInfNormDistance: public iAVectorDistance
@@ -58,6 +61,7 @@ public:
 	char const * name() const override;
 	char const * GetShortName() const override;
 	double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const override;
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 };
 
 class Segmentation_API iAJensenShannonDistance : public iAVectorDistance
@@ -66,6 +70,7 @@ public:
 	char const * name() const override;
 	char const * GetShortName() const override;
 	double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const override;
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 };
 
 class Segmentation_API iAKullbackLeiblerDivergence : public iAVectorDistance
@@ -74,6 +79,7 @@ public:
 	char const * name() const override;
 	char const * GetShortName() const override;
 	double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const override;
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 	bool isSymmetric() const  override {return false; }
 };
 
@@ -83,6 +89,7 @@ public:
 	char const * name() const override;
 	char const * GetShortName() const override;
 	double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const override;
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 };
 
 class Segmentation_API iAEarthMoversDistance: public iAVectorDistance
@@ -91,6 +98,7 @@ public:
 	char const * name() const override;
 	char const * GetShortName() const override;
 	double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const override;
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 };
 
 class Segmentation_API iASquaredDistance: public iAVectorDistance
@@ -99,6 +107,7 @@ public:
 	char const * name() const override;
 	char const * GetShortName() const override;
 	double GetDistance(std::shared_ptr<iAVectorType const> spec1, std::shared_ptr<iAVectorType const> spec2) const override;
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 };
 
 class Segmentation_API iANullDistance: public iAVectorDistance
@@ -107,6 +116,7 @@ public:
 	char const * name() const override { return "Null Dist."; }
 	char const * GetShortName() const  override { return "null"; }
 	double GetDistance(std::shared_ptr<iAVectorType const> /*spec1*/, std::shared_ptr<iAVectorType const> /*spec2*/) const override { return 0; }
+	void GetDistances(iAChannelMajorData const & data, iAVectorIndexPair const * pairs, size_t pairCount, double * result) const override;
 };
 
 /*
@@ -0,0 +1,67 @@
+// Copyright (c) open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASimpleTester.h"
+#include "iAVoxelKernels.h"
+
+#include <vector>
+
+BEGIN_TEST
+	// more values than in one chunk, and not a multiple of the chunk size:
+	const qint64 count = 3 * VoxelKernelChunkSize + 17;
+	std::vector<float> a(count);
+	std::vector<int> b(count);
+	std::vector<unsigned char> c(count);
+	for (qint64 i = 0; i < count; ++i)
+	{
+		a[i] = static_cast<float>(i % 100) / 4;
+		b[i] = static_cast<int>(i % 7) - 3;
+		c[i] = static_cast<unsigned char>(i % 3);
+	}
+
+	// unary:
+	std::vector<float> unary(a);
+	transformVoxels(unary.data(), count, [](float v) { return 2 * v; });
+	bool unaryOK = true;
+	for (qint64 i = 0; i < count; ++i)
+	{
+		unaryOK &= (unary[i] == 2 * a[i]);
+	}
+	TestAssert(unaryOK);
+
+	// binary, with conversion to the destination type:
+	std::vector<int> binary(b);
+	transformVoxels(binary.data(), a.data(), count, [](int x, float y) { return x + y; });
+	bool binaryOK = true;
+	for (qint64 i = 0; i < count; ++i)
+	{
+		binaryOK &= (binary[i] == static_cast<int>(b[i] + a[i]));
+	}
+	TestAssert(binaryOK);
+
+	// n-ary, with sources of different types:
+	std::vector<double> nary(count, -1.0);
+	combineVoxels(nary.data(), count, [](float x, int y, unsigned char z) { return x * y + z; }, nullptr,
+		static_cast<float const*>(a.data()), static_cast<int const*>(b.data()), static_cast<unsigned char const*>(c.data()));
+	bool naryOK = true;
+	for (qint64 i = 0; i < count; ++i)
+	{
+		naryOK &= (nary[i] == static_cast<double>(a[i] * b[i] + c[i]));
+	}
+	TestAssert(naryOK);
+
+	// n-ary, with the destination also being a source:
+	std::vector<float> inPlace(a);
+	combineVoxels(inPlace.data(), count, [](float x, int y, unsigned char z) { return x - y * z; }, nullptr,
+		static_cast<float const*>(inPlace.data()), static_cast<int const*>(b.data()), static_cast<unsigned char const*>(c.data()));
+	bool inPlaceOK = true;
+	for (qint64 i = 0; i < count; ++i)
+	{
+		inPlaceOK &= (inPlace[i] == a[i] - b[i] * c[i]);
+	}
+	TestAssert(inPlaceOK);
+
+	// zero-length buffers are not touched:
+	std::vector<double> untouched(1, -1.0);
+	combineVoxels(untouched.data(), 0, [](float) { return 0.0; }, nullptr, static_cast<float const*>(a.data()));
+	TestEqual(-1.0, untouched[0]);
+END_TEST